@@ -0,0 +1,144 @@
+/*
+** EPITECH PROJECT, 2025
+** Title: Flakkari
+** Author: MasterLaplace
+** Created: 2025-11-04
+** File description:
+** Connection
+*/
+
+#include "Connection.hpp"
+
+namespace Flakkari {
+
+Connection::Connection(std::string game, std::chrono::milliseconds keepAliveInterval, Send send, bool checksum)
+    : _GAME_NAME(std::move(game)), _KEEP_ALIVE_INTERVAL(keepAliveInterval), _send(std::move(send)),
+      _checksum(checksum)
+{
+}
+
+void Connection::connect(Clock::time_point now)
+{
+    Packet packet;
+    packet.header._commandId = Protocol::CommandId::REQ_CONNECT;
+    packet.header._reliable = true;
+    packet.injectString(_GAME_NAME);
+    packet << _compressor.getDictionaryId();
+    packet << static_cast<uint8_t>(_checksum.isEnabled() ? Protocol::DatagramChecksum::OPTION : 0);
+    send(packet.serialize(), now);
+}
+
+void Connection::disconnect(Clock::time_point now)
+{
+    Packet packet;
+    packet.header._commandId = Protocol::CommandId::REQ_DISCONNECT;
+    send(packet.serialize(), now);
+}
+
+void Connection::send(const Network::Buffer &serializedPacket, Clock::time_point now)
+{
+    Network::Buffer datagram;
+    auto mtu = Protocol::DEFAULT_MTU - _checksum.getOverhead();
+
+    if (serializedPacket.size() <= mtu)
+    {
+        _channel.write(datagram, serializedPacket, now);
+        sendDatagram(datagram, now);
+        return;
+    }
+    auto count = _fragmenter.split(serializedPacket, Protocol::CommandId::REQ_FRAGMENT, mtu,
+                                   [&](const Network::Buffer &fragment) {
+                                       datagram.clear();
+                                       _channel.write(datagram, fragment, now);
+                                       sendDatagram(datagram, now);
+                                   });
+    if (count == 0)
+        FLAKKARI_LOG_WARNING("packet of " + std::to_string(serializedPacket.size()) + " bytes too large to send");
+}
+
+void Connection::flush(Clock::time_point now)
+{
+    Network::Buffer datagram;
+
+    // the reliable packets not acked in time and the ones the window had no room for
+    _channel.writeRetransmissions(datagram, now);
+    // the server only knows the client once it got REQ_CONNECT, whose retransmissions keep it alive until then
+    if (datagram.empty() && _entity.load() != NO_ENTITY && now - _lastSend >= _KEEP_ALIVE_INTERVAL)
+    {
+        Packet packet;
+        packet.header._commandId = Protocol::CommandId::REQ_HEARTBEAT;
+        _channel.write(datagram, packet.serialize(), now);
+    }
+    // the acks of the reliable packets received, when nothing else carries them
+    if (datagram.empty() && _channel.needsAck())
+        _channel.writeAck(datagram, Protocol::CommandId::REQ_ACK, now);
+    sendDatagram(datagram, now);
+}
+
+bool Connection::receive(const byte *data, std::size_t size, Clock::time_point now, const Deliver &deliver,
+                         const Observe &observe)
+{
+    // the trailer covers the datagram as it was sent, compressed or not: a corrupted one is dropped
+    if (!_checksum.open(data, size))
+        return FLAKKARI_LOG_WARNING("Received a datagram with an invalid checksum"), false;
+
+    // the packets of a compressed datagram are unpacked first, with the dictionary offered in REQ_CONNECT
+    bool compressed = _compressor.isCompressed(data, size);
+    if (compressed)
+    {
+        auto *packets = _compressor.decompress(data, size);
+        if (!packets)
+            return FLAKKARI_LOG_WARNING("Received an invalid compressed datagram"), false;
+        data = packets->data();
+        size = packets->size();
+    }
+    if (observe)
+        observe(data, size, compressed);
+
+    // the server puts the packets of a tick end to end in one datagram
+    for (std::size_t offset = 0; offset < size;)
+    {
+        Packet packet;
+        if (!Protocol::readHeader(packet.header, data + offset, size - offset))
+            return FLAKKARI_LOG_WARNING("Received an invalid packet"), false;
+        auto payload = data + offset + packet.header.size();
+        packet.payload.assign(payload, payload + packet.header._contentLength);
+        offset += packet.size();
+        _channel.receive(std::move(packet), now, [&](const Packet &packet) { handle(packet, now, deliver); });
+    }
+    return true;
+}
+
+std::optional<uint64_t> Connection::getEntity() const
+{
+    auto entity = _entity.load();
+    if (entity == NO_ENTITY)
+        return std::nullopt;
+    return entity;
+}
+
+void Connection::sendDatagram(Network::Buffer &datagram, Clock::time_point now)
+{
+    if (datagram.empty())
+        return;
+    _checksum.seal(datagram);
+    _send(datagram);
+    _lastSend = now;
+}
+
+void Connection::handle(const Packet &packet, Clock::time_point now, const Deliver &deliver)
+{
+    if (packet.header._commandId == Protocol::CommandId::REP_FRAGMENT)
+    {
+        auto whole = _reassembler.add(packet.payload.data(), packet.payload.size(), packet.header._reliable, now);
+        Packet reassembled;
+        if (whole && reassembled.deserialize(*whole))
+            handle(reassembled, now, deliver);
+        return;
+    }
+    if (packet.header._commandId == Protocol::CommandId::REP_CONNECT && packet.payload.size() >= sizeof(uint64_t))
+        _entity = *(uint64_t *) packet.payload.data();
+    deliver(packet);
+}
+
+} /* namespace Flakkari */
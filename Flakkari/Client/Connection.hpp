@@ -0,0 +1,179 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file Connection.hpp
+ * @brief This file contains the Connection class. It is the protocol state
+ *        of a client connected to a server, without its socket: handshake,
+ *        reliability, fragmentation and compression of the datagrams.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2025 @MasterLaplace
+ * @version 0.10.0
+ * @date 2025-11-04
+ **************************************************************************/
+
+#ifndef CONNECTION_HPP_
+#define CONNECTION_HPP_
+
+#include "Protocol/Checksum.hpp"
+#include "Protocol/Compression.hpp"
+#include "Protocol/Fragmentation.hpp"
+#include "Protocol/Packet.hpp"
+#include "Protocol/Reliability.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+
+namespace Flakkari {
+
+/**
+ * @brief Protocol side of the connection of a client to a server
+ *
+ * @details The connection writes the datagrams of the client and reads the
+ * ones of the server, and leaves the socket to its owner: UDPClient sends
+ * them from its network thread, flakkari-bots batches the datagrams of many
+ * connections in one sendmmsg. Each datagram written is handed to the send
+ * function given at construction.
+ *
+ * Sending, the packets go through the reliability layer (sequence, acks,
+ * retransmission of the reliable ones) and a packet larger than the MTU is
+ * split in fragments. The owner calls flush() regularly (every tick, or
+ * every few milliseconds) to send the retransmissions, the acks and a
+ * heartbeat when the connection was idle for keepAliveInterval.
+ *
+ * Receiving, a datagram is checked against its CRC32C trailer (when asked
+ * for), decompressed (with the dictionary offered in REQ_CONNECT), its
+ * packets read end to end, ordered by the reliability layer and put back
+ * together from their fragments before being delivered. REP_CONNECT gives
+ * the entity of the client.
+ *
+ * The connection is not thread safe, except getEntity(): its owner locks it
+ * when it sends from a thread and receives from another.
+ *
+ * @example "Flakkari/Client/Connection.hpp"
+ * @code
+ * Connection connection("R-Type", std::chrono::milliseconds(3000),
+ *                       [&](const Network::Buffer &datagram) { socket.sendTo(address, datagram); });
+ * connection.connect(now);
+ * connection.receive(datagram.data(), datagram.size(), now, [&](const auto &packet) { handle(packet); });
+ * connection.flush(now);
+ * @endcode
+ */
+class Connection {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Packet = Protocol::Packet<Protocol::CommandId>;
+    using Send = std::function<void(const Network::Buffer &datagram)>;
+    using Deliver = std::function<void(const Packet &packet)>;
+    using Observe = std::function<void(const byte *packets, std::size_t size, bool compressed)>;
+
+    /**
+     * @brief Construct a new Connection object
+     *
+     * @param game  The name of the game to join
+     * @param keepAliveInterval  The idle time after which a heartbeat is sent
+     * @param send  Called with each datagram to send to the server
+     * @param checksum  Ask for a CRC32C trailer on every datagram, both ways (see Protocol::DatagramChecksum)
+     */
+    Connection(std::string game, std::chrono::milliseconds keepAliveInterval, Send send, bool checksum = false);
+
+    /**
+     * @brief Send REQ_CONNECT: the name of the game, the id of the
+     * dictionary of the datagrams and the options (the CRC32C trailer). It is
+     * reliable, so flush() sends it again until the server acks it.
+     *
+     * @param now  The current time
+     */
+    void connect(Clock::time_point now);
+
+    /**
+     * @brief Send REQ_DISCONNECT, once: the server frees the slot of the
+     * client without waiting for its timeout
+     *
+     * @param now  The current time
+     */
+    void disconnect(Clock::time_point now);
+
+    /**
+     * @brief Send a serialized packet, stamped by the reliability layer, in
+     * fragments (one per datagram) if it is larger than the MTU
+     *
+     * @param serializedPacket  The serialized packet
+     * @param now  The current time
+     */
+    void send(const Network::Buffer &serializedPacket, Clock::time_point now);
+
+    /**
+     * @brief Send the reliable packets whose timeout expired or that waited
+     * for room in the window, a heartbeat after keepAliveInterval without
+     * sending once connected, and the acks of the reliable packets received
+     *
+     * @param now  The current time
+     */
+    void flush(Clock::time_point now);
+
+    /**
+     * @brief Handle a datagram of the server: deliver its packets, in order
+     * for the reliable ones, once their fragments are put back together
+     *
+     * @param data  The datagram
+     * @param size  The size of the datagram
+     * @param now  The current time
+     * @param deliver  Called with each packet delivered
+     * @param observe  Called with the packets of the datagram, decompressed, before they are read (optional)
+     * @return false  If the datagram is invalid or corrupted (the packets before an invalid one are delivered)
+     */
+    bool receive(const byte *data, std::size_t size, Clock::time_point now, const Deliver &deliver,
+                 const Observe &observe = nullptr);
+
+public: // Getters
+    /**
+     * @brief Get the entity of the client, known once REP_CONNECT is received
+     * (thread safe)
+     */
+    [[nodiscard]] std::optional<uint64_t> getEntity() const;
+
+    [[nodiscard]] Protocol::ReliabilityStats getReliabilityStats() const { return _channel.getStats(); }
+    [[nodiscard]] const Protocol::ReassemblyStats &getReassemblyStats() const { return _reassembler.getStats(); }
+    [[nodiscard]] const Protocol::CompressionStats &getCompressionStats() const { return _compressor.getStats(); }
+    [[nodiscard]] const Protocol::ChecksumStats &getChecksumStats() const { return _checksum.getStats(); }
+
+private:
+    static constexpr uint64_t NO_ENTITY = UINT64_MAX;
+
+    /**
+     * @brief Send a datagram written by the channel, with its trailer, unless
+     * it is empty (a reliable packet waiting for room in the window writes
+     * nothing)
+     */
+    void sendDatagram(Network::Buffer &datagram, Clock::time_point now);
+
+    /**
+     * @brief Handle a packet delivered by the channel: put a fragment in the
+     * reassembly buffer (and handle the packet once complete), take the entity
+     * of REP_CONNECT, and deliver the packet
+     */
+    void handle(const Packet &packet, Clock::time_point now, const Deliver &deliver);
+
+private:
+    const std::string _GAME_NAME;
+    const std::chrono::milliseconds _KEEP_ALIVE_INTERVAL;
+    Send _send;                               // Sender of the datagrams
+    Clock::time_point _lastSend;              // Time of the last datagram sent
+    std::atomic<uint64_t> _entity{NO_ENTITY}; // Entity of the client
+    Protocol::ReliableChannel<Protocol::CommandId, Packet> _channel;
+    Protocol::Fragmenter<Protocol::CommandId> _fragmenter; // Splitter of the packets sent
+    Protocol::Reassembler _reassembler;                    // Fragments received
+    // Decompression of the datagrams received, with the dictionary offered in REQ_CONNECT
+    Protocol::DatagramCompressor<Protocol::CommandId> _compressor{Protocol::CommandId::REP_COMPRESSED};
+    Protocol::DatagramChecksum _checksum; // CRC32C trailer of the datagrams, both ways
+};
+
+} /* namespace Flakkari */
+
+#endif /* !CONNECTION_HPP_ */
@@ -0,0 +1,144 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file PredictionBuffer.hpp
+ * @brief This file contains the PredictionBuffer class. It keeps the inputs
+ *        sent to the server and not acknowledged yet, so that the client can
+ *        apply its inputs at once (prediction) and replay them on top of
+ *        each authoritative state it receives (reconciliation).
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2025 @MasterLaplace
+ * @version 0.10.0
+ * @date 2025-11-04
+ **************************************************************************/
+
+#ifndef PREDICTIONBUFFER_HPP_
+#define PREDICTIONBUFFER_HPP_
+
+#include "Protocol/Events.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Flakkari {
+
+/**
+ * @brief Buffer of the unacknowledged inputs of a client
+ *
+ * @details Each input sent in a REQ_USER_UPDATES packet gets a sequence
+ * number (starting at 1). The server applies the inputs in order and sends
+ * the sequence number of the last one it applied with the state of the
+ * entity of the client (REQ_ENTITIES_MOVED). When that state arrives, the
+ * client acknowledges the sequence number, which drops the applied inputs,
+ * resets its entity to the received state and replays the inputs that are
+ * still in the buffer.
+ *
+ * The buffer is thread safe: the inputs are pushed by the game thread and
+ * acknowledged by the network thread of UDPClient.
+ *
+ * @example "Flakkari/Client/PredictionBuffer.hpp"
+ * @code
+ * auto sequence = client.reqUserUpdates(events, axisEvents);
+ * applyInputs(predictedState, events, axisEvents);
+ * // on a REQ_ENTITIES_MOVED for the entity of the client:
+ * predictedState = authoritativeState;
+ * client.getPredictionBuffer().replay([&](const PredictionBuffer::Input &input) {
+ *     applyInputs(predictedState, input.events, input.axisEvents);
+ * });
+ * @endcode
+ */
+class PredictionBuffer {
+public:
+    struct Input {
+        uint32_t sequence;                                       // Sequence number of the input
+        std::vector<Protocol::Event> events;                     // Events of the input
+        std::unordered_map<Protocol::EventId, float> axisEvents; // Axis events of the input
+    };
+
+    static constexpr std::size_t MAX_INPUTS = 256; // Oldest inputs are dropped past this count
+
+public:
+    PredictionBuffer() = default;
+    PredictionBuffer(const PredictionBuffer &) = delete;
+    ~PredictionBuffer() = default;
+
+    /**
+     * @brief Add an input sent to the server.
+     *
+     * @param events  Events of the input.
+     * @param axisEvents  Axis events of the input.
+     * @return uint32_t  The sequence number of the input.
+     */
+    uint32_t push(const std::vector<Protocol::Event> &events,
+                  const std::unordered_map<Protocol::EventId, float> &axisEvents)
+    {
+        std::scoped_lock lock(_mutex);
+        if (++_nextSequence == 0) // 0 means "no input"
+            ++_nextSequence;
+        if (_inputs.size() >= MAX_INPUTS)
+            _inputs.pop_front();
+        _inputs.push_back({_nextSequence, events, axisEvents});
+        return _nextSequence;
+    }
+
+    /**
+     * @brief Drop the inputs applied by the server.
+     *
+     * @param sequence  Sequence number of the last input applied by the server (0 is ignored).
+     */
+    void acknowledge(uint32_t sequence)
+    {
+        std::scoped_lock lock(_mutex);
+        if (sequence == 0 || static_cast<int32_t>(sequence - _lastAcknowledged) <= 0)
+            return;
+        _lastAcknowledged = sequence;
+        while (!_inputs.empty() && static_cast<int32_t>(_inputs.front().sequence - sequence) <= 0)
+            _inputs.pop_front();
+    }
+
+    /**
+     * @brief Apply the unacknowledged inputs, oldest first.
+     *
+     * @param apply  Called with each input.
+     */
+    template <typename Apply> void replay(Apply &&apply)
+    {
+        std::scoped_lock lock(_mutex);
+        for (const auto &input : _inputs)
+            apply(input);
+    }
+
+    [[nodiscard]] uint32_t getLastAcknowledged()
+    {
+        std::scoped_lock lock(_mutex);
+        return _lastAcknowledged;
+    }
+
+    [[nodiscard]] std::size_t size()
+    {
+        std::scoped_lock lock(_mutex);
+        return _inputs.size();
+    }
+
+    void clear()
+    {
+        std::scoped_lock lock(_mutex);
+        _inputs.clear();
+    }
+
+private:
+    std::mutex _mutex;
+    std::deque<Input> _inputs;
+    uint32_t _nextSequence = 0;
+    uint32_t _lastAcknowledged = 0;
+};
+
+} /* namespace Flakkari */
+
+#endif /* !PREDICTIONBUFFER_HPP_ */
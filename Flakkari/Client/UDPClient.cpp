@@ -11,8 +11,11 @@
 
 namespace Flakkari {
 
-UDPClient::UDPClient(const std::string &game, const std::string &ip, unsigned short port, long int keepAliveInterval)
-    : _KEEP_ALIVE_INTERVAL(keepAliveInterval), _GAME_NAME(game)
+UDPClient::UDPClient(const std::string &game, const std::string &ip, unsigned short port, long int keepAliveInterval,
+                     bool checksum)
+    : _connection(
+          game, std::chrono::milliseconds(keepAliveInterval),
+          [this](const Network::Buffer &datagram) { _socket->sendTo(_socket->getAddress(), datagram); }, checksum)
 {
     Network::init();
 
@@ -22,7 +25,7 @@ UDPClient::UDPClient(const std::string &game, const std::string &ip, unsigned sh
     FLAKKARI_LOG_INFO(std::string(*_socket));
     _socket->setBlocking(false);
 
-    _io = std::make_unique<IO_SELECTED>(_socket->getSocket(), _KEEP_ALIVE_INTERVAL);
+    _io = std::make_unique<IO_SELECTED>(_socket->getSocket(), 0, FLUSH_INTERVAL_US);
 }
 
 UDPClient::~UDPClient()
@@ -41,11 +44,8 @@ void UDPClient::connectToServer()
 
     _thread = std::thread(&UDPClient::run, this);
 
-    Protocol::Packet<Protocol::CommandId> packet;
-    packet.header._apiVersion = packet.header._apiVersion;
-    packet.header._commandId = Protocol::CommandId::REQ_CONNECT;
-    packet.injectString(_GAME_NAME);
-    sendPacket(packet.serialize());
+    std::scoped_lock lock(_connectionMutex);
+    _connection.connect(std::chrono::steady_clock::now());
 }
 
 void UDPClient::disconnectFromServer() { _running = false; }
@@ -54,14 +54,16 @@ void UDPClient::sendPacket(const Network::Buffer &serializedPacket)
 {
     if (!_socket)
         return;
-    _socket->sendTo(_socket->getAddress(), serializedPacket);
+
+    std::scoped_lock lock(_connectionMutex);
+    _connection.send(serializedPacket, std::chrono::steady_clock::now());
 }
 
-void UDPClient::reqUserUpdates(std::vector<Protocol::Event> events,
-                               std::unordered_map<Protocol::EventId, float> axisEvents)
+uint32_t UDPClient::reqUserUpdates(std::vector<Protocol::Event> events,
+                                   std::unordered_map<Protocol::EventId, float> axisEvents)
 {
     if (events.empty() && axisEvents.empty())
-        return;
+        return 0;
 
     Protocol::Packet<Protocol::CommandId> packet;
     packet.header._priority = Protocol::Priority::HIGH;
@@ -80,7 +82,33 @@ void UDPClient::reqUserUpdates(std::vector<Protocol::Event> events,
         packet << value;
     }
 
+    auto sequence = _prediction.push(events, axisEvents);
+    packet << sequence;
+
     sendPacket(packet.serialize());
+    return sequence;
+}
+
+std::optional<uint64_t> UDPClient::getEntity() const { return _connection.getEntity(); }
+
+void UDPClient::acknowledgeInputs(const Protocol::Packet<Protocol::CommandId> &packet)
+{
+    auto entity = _connection.getEntity();
+    if (!entity || packet.payload.size() < sizeof(uint16_t))
+        return;
+
+    uint16_t count = *(uint16_t *) packet.payload.data();
+    auto entry = packet.payload.data() + sizeof(uint16_t);
+
+    if (packet.payload.size() < sizeof(uint16_t) + count * ENTITY_MOVED_SIZE)
+        return;
+    for (uint16_t i = 0; i < count; ++i, entry += ENTITY_MOVED_SIZE)
+    {
+        if (*(uint64_t *) entry != *entity)
+            continue;
+        _prediction.acknowledge(*(uint32_t *) (entry + sizeof(uint64_t)));
+        return;
+    }
 }
 
 void UDPClient::addPacket(const Protocol::Packet<Protocol::CommandId> &packet) { _packetQueue.push_back(packet); }
@@ -97,10 +125,8 @@ bool UDPClient::handleTimeout(int event)
     if (event != 0)
         return false;
 
-    Protocol::Packet<Protocol::CommandId> packet;
-    packet.header._apiVersion = packet.header._apiVersion;
-    packet.header._commandId = Protocol::CommandId::REQ_HEARTBEAT;
-    sendPacket(packet.serialize());
+    std::scoped_lock lock(_connectionMutex);
+    _connection.flush(std::chrono::steady_clock::now());
     return true;
 }
 
@@ -113,16 +139,20 @@ void UDPClient::handlePacket()
     if (responses.empty())
         return;
 
+    auto now = std::chrono::steady_clock::now();
+    std::scoped_lock lock(_connectionMutex);
+
     for (auto &resp : responses)
-    {
-        Protocol::Packet<Protocol::CommandId> packet;
-        if (!packet.deserialize(resp.second))
-        {
-            FLAKKARI_LOG_WARNING("Received an invalid packet");
-            continue;
-        }
-        addPacket(packet);
-    }
+        _connection.receive(resp.second.data(), resp.second.size(), now,
+                            [this](const Protocol::Packet<Protocol::CommandId> &packet) { deliverPacket(packet); });
+    _connection.flush(now);
+}
+
+void UDPClient::deliverPacket(const Protocol::Packet<Protocol::CommandId> &packet)
+{
+    if (packet.header._commandId == Protocol::CommandId::REQ_ENTITIES_MOVED)
+        acknowledgeInputs(packet);
+    addPacket(packet);
 }
 
 void UDPClient::run()
@@ -16,12 +16,14 @@
 #ifndef UDPCLIENT_HPP_
 #define UDPCLIENT_HPP_
 
+#include "Connection.hpp"
 #include "Network/IOMultiplexer.hpp"
 #include "Network/Network.hpp"
 #include "Network/PacketQueue.hpp"
 #include "Network/Serializer.hpp"
-#include "Protocol/Packet.hpp"
+#include "PredictionBuffer.hpp"
 #include <atomic>
+#include <mutex>
 #include <optional>
 #include <thread>
 
@@ -60,10 +62,11 @@ public:
      * @param game The name of the game
      * @param ip The ip to bind the server to (default: localhost)
      * @param port The port to bind the server to (default: 8081)
-     * @param keepAliveInterval The interval to send keep alive packets (default: 3000 ms)
+     * @param keepAliveInterval The idle time after which a keep alive packet is sent (default: 3000 ms)
+     * @param checksum Ask for a CRC32C trailer on every datagram, both ways (default: false)
      */
     UDPClient(const std::string &game, const std::string &ip = "localhost", unsigned short port = 8081,
-              long int keepAliveInterval = 3000);
+              long int keepAliveInterval = 3000, bool checksum = false);
     ~UDPClient();
 
     /**
@@ -83,6 +86,11 @@ public:
     /**
      * @brief Send a serialized packet to the server
      *
+     * @details The packet is stamped by the reliability layer of the
+     * connection: it carries the acks of the packets received, and is sent
+     * again until the server acks it if its header has the reliable flag. A
+     * packet larger than the MTU is sent in fragments, one per datagram.
+     *
      * @param serializedPacket The serialized packet to send
      */
     void sendPacket(const Flakkari::Network::Buffer &serializedPacket);
@@ -90,10 +98,29 @@ public:
     /**
      * @brief Send a REQ_USER_UPDATES packet to the server
      *
+     * @details The input is numbered and kept in the prediction buffer until
+     * the server acknowledges it in a REQ_ENTITIES_MOVED packet.
+     *
      * @param events The list of events to send
      * @param axisEvents The dictionary of axis events to send
+     * @return uint32_t The sequence number of the input (0 if nothing was sent)
+     */
+    uint32_t reqUserUpdates(std::vector<Protocol::Event> events,
+                            std::unordered_map<Protocol::EventId, float> axisEvents);
+
+    /**
+     * @brief Get the inputs sent to the server and not acknowledged yet
+     *
+     * @return PredictionBuffer&  The prediction buffer of the client
+     */
+    [[nodiscard]] PredictionBuffer &getPredictionBuffer() { return _prediction; }
+
+    /**
+     * @brief Get the entity of the client, known once REP_CONNECT is received
+     *
+     * @return std::optional<uint64_t>  The entity id of the client
      */
-    void reqUserUpdates(std::vector<Protocol::Event> events, std::unordered_map<Protocol::EventId, float> axisEvents);
+    [[nodiscard]] std::optional<uint64_t> getEntity() const;
 
     /**
      * @brief Get the next packet from the packet queue
@@ -103,6 +130,10 @@ public:
     [[nodiscard]] std::optional<Protocol::Packet<Protocol::CommandId>> getNextPacket();
 
 private:
+    static constexpr long int FLUSH_INTERVAL_US = 10000; // Longest wait before the retransmissions are written
+    // Size of an entry of REQ_ENTITIES_MOVED: (id)(last input)(position, rotation, scale, velocity, acceleration)
+    static constexpr std::size_t ENTITY_MOVED_SIZE = sizeof(uint64_t) + sizeof(uint32_t) + sizeof(float) * 16;
+
     /**
      * @brief Add a packet to the packet queue
      *
@@ -111,7 +142,9 @@ private:
     void addPacket(const Protocol::Packet<Protocol::CommandId> &packet);
 
     /**
-     * @brief Handle the timeout of the server (check for inactive clients)
+     * @brief Handle the timeout of the wait, every FLUSH_INTERVAL_US without
+     * a datagram received: flush the connection, so that a client that receives
+     * nothing still sends its packets again
      *
      * @param event  The event that triggered the timeout (0 if timeout)
      * @return true  If the timeout was handled
@@ -125,6 +158,23 @@ private:
      */
     void handlePacket();
 
+    /**
+     * @brief Handle a packet delivered by the connection (in order for a
+     * reliable packet, put back together for a fragmented one) and add it to
+     * the packet queue.
+     *
+     * @param packet  The packet
+     */
+    void deliverPacket(const Protocol::Packet<Protocol::CommandId> &packet);
+
+    /**
+     * @brief Acknowledge the inputs applied by the server from the entry of
+     * the entity of the client in a REQ_ENTITIES_MOVED packet.
+     *
+     * @param packet  The REQ_ENTITIES_MOVED packet
+     */
+    void acknowledgeInputs(const Protocol::Packet<Protocol::CommandId> &packet);
+
     /**
      * @brief Run the client and wait for incoming packets
      *
@@ -138,8 +188,9 @@ private:
     std::atomic<bool> _running{false};
     std::thread _thread;
     Network::PacketQueue<Protocol::Packet<Protocol::CommandId>> _packetQueue;
-    const long int _KEEP_ALIVE_INTERVAL = 3000; // 3 seconds
-    const std::string _GAME_NAME;
+    PredictionBuffer _prediction; // Unacknowledged inputs
+    std::mutex _connectionMutex;  // Lock of _connection (sent from any thread, received by _thread)
+    Connection _connection;       // Protocol state of the connection to the server
 };
 
 } /* namespace Flakkari */
@@ -18,6 +18,10 @@ void Registry::clear()
     _components.clear();
     _eraseFunctions.clear();
     _systems.clear();
+    _systemNames.clear();
+#ifdef FLAKKARI_PROFILE_SYSTEMS
+    _profilerSlots.clear();
+#endif
     _deadEntities = std::queue<entity_type>();
     _nextEntity = 0;
 }
@@ -47,8 +51,35 @@ void Registry::kill_entity(const entity_type &e)
 
 void Registry::run_systems()
 {
+#ifdef FLAKKARI_PROFILE_SYSTEMS
+    if (_profiler)
+    {
+        auto start = SystemProfiler::Clock::now();
+
+        for (std::size_t i = 0; i < _systems.size(); ++i)
+        {
+            _systems[i](*this);
+            auto end = SystemProfiler::Clock::now();
+            _profiler->record(_profilerSlots[i], end - start);
+            start = end;
+        }
+        return;
+    }
+#endif
     for (auto &system : _systems)
         system(*this);
 }
 
+#ifdef FLAKKARI_PROFILE_SYSTEMS
+void Registry::setProfiler(SystemProfiler *profiler)
+{
+    _profiler = profiler;
+    _profilerSlots.clear();
+    if (!_profiler)
+        return;
+    for (const auto &name : _systemNames)
+        _profilerSlots.emplace_back(_profiler->slot(name));
+}
+#endif
+
 } // namespace Flakkari::Engine::ECS
@@ -18,12 +18,17 @@
 #include "Entity.hpp"
 #include "SparseArrays.hpp"
 
+#ifdef FLAKKARI_PROFILE_SYSTEMS
+#    include "SystemProfiler.hpp"
+#endif
+
 #include <any>
 #include <climits>
 #include <functional>
 #include <iostream>
 #include <queue>
 #include <stdexcept>
+#include <string>
 #include <typeindex>
 #include <unordered_map>
 
@@ -235,9 +240,27 @@ public:
      * @param f  The function to add to the system.
      */
     template <typename... Components, typename Function> void add_system(Function &&f)
+    {
+        add_system<Components...>("system", std::forward<Function>(f));
+    }
+
+    /**
+     * @brief Add a named system to the registry.
+     *
+     * @tparam Components  The components to add to the system.
+     * @tparam Function  The function to add to the system.
+     * @param name  The name of the system (used by the profiler).
+     * @param f  The function to add to the system.
+     */
+    template <typename... Components, typename Function> void add_system(const std::string &name, Function &&f)
     {
         _systems.emplace_back(
             [sys{std::forward<Function>(f)}](Registry &r) { sys(r, r.getComponents<Components>()...); });
+        _systemNames.emplace_back(name);
+#ifdef FLAKKARI_PROFILE_SYSTEMS
+        if (_profiler)
+            _profilerSlots.emplace_back(_profiler->slot(name));
+#endif
     }
 
     /**
@@ -246,10 +269,26 @@ public:
      */
     void run_systems();
 
+#ifdef FLAKKARI_PROFILE_SYSTEMS
+    /**
+     * @brief Time each system run by run_systems in a profiler.
+     *
+     * @param profiler  The profiler, nullptr to stop profiling. It must outlive the registry.
+     */
+    void setProfiler(SystemProfiler *profiler);
+#endif
+
+    [[nodiscard]] const std::vector<std::string> &getSystemNames() const { return _systemNames; }
+
 private:
     std::unordered_map<std::type_index, std::any> _components;
     std::unordered_map<std::type_index, EraseFn> _eraseFunctions;
     std::vector<SystemFn> _systems;
+    std::vector<std::string> _systemNames;
+#ifdef FLAKKARI_PROFILE_SYSTEMS
+    SystemProfiler *_profiler = nullptr;
+    std::vector<std::size_t> _profilerSlots; // Slot of each system in the profiler
+#endif
     std::queue<entity_type> _deadEntities;
     size_t _nextEntity = 0;
 };
@@ -0,0 +1,101 @@
+/*
+** EPITECH PROJECT, 2024
+** Title: Flakkari
+** Author: MasterLaplace
+** Created: 2024-01-05
+** File description:
+** SystemProfiler
+*/
+
+#include "SystemProfiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace Flakkari::Engine::ECS {
+
+uint64_t Histogram::lowestValueOf(std::size_t index)
+{
+    if (index < 2 * SUB_BUCKETS)
+        return index;
+    auto shift = static_cast<unsigned>(index / SUB_BUCKETS - 1);
+    return static_cast<uint64_t>(index % SUB_BUCKETS + SUB_BUCKETS) << shift;
+}
+
+uint64_t Histogram::percentile(double ratio) const
+{
+    if (_count == 0)
+        return 0;
+
+    auto rank = static_cast<uint64_t>(std::clamp(ratio, 0.0, 1.0) * static_cast<double>(_count));
+    rank = std::clamp<uint64_t>(rank, 1, _count);
+
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKETS; ++i)
+    {
+        seen += _counts[i];
+        if (seen < rank)
+            continue;
+        if (i + 1 == BUCKETS)
+            return _max;
+        return std::clamp(lowestValueOf(i + 1) - 1, min(), _max);
+    }
+    return _max;
+}
+
+void Histogram::reset()
+{
+    _counts.fill(0);
+    _count = 0;
+    _sum = 0;
+    _min = UINT64_MAX;
+    _max = 0;
+}
+
+std::size_t SystemProfiler::slot(const std::string &name)
+{
+    for (std::size_t i = 0; i < _systems.size(); ++i)
+        if (_systems[i].name == name)
+            return i;
+    _systems.push_back({name, {}});
+    return _systems.size() - 1;
+}
+
+std::string SystemProfiler::report() const
+{
+    std::string table;
+    char line[160];
+
+    std::snprintf(line, sizeof(line), "%-28s %10s %10s %10s %10s %10s %10s\n", "system (us)", "count", "mean", "p50",
+                  "p90", "p99", "max");
+    table += line;
+    for (const auto &system : _systems)
+    {
+        const auto &h = system.histogram;
+
+        if (h.count() == 0)
+            continue;
+        std::snprintf(line, sizeof(line), "%-28s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n", system.name.c_str(),
+                      static_cast<unsigned long long>(h.count()), h.mean() / 1000.0,
+                      static_cast<double>(h.percentile(0.5)) / 1000.0, static_cast<double>(h.percentile(0.9)) / 1000.0,
+                      static_cast<double>(h.percentile(0.99)) / 1000.0, static_cast<double>(h.max()) / 1000.0);
+        table += line;
+    }
+    return table;
+}
+
+void SystemProfiler::reset()
+{
+    for (auto &system : _systems)
+        system.histogram.reset();
+}
+
+const Histogram *SystemProfiler::get(const std::string &name) const
+{
+    for (const auto &system : _systems)
+        if (system.name == name)
+            return &system.histogram;
+    return nullptr;
+}
+
+} // namespace Flakkari::Engine::ECS
@@ -0,0 +1,151 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file SystemProfiler.hpp
+ * @brief SystemProfiler class for ECS (Entity Component System). It keeps
+ *        a histogram of the run time of each system of the registries it
+ *        is attached to.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-01-05
+ **************************************************************************/
+
+#ifndef FLAKKARI_SYSTEMPROFILER_HPP_
+#define FLAKKARI_SYSTEMPROFILER_HPP_
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Flakkari::Engine::ECS {
+
+/**
+ * @brief Histogram of durations with a bounded relative error
+ *
+ * @details Same layout as an HDR histogram: values below 32 have their own
+ * bucket, then each power of two is split in 16 linear sub-buckets, which
+ * keeps the error of a percentile below 1/16 (6.25%) for any value. The
+ * buckets are a fixed array: recording a value is a few integer operations
+ * and never allocates.
+ */
+class Histogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+    static constexpr std::size_t SUB_BUCKETS = std::size_t(1) << SUB_BUCKET_BITS;
+    static constexpr std::size_t BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+public:
+    void record(uint64_t value)
+    {
+        ++_counts[indexOf(value)];
+        ++_count;
+        _sum += value;
+        _min = value < _min ? value : _min;
+        _max = value > _max ? value : _max;
+    }
+
+    /**
+     * @brief Get the value below which a ratio of the recorded values are.
+     *
+     * @param ratio  Ratio in [0, 1] (0.99 for the 99th percentile).
+     * @return uint64_t  The highest value of the bucket of the percentile.
+     */
+    [[nodiscard]] uint64_t percentile(double ratio) const;
+
+    void reset();
+
+    [[nodiscard]] uint64_t count() const { return _count; }
+    [[nodiscard]] uint64_t min() const { return _count == 0 ? 0 : _min; }
+    [[nodiscard]] uint64_t max() const { return _max; }
+    [[nodiscard]] uint64_t sum() const { return _sum; }
+    [[nodiscard]] double mean() const { return _count == 0 ? 0 : static_cast<double>(_sum) / _count; }
+
+private:
+    [[nodiscard]] static std::size_t indexOf(uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+            return static_cast<std::size_t>(value);
+        unsigned shift = static_cast<unsigned>(std::bit_width(value)) - 1 - SUB_BUCKET_BITS;
+        return shift * SUB_BUCKETS + static_cast<std::size_t>(value >> shift);
+    }
+
+    [[nodiscard]] static uint64_t lowestValueOf(std::size_t index);
+
+private:
+    std::array<uint64_t, BUCKETS> _counts{};
+    uint64_t _count = 0;
+    uint64_t _sum = 0;
+    uint64_t _min = UINT64_MAX;
+    uint64_t _max = 0;
+};
+
+/**
+ * @brief Run time histograms of the systems of one or more registries
+ *
+ * @details A registry attached to a profiler (Registry::setProfiler) times
+ * each of its systems with a steady clock and records the durations, in
+ * nanoseconds, in the histogram of the name of the system. The registries
+ * of the scenes of a game share the profiler of the game, so the same
+ * system run in several scenes has one histogram.
+ *
+ * The profiler is not thread safe: it is used by the thread of the game
+ * and read under the lock of the game.
+ *
+ * @example "Flakkari/Engine/EntityComponentSystem/SystemProfiler.hpp"
+ * @code
+ * SystemProfiler profiler;
+ * registry.setProfiler(&profiler);
+ * registry.run_systems();
+ * std::cout << profiler.report();
+ * @endcode
+ */
+class SystemProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+public:
+    /**
+     * @brief Get the slot of a system, added if it is not known yet.
+     *
+     * @param name  Name of the system.
+     * @return std::size_t  Index to pass to record().
+     */
+    std::size_t slot(const std::string &name);
+
+    void record(std::size_t slot, Clock::duration duration)
+    {
+        _systems[slot].histogram.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()));
+    }
+
+    /**
+     * @brief Get a table of the run time of each system (count, mean,
+     * percentiles and max, in microseconds) since the last reset.
+     *
+     * @return std::string  The table, one line per system.
+     */
+    [[nodiscard]] std::string report() const;
+
+    void reset();
+
+    [[nodiscard]] const Histogram *get(const std::string &name) const;
+
+private:
+    struct System {
+        std::string name;    // Name of the system
+        Histogram histogram; // Run times in nanoseconds
+    };
+
+    std::vector<System> _systems;
+};
+
+} // namespace Flakkari::Engine::ECS
+
+#endif /* !FLAKKARI_SYSTEMPROFILER_HPP_ */
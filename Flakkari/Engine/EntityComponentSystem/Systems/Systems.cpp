@@ -100,12 +100,12 @@ void apply_movable(Registry &r, float deltaTime)
     }
 }
 
-static float randomRange(float min, float max)
+static float randomRange(std::mt19937 &rng, float min, float max)
 {
-    return min + static_cast<float>(rand()) / (static_cast<float>(RAND_MAX / (max - min)));
+    return std::uniform_real_distribution<float>(min, max)(rng);
 }
 
-void spawn_random_within_skybox(Registry &r, std::vector<Entity> &entities)
+void spawn_random_within_skybox(Registry &r, std::vector<Entity> &entities, std::mt19937 &rng)
 {
     if (!r.isRegistered<ECS::Components::_3D::Transform>() || !r.isRegistered<ECS::Components::Common::Tag>() ||
         !r.isRegistered<ECS::Components::Common::Spawned>())
@@ -149,9 +149,9 @@ void spawn_random_within_skybox(Registry &r, std::vector<Entity> &entities)
 
         if ((tag->tag == "Player" || tag->tag == "Enemy") && spawn->has_spawned == false)
         {
-            transform->_position.vec.x = randomRange(-maxRangeX, maxRangeX);
-            transform->_position.vec.y = randomRange(-maxRangeY, maxRangeY);
-            transform->_position.vec.z = randomRange(-maxRangeZ, maxRangeZ);
+            transform->_position.vec.x = randomRange(rng, -maxRangeX, maxRangeX);
+            transform->_position.vec.y = randomRange(rng, -maxRangeY, maxRangeY);
+            transform->_position.vec.z = randomRange(rng, -maxRangeZ, maxRangeZ);
             spawn->has_spawned = true;
             entities.emplace_back(i);
         }
@@ -180,7 +180,8 @@ static size_t count_entities(Registry &r, const std::string &tag)
     return count;
 }
 
-bool spawn_enemy(Registry &r, std::string &templateName, Entity &entity)
+bool spawn_enemy(Registry &r, std::string &templateName, Entity &entity, std::chrono::steady_clock::time_point now,
+                 std::mt19937 &rng)
 {
     if (!r.isRegistered<ECS::Components::_3D::Transform>() || !r.isRegistered<ECS::Components::Common::Tag>() ||
         !r.isRegistered<ECS::Components::Common::Spawned>())
@@ -215,7 +216,6 @@ bool spawn_enemy(Registry &r, std::string &templateName, Entity &entity)
         maxRangeY = (box->_size.dimension.height * transform->_scale.vec.y) / 2;
         maxRangeZ = (box->_size.dimension.depth * transform->_scale.vec.z) / 2;
 
-        auto now = std::chrono::steady_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - timer->lastTime);
         if (duration.count() <= timer->maxTime * 1000)
             return false;
@@ -231,9 +231,9 @@ bool spawn_enemy(Registry &r, std::string &templateName, Entity &entity)
         Factory::RegistryEntityByTemplate(r, entity, template_->content);
 
         auto &enemyTransform = r.getComponents<ECS::Components::_3D::Transform>()[entity];
-        enemyTransform->_position.vec.x = randomRange(-maxRangeX, maxRangeX);
-        enemyTransform->_position.vec.y = randomRange(-maxRangeY, maxRangeY);
-        enemyTransform->_position.vec.z = randomRange(-maxRangeZ, maxRangeZ);
+        enemyTransform->_position.vec.x = randomRange(rng, -maxRangeX, maxRangeX);
+        enemyTransform->_position.vec.y = randomRange(rng, -maxRangeY, maxRangeY);
+        enemyTransform->_position.vec.z = randomRange(rng, -maxRangeZ, maxRangeZ);
         return true;
     }
     return false;
@@ -21,6 +21,7 @@
 #include <chrono>
 #include <cmath>
 #include <cstdlib>
+#include <random>
 
 namespace Flakkari::Engine::ECS::Systems::_2D {
 
@@ -51,8 +52,9 @@ void apply_movable(Registry &r, float deltaTime);
  *
  * @param r  The registry containing the entities to update.
  * @param entities  The updated entities.
+ * @param rng  The random generator of the scene.
  */
-void spawn_random_within_skybox(Registry &r, std::vector<Entity> &entities);
+void spawn_random_within_skybox(Registry &r, std::vector<Entity> &entities, std::mt19937 &rng);
 
 /**
  * @brief Spawns an enemy entity.
@@ -60,9 +62,12 @@ void spawn_random_within_skybox(Registry &r, std::vector<Entity> &entities);
  * @param r  The registry containing the entities to update.
  * @param templateName  The name of the template to use for the enemy entity.
  * @param entity  The entity to spawn.
+ * @param now  The current time of the game (not the wall clock, so that a replay gives the same result).
+ * @param rng  The random generator of the scene.
  * @return true if the enemy was spawned, false otherwise.
  */
-bool spawn_enemy(Registry &r, std::string &templateName, Entity &entity);
+bool spawn_enemy(Registry &r, std::string &templateName, Entity &entity, std::chrono::steady_clock::time_point now,
+                 std::mt19937 &rng);
 
 /**
  * @brief Handles collisions between entities.
@@ -17,6 +17,13 @@ static Logger::Mode _mode = Logger::Mode::NORMAL;
 
 void Logger::setMode(Logger::Mode mode) noexcept { _mode = mode; }
 
+bool Logger::isEnabled(int level) noexcept
+{
+    if (_mode == Logger::Mode::SILENT)
+        return level == LOG_FATAL;
+    return _mode != Logger::Mode::NORMAL || level != LOG_DEBUG;
+}
+
 const std::string Logger::get_current_time() noexcept
 {
     char buffer[80];
@@ -29,7 +29,9 @@
 #define LOG_ERROR   4
 #define LOG_FATAL   5
 
-#define FLAKKARI_LOG(level, message)  Flakkari::Logger::log(level, message, __LINE__, __FILE__)
+// the message is only built if the level is printed in the current mode
+#define FLAKKARI_LOG(level, message)                                                                                   \
+    (Flakkari::Logger::isEnabled(level) ? Flakkari::Logger::log(level, message, __LINE__, __FILE__) : void())
 #define FLAKKARI_LOG_INFO(message)    FLAKKARI_LOG(LOG_INFO, message)
 #define FLAKKARI_LOG_LOG(message)     FLAKKARI_LOG(LOG_LOG, message)
 #define FLAKKARI_LOG_DEBUG(message)   FLAKKARI_LOG(LOG_DEBUG, message)
@@ -106,6 +108,7 @@ public:
 
 public:
     static void setMode(Mode mode) noexcept;
+    static bool isEnabled(int level) noexcept;
     static const std::string get_current_time() noexcept;
     static const std::string fatal_error_message() noexcept;
     static void log(int level, std::string message, int line, std::string file = "") noexcept;
@@ -101,39 +101,35 @@ Address::Address(const sockaddr_in &clientAddr, SocketType socket_type, IpType i
 }
 
 Address::Address(const sockaddr_storage &clientAddr, SocketType socket_type, IpType ip_type)
-    : _socket_type(socket_type), _ip_type(ip_type)
+    : Address(Endpoint::from(clientAddr), socket_type)
 {
-    addrinfo hints{};
-    hints.ai_family = (_ip_type == IpType::IPv4) ? AF_INET : AF_INET6;
-    hints.ai_socktype = (_socket_type == SocketType::TCP) ? SOCK_STREAM : SOCK_DGRAM;
-    hints.ai_protocol = (_socket_type == SocketType::TCP) ? IPPROTO_TCP : IPPROTO_UDP;
-    hints.ai_flags =
-        (_ip_type == IpType::IPv4) ? (AI_ADDRCONFIG | AI_PASSIVE | AI_V4MAPPED) : (AI_ADDRCONFIG | AI_PASSIVE | AI_ALL);
-
-    addrinfo *result = nullptr;
-#if defined(_WIN32)
-    char name[INET6_ADDRSTRLEN] = {0};
-
-    if (clientAddr.ss_family == AF_INET)
-        inet_ntop(AF_INET, &(((sockaddr_in *) &clientAddr)->sin_addr), name, INET_ADDRSTRLEN);
-    else
-        inet_ntop(AF_INET6, &(((sockaddr_in6 *) &clientAddr)->sin6_addr), name, INET6_ADDRSTRLEN);
-#else
-    const char *name = inet_ntoa(((sockaddr_in *) &clientAddr)->sin_addr);
-#endif
-
-    const std::string serviceStr = std::to_string(ntohs(((sockaddr_in *) &clientAddr)->sin_port));
+    _ip_type = ip_type;
+}
 
-    if (getaddrinfo(name, serviceStr.c_str(), &hints, &result) != 0)
+Address::Address(const Endpoint &endpoint, SocketType socket_type)
+    : _socket_type(socket_type), _ip_type(endpoint.family == 6 ? IpType::IPv6 : IpType::IPv4)
+{
+    // one block for the addrinfo and its address, owned through the aliasing shared_ptr
+    struct Storage {
+        addrinfo info;
+        sockaddr_storage address;
+    };
+
+    auto storage = std::make_shared<Storage>();
+    socklen_t length = endpoint.toSockAddr(storage->address);
+    if (length == 0)
     {
-        FLAKKARI_LOG_ERROR("getaddrinfo() failed");
+        FLAKKARI_LOG_ERROR("Invalid endpoint");
         return;
     }
 
-    _addrInfo = std::shared_ptr<addrinfo>(result, [](addrinfo *addrInfo) {
-        if (addrInfo != nullptr)
-            freeaddrinfo(addrInfo);
-    });
+    storage->info = {};
+    storage->info.ai_family = storage->address.ss_family;
+    storage->info.ai_socktype = (_socket_type == SocketType::TCP) ? SOCK_STREAM : SOCK_DGRAM;
+    storage->info.ai_protocol = (_socket_type == SocketType::TCP) ? IPPROTO_TCP : IPPROTO_UDP;
+    storage->info.ai_addrlen = length;
+    storage->info.ai_addr = reinterpret_cast<sockaddr *>(&storage->address);
+    _addrInfo = std::shared_ptr<addrinfo>(storage, &storage->info);
 }
 
 std::optional<std::string> Address::toString() const
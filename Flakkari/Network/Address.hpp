@@ -34,6 +34,7 @@
 #include <string>
 
 #include "../Logger/Logger.hpp"
+#include "Endpoint.hpp"
 
 namespace Flakkari::Network {
 
@@ -78,6 +79,15 @@ public:
     Address(port_t port, SocketType socket_type, IpType ip_type);
     Address(const sockaddr_in &clientAddr, SocketType socket_type, IpType ip_type);
     Address(const sockaddr_storage &clientAddr, SocketType socket_type, IpType ip_type);
+
+    /**
+     * @brief Construct the Address of a peer from its endpoint, without any
+     * resolution (the addrinfo is filled from the endpoint)
+     *
+     * @param endpoint  The family, ip and port of the peer
+     * @param socket_type  The socket type
+     */
+    Address(const Endpoint &endpoint, SocketType socket_type);
     Address(const Address &) = default;
     Address(Address &&) = default;
     Address() = default;
@@ -136,6 +146,16 @@ public:
      */
     [[nodiscard]] port_t getPort() const { return ntohs(getSockAddrIn()->sin_port); }
 
+    /**
+     * @brief Get the Endpoint of the Address (family, ip and port)
+     *
+     * @return Endpoint  The endpoint, of family 0 if the Address is not valid
+     */
+    [[nodiscard]] Endpoint getEndpoint() const
+    {
+        return _addrInfo ? Endpoint::from(_addrInfo->ai_addr) : Endpoint{};
+    }
+
     /**
      * @brief Get the Socket Type object
      *
@@ -8,6 +8,9 @@
 */
 
 #include "Buffer.hpp"
+#include "Kernels.hpp"
+
+#include <stdexcept>
 
 namespace Flakkari::Network {
 
@@ -32,22 +35,11 @@ Buffer Buffer::extractData(std::size_t offset, std::size_t length) const
 
 void Buffer::concat(const Buffer &otherBuffer) { insert(end(), otherBuffer.begin(), otherBuffer.end()); }
 
-uint16_t Buffer::calculateChecksum() const
-{
-    uint16_t checksum = 0;
-
-    for (const auto &byte : *this)
-        checksum += byte;
-
-    return checksum;
-}
+uint32_t Buffer::calculateChecksum() const { return Kernels::get().crc32c(0, data(), size()); }
 
 void Buffer::bitwiseXOR(const Buffer &otherBuffer)
 {
-    std::size_t minSize = std::min(size(), otherBuffer.size());
-
-    for (std::size_t i = 0; i < minSize; ++i)
-        (*this)[i] ^= otherBuffer[i];
+    Kernels::get().bitwiseXOR(data(), otherBuffer.data(), std::min(size(), otherBuffer.size()));
 }
 
 void Buffer::runLengthEncode()
@@ -91,26 +83,21 @@ void Buffer::runLengthDecode()
 
 void Buffer::convertToHex()
 {
-    Buffer hexBuffer;
+    Buffer hexBuffer(size() * 2);
 
-    for (const auto &byte : *this)
-    {
-        hexBuffer.push_back(byte / 16);
-        hexBuffer.push_back(byte % 16);
-    }
-    std::copy(hexBuffer.begin(), hexBuffer.end(), begin());
+    Kernels::get().toHex(data(), size(), hexBuffer.data());
+    swap(hexBuffer);
 }
 
 void Buffer::convertFromHex()
 {
-    Buffer hexBuffer;
+    if (size() % 2 != 0)
+        throw std::invalid_argument("Buffer::convertFromHex: odd number of digits");
 
-    for (std::size_t i = 0; i < size(); i += 2)
-    {
-        byte currentByte = (*this)[i] * 16 + (*this)[i + 1];
-        hexBuffer.push_back(currentByte);
-    }
-    std::copy(hexBuffer.begin(), hexBuffer.end(), begin());
+    Buffer binaryBuffer(size() / 2);
+    if (!Kernels::get().fromHex(data(), binaryBuffer.size(), binaryBuffer.data()))
+        throw std::invalid_argument("Buffer::convertFromHex: invalid digit");
+    swap(binaryBuffer);
 }
 
 Buffer::operator byte *() { return data(); }
@@ -128,7 +115,7 @@ Buffer Buffer::operator+(const Buffer &otherBuffer) const
     return newBuffer;
 }
 
-Buffer Buffer::operator+=(const Buffer &otherBuffer)
+Buffer &Buffer::operator+=(const Buffer &otherBuffer)
 {
     concat(otherBuffer);
     return *this;
@@ -141,7 +128,7 @@ Buffer Buffer::operator-(const Buffer &otherBuffer) const
     return newBuffer;
 }
 
-Buffer Buffer::operator-=(const Buffer &otherBuffer)
+Buffer &Buffer::operator-=(const Buffer &otherBuffer)
 {
     for (const auto &byte : otherBuffer)
         erase(std::find(begin(), end(), byte));
@@ -0,0 +1,160 @@
+/*
+** EPITECH PROJECT, 2024
+** Title: Flakkari
+** Author: MasterLaplace
+** Created: 2024-10-19
+** File description:
+** BufferPool
+*/
+
+#include "BufferPool.hpp"
+
+#include <cstring>
+
+namespace Flakkari::Network {
+
+BufferView::BufferView(BufferSlab *slab, const byte *data, std::size_t size) : _slab(slab), _data(data), _size(size)
+{
+    if (_slab)
+        _slab->references.fetch_add(1, std::memory_order_relaxed);
+}
+
+BufferView::BufferView(const BufferView &other) : BufferView(other._slab, other._data, other._size) {}
+
+BufferView::BufferView(BufferView &&other) noexcept : _slab(other._slab), _data(other._data), _size(other._size)
+{
+    other._slab = nullptr;
+    other._data = nullptr;
+    other._size = 0;
+}
+
+BufferView &BufferView::operator=(const BufferView &other)
+{
+    if (this != &other)
+        *this = BufferView(other);
+    return *this;
+}
+
+BufferView &BufferView::operator=(BufferView &&other) noexcept
+{
+    if (this == &other)
+        return *this;
+    release();
+    _slab = other._slab;
+    _data = other._data;
+    _size = other._size;
+    other._slab = nullptr;
+    other._data = nullptr;
+    other._size = 0;
+    return *this;
+}
+
+BufferView::~BufferView() { release(); }
+
+void BufferView::release()
+{
+    if (_slab)
+        BufferPool::release(_slab);
+    _slab = nullptr;
+}
+
+BufferView BufferView::copyOf(const byte *data, std::size_t size)
+{
+    auto slab = new BufferSlab();
+    slab->storage = std::make_unique<byte[]>(size);
+    slab->data = slab->storage.get();
+    slab->capacity = size;
+    slab->references = 1;
+    if (size != 0)
+        std::memcpy(slab->data, data, size);
+
+    BufferView view(slab, slab->data, size);
+    BufferPool::release(slab);
+    return view;
+}
+
+BufferView BufferView::subview(std::size_t offset, std::size_t length) const
+{
+    if (offset >= _size)
+        return {};
+    return BufferView(_slab, _data + offset, std::min(length, _size - offset));
+}
+
+std::shared_ptr<BufferPool> BufferPool::create(std::size_t slabs, std::size_t slabSize)
+{
+    return std::make_shared<BufferPool>(slabs, slabSize);
+}
+
+BufferPool::BufferPool(std::size_t slabs, std::size_t slabSize)
+    : _slabSize(slabSize), _memory(new byte[slabs * slabSize]) // not zeroed: the pages are touched on first receive
+{
+    _slabs.reserve(slabs);
+    _free.reserve(slabs);
+    for (std::size_t i = 0; i < slabs; ++i)
+    {
+        auto slab = std::make_unique<BufferSlab>();
+        slab->data = _memory.get() + i * slabSize;
+        slab->capacity = slabSize;
+        _free.push_back(slab.get());
+        _slabs.push_back(std::move(slab));
+    }
+}
+
+std::size_t BufferPool::acquire(BufferSlab **slabs, std::size_t count)
+{
+    std::size_t taken = 0;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        while (taken < count && !_free.empty())
+        {
+            slabs[taken++] = _free.back();
+            _free.pop_back();
+        }
+    }
+
+    auto self = shared_from_this();
+    for (std::size_t i = 0; i < taken; ++i)
+    {
+        slabs[i]->references.store(1, std::memory_order_relaxed);
+        slabs[i]->pool = self;
+    }
+    if (taken != 0 || count == 0)
+        return taken;
+
+    _fallbacks.fetch_add(1, std::memory_order_relaxed);
+    auto slab = new BufferSlab();
+    slab->storage.reset(new byte[_slabSize]);
+    slab->data = slab->storage.get();
+    slab->capacity = _slabSize;
+    slab->references.store(1, std::memory_order_relaxed);
+    slabs[0] = slab;
+    return 1;
+}
+
+void BufferPool::release(BufferSlab *slab)
+{
+    if (slab->references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+    if (!slab->pool)
+    {
+        delete slab;
+        return;
+    }
+    // the slab may hold the last reference on its pool: keep it alive until the slab is back
+    auto pool = std::move(slab->pool);
+    pool->recycle(slab);
+}
+
+void BufferPool::recycle(BufferSlab *slab)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _free.push_back(slab);
+}
+
+std::size_t BufferPool::getFreeCount()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _free.size();
+}
+
+} // namespace Flakkari::Network
@@ -0,0 +1,199 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file BufferPool.hpp
+ * @brief This file contains the BufferPool and BufferView classes. The pool
+ *        owns a fixed set of receive slabs, the views reference slices of a
+ *        slab and give it back to the pool when the last of them is gone.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef FLAKKARI_BUFFERPOOL_HPP_
+#define FLAKKARI_BUFFERPOOL_HPP_
+
+#include "Buffer.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Flakkari::Network {
+
+class BufferPool;
+
+/**
+ * @brief A receive buffer of a BufferPool, or of the heap when the pool is
+ * empty. It is counted by the views that reference it.
+ */
+struct BufferSlab {
+    std::atomic<uint32_t> references = 0; // Views referencing the slab
+    byte *data = nullptr;                 // First byte of the slab
+    std::size_t capacity = 0;             // Size of the slab in bytes
+    std::shared_ptr<BufferPool> pool;     // Pool to give it back to, set while in use (nullptr for the heap)
+    std::unique_ptr<byte[]> storage;      // Memory of a heap slab
+};
+
+/**
+ * @brief Read-only slice of a receive slab
+ *
+ * @details A BufferView is what a Buffer is to a received datagram without
+ * the copy: a pointer and a size in a slab of a BufferPool, plus a counted
+ * reference to the slab. Copying a view only increments the counter of the
+ * slab (no allocation), and the slab goes back to its pool when the last
+ * view referencing it is destroyed, whichever thread it is on.
+ *
+ * @example "Flakkari/Network/BufferPool.hpp"
+ * @code
+ * auto pool = BufferPool::create(256, 4096);
+ * std::vector<std::pair<Endpoint, BufferView>> datagrams;
+ * socket->receiveBatch(*pool, datagrams, 64);
+ * auto header = datagrams[0].second.subview(0, 12);
+ * @endcode
+ */
+class BufferView {
+public:
+    BufferView() = default;
+
+    /**
+     * @brief Construct a view of a slice of a slab, which is referenced one
+     * more time
+     *
+     * @param slab  The slab of the slice
+     * @param data  The first byte of the slice, in the slab
+     * @param size  The size of the slice
+     */
+    BufferView(BufferSlab *slab, const byte *data, std::size_t size);
+
+    BufferView(const BufferView &other);
+    BufferView(BufferView &&other) noexcept;
+    BufferView &operator=(const BufferView &other);
+    BufferView &operator=(BufferView &&other) noexcept;
+    ~BufferView();
+
+    /**
+     * @brief Copy bytes in a heap slab of their own, for the data that was
+     * not received in a pool
+     *
+     * @param data  The bytes to copy
+     * @param size  The number of bytes
+     * @return BufferView  A view of the whole copy
+     */
+    [[nodiscard]] static BufferView copyOf(const byte *data, std::size_t size);
+    [[nodiscard]] static BufferView copyOf(const Buffer &buffer) { return copyOf(buffer.data(), buffer.size()); }
+
+    [[nodiscard]] const byte *data() const { return _data; }
+    [[nodiscard]] std::size_t size() const { return _size; }
+    [[nodiscard]] bool empty() const { return _size == 0; }
+    [[nodiscard]] const byte *begin() const { return _data; }
+    [[nodiscard]] const byte *end() const { return _data + _size; }
+    [[nodiscard]] byte operator[](std::size_t index) const { return _data[index]; }
+
+    /**
+     * @brief Get a view of a slice of this view, on the same slab
+     *
+     * @param offset  Offset of the slice in the view
+     * @param length  Length of the slice, clamped to the end of the view
+     * @return BufferView  The slice, empty if offset is past the end
+     */
+    [[nodiscard]] BufferView subview(std::size_t offset, std::size_t length) const;
+
+    /**
+     * @brief Copy the bytes of the view in a Buffer
+     *
+     * @return Buffer  The copy
+     */
+    [[nodiscard]] Buffer toBuffer() const { return Buffer(_data, _data + _size); }
+
+private:
+    void release();
+
+private:
+    BufferSlab *_slab = nullptr; // Referenced slab, nullptr for an empty view
+    const byte *_data = nullptr; // First byte of the slice
+    std::size_t _size = 0;       // Size of the slice
+};
+
+/**
+ * @brief Fixed pool of receive slabs
+ *
+ * @details The slabs are allocated once, in one block, when the pool is
+ * created. Socket::receiveBatch takes the slabs of a batch in one lock,
+ * receives the datagrams in them and hands out BufferViews, so that the
+ * bytes of a datagram are never copied nor allocated between the kernel and
+ * the game thread that releases the packet. When every slab is in use (the
+ * game threads are late), acquire() falls back to a slab of the heap, freed
+ * instead of recycled, and counts it.
+ *
+ * The pool is always owned by a shared pointer (see create()): a slab in
+ * use keeps its pool alive, so the views may outlive the owner of the pool.
+ */
+class BufferPool : public std::enable_shared_from_this<BufferPool> {
+public:
+    /**
+     * @brief Create a pool
+     *
+     * @param slabs  The number of slabs
+     * @param slabSize  The size of a slab in bytes (the largest datagram, or GRO message, to receive)
+     * @return std::shared_ptr<BufferPool>  The pool
+     */
+    [[nodiscard]] static std::shared_ptr<BufferPool> create(std::size_t slabs, std::size_t slabSize);
+
+    BufferPool(std::size_t slabs, std::size_t slabSize);
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+    ~BufferPool() = default;
+
+    /**
+     * @brief Take up to `count` free slabs in one lock. Each slab comes with
+     * one reference, owned by the caller: it makes BufferViews of the slab,
+     * then calls release() on it, which gives back the slabs it did not use.
+     *
+     * @param slabs  Where to write the slabs
+     * @param count  The number of slabs wanted
+     * @return std::size_t  The number of slabs taken, at least 1 (a heap slab when the pool is empty)
+     */
+    std::size_t acquire(BufferSlab **slabs, std::size_t count);
+
+    /**
+     * @brief Drop a reference on a slab, and give it back to its pool (or
+     * free it for a heap slab) if it was the last one.
+     *
+     * @param slab  The slab
+     */
+    static void release(BufferSlab *slab);
+
+    [[nodiscard]] std::size_t getSlabSize() const { return _slabSize; }
+    [[nodiscard]] std::size_t getSlabCount() const { return _slabs.size(); }
+
+    /**
+     * @brief Get the number of slabs currently free
+     */
+    [[nodiscard]] std::size_t getFreeCount();
+
+    /**
+     * @brief Get the number of heap slabs allocated because the pool was empty
+     */
+    [[nodiscard]] uint64_t getFallbackCount() const { return _fallbacks.load(std::memory_order_relaxed); }
+
+private:
+    void recycle(BufferSlab *slab);
+
+private:
+    std::size_t _slabSize;                           // Size of a slab in bytes
+    std::unique_ptr<byte[]> _memory;                 // The slabs' bytes, one block
+    std::vector<std::unique_ptr<BufferSlab>> _slabs; // Every slab of the pool
+    std::vector<BufferSlab *> _free;                 // Slabs not in use
+    std::mutex _mutex;                               // Lock of _free
+    std::atomic<uint64_t> _fallbacks = 0;            // Heap slabs allocated
+};
+
+} // namespace Flakkari::Network
+
+#endif /* !FLAKKARI_BUFFERPOOL_HPP_ */
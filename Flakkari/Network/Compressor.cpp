@@ -0,0 +1,305 @@
+/*
+** EPITECH PROJECT, 2024
+** Title: Flakkari
+** Author: MasterLaplace
+** Created: 2024-10-19
+** File description:
+** Compressor
+*/
+
+#include "Compressor.hpp"
+
+#include <bit>
+#include <cstring>
+
+namespace Flakkari::Network {
+
+namespace {
+
+inline uint32_t read32(const byte *data)
+{
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline uint64_t read64(const byte *data)
+{
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline std::size_t hash(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - Compressor::HASH_LOG); }
+
+/**
+ * @brief Write a length of a token: the part over 15 in bytes of 255, then
+ * the rest
+ */
+inline byte *writeLength(byte *op, std::size_t length)
+{
+    for (length -= 15; length >= 255; length -= 255)
+        *op++ = 255;
+    *op++ = static_cast<byte>(length);
+    return op;
+}
+
+/**
+ * @brief Read the extension of a length of a token
+ *
+ * @return bool  false if the block ends in the middle of it
+ */
+inline bool readLength(const byte *&ip, const byte *end, std::size_t &length)
+{
+    byte next;
+
+    do
+    {
+        if (ip >= end)
+            return false;
+        next = *ip++;
+        length += next;
+    } while (next == 255);
+    return true;
+}
+
+/**
+ * @brief Write a sequence: the literals from `literals`, then a match of
+ * `length` bytes at `distance` (none if `length` is 0, for the last sequence)
+ *
+ * @return byte*  The end of the sequence, nullptr if it does not fit before `end`
+ */
+byte *writeSequence(byte *op, byte *end, const byte *literals, std::size_t count, std::size_t distance,
+                    std::size_t length)
+{
+    if (static_cast<std::size_t>(end - op) < 1 + count + count / 255 + 1 + (length > 0 ? 2 + length / 255 + 1 : 0))
+        return nullptr;
+
+    byte *token = op++;
+    *token = static_cast<byte>(std::min<std::size_t>(count, 15) << 4);
+    if (count >= 15)
+        op = writeLength(op, count);
+    std::memcpy(op, literals, count);
+    op += count;
+    if (length == 0)
+        return op;
+
+    *op++ = static_cast<byte>(distance);
+    *op++ = static_cast<byte>(distance >> 8);
+    length -= Compressor::MIN_MATCH;
+    *token |= static_cast<byte>(std::min<std::size_t>(length, 15));
+    if (length >= 15)
+        op = writeLength(op, length);
+    return op;
+}
+
+} // namespace
+
+Compressor::Compressor(const byte *dictionary, std::size_t size)
+{
+    if (dictionary == nullptr || size == 0)
+        return;
+
+    // a match reaches MAX_DISTANCE back from its input at most: the start of a larger dictionary is never used
+    _dictionarySize = std::min(size, MAX_DISTANCE);
+    _dictionary = dictionary + size - _dictionarySize;
+
+    // FNV-1a, 0 is kept for the empty dictionary
+    _dictionaryId = 2166136261u;
+    for (std::size_t i = 0; i < _dictionarySize; ++i)
+        _dictionaryId = (_dictionaryId ^ _dictionary[i]) * 16777619u;
+    if (_dictionaryId == NO_DICTIONARY)
+        _dictionaryId = 1;
+
+    // the last occurrence wins: the nearest is as good as any other, a distance costs 2 bytes whatever it is
+    for (std::size_t i = 0; i + MIN_MATCH <= _dictionarySize; ++i)
+        _dictionaryTable[hash(read32(_dictionary + i))] = static_cast<uint32_t>(i + 1);
+}
+
+std::size_t Compressor::count(const byte *ip, std::size_t source, const byte *src, const byte *limit) const
+{
+    const byte *start = ip;
+
+    // a match in the dictionary goes on in the input if it reaches the end of the dictionary
+    if (source < _dictionarySize)
+    {
+        const byte *match = _dictionary + source;
+        const byte *dictionaryEnd = _dictionary + _dictionarySize;
+
+        while (ip < limit && match < dictionaryEnd && *ip == *match)
+            ++ip, ++match;
+        if (match != dictionaryEnd || ip == limit)
+            return static_cast<std::size_t>(ip - start);
+        source = _dictionarySize;
+    }
+
+    const byte *match = src + (source - _dictionarySize);
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        for (; ip + sizeof(uint64_t) <= limit; ip += sizeof(uint64_t), match += sizeof(uint64_t))
+        {
+            if (uint64_t diff = read64(ip) ^ read64(match); diff != 0)
+                return static_cast<std::size_t>(ip - start) + std::countr_zero(diff) / 8;
+        }
+    }
+    while (ip < limit && *ip == *match)
+        ++ip, ++match;
+    return static_cast<std::size_t>(ip - start);
+}
+
+std::size_t Compressor::find(const byte *ip, const byte *src, uint32_t base, const byte *limit, std::size_t &distance)
+{
+    auto position = static_cast<std::size_t>(ip - src);
+    uint32_t sequence = read32(ip);
+    auto slot = hash(sequence);
+    std::size_t length = 0;
+
+    // the best of the last occurrence in the input and the one in the dictionary
+    if (uint32_t last = _table[slot]; last >= base && read32(src + (last - base)) == sequence)
+    {
+        distance = position - (last - base);
+        length = MIN_MATCH + count(ip + MIN_MATCH, _dictionarySize + position - distance + MIN_MATCH, src, limit);
+    }
+    if (uint32_t last = _dictionaryTable[slot]; last != 0)
+    {
+        std::size_t source = last - 1;
+        std::size_t far = position + _dictionarySize - source;
+
+        if (far <= MAX_DISTANCE && read32(_dictionary + source) == sequence)
+        {
+            std::size_t farLength = MIN_MATCH + count(ip + MIN_MATCH, source + MIN_MATCH, src, limit);
+            if (farLength > length)
+                length = farLength, distance = far;
+        }
+    }
+    _table[slot] = base + static_cast<uint32_t>(position);
+    return length;
+}
+
+std::size_t Compressor::compress(const byte *src, std::size_t size, byte *dst, std::size_t capacity)
+{
+    if (size == 0 || size > MAX_SIZE)
+        return 0;
+
+    // the positions of the last inputs are below the base of this one: they are never matched, without a clear
+    if (_base > UINT32_MAX - MAX_SIZE)
+    {
+        _table.fill(0);
+        _base = 1;
+    }
+    uint32_t base = _base;
+    _base += static_cast<uint32_t>(size);
+
+    const byte *ip = src;
+    const byte *anchor = src; // Start of the literals of the next sequence
+    const byte *end = src + size;
+    const byte *matchEnd = end - std::min(size, LAST_LITERALS);
+    byte *op = dst;
+    byte *opEnd = dst + capacity;
+
+    while (size > MATCH_LIMIT && ip + MATCH_LIMIT <= end)
+    {
+        std::size_t distance = 0;
+        std::size_t length = find(ip, src, base, matchEnd, distance);
+
+        if (length == 0)
+        {
+            ip += 1 + (static_cast<std::size_t>(ip - anchor) >> SKIP_TRIGGER);
+            continue;
+        }
+
+        // lazy matching: a longer match one byte further is worth a literal (a short match of the dictionary
+        // would otherwise cut a long one of the input)
+        for (std::size_t nextDistance = 0; ip + 1 + MATCH_LIMIT <= end; ++ip)
+        {
+            std::size_t next = find(ip + 1, src, base, matchEnd, nextDistance);
+            if (next <= length)
+                break;
+            length = next;
+            distance = nextDistance;
+        }
+
+        // the match may start in the literals before it
+        auto position = static_cast<std::size_t>(ip - src);
+        for (std::size_t source = _dictionarySize + position - distance; ip > anchor && source > 0; --source)
+        {
+            byte previous = source - 1 < _dictionarySize ? _dictionary[source - 1] : src[source - 1 - _dictionarySize];
+            if (previous != ip[-1])
+                break;
+            --ip;
+            ++length;
+        }
+
+        op = writeSequence(op, opEnd, anchor, static_cast<std::size_t>(ip - anchor), distance, length);
+        if (op == nullptr)
+            return 0;
+        ip += length;
+        anchor = ip;
+
+        // the position before the end of the match is likely to start the next one
+        if (ip + MATCH_LIMIT <= end)
+            _table[hash(read32(ip - 2))] = base + static_cast<uint32_t>(ip - 2 - src);
+    }
+
+    op = writeSequence(op, opEnd, anchor, static_cast<std::size_t>(end - anchor), 0, 0);
+    return op == nullptr ? 0 : static_cast<std::size_t>(op - dst);
+}
+
+std::size_t Compressor::decompress(const byte *src, std::size_t size, byte *dst, std::size_t capacity) const
+{
+    const byte *ip = src;
+    const byte *end = src + size;
+    byte *op = dst;
+    byte *opEnd = dst + capacity;
+
+    while (ip < end)
+    {
+        byte token = *ip++;
+        std::size_t count = token >> 4;
+
+        if (count == 15 && !readLength(ip, end, count))
+            return 0;
+        if (count > static_cast<std::size_t>(end - ip) || count > static_cast<std::size_t>(opEnd - op))
+            return 0;
+        std::memcpy(op, ip, count);
+        op += count;
+        ip += count;
+        if (ip == end)
+            break; // the last sequence has no match
+
+        if (end - ip < 2)
+            return 0;
+        std::size_t distance = ip[0] | (static_cast<std::size_t>(ip[1]) << 8);
+        ip += 2;
+        std::size_t length = token & 15;
+        if (length == 15 && !readLength(ip, end, length))
+            return 0;
+        length += MIN_MATCH;
+
+        auto produced = static_cast<std::size_t>(op - dst);
+        if (distance == 0 || distance > produced + _dictionarySize || length > static_cast<std::size_t>(opEnd - op))
+            return 0;
+
+        // the part of the match in the dictionary, then the rest in the output
+        if (distance > produced)
+        {
+            std::size_t back = distance - produced;
+            std::size_t copied = std::min(back, length);
+            std::memcpy(op, _dictionary + _dictionarySize - back, copied);
+            op += copied;
+            length -= copied;
+            if (length == 0)
+                continue;
+        }
+        const byte *match = op - distance;
+        if (distance >= length)
+            std::memcpy(op, match, length);
+        else
+            for (std::size_t i = 0; i < length; ++i)
+                op[i] = match[i]; // the match overlaps the bytes it produces (a repeated pattern)
+        op += length;
+    }
+    return static_cast<std::size_t>(op - dst);
+}
+
+} // namespace Flakkari::Network
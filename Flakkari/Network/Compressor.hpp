@@ -0,0 +1,136 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file Compressor.hpp
+ * @brief This file contains the Compressor class. It compresses small
+ *        buffers, such as datagrams, in the LZ4 block format, with an
+ *        optional dictionary shared by both sides of a connection.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef FLAKKARI_COMPRESSOR_HPP_
+#define FLAKKARI_COMPRESSOR_HPP_
+
+#include "Buffer.hpp"
+
+#include <array>
+
+namespace Flakkari::Network {
+
+/**
+ * @brief Fast dictionary compressor of small buffers (LZ4 block format)
+ *
+ * @details A compressed block is a list of sequences: a token, literals
+ * copied as is, then a match, a copy of bytes already produced given by its
+ * distance and its length. The greedy compressor finds the matches with a
+ * hash table of 4 bytes sequences: it runs at memory speed, trading ratio
+ * for CPU time, as a server compressing the datagrams of every tick has to.
+ *
+ * A datagram is too small to repeat much of itself: the dictionary is a
+ * block of bytes seen as if it preceded every input, so that the matches
+ * find the usual content of the datagrams (headers, ids, template names)
+ * from the first byte. Both sides must use the same dictionary, which is
+ * not copied and must outlive the compressor: getDictionaryId() tells which
+ * one it is. Only the last 64 KiB of a dictionary can be referenced.
+ *
+ * The decompressor checks every length and distance against its input and
+ * output: an invalid or hostile block is rejected, never read or written
+ * out of bounds.
+ *
+ * @example "Flakkari/Network/Compressor.hpp"
+ * @code
+ * Compressor compressor(dictionary, sizeof(dictionary));
+ * Buffer compressed(Compressor::bound(datagram.size()));
+ * compressed.resize(compressor.compress(datagram.data(), datagram.size(), compressed.data(), compressed.size()));
+ * compressor.decompress(compressed.data(), compressed.size(), datagram.data(), datagram.size());
+ * @endcode
+ */
+class Compressor {
+public:
+    static constexpr std::size_t MAX_SIZE = 65535;     // Largest buffer compressed
+    static constexpr std::size_t MAX_DISTANCE = 65535; // Farthest match (its distance is written on 16 bits)
+    static constexpr std::size_t MIN_MATCH = 4;        // Shortest match
+    static constexpr std::size_t LAST_LITERALS = 5;    // A block ends with at least 5 literals
+    static constexpr std::size_t MATCH_LIMIT = 12;     // A match starts at least 12 bytes before the end
+    static constexpr std::size_t HASH_LOG = 12;        // 4096 entries per hash table
+    static constexpr std::size_t SKIP_TRIGGER = 6;     // The search speeds up after 64 bytes without a match
+    static constexpr uint32_t NO_DICTIONARY = 0;       // Id of the empty dictionary
+
+public:
+    /**
+     * @brief Construct a new Compressor object, with its dictionary
+     *
+     * @param dictionary  The dictionary (not copied), or nullptr for none
+     * @param size  The size of the dictionary
+     */
+    explicit Compressor(const byte *dictionary = nullptr, std::size_t size = 0);
+
+    /**
+     * @brief Get the size of the largest block an input of `size` bytes can
+     * compress to (incompressible input)
+     */
+    static constexpr std::size_t bound(std::size_t size) { return size + size / 255 + 16; }
+
+    /**
+     * @brief Compress a buffer
+     *
+     * @param src  The buffer to compress
+     * @param size  The size of the buffer (MAX_SIZE at most)
+     * @param dst  The block to write
+     * @param capacity  The size of the block at most
+     * @return std::size_t  The size of the block, 0 if it is larger than `capacity` (or the input empty or too large)
+     */
+    std::size_t compress(const byte *src, std::size_t size, byte *dst, std::size_t capacity);
+
+    /**
+     * @brief Decompress a block compressed with the same dictionary
+     *
+     * @param src  The block
+     * @param size  The size of the block
+     * @param dst  The buffer to write
+     * @param capacity  The size of the buffer at most
+     * @return std::size_t  The size of the buffer, 0 if the block is invalid or does not fit in `capacity`
+     */
+    std::size_t decompress(const byte *src, std::size_t size, byte *dst, std::size_t capacity) const;
+
+    /**
+     * @brief Get the id of the dictionary: a hash of its content, that the
+     * peers compare to know they have the same (NO_DICTIONARY for none)
+     */
+    [[nodiscard]] uint32_t getDictionaryId() const { return _dictionaryId; }
+
+    [[nodiscard]] std::size_t getDictionarySize() const { return _dictionarySize; }
+
+private:
+    /**
+     * @brief Find the longest match of the position `ip` of the input `src`,
+     * and add the position to the hash table of the input
+     *
+     * @return std::size_t  The length of the match (0 if none), whose distance is written to `distance`
+     */
+    std::size_t find(const byte *ip, const byte *src, uint32_t base, const byte *limit, std::size_t &distance);
+
+    /**
+     * @brief Count the bytes from `ip` equal to the ones from `source`, an
+     * index in the dictionary followed by the input
+     */
+    std::size_t count(const byte *ip, std::size_t source, const byte *src, const byte *limit) const;
+
+private:
+    const byte *_dictionary = nullptr; // Last bytes of the dictionary, seen before the input
+    std::size_t _dictionarySize = 0;   // Size of the dictionary (MAX_DISTANCE at most)
+    uint32_t _dictionaryId = NO_DICTIONARY;
+    std::array<uint32_t, 1 << HASH_LOG> _dictionaryTable{}; // Hash of 4 bytes -> position in the dictionary + 1
+    std::array<uint32_t, 1 << HASH_LOG> _table{};           // Hash of 4 bytes -> position in an input + its base
+    uint32_t _base = 1;                                     // Base of the positions of the next input
+};
+
+} // namespace Flakkari::Network
+
+#endif /* !FLAKKARI_COMPRESSOR_HPP_ */
@@ -0,0 +1,68 @@
+/*
+** EPITECH PROJECT, 2024
+** Title: Flakkari
+** Author: MasterLaplace
+** Created: 2024-10-19
+** File description:
+** Endpoint
+*/
+
+#include "Endpoint.hpp"
+
+namespace Flakkari::Network {
+
+Endpoint Endpoint::from(const sockaddr *address)
+{
+    Endpoint endpoint;
+
+    if (address->sa_family == AF_INET)
+    {
+        const auto *in = reinterpret_cast<const sockaddr_in *>(address);
+        endpoint.family = 4;
+        endpoint.port = in->sin_port;
+        std::memcpy(endpoint.ip, &in->sin_addr, sizeof(in->sin_addr));
+    }
+    else if (address->sa_family == AF_INET6)
+    {
+        const auto *in6 = reinterpret_cast<const sockaddr_in6 *>(address);
+        endpoint.family = 6;
+        endpoint.port = in6->sin6_port;
+        std::memcpy(endpoint.ip, &in6->sin6_addr, sizeof(in6->sin6_addr));
+    }
+    return endpoint;
+}
+
+socklen_t Endpoint::toSockAddr(sockaddr_storage &address) const
+{
+    std::memset(&address, 0, sizeof(address));
+    if (family == 4)
+    {
+        auto *in = reinterpret_cast<sockaddr_in *>(&address);
+        in->sin_family = AF_INET;
+        in->sin_port = port;
+        std::memcpy(&in->sin_addr, ip, sizeof(in->sin_addr));
+        return sizeof(sockaddr_in);
+    }
+    if (family == 6)
+    {
+        auto *in6 = reinterpret_cast<sockaddr_in6 *>(&address);
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port = port;
+        std::memcpy(&in6->sin6_addr, ip, sizeof(in6->sin6_addr));
+        return sizeof(sockaddr_in6);
+    }
+    return 0;
+}
+
+std::string Endpoint::toString() const
+{
+    char host[INET6_ADDRSTRLEN] = {0};
+
+    if (family == 0 || inet_ntop(family == 4 ? AF_INET : AF_INET6, ip, host, sizeof(host)) == nullptr)
+        return "null";
+    if (family == 6)
+        return "[" + std::string(host) + "]:" + std::to_string(getPort());
+    return std::string(host) + ":" + std::to_string(getPort());
+}
+
+} // namespace Flakkari::Network
@@ -0,0 +1,125 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file Endpoint.hpp
+ * @brief This file contains the Endpoint struct: the family, ip and port of
+ *        a peer as a trivially copyable key, with a fast hash.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef FLAKKARI_ENDPOINT_HPP_
+#define FLAKKARI_ENDPOINT_HPP_
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#    include <arpa/inet.h>
+#    include <netdb.h>
+#else
+#    define WIN32_LEAN_AND_MEAN
+#    define _WINSOCK_DEPRECATED_NO_WARNINGS
+#    define _CRT_SECURE_NO_WARNINGS
+#    include <ws2tcpip.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace Flakkari::Network {
+
+/**
+ * @brief Address of a peer as a key: family, ip bytes and port
+ *
+ * @details An Endpoint is read from the sockaddr of a received datagram
+ * with a few copies: no allocation, no formatting and no resolution, unlike
+ * Address. It is what the server uses to find the client of a datagram (see
+ * EndpointMap); an Address is only made for a new client, to send to it.
+ *
+ * @example "Flakkari/Network/Endpoint.hpp"
+ * @code
+ * sockaddr_storage storage = ...; // filled by recvmmsg
+ * auto endpoint = Flakkari::Network::Endpoint::from(storage);
+ * auto client = clients.find(endpoint);
+ * @endcode
+ */
+struct Endpoint {
+    uint8_t family = 0; // 4 for IPv4, 6 for IPv6, 0 for none
+    uint8_t reserved = 0;
+    uint16_t port = 0;   // Port in network byte order
+    uint8_t ip[16] = {}; // Ip in network byte order, an IPv4 in the first 4 bytes
+
+    /**
+     * @brief Read the endpoint of a socket address
+     *
+     * @param address  The socket address (sockaddr_in or sockaddr_in6)
+     * @return Endpoint  The endpoint, of family 0 for another address family
+     */
+    [[nodiscard]] static Endpoint from(const sockaddr *address);
+    [[nodiscard]] static Endpoint from(const sockaddr_storage &address)
+    {
+        return from(reinterpret_cast<const sockaddr *>(&address));
+    }
+
+    /**
+     * @brief Write the endpoint in a socket address
+     *
+     * @param address  The socket address to fill
+     * @return socklen_t  The length of the address, 0 for an endpoint of family 0
+     */
+    socklen_t toSockAddr(sockaddr_storage &address) const;
+
+    /**
+     * @brief Format the endpoint as "ip:port" (numeric, no resolution)
+     *
+     * @return std::string  The endpoint as a string
+     */
+    [[nodiscard]] std::string toString() const;
+
+    /**
+     * @brief Get the endpoint of the ip alone (port 0), to key per ip
+     */
+    [[nodiscard]] Endpoint host() const
+    {
+        Endpoint endpoint = *this;
+        endpoint.port = 0;
+        return endpoint;
+    }
+
+    [[nodiscard]] uint16_t getPort() const { return ntohs(port); }
+
+    /**
+     * @brief Hash of the 20 bytes of the endpoint: three multiply-xorshift
+     * rounds over two 64 bit words and a 32 bit one.
+     */
+    [[nodiscard]] std::size_t hash() const
+    {
+        uint64_t a = 0;
+        uint64_t b = 0;
+        uint32_t c = 0;
+
+        std::memcpy(&a, this, sizeof(a));
+        std::memcpy(&b, reinterpret_cast<const uint8_t *>(this) + 8, sizeof(b));
+        std::memcpy(&c, reinterpret_cast<const uint8_t *>(this) + 16, sizeof(c));
+
+        uint64_t h = (a ^ 0x9E3779B97F4A7C15ull) * 0xBF58476D1CE4E5B9ull;
+        h = (h ^ (h >> 31) ^ b) * 0x94D049BB133111EBull;
+        h = (h ^ (h >> 29) ^ c) * 0xBF58476D1CE4E5B9ull;
+        return static_cast<std::size_t>(h ^ (h >> 32));
+    }
+
+    bool operator==(const Endpoint &other) const { return std::memcmp(this, &other, sizeof(Endpoint)) == 0; }
+    bool operator!=(const Endpoint &other) const { return !(*this == other); }
+};
+
+static_assert(std::is_trivially_copyable_v<Endpoint>, "Endpoint must be trivially copyable");
+static_assert(sizeof(Endpoint) == 20, "Endpoint must have no padding (it is hashed and compared as bytes)");
+
+} // namespace Flakkari::Network
+
+#endif /* !FLAKKARI_ENDPOINT_HPP_ */
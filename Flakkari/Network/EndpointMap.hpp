@@ -0,0 +1,223 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file EndpointMap.hpp
+ * @brief This file contains the EndpointMap class. It is an open addressing
+ *        hash table keyed by Endpoint, used for the client tables.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef FLAKKARI_ENDPOINTMAP_HPP_
+#define FLAKKARI_ENDPOINTMAP_HPP_
+
+#include "Endpoint.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace Flakkari::Network {
+
+/**
+ * @brief Hash table from Endpoint to T, with open addressing
+ *
+ * @details The slots are one flat array (key, value, used flag) of a power
+ * of two size, probed linearly from the hash of the key, and kept at most
+ * half full. A lookup hashes the 20 bytes of the key and compares keys of
+ * adjacent slots: no allocation and, for a hit, usually one cache line. An
+ * erase shifts the next slots of the cluster back instead of leaving a
+ * tombstone, so that lookups never slow down with churn. The table is not
+ * thread safe: the owner locks it.
+ *
+ * @tparam T  Type of the values (default constructible and movable).
+ *
+ * @example "Flakkari/Network/EndpointMap.hpp"
+ * @code
+ * EndpointMap<std::shared_ptr<Client>> clients;
+ * clients.insert(endpoint, client);
+ * if (auto *found = clients.find(endpoint))
+ *     (*found)->keepAlive();
+ * clients.eraseIf([](const Endpoint &, auto &client) { return !client->isConnected(); });
+ * @endcode
+ */
+template <typename T> class EndpointMap {
+public:
+    static constexpr std::size_t MIN_CAPACITY = 16;
+
+public:
+    explicit EndpointMap(std::size_t capacity = MIN_CAPACITY) { _slots.resize(roundCapacity(capacity)); }
+
+    /**
+     * @brief Find the value of a key
+     *
+     * @param key  The key
+     * @return T*  The value, nullptr if the key is not in the table
+     */
+    [[nodiscard]] T *find(const Endpoint &key)
+    {
+        std::size_t mask = _slots.size() - 1;
+
+        for (std::size_t i = key.hash() & mask;; i = (i + 1) & mask)
+        {
+            auto &slot = _slots[i];
+            if (!slot.used)
+                return nullptr;
+            if (slot.key == key)
+                return &slot.value;
+        }
+    }
+
+    [[nodiscard]] bool contains(const Endpoint &key) { return find(key) != nullptr; }
+
+    /**
+     * @brief Insert a value, or replace the value of a key already in the table
+     *
+     * @param key  The key
+     * @param value  The value
+     * @return T&  The value in the table
+     */
+    T &insert(const Endpoint &key, T value)
+    {
+        if ((_size + 1) * 2 > _slots.size())
+            rehash(_slots.size() * 2);
+
+        std::size_t mask = _slots.size() - 1;
+        std::size_t i = key.hash() & mask;
+        for (; _slots[i].used; i = (i + 1) & mask)
+            if (_slots[i].key == key)
+                return _slots[i].value = std::move(value);
+
+        _slots[i].key = key;
+        _slots[i].value = std::move(value);
+        _slots[i].used = true;
+        ++_size;
+        return _slots[i].value;
+    }
+
+    /**
+     * @brief Remove a key
+     *
+     * @param key  The key
+     * @return true  If the key was in the table
+     */
+    bool erase(const Endpoint &key)
+    {
+        std::size_t mask = _slots.size() - 1;
+
+        for (std::size_t i = key.hash() & mask; _slots[i].used; i = (i + 1) & mask)
+        {
+            if (_slots[i].key != key)
+                continue;
+            eraseSlot(i);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Remove the entries for which a predicate is true
+     *
+     * @param predicate  Called with the key and the value of each entry
+     * @return std::size_t  The number of entries removed
+     */
+    template <typename Predicate> std::size_t eraseIf(Predicate &&predicate)
+    {
+        std::size_t erased = 0;
+
+        for (std::size_t i = 0; i < _slots.size();)
+        {
+            if (_slots[i].used && predicate(_slots[i].key, _slots[i].value))
+            {
+                // the slot is refilled by the shift: check it again
+                eraseSlot(i);
+                ++erased;
+                continue;
+            }
+            ++i;
+        }
+        return erased;
+    }
+
+    /**
+     * @brief Call a function on each entry, in no particular order
+     *
+     * @param function  Called with the key and the value of each entry
+     */
+    template <typename Function> void forEach(Function &&function)
+    {
+        for (auto &slot : _slots)
+            if (slot.used)
+                function(slot.key, slot.value);
+    }
+
+    void clear()
+    {
+        for (auto &slot : _slots)
+            slot = Slot{};
+        _size = 0;
+    }
+
+    [[nodiscard]] std::size_t size() const { return _size; }
+    [[nodiscard]] bool empty() const { return _size == 0; }
+    [[nodiscard]] std::size_t capacity() const { return _slots.size(); }
+
+private:
+    struct Slot {
+        Endpoint key;
+        T value{};
+        bool used = false;
+    };
+
+    static std::size_t roundCapacity(std::size_t capacity)
+    {
+        std::size_t rounded = MIN_CAPACITY;
+        while (rounded < capacity)
+            rounded *= 2;
+        return rounded;
+    }
+
+    void rehash(std::size_t capacity)
+    {
+        std::vector<Slot> slots(roundCapacity(capacity));
+        std::swap(slots, _slots);
+        _size = 0;
+        for (auto &slot : slots)
+            if (slot.used)
+                insert(slot.key, std::move(slot.value));
+    }
+
+    /**
+     * @brief Empty a slot and shift back the next slots of its cluster that
+     * would not be found anymore (backward shift deletion)
+     */
+    void eraseSlot(std::size_t hole)
+    {
+        std::size_t mask = _slots.size() - 1;
+
+        for (std::size_t i = (hole + 1) & mask; _slots[i].used; i = (i + 1) & mask)
+        {
+            std::size_t home = _slots[i].key.hash() & mask;
+
+            // the slot stays if its home is cyclically in (hole, i]
+            if (((i - home) & mask) < ((i - hole) & mask))
+                continue;
+            _slots[hole] = std::move(_slots[i]);
+            hole = i;
+        }
+        _slots[hole] = Slot{};
+        --_size;
+    }
+
+private:
+    std::vector<Slot> _slots;
+    std::size_t _size = 0;
+};
+
+} // namespace Flakkari::Network
+
+#endif /* !FLAKKARI_ENDPOINTMAP_HPP_ */
@@ -0,0 +1,144 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file FrameWriter.hpp
+ * @brief This file contains the FrameWriter class. It packs the packets sent
+ *        to a client during a tick in preallocated frames of at most one MTU,
+ *        one frame per datagram.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef FLAKKARI_FRAMEWRITER_HPP_
+#define FLAKKARI_FRAMEWRITER_HPP_
+
+#include "Buffer.hpp"
+
+#include <vector>
+
+namespace Flakkari::Network {
+
+/**
+ * @brief Outbound writer of a connection: write-combining of the packets of
+ * a tick in datagrams of at most one MTU
+ *
+ * @details The packets are appended end to end, as the receivers parse them,
+ * to the current frame until the next one does not fit: a new frame, a new
+ * datagram, is then opened. The frames keep their memory from a tick to the
+ * next (clear() only empties them), each reserved to the MTU when it is
+ * first used: once the writer has seen its busiest tick, writing a tick
+ * allocates nothing.
+ *
+ * A packet larger than the MTU gets a frame of its own, larger than the MTU:
+ * the caller fragments such packets first (see Protocol::Fragmenter).
+ *
+ * @example "Flakkari/Network/FrameWriter.hpp"
+ * @code
+ * FrameWriter writer(1200);
+ * writer.clear();
+ * channel.write(writer.reserve(packet.size()), packet, now);
+ * writer.forEach([&](const Buffer &frame) { datagrams.emplace_back(address, &frame); });
+ * @endcode
+ */
+class FrameWriter {
+public:
+    explicit FrameWriter(std::size_t mtu) : _mtu(mtu) {}
+
+    /**
+     * @brief Empty the frames of the last tick, keeping their memory
+     */
+    void clear()
+    {
+        for (std::size_t i = 0; i < _count; ++i)
+            _frames[i].clear();
+        _count = 0;
+    }
+
+    /**
+     * @brief Get the frame to append a packet of `size` bytes to: the current
+     * frame if the packet fits in it, else a new one
+     *
+     * @param size  The size of the packet
+     * @return Buffer&  The frame, valid until the next frame is opened
+     */
+    Buffer &reserve(std::size_t size)
+    {
+        if (_count > 0 && (_frames[_count - 1].empty() || _frames[_count - 1].size() + size <= _mtu))
+            return _frames[_count - 1];
+        return open();
+    }
+
+    /**
+     * @brief Get the current frame, opened if there is none
+     */
+    Buffer &current() { return _count > 0 ? _frames[_count - 1] : open(); }
+
+    /**
+     * @brief Close the current frame, unless it is empty, and open the next one
+     *
+     * @return Buffer&  The new current frame (empty)
+     */
+    Buffer &open()
+    {
+        if (_count > 0 && _frames[_count - 1].empty())
+            return _frames[_count - 1];
+        if (_count == _frames.size())
+            _frames.emplace_back().reserve(_mtu);
+        return _frames[_count++];
+    }
+
+    /**
+     * @brief Call a function on each frame written since clear(), in order
+     *
+     * @param function  Called with each frame that is not empty (const Buffer &)
+     */
+    template <typename Function> void forEach(Function &&function) const
+    {
+        for (std::size_t i = 0; i < _count; ++i)
+            if (!_frames[i].empty())
+                function(_frames[i]);
+    }
+
+    /**
+     * @brief Call a function that may rewrite them (compress them) on each
+     * frame written since clear(), in order
+     *
+     * @param function  Called with each frame that is not empty (Buffer &)
+     */
+    template <typename Function> void forEach(Function &&function)
+    {
+        for (std::size_t i = 0; i < _count; ++i)
+            if (!_frames[i].empty())
+                function(_frames[i]);
+    }
+
+    /**
+     * @brief Get the number of bytes written since clear()
+     */
+    [[nodiscard]] std::size_t size() const
+    {
+        std::size_t size = 0;
+        for (std::size_t i = 0; i < _count; ++i)
+            size += _frames[i].size();
+        return size;
+    }
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    [[nodiscard]] std::size_t getMtu() const { return _mtu; }
+    void setMtu(std::size_t mtu) { _mtu = mtu; }
+
+private:
+    std::size_t _mtu;            // Size of a frame at most
+    std::vector<Buffer> _frames; // Frames, reserved to the MTU, kept from a tick to the next
+    std::size_t _count = 0;      // Frames used since clear(), the last is the current one
+};
+
+} // namespace Flakkari::Network
+
+#endif /* !FLAKKARI_FRAMEWRITER_HPP_ */
@@ -9,6 +9,14 @@
 
 #include "IOMultiplexer.hpp"
 
+#if defined(_IO_URING_) && defined(__linux__)
+#    include <atomic>
+#    include <bit>
+#    include <csignal>
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#endif
+
 namespace Flakkari::Network {
 
 #if defined(_PSELECT_)
@@ -23,7 +31,7 @@ PSELECT::PSELECT(FileDescriptor fileDescriptor, long int seconds, long int micro
     _sockets.push_back(fileDescriptor);
 
     _timeout.tv_sec = seconds;
-    _timeout.tv_nsec = microseconds;
+    _timeout.tv_nsec = microseconds * 1000;
 }
 
 PSELECT::PSELECT(long int seconds, long int microseconds)
@@ -31,7 +39,7 @@ PSELECT::PSELECT(long int seconds, long int microseconds)
     FD_ZERO(&_fds);
 
     _timeout.tv_sec = seconds;
-    _timeout.tv_nsec = microseconds;
+    _timeout.tv_nsec = microseconds * 1000;
 }
 
 void PSELECT::addSocket(FileDescriptor socket)
@@ -65,7 +73,8 @@ int PSELECT::wait()
     for (auto &fd : _sockets)
         FD_SET(fd, &_fds);
 #    if defined(__APPLE__)
-    return ::select(_maxFd + 1, &_fds, nullptr, nullptr, (struct timeval *) &_timeout);
+    struct timeval timeout = {_timeout.tv_sec, static_cast<suseconds_t>(_timeout.tv_nsec / 1000)};
+    return ::select(_maxFd + 1, &_fds, nullptr, nullptr, &timeout);
 #    else
     return ::pselect(_maxFd + 1, &_fds, nullptr, nullptr, &_timeout, nullptr);
 #    endif
@@ -98,13 +107,13 @@ PPOLL::PPOLL(FileDescriptor fileDescriptor, event_t events, long int seconds, lo
     _pollfds[fileDescriptor] = pollfd{fileDescriptor, events, 0};
 
     _timeout.tv_sec = seconds;
-    _timeout.tv_nsec = microseconds;
+    _timeout.tv_nsec = microseconds * 1000;
 }
 
 PPOLL::PPOLL(long int seconds, long int microseconds)
 {
     _timeout.tv_sec = seconds;
-    _timeout.tv_nsec = microseconds;
+    _timeout.tv_nsec = microseconds * 1000;
 }
 
 void PPOLL::addSocket(FileDescriptor socket)
@@ -190,6 +199,480 @@ bool PPOLL::skipableError() { return errno == EINTR || errno == EAGAIN || errno
 
 #endif
 
+#if defined(_EPOLL_) && defined(__linux__)
+
+EPOLL::EPOLL(FileDescriptor fileDescriptor, long int seconds, long int microseconds) : EPOLL(seconds, microseconds)
+{
+    addSocket(fileDescriptor);
+}
+
+EPOLL::EPOLL(long int seconds, long int microseconds)
+{
+    _epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll == -1)
+        throw std::runtime_error("Failed to create epoll, error: " + SPECIAL_ERROR);
+
+    _timeoutMs = static_cast<int>(seconds * 1000 + microseconds / 1000);
+}
+
+EPOLL::~EPOLL()
+{
+    if (_epoll != -1)
+        ::close(_epoll);
+}
+
+void EPOLL::addSocket(FileDescriptor socket) { addSocket(socket, EPOLLIN | EPOLLPRI); }
+
+void EPOLL::addSocket(FileDescriptor socket, event_t events)
+{
+    if (socket == -1)
+        throw std::runtime_error("Socket is -1");
+
+    struct epoll_event event = {};
+    event.events = events;
+    event.data.fd = socket;
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, socket, &event) == -1)
+        throw std::runtime_error("Failed to add socket to epoll, error: " + SPECIAL_ERROR);
+
+    ++_count;
+    _events.resize(_count);
+    if (_isReady.size() <= std::size_t(socket))
+        _isReady.resize(socket + 1, false);
+}
+
+void EPOLL::removeSocket(FileDescriptor socket)
+{
+    if (socket == -1)
+        throw std::runtime_error("Socket is -1");
+    if (epoll_ctl(_epoll, EPOLL_CTL_DEL, socket, nullptr) == -1)
+        throw std::runtime_error("Failed to remove socket from epoll, error: " + SPECIAL_ERROR);
+
+    --_count;
+    _ready.erase(std::remove(_ready.begin(), _ready.end(), socket), _ready.end());
+    _isReady[socket] = false;
+}
+
+int EPOLL::wait()
+{
+    for (auto fd : _ready)
+        _isReady[fd] = false;
+    _ready.clear();
+
+    int count = epoll_wait(_epoll, _events.data(), static_cast<int>(std::max<std::size_t>(_events.size(), 1)),
+                           _timeoutMs);
+
+    for (int i = 0; i < count; ++i)
+    {
+        auto fd = _events[i].data.fd;
+        _ready.push_back(fd);
+        _isReady[fd] = true;
+    }
+    return count;
+}
+
+bool EPOLL::isReady(FileDescriptor socket)
+{
+    if (socket == -1)
+        throw std::runtime_error("Socket is -1");
+
+    return std::size_t(socket) < _isReady.size() && _isReady[socket];
+}
+
+bool EPOLL::skipableError() { return errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK; }
+
+#endif
+
+#if defined(_IO_URING_) && defined(__linux__)
+
+namespace {
+
+enum class UringRequest : uint64_t {
+    RECEIVE = 1,
+    SEND = 2,
+    CANCEL = 3,
+};
+
+constexpr uint64_t userData(UringRequest request, uint32_t value)
+{
+    return (static_cast<uint64_t>(request) << 56) | value;
+}
+
+} // namespace
+
+IO_URING::IO_URING(FileDescriptor fileDescriptor, long int seconds, long int microseconds)
+    : IO_URING(seconds, microseconds)
+{
+    addSocket(fileDescriptor);
+}
+
+IO_URING::IO_URING(long int seconds, long int microseconds, unsigned entries, unsigned bufferCount,
+                   unsigned bufferSize)
+{
+    _bufferCount = std::bit_ceil(std::clamp(bufferCount, 1u, 32768u));
+    _bufferSize = std::max<unsigned>(bufferSize, sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_storage) + 1);
+
+    // completions are only posted when wait() enters the kernel, so that one wait reaps a batch of them
+    _params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    _params.cq_entries = std::bit_ceil(std::max(entries, 1u)) * 8;
+    _ring = static_cast<FileDescriptor>(::syscall(__NR_io_uring_setup, std::max(entries, 1u), &_params));
+    if (_ring == -1 && errno == EINVAL)
+    {
+        _params = {};
+        _params.flags = IORING_SETUP_CQSIZE;
+        _params.cq_entries = std::bit_ceil(std::max(entries, 1u)) * 8;
+        _ring = static_cast<FileDescriptor>(::syscall(__NR_io_uring_setup, std::max(entries, 1u), &_params));
+    }
+    if (_ring == -1)
+        throw std::runtime_error("Failed to create io_uring, error: " + SPECIAL_ERROR);
+    if (!(_params.features & IORING_FEAT_SINGLE_MMAP) || !(_params.features & IORING_FEAT_EXT_ARG))
+    {
+        release();
+        throw std::runtime_error("io_uring is too old (no single mmap or extended arguments)");
+    }
+
+    _sqRingSize = _params.sq_off.array + _params.sq_entries * sizeof(uint32_t);
+    _cqRingSize = _params.cq_off.cqes + _params.cq_entries * sizeof(io_uring_cqe);
+    _sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+    _sqRing = ::mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring,
+                     IORING_OFF_SQ_RING);
+    if (_sqRing == MAP_FAILED)
+    {
+        _sqRing = nullptr;
+        release();
+        throw std::runtime_error("Failed to map io_uring, error: " + STD_ERROR);
+    }
+    _cqRing = _sqRing;
+
+    _sqesSize = _params.sq_entries * sizeof(io_uring_sqe);
+    _sqes = static_cast<io_uring_sqe *>(
+        ::mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_SQES));
+    if (_sqes == MAP_FAILED)
+    {
+        _sqes = nullptr;
+        release();
+        throw std::runtime_error("Failed to map io_uring, error: " + STD_ERROR);
+    }
+
+    auto *sq = static_cast<uint8_t *>(_sqRing);
+    auto *cq = static_cast<uint8_t *>(_cqRing);
+    _sqHead = reinterpret_cast<uint32_t *>(sq + _params.sq_off.head);
+    _sqTail = reinterpret_cast<uint32_t *>(sq + _params.sq_off.tail);
+    _sqArray = reinterpret_cast<uint32_t *>(sq + _params.sq_off.array);
+    _sqMask = *reinterpret_cast<uint32_t *>(sq + _params.sq_off.ring_mask);
+    _sqLocalTail = *_sqTail;
+    _cqHead = reinterpret_cast<uint32_t *>(cq + _params.cq_off.head);
+    _cqTail = reinterpret_cast<uint32_t *>(cq + _params.cq_off.tail);
+    _cqMask = *reinterpret_cast<uint32_t *>(cq + _params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<io_uring_cqe *>(cq + _params.cq_off.cqes);
+
+    // provided buffer ring: the kernel picks a buffer for each datagram
+    _bufferRingSize = _bufferCount * sizeof(io_uring_buf);
+    void *bufferRing = ::mmap(nullptr, _bufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bufferRing == MAP_FAILED)
+    {
+        release();
+        throw std::runtime_error("Failed to map io_uring buffers, error: " + STD_ERROR);
+    }
+    _bufferRing = static_cast<io_uring_buf_ring *>(bufferRing);
+
+    io_uring_buf_reg reg = {};
+    reg.ring_addr = reinterpret_cast<uint64_t>(_bufferRing);
+    reg.ring_entries = _bufferCount;
+    reg.bgid = 0;
+    if (::syscall(__NR_io_uring_register, _ring, IORING_REGISTER_PBUF_RING, &reg, 1) == -1)
+    {
+        release();
+        throw std::runtime_error("Failed to register io_uring buffers, error: " + STD_ERROR);
+    }
+
+    _buffers.resize(std::size_t(_bufferCount) * _bufferSize);
+    for (unsigned i = 0; i < _bufferCount; ++i)
+        _recycle.push_back(static_cast<uint16_t>(i));
+    recycleBuffers();
+
+    _receiveMessage.msg_namelen = sizeof(sockaddr_storage);
+
+    _sendSlots.resize(_params.cq_entries / 2);
+    for (uint32_t i = 0; i < _sendSlots.size(); ++i)
+        _freeSendSlots.push_back(static_cast<uint32_t>(_sendSlots.size() - 1 - i));
+
+    _timeout.tv_sec = seconds;
+    _timeout.tv_nsec = microseconds * 1000;
+}
+
+IO_URING::~IO_URING() { release(); }
+
+void IO_URING::release()
+{
+    // closing the ring cancels the requests before the buffers are freed
+    if (_ring != -1)
+        ::close(_ring);
+    _ring = -1;
+    if (_sqes)
+        ::munmap(_sqes, _sqesSize);
+    _sqes = nullptr;
+    if (_sqRing)
+        ::munmap(_sqRing, _sqRingSize);
+    _sqRing = _cqRing = nullptr;
+    if (_bufferRing)
+        ::munmap(_bufferRing, _bufferRingSize);
+    _bufferRing = nullptr;
+}
+
+bool IO_URING::isSupported()
+{
+    static const bool supported = [] {
+        try
+        {
+            IO_URING io(0, 100000, 8, 8, 512);
+            FileDescriptor probe = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            sockaddr_in address = {};
+            socklen_t length = sizeof(address);
+            const byte data[] = {'p', 'r', 'o', 'b', 'e'};
+            bool received = false;
+
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (probe == -1 || ::bind(probe, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1 ||
+                ::getsockname(probe, reinterpret_cast<sockaddr *>(&address), &length) == -1)
+            {
+                if (probe != -1)
+                    ::close(probe);
+                return false;
+            }
+            io.addSocket(probe);
+            io.sendTo(probe, reinterpret_cast<sockaddr *>(&address), length, data, sizeof(data));
+            for (int attempt = 0; attempt < 3 && !received; ++attempt)
+                if (io.wait() > 0)
+                    received = io.begin()->size == sizeof(data);
+            ::close(probe);
+            return received;
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+    }();
+    return supported;
+}
+
+io_uring_sqe *IO_URING::getSqe()
+{
+    if (_sqLocalTail - std::atomic_ref<uint32_t>(*_sqHead).load(std::memory_order_acquire) >= _params.sq_entries)
+    {
+        flush();
+        if (_sqLocalTail - std::atomic_ref<uint32_t>(*_sqHead).load(std::memory_order_acquire) >=
+            _params.sq_entries)
+            return nullptr;
+    }
+
+    uint32_t index = _sqLocalTail & _sqMask;
+    io_uring_sqe *sqe = &_sqes[index];
+
+    _sqArray[index] = index;
+    ++_sqLocalTail;
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+void IO_URING::armReceive(FileDescriptor socket)
+{
+    io_uring_sqe *sqe = getSqe();
+    if (!sqe)
+        return _rearm.push_back(socket);
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = socket;
+    sqe->addr = reinterpret_cast<uint64_t>(&_receiveMessage);
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = 0;
+    sqe->user_data = userData(UringRequest::RECEIVE, static_cast<uint32_t>(socket));
+}
+
+void IO_URING::addSocket(FileDescriptor socket)
+{
+    if (socket == -1)
+        throw std::runtime_error("Socket is -1");
+
+    _sockets.push_back(socket);
+    armReceive(socket);
+}
+
+void IO_URING::removeSocket(FileDescriptor socket)
+{
+    if (socket == -1)
+        throw std::runtime_error("Socket is -1");
+
+    _sockets.erase(std::remove(_sockets.begin(), _sockets.end(), socket), _sockets.end());
+    _rearm.erase(std::remove(_rearm.begin(), _rearm.end(), socket), _rearm.end());
+
+    io_uring_sqe *sqe = getSqe();
+    if (!sqe)
+        return;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = userData(UringRequest::RECEIVE, static_cast<uint32_t>(socket));
+    sqe->user_data = userData(UringRequest::CANCEL, static_cast<uint32_t>(socket));
+    flush();
+}
+
+void IO_URING::sendTo(FileDescriptor socket, const sockaddr *address, socklen_t addressLength, const byte *data,
+                      std::size_t size)
+{
+    io_uring_sqe *sqe = _freeSendSlots.empty() ? nullptr : getSqe();
+
+    if (!sqe)
+    {
+        ++_directSends;
+        ::sendto(socket, data, size, MSG_DONTWAIT, address, addressLength);
+        return;
+    }
+
+    uint32_t index = _freeSendSlots.back();
+    SendSlot &slot = _sendSlots[index];
+    _freeSendSlots.pop_back();
+
+    slot.data.assign(data, data + size);
+    std::memcpy(&slot.address, address, std::min<std::size_t>(addressLength, sizeof(slot.address)));
+    slot.vector = {slot.data.data(), slot.data.size()};
+    slot.message = {};
+    slot.message.msg_name = &slot.address;
+    slot.message.msg_namelen = addressLength;
+    slot.message.msg_iov = &slot.vector;
+    slot.message.msg_iovlen = 1;
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = socket;
+    sqe->addr = reinterpret_cast<uint64_t>(&slot.message);
+    sqe->len = 1;
+    sqe->user_data = userData(UringRequest::SEND, index);
+}
+
+int IO_URING::enter(unsigned minComplete, bool timeout)
+{
+    std::atomic_ref<uint32_t>(*_sqTail).store(_sqLocalTail, std::memory_order_release);
+    unsigned toSubmit = _sqLocalTail - std::atomic_ref<uint32_t>(*_sqHead).load(std::memory_order_acquire);
+    unsigned flags = 0;
+    io_uring_getevents_arg arg = {};
+    void *argument = nullptr;
+    std::size_t argumentSize = 0;
+
+    if (toSubmit == 0 && minComplete == 0)
+        return 0;
+    if (minComplete > 0)
+        flags |= IORING_ENTER_GETEVENTS;
+    if (timeout)
+    {
+        arg.sigmask_sz = _NSIG / 8;
+        arg.ts = reinterpret_cast<uint64_t>(&_timeout);
+        flags |= IORING_ENTER_EXT_ARG;
+        argument = &arg;
+        argumentSize = sizeof(arg);
+    }
+    ++_syscalls;
+    return static_cast<int>(::syscall(__NR_io_uring_enter, _ring, toSubmit, minComplete, flags, argument,
+                                      argumentSize));
+}
+
+int IO_URING::flush() { return enter(0, false); }
+
+void IO_URING::recycleBuffers()
+{
+    for (auto &datagram : _datagrams)
+        _recycle.push_back(datagram.buffer);
+    _datagrams.clear();
+
+    if (_recycle.empty())
+        return;
+    // not _bufferRing->bufs: in C++ the empty struct of __DECLARE_FLEX_ARRAY moves it 8 bytes after the ring
+    auto *entries = reinterpret_cast<io_uring_buf *>(_bufferRing);
+    for (auto buffer : _recycle)
+    {
+        io_uring_buf &entry = entries[_bufferTail & (_bufferCount - 1)];
+        entry.addr = reinterpret_cast<uint64_t>(&_buffers[std::size_t(buffer) * _bufferSize]);
+        entry.len = _bufferSize;
+        entry.bid = buffer;
+        ++_bufferTail;
+    }
+    _recycle.clear();
+    std::atomic_ref<uint16_t>(_bufferRing->tail).store(_bufferTail, std::memory_order_release);
+}
+
+void IO_URING::reap()
+{
+    uint32_t head = *_cqHead;
+    uint32_t tail = std::atomic_ref<uint32_t>(*_cqTail).load(std::memory_order_acquire);
+
+    for (; head != tail; ++head)
+    {
+        const io_uring_cqe &cqe = _cqes[head & _cqMask];
+        auto request = static_cast<UringRequest>(cqe.user_data >> 56);
+        auto value = static_cast<uint32_t>(cqe.user_data & 0xffffffffu);
+
+        if (request == UringRequest::SEND)
+        {
+            _freeSendSlots.push_back(value);
+            continue;
+        }
+        if (request != UringRequest::RECEIVE)
+            continue;
+
+        auto socket = static_cast<FileDescriptor>(value);
+        bool armed = std::find(_sockets.begin(), _sockets.end(), socket) != _sockets.end();
+
+        // the kernel stops a multishot request when it runs out of buffers
+        if (!(cqe.flags & IORING_CQE_F_MORE) && armed &&
+            std::find(_rearm.begin(), _rearm.end(), socket) == _rearm.end())
+            _rearm.push_back(socket);
+        if (!(cqe.flags & IORING_CQE_F_BUFFER))
+            continue;
+
+        auto buffer = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        byte *data = &_buffers[std::size_t(buffer) * _bufferSize];
+        auto *out = reinterpret_cast<io_uring_recvmsg_out *>(data);
+        std::size_t header = sizeof(io_uring_recvmsg_out) + _receiveMessage.msg_namelen;
+
+        if (!armed || cqe.res < static_cast<int32_t>(header))
+        {
+            _recycle.push_back(buffer);
+            continue;
+        }
+        _datagrams.push_back({socket, reinterpret_cast<const sockaddr *>(data + sizeof(io_uring_recvmsg_out)),
+                              static_cast<socklen_t>(std::min(out->namelen, _receiveMessage.msg_namelen)),
+                              data + header, std::min<std::size_t>(out->payloadlen, cqe.res - header),
+                              (out->flags & MSG_TRUNC) != 0, buffer});
+    }
+    std::atomic_ref<uint32_t>(*_cqHead).store(head, std::memory_order_release);
+}
+
+int IO_URING::wait()
+{
+    recycleBuffers();
+
+    auto rearm = std::move(_rearm);
+    _rearm.clear();
+    for (auto socket : rearm)
+        armReceive(socket);
+
+    // returns at once if completions are already waiting
+    if (enter(1, true) == -1 && errno != ETIME)
+        return -1;
+    reap();
+    return static_cast<int>(_datagrams.size());
+}
+
+bool IO_URING::isReady(FileDescriptor socket)
+{
+    return std::any_of(_datagrams.begin(), _datagrams.end(),
+                       [socket](const Datagram &datagram) { return datagram.socket == socket; });
+}
+
+bool IO_URING::skipableError() { return errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK || errno == EBUSY; }
+
+#endif
+
 #if defined(_WSA_)
 
 WSA::WSA(FileDescriptor socket, int seconds, int microseconds)
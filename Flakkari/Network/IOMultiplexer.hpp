@@ -25,13 +25,26 @@
 #else
 #    define _PSELECT_
 #    define _PPOLL_
-#    define _EPOLL_
+#    if defined(__linux__)
+#        define _EPOLL_
+#        if __has_include(<linux/io_uring.h>)
+#            define _IO_URING_
+#        endif
+#    endif
 #endif
 
 #include "Socket.hpp"
 #include <unordered_map>
 #include <vector>
 
+#if defined(_EPOLL_) && defined(__linux__)
+#    include <sys/epoll.h>
+#endif
+
+#if defined(_IO_URING_) && defined(__linux__)
+#    include <linux/io_uring.h>
+#endif
+
 namespace Flakkari::Network {
 
 #if defined(_PSELECT_)
@@ -246,6 +259,319 @@ private:
 };
 #endif
 
+#if defined(_EPOLL_) && defined(__linux__)
+
+/**
+ * @brief EPOLL is a class that represents an EPOLL
+ *
+ * @details The sockets are registered once in the kernel: a wait does not
+ * copy the list of the sockets and its cost does not depend on their number.
+ * Only the sockets ready after a wait are iterated. The sockets are
+ * level-triggered by default; a socket added with EPOLLET is only reported
+ * when new data arrives, so it must be read until EAGAIN each time it is
+ * ready.
+ *
+ * @class EPOLL
+ * @implements IOMultiplexer
+ * @see IOMultiplexer
+ *
+ * @example "EPOLL example":
+ * @code
+ * auto socket = std::make_shared<Socket>(12345, Address::IpType::IPv4, Address::SocketType::UDP);
+ * socket->bind();
+ *
+ * auto io = std::make_unique<EPOLL>();
+ * io->addSocket(socket->getSocket(), EPOLLIN | EPOLLET);
+ *
+ * while (true) {
+ *    int result = io->wait();
+ *    if (result > 0) {
+ *       for (auto &fd : *io) {
+ *         // read fd until EAGAIN
+ *       }
+ *    }
+ * }
+ * @endcode
+ */
+class EPOLL {
+public:
+    using FileDescriptor = int;
+    using event_t = uint32_t;
+
+public:
+    EPOLL(FileDescriptor fileDescriptor, long int seconds = 1, long int microseconds = 0);
+    EPOLL(long int seconds = 1, long int microseconds = 0);
+    EPOLL(const EPOLL &) = delete;
+    EPOLL &operator=(const EPOLL &) = delete;
+    ~EPOLL();
+
+    /**
+     * @brief Add a socket to the EPOLL list (level-triggered read events)
+     *
+     * @param socket  The socket to add to the list
+     */
+    void addSocket(FileDescriptor socket);
+
+    /**
+     * @brief Add a socket to the EPOLL list with specific events
+     *
+     * @param socket  The socket to add to the list
+     * @param events  The events to listen to on the socket (EPOLLIN | EPOLLET for edge-triggered reads)
+     */
+    void addSocket(FileDescriptor socket, event_t events);
+
+    /**
+     * @brief Remove a socket from the EPOLL list
+     *
+     * @param socket  The socket to remove from the list
+     */
+    void removeSocket(FileDescriptor socket);
+
+    /**
+     * @brief Wait for an event to happen on a socket or timeout
+     *
+     * @return int  The number of sockets ready or -1 if an error occured or 0 if the timeout expired
+     * @see epoll_wait
+     * @see errno
+     */
+    int wait();
+
+    std::vector<FileDescriptor>::iterator begin() { return _ready.begin(); }
+    std::vector<FileDescriptor>::iterator end() { return _ready.end(); }
+
+    /**
+     * @brief Check if a socket was ready after the last wait
+     *
+     * @param socket  The socket to check
+     * @return true  If the socket is ready
+     * @return false  If the socket is not ready
+     */
+    [[nodiscard]] bool isReady(FileDescriptor socket);
+
+    /**
+     * @brief Check if the error is skipable
+     *
+     * @return true  If the error is skipable
+     * @return false  If the error is not skipable
+     */
+    [[nodiscard]] bool skipableError();
+
+protected:
+private:
+    FileDescriptor _epoll = -1;
+    std::size_t _count = 0;                  // Number of sockets in the list
+    std::vector<struct epoll_event> _events; // Events of the last wait
+    std::vector<FileDescriptor> _ready;      // Sockets ready after the last wait
+    std::vector<bool> _isReady;              // Readiness of each socket, indexed by socket
+    int _timeoutMs = 0;
+};
+#endif
+
+#if defined(_IO_URING_) && defined(__linux__)
+
+/**
+ * @brief IO_URING is a class that represents an io_uring instance for UDP sockets
+ *
+ * @details Unlike the other multiplexers, IO_URING does not report ready
+ * sockets but received datagrams: each socket added has a multishot recvmsg
+ * armed in the kernel, which writes every datagram into a buffer of a
+ * provided buffer ring without any syscall. A wait submits the queued sends
+ * and the requests of the ring, then collects every completed datagram in
+ * one io_uring_enter. The datagrams stay valid until the next wait, which
+ * gives their buffers back to the kernel.
+ *
+ * Sends are queued as sendmsg requests by sendTo() (the data is copied) and
+ * submitted with the next wait or flush().
+ *
+ * The ring is set up for a single issuer: an instance must only be used by
+ * the thread that created it.
+ *
+ * The kernel must support provided buffer rings and multishot recvmsg
+ * (Linux 6.0): use isSupported() to fall back on another multiplexer.
+ *
+ * @class IO_URING
+ * @see IOMultiplexer
+ *
+ * @example "IO_URING example":
+ * @code
+ * if (!IO_URING::isSupported())
+ *     return useEpoll();
+ * auto io = std::make_unique<IO_URING>(socket->getSocket());
+ *
+ * while (true) {
+ *    int result = io->wait();
+ *    for (auto &datagram : *io)
+ *        io->sendTo(datagram.socket, datagram.address, datagram.addressLength, datagram.data, datagram.size);
+ * }
+ * @endcode
+ */
+class IO_URING {
+public:
+    using FileDescriptor = int;
+
+    struct Datagram {
+        FileDescriptor socket;   // Socket that received the datagram
+        const sockaddr *address; // Address of the sender
+        socklen_t addressLength; // Length of the address of the sender
+        const byte *data;        // Payload of the datagram
+        std::size_t size;        // Size of the payload
+        bool truncated;          // The datagram did not fit in a buffer
+        uint16_t buffer;         // Buffer of the ring holding the datagram
+    };
+
+    static constexpr unsigned DEFAULT_ENTRIES = 256;       // Requests in the submission queue
+    static constexpr unsigned DEFAULT_BUFFER_COUNT = 1024; // Receive buffers (power of 2)
+    static constexpr unsigned DEFAULT_BUFFER_SIZE = 2048;  // Size of a receive buffer (datagrams of about 1.9 KB)
+
+    /**
+     * @brief Get the size of a receive buffer that holds a datagram of
+     * `payload` bytes whole, after the header of recvmsg and the address of
+     * its sender. A larger datagram is received truncated.
+     */
+    static constexpr unsigned bufferSizeFor(std::size_t payload)
+    {
+        return static_cast<unsigned>(payload + sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_storage));
+    }
+
+public:
+    IO_URING(FileDescriptor fileDescriptor, long int seconds = 1, long int microseconds = 0);
+    IO_URING(long int seconds = 1, long int microseconds = 0, unsigned entries = DEFAULT_ENTRIES,
+             unsigned bufferCount = DEFAULT_BUFFER_COUNT, unsigned bufferSize = DEFAULT_BUFFER_SIZE);
+    IO_URING(const IO_URING &) = delete;
+    IO_URING &operator=(const IO_URING &) = delete;
+    ~IO_URING();
+
+    /**
+     * @brief Check that the kernel runs multishot recvmsg with provided
+     * buffer rings (probed once on a loopback socket).
+     *
+     * @return true  If IO_URING can be used
+     * @return false  If another multiplexer must be used
+     */
+    [[nodiscard]] static bool isSupported();
+
+    /**
+     * @brief Arm a multishot recvmsg on a UDP socket
+     *
+     * @param socket  The socket to add
+     */
+    void addSocket(FileDescriptor socket);
+
+    /**
+     * @brief Cancel the multishot recvmsg of a socket
+     *
+     * @param socket  The socket to remove
+     */
+    void removeSocket(FileDescriptor socket);
+
+    /**
+     * @brief Queue a datagram to send. The data is copied: the caller can
+     * reuse its buffer at once. If every send slot is in use, the datagram
+     * is sent at once with sendto.
+     *
+     * @param socket  The socket to send from
+     * @param address  The address to send to
+     * @param addressLength  The length of the address
+     * @param data  The data to send
+     * @param size  The size of the data
+     */
+    void sendTo(FileDescriptor socket, const sockaddr *address, socklen_t addressLength, const byte *data,
+                std::size_t size);
+
+    /**
+     * @brief Submit the queued requests without waiting.
+     *
+     * @return int  The number of requests submitted or -1 if an error occured
+     */
+    int flush();
+
+    /**
+     * @brief Give back the buffers of the previous datagrams, submit the
+     * queued requests and wait for datagrams or timeout
+     *
+     * @return int  The number of datagrams received or -1 if an error occured or 0 if the timeout expired
+     */
+    int wait();
+
+    std::vector<Datagram>::iterator begin() { return _datagrams.begin(); }
+    std::vector<Datagram>::iterator end() { return _datagrams.end(); }
+
+    /**
+     * @brief Check if a socket received datagrams during the last wait
+     *
+     * @param socket  The socket to check
+     * @return true  If the socket received datagrams
+     * @return false  If the socket did not receive datagrams
+     */
+    [[nodiscard]] bool isReady(FileDescriptor socket);
+
+    /**
+     * @brief Check if the error is skipable
+     *
+     * @return true  If the error is skipable
+     * @return false  If the error is not skipable
+     */
+    [[nodiscard]] bool skipableError();
+
+    [[nodiscard]] uint64_t getSyscallCount() const { return _syscalls; }
+    [[nodiscard]] uint64_t getDirectSendCount() const { return _directSends; }
+
+private:
+    struct SendSlot {
+        msghdr message;           // Header of the sendmsg request
+        iovec vector;             // Payload of the request
+        sockaddr_storage address; // Destination of the datagram
+        std::vector<byte> data;   // Copy of the datagram
+    };
+
+    void release();
+    io_uring_sqe *getSqe();
+    void armReceive(FileDescriptor socket);
+    void recycleBuffers();
+    int enter(unsigned minComplete, bool timeout);
+    void reap();
+
+protected:
+private:
+    FileDescriptor _ring = -1;
+    io_uring_params _params = {};
+
+    void *_sqRing = nullptr; // Mapping of the submission queue ring
+    void *_cqRing = nullptr; // Mapping of the completion queue ring
+    std::size_t _sqRingSize = 0;
+    std::size_t _cqRingSize = 0;
+    io_uring_sqe *_sqes = nullptr; // Submission queue entries
+    std::size_t _sqesSize = 0;
+    uint32_t *_sqHead = nullptr;
+    uint32_t *_sqTail = nullptr;
+    uint32_t *_sqArray = nullptr;
+    uint32_t _sqMask = 0;
+    uint32_t _sqLocalTail = 0; // Tail with the requests not published yet
+    uint32_t *_cqHead = nullptr;
+    uint32_t *_cqTail = nullptr;
+    uint32_t _cqMask = 0;
+    io_uring_cqe *_cqes = nullptr;
+
+    io_uring_buf_ring *_bufferRing = nullptr; // Provided buffer ring shared with the kernel
+    std::size_t _bufferRingSize = 0;
+    std::vector<byte> _buffers; // Memory of the receive buffers
+    unsigned _bufferCount = 0;
+    unsigned _bufferSize = 0;
+    uint16_t _bufferTail = 0;    // Tail of the buffer ring
+    msghdr _receiveMessage = {}; // Layout of the received buffers (address length, no control data)
+
+    std::vector<SendSlot> _sendSlots;
+    std::vector<uint32_t> _freeSendSlots;
+    std::vector<FileDescriptor> _sockets; // Sockets with a multishot recvmsg
+    std::vector<FileDescriptor> _rearm;   // Sockets whose recvmsg must be armed again
+    std::vector<Datagram> _datagrams;     // Datagrams of the last wait
+    std::vector<uint16_t> _recycle;       // Buffers to give back to the kernel
+    struct __kernel_timespec _timeout = {0, 0};
+    uint64_t _syscalls = 0;
+    uint64_t _directSends = 0; // Datagrams sent with sendto because every send slot was in use
+};
+#endif
+
 #if defined(_WSA_)
 
 #    define MAX_POLLFD 1024
@@ -343,7 +669,10 @@ private:
 };
 #endif
 
-#ifdef _PSELECT_
+// Selected at build time: EPOLL on Linux unless FLAKKARI_IO_PSELECT is defined
+#if defined(_EPOLL_) && defined(__linux__) && !defined(FLAKKARI_IO_PSELECT)
+#    define IO_SELECTED Network::EPOLL
+#elif defined(_PSELECT_)
 #    define IO_SELECTED Network::PSELECT
 #elif defined(_WSA_)
 #    define IO_SELECTED Network::WSA
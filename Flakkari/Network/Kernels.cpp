@@ -0,0 +1,399 @@
+/*
+** EPITECH PROJECT, 2024
+** Title: Flakkari
+** Author: MasterLaplace
+** Created: 2024-10-19
+** File description:
+** Kernels
+*/
+
+#include "Kernels.hpp"
+
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#    define FLAKKARI_KERNELS_X86
+#    if defined(_MSC_VER)
+#        include <intrin.h>
+#    endif
+#    include <immintrin.h>
+#    if defined(_MSC_VER) && !defined(__clang__)
+#        define FLAKKARI_TARGET(isa) // MSVC compiles the intrinsics of any instruction set
+#    else
+#        define FLAKKARI_TARGET(isa) __attribute__((target(isa)))
+#    endif
+#endif
+
+namespace Flakkari::Network {
+
+namespace {
+
+constexpr uint32_t POLYNOMIAL = 0x82F63B78; // Castagnoli polynomial, bits reversed
+
+/**
+ * @brief Tables of the CRC slice by 8: table t gives the CRC of a byte
+ * followed by t zero bytes
+ */
+constexpr std::array<std::array<uint32_t, 256>, 8> makeTables()
+{
+    std::array<std::array<uint32_t, 256>, 8> tables{};
+
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit)
+            crc = (crc >> 1) ^ (POLYNOMIAL & (0u - (crc & 1)));
+        tables[0][i] = crc;
+    }
+    for (std::size_t t = 1; t < tables.size(); ++t)
+        for (uint32_t i = 0; i < 256; ++i)
+            tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 0xFF];
+    return tables;
+}
+
+constexpr auto TABLES = makeTables();
+
+constexpr std::size_t STRIPE = 128; // Bytes of each of the 3 CRCs computed at once with the crc32 instruction
+
+/**
+ * @brief Tables that move a CRC over `bytes` zero bytes: the CRC after them
+ * is the XOR of the entries of its 4 bytes (the CRC is linear)
+ */
+constexpr std::array<std::array<uint32_t, 256>, 4> makeShift(std::size_t bytes)
+{
+    std::array<uint32_t, 32> basis{};
+    std::array<std::array<uint32_t, 256>, 4> tables{};
+
+    for (std::size_t bit = 0; bit < basis.size(); ++bit)
+    {
+        uint32_t crc = 1u << bit;
+        for (std::size_t i = 0; i < bytes; ++i)
+            crc = (crc >> 8) ^ TABLES[0][crc & 0xFF];
+        basis[bit] = crc;
+    }
+    for (std::size_t t = 0; t < tables.size(); ++t)
+        for (uint32_t i = 0; i < 256; ++i)
+            for (std::size_t bit = 0; bit < 8; ++bit)
+                tables[t][i] ^= (i >> bit & 1) ? basis[8 * t + bit] : 0;
+    return tables;
+}
+
+constexpr auto SHIFT_STRIPE = makeShift(STRIPE);
+constexpr auto SHIFT_2_STRIPES = makeShift(2 * STRIPE);
+
+inline uint32_t shift(const std::array<std::array<uint32_t, 256>, 4> &tables, uint32_t crc)
+{
+    return tables[0][crc & 0xFF] ^ tables[1][(crc >> 8) & 0xFF] ^ tables[2][(crc >> 16) & 0xFF] ^ tables[3][crc >> 24];
+}
+
+constexpr char DIGITS[] = "0123456789abcdef";
+
+constexpr std::array<byte, 256> makeValues()
+{
+    std::array<byte, 256> values{};
+
+    for (auto &value : values)
+        value = 0xFF; // not a digit
+    for (byte i = 0; i < 16; ++i)
+        values[static_cast<byte>(DIGITS[i])] = i;
+    for (byte i = 10; i < 16; ++i)
+        values['A' + i - 10] = i;
+    return values;
+}
+
+constexpr auto VALUES = makeValues();
+
+/**
+ * @brief Read 8 bytes as a little endian word
+ */
+inline uint64_t read64(const byte *data)
+{
+    uint64_t word;
+
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        std::memcpy(&word, data, sizeof(word));
+        return word;
+    }
+    word = 0;
+    for (int i = 7; i >= 0; --i)
+        word = (word << 8) | data[i];
+    return word;
+}
+
+uint32_t crc32cPortable(uint32_t crc, const byte *data, std::size_t size)
+{
+    crc = ~crc;
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        uint64_t word = read64(data) ^ crc;
+        crc = TABLES[7][word & 0xFF] ^ TABLES[6][(word >> 8) & 0xFF] ^ TABLES[5][(word >> 16) & 0xFF] ^
+              TABLES[4][(word >> 24) & 0xFF] ^ TABLES[3][(word >> 32) & 0xFF] ^ TABLES[2][(word >> 40) & 0xFF] ^
+              TABLES[1][(word >> 48) & 0xFF] ^ TABLES[0][word >> 56];
+    }
+    for (; size > 0; --size)
+        crc = (crc >> 8) ^ TABLES[0][(crc ^ *data++) & 0xFF];
+    return ~crc;
+}
+
+void bitwiseXORPortable(byte *data, const byte *key, std::size_t size)
+{
+    std::size_t i = 0;
+
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        uint64_t mask;
+        std::memcpy(&word, data + i, sizeof(word));
+        std::memcpy(&mask, key + i, sizeof(mask));
+        word ^= mask;
+        std::memcpy(data + i, &word, sizeof(word));
+    }
+    for (; i < size; ++i)
+        data[i] ^= key[i];
+}
+
+void toHexPortable(const byte *src, std::size_t size, byte *dst)
+{
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        dst[2 * i] = static_cast<byte>(DIGITS[src[i] >> 4]);
+        dst[2 * i + 1] = static_cast<byte>(DIGITS[src[i] & 0x0F]);
+    }
+}
+
+bool fromHexPortable(const byte *src, std::size_t size, byte *dst)
+{
+    byte invalid = 0;
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        byte high = VALUES[src[2 * i]];
+        byte low = VALUES[src[2 * i + 1]];
+        invalid |= high | low;
+        dst[i] = static_cast<byte>(high << 4 | (low & 0x0F));
+    }
+    return (invalid & 0xF0) == 0;
+}
+
+#ifdef FLAKKARI_KERNELS_X86
+
+FLAKKARI_TARGET("sse4.2") uint32_t crc32cSse42(uint32_t crc, const byte *data, std::size_t size)
+{
+    uint64_t state = ~crc;
+
+    // the instruction takes 3 cycles, but starts one per cycle: 3 independent CRCs of a stripe each run at once,
+    // then are joined by moving the first two over the stripes after them
+    for (; size >= 3 * STRIPE; data += 3 * STRIPE, size -= 3 * STRIPE)
+    {
+        uint64_t second = 0;
+        uint64_t third = 0;
+        for (std::size_t i = 0; i < STRIPE; i += 8)
+        {
+            state = _mm_crc32_u64(state, read64(data + i));
+            second = _mm_crc32_u64(second, read64(data + STRIPE + i));
+            third = _mm_crc32_u64(third, read64(data + 2 * STRIPE + i));
+        }
+        state = shift(SHIFT_2_STRIPES, static_cast<uint32_t>(state)) ^
+                shift(SHIFT_STRIPE, static_cast<uint32_t>(second)) ^ static_cast<uint32_t>(third);
+    }
+    for (; size >= 8; data += 8, size -= 8)
+        state = _mm_crc32_u64(state, read64(data));
+    crc = static_cast<uint32_t>(state);
+    for (; size > 0; --size)
+        crc = _mm_crc32_u8(crc, *data++);
+    return ~crc;
+}
+
+FLAKKARI_TARGET("sse2") void bitwiseXORSse2(byte *data, const byte *key, std::size_t size)
+{
+    std::size_t i = 0;
+
+    for (; i + 16 <= size; i += 16)
+    {
+        auto *out = reinterpret_cast<__m128i *>(data + i);
+        __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i *>(key + i));
+        _mm_storeu_si128(out, _mm_xor_si128(_mm_loadu_si128(out), mask));
+    }
+    bitwiseXORPortable(data + i, key + i, size - i);
+}
+
+FLAKKARI_TARGET("ssse3") void toHexSsse3(const byte *src, std::size_t size, byte *dst)
+{
+    const __m128i digits = _mm_loadu_si128(reinterpret_cast<const __m128i *>(DIGITS));
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    std::size_t i = 0;
+
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble));
+        __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(bytes, nibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * i), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+    }
+    toHexPortable(src + i, size - i, dst + 2 * i);
+}
+
+/**
+ * @brief Values of 16 hexadecimal digits, whose invalid ones clear their
+ * bit of `valid`
+ */
+FLAKKARI_TARGET("ssse3") inline __m128i hexValues(__m128i chars, int &valid)
+{
+    __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20)); // 'A' to 'F' as 'a' to 'f', digits unchanged
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), chars));
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                   _mm_cmpgt_epi8(_mm_set1_epi8('f' + 1), lower));
+
+    valid &= _mm_movemask_epi8(_mm_or_si128(digit, letter));
+    return _mm_or_si128(_mm_and_si128(digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+                        _mm_and_si128(letter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+}
+
+FLAKKARI_TARGET("ssse3") bool fromHexSsse3(const byte *src, std::size_t size, byte *dst)
+{
+    const __m128i weights = _mm_set1_epi16(0x0110); // high digit * 16 + low digit
+    int valid = 0xFFFF;
+    std::size_t i = 0;
+
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i first = hexValues(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2 * i)), valid);
+        __m128i second = hexValues(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2 * i + 16)), valid);
+        __m128i bytes = _mm_packus_epi16(_mm_maddubs_epi16(first, weights), _mm_maddubs_epi16(second, weights));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), bytes);
+    }
+    return valid == 0xFFFF && fromHexPortable(src + 2 * i, size - i, dst + i);
+}
+
+FLAKKARI_TARGET("avx2") void bitwiseXORAvx2(byte *data, const byte *key, std::size_t size)
+{
+    std::size_t i = 0;
+
+    for (; i + 32 <= size; i += 32)
+    {
+        auto *out = reinterpret_cast<__m256i *>(data + i);
+        __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(key + i));
+        _mm256_storeu_si256(out, _mm256_xor_si256(_mm256_loadu_si256(out), mask));
+    }
+    _mm256_zeroupper(); // the SSE code of the end would wait for the upper halves of the AVX registers
+    bitwiseXORSse2(data + i, key + i, size - i);
+}
+
+FLAKKARI_TARGET("avx2") void toHexAvx2(const byte *src, std::size_t size, byte *dst)
+{
+    const __m256i digits = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(DIGITS)));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    std::size_t i = 0;
+
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        __m256i high = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble));
+        __m256i low = _mm256_shuffle_epi8(digits, _mm256_and_si256(bytes, nibble));
+        // the unpacks interleave each 128 bits lane: bytes 0-7 and 16-23, then 8-15 and 24-31
+        __m256i first = _mm256_unpacklo_epi8(high, low);
+        __m256i second = _mm256_unpackhi_epi8(high, low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 2 * i), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 2 * i + 32),
+                            _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    _mm256_zeroupper();
+    toHexSsse3(src + i, size - i, dst + 2 * i);
+}
+
+FLAKKARI_TARGET("avx2") inline __m256i hexValues(__m256i chars, uint32_t &valid)
+{
+    __m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+    __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars));
+    __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                      _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+
+    valid &= static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(digit, letter)));
+    return _mm256_or_si256(_mm256_and_si256(digit, _mm256_sub_epi8(chars, _mm256_set1_epi8('0'))),
+                           _mm256_and_si256(letter, _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10))));
+}
+
+FLAKKARI_TARGET("avx2") bool fromHexAvx2(const byte *src, std::size_t size, byte *dst)
+{
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    uint32_t valid = UINT32_MAX;
+    std::size_t i = 0;
+
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i first = hexValues(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 2 * i)), valid);
+        __m256i second = hexValues(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 2 * i + 32)), valid);
+        __m256i bytes =
+            _mm256_packus_epi16(_mm256_maddubs_epi16(first, weights), _mm256_maddubs_epi16(second, weights));
+        // the pack interleaves the 8 bytes of each lane of both halves: put them back in order
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_permute4x64_epi64(bytes, 0xD8));
+    }
+    _mm256_zeroupper();
+    return valid == UINT32_MAX && fromHexSsse3(src + 2 * i, size - i, dst + i);
+}
+
+struct Cpu {
+    bool sse42 = false; // SSE 4.2 and SSSE3
+    bool avx2 = false;  // AVX2, enabled by the OS
+};
+
+Cpu detectCpu()
+{
+    Cpu cpu;
+
+#    if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    cpu.sse42 = (info[2] >> 20 & 1) && (info[2] >> 9 & 1);
+    bool osxsave = info[2] >> 27 & 1;
+    __cpuidex(info, 7, 0);
+    cpu.avx2 = cpu.sse42 && osxsave && (info[1] >> 5 & 1) && (_xgetbv(0) & 6) == 6;
+#    else
+    __builtin_cpu_init();
+    cpu.sse42 = __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("ssse3");
+    cpu.avx2 = cpu.sse42 && __builtin_cpu_supports("avx2");
+#    endif
+    return cpu;
+}
+
+constexpr Kernels SSE42{"sse4.2", &crc32cSse42, &bitwiseXORSse2, &toHexSsse3, &fromHexSsse3};
+constexpr Kernels AVX2{"avx2", &crc32cSse42, &bitwiseXORAvx2, &toHexAvx2, &fromHexAvx2};
+
+#endif
+
+constexpr Kernels PORTABLE{"portable", &crc32cPortable, &bitwiseXORPortable, &toHexPortable, &fromHexPortable};
+
+} // namespace
+
+const std::vector<const Kernels *> &Kernels::getSupported()
+{
+    static const std::vector<const Kernels *> supported = [] {
+        std::vector<const Kernels *> kernels{&PORTABLE};
+
+#ifdef FLAKKARI_KERNELS_X86
+        Cpu cpu = detectCpu();
+        if (cpu.sse42)
+            kernels.push_back(&SSE42);
+        if (cpu.avx2)
+            kernels.push_back(&AVX2);
+#endif
+        return kernels;
+    }();
+
+    return supported;
+}
+
+const Kernels &Kernels::get()
+{
+    static const Kernels &fastest = *getSupported().back();
+
+    return fastest;
+}
+
+} // namespace Flakkari::Network
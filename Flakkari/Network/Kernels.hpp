@@ -0,0 +1,89 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file Kernels.hpp
+ * @brief This file contains the byte kernels of the Buffer class (CRC32C,
+ *        XOR, hexadecimal), in a portable version and in vector versions
+ *        chosen at runtime from the instructions of the CPU.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef FLAKKARI_KERNELS_HPP_
+#define FLAKKARI_KERNELS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using byte = std::uint8_t;
+
+namespace Flakkari::Network {
+
+/**
+ * @brief Set of implementations of the byte kernels for one instruction set
+ *
+ * @details The kernels run on every datagram when they check its integrity,
+ * so that they are written for the vector units of the CPU: the CRC32C with
+ * the crc32 instruction of SSE 4.2 (8 bytes per instruction), the XOR and
+ * the hexadecimal conversions 16 (SSSE3) or 32 (AVX2) bytes at a time. The
+ * portable set, which any CPU runs, computes the CRC32C slice by 8 (8 bytes
+ * per step with 8 tables) and the XOR a 64 bits word at a time.
+ *
+ * get() gives the fastest set the CPU supports, detected once at the first
+ * call: a binary built for any x86-64 CPU uses the instructions of the CPU
+ * it runs on. All the sets give the same results.
+ *
+ * @example "Flakkari/Network/Kernels.hpp"
+ * @code
+ * const Kernels &kernels = Kernels::get();
+ * uint32_t crc = kernels.crc32c(0, datagram.data(), datagram.size());
+ * crc = kernels.crc32c(crc, trailer.data(), trailer.size()); // CRC32C of datagram + trailer
+ * @endcode
+ */
+struct Kernels {
+    const char *name; // Instruction set of the kernels ("portable", "sse4.2" or "avx2")
+
+    /**
+     * @brief CRC32C (Castagnoli polynomial, as iSCSI and SCTP) of `size`
+     * bytes, following the CRC of the bytes before them (0 for none)
+     */
+    uint32_t (*crc32c)(uint32_t crc, const byte *data, std::size_t size);
+
+    /**
+     * @brief XOR `size` bytes of `data` with the ones of `key`
+     */
+    void (*bitwiseXOR)(byte *data, const byte *key, std::size_t size);
+
+    /**
+     * @brief Write the `2 * size` lower case hexadecimal digits of `size` bytes
+     */
+    void (*toHex)(const byte *src, std::size_t size, byte *dst);
+
+    /**
+     * @brief Write the `size` bytes of `2 * size` hexadecimal digits (lower or upper case)
+     *
+     * @return bool  false if a digit is invalid (`dst` is then undefined)
+     */
+    bool (*fromHex)(const byte *src, std::size_t size, byte *dst);
+
+    /**
+     * @brief Get the fastest kernels supported by the CPU
+     */
+    static const Kernels &get();
+
+    /**
+     * @brief Get every set of kernels supported by the CPU, the portable one
+     * first and the fastest last (to benchmark them against each other)
+     */
+    static const std::vector<const Kernels *> &getSupported();
+};
+
+} // namespace Flakkari::Network
+
+#endif /* !FLAKKARI_KERNELS_HPP_ */
@@ -0,0 +1,189 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file LinkSimulator.hpp
+ * @brief This file contains the LinkSimulator class. It models one direction
+ *        of a bad network link (loss, duplication, latency, jitter and
+ *        bandwidth) to test the reliability layer and the congestion control
+ *        without a real one.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef FLAKKARI_LINKSIMULATOR_HPP_
+#define FLAKKARI_LINKSIMULATOR_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <random>
+#include <vector>
+
+namespace Flakkari::Network {
+
+/**
+ * @brief One direction of a simulated lossy link
+ *
+ * @details Each datagram pushed in the link is lost, or delivered once or
+ * twice, each copy after the latency plus a uniform jitter: the jitter
+ * reorders the datagrams as a real link does. The random generator is seeded
+ * so that a run can be replayed.
+ *
+ * A link with a bandwidth sends the datagrams one after the other at that
+ * rate: a datagram waits for the ones before it, and is dropped if it would
+ * wait more than the queue delay, as by the full buffer of a router.
+ *
+ * @tparam T  Type of the datagrams (movable and copyable).
+ *
+ * @example "Flakkari/Network/LinkSimulator.hpp"
+ * @code
+ * LinkSimulator<Buffer> uplink({0.1, 0.01, std::chrono::milliseconds(30), std::chrono::milliseconds(10)});
+ * uplink.push(std::move(datagram), now);
+ * uplink.deliver(now, [&](Buffer &datagram) { socket.send(datagram); });
+ * @endcode
+ */
+template <typename T> class LinkSimulator {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Settings {
+        double loss = 0;                      // Probability that a datagram is lost
+        double duplicate = 0;                 // Probability that a datagram is delivered twice
+        std::chrono::microseconds latency{0}; // Delay of every datagram
+        std::chrono::microseconds jitter{0};  // Largest extra delay, drawn for each copy
+        std::size_t bandwidth = 0;            // Bytes per second the link carries (0: no limit)
+        std::chrono::milliseconds queue{50};  // Longest wait for the bandwidth before a drop
+        uint64_t seed = 0x5EED;               // Seed of the random generator
+    };
+
+    struct Stats {
+        uint64_t pushed = 0;     // Datagrams pushed in the link
+        uint64_t lost = 0;       // Datagrams lost
+        uint64_t overflowed = 0; // Datagrams dropped because the queue was full
+        uint64_t duplicated = 0; // Datagrams delivered twice
+        uint64_t delivered = 0;  // Copies delivered
+    };
+
+public:
+    explicit LinkSimulator(const Settings &settings) : _settings(settings), _random(settings.seed) {}
+
+    /**
+     * @brief Whether the link changes anything: without loss, duplication nor
+     * delay, the owner can skip it
+     */
+    [[nodiscard]] bool isPerfect() const
+    {
+        return _settings.loss <= 0 && _settings.duplicate <= 0 && _settings.latency.count() == 0 &&
+               _settings.jitter.count() == 0 && _settings.bandwidth == 0;
+    }
+
+    /**
+     * @brief Push a datagram in the link
+     *
+     * @param datagram  The datagram
+     * @param now  The time it is sent at
+     * @param size  The size of the datagram in bytes (for the bandwidth)
+     */
+    void push(T datagram, Clock::time_point now, std::size_t size = 0)
+    {
+        ++_stats.pushed;
+        if (_chance(_random) < _settings.loss)
+        {
+            ++_stats.lost;
+            return;
+        }
+        if (_settings.bandwidth > 0)
+        {
+            auto start = std::max(now, _busyUntil);
+            if (start - now > _settings.queue)
+            {
+                ++_stats.overflowed;
+                return;
+            }
+            _busyUntil = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(
+                                     static_cast<double>(size) / static_cast<double>(_settings.bandwidth)));
+            now = _busyUntil;
+        }
+        if (_chance(_random) < _settings.duplicate)
+        {
+            ++_stats.duplicated;
+            _inFlight.push({now + delay(), _order++, datagram});
+        }
+        _inFlight.push({now + delay(), _order++, std::move(datagram)});
+    }
+
+    /**
+     * @brief Deliver the datagrams whose time has come, earliest first
+     *
+     * @param now  The current time
+     * @param deliver  Called with each datagram (T &)
+     * @return std::size_t  The number of datagrams delivered
+     */
+    template <typename Deliver> std::size_t deliver(Clock::time_point now, Deliver &&deliver)
+    {
+        std::size_t count = 0;
+
+        while (!_inFlight.empty() && _inFlight.top().at <= now)
+        {
+            // the queue only gives const access to its top: the entry is moved out before the pop
+            auto entry = std::move(const_cast<Entry &>(_inFlight.top()));
+            _inFlight.pop();
+            deliver(entry.datagram);
+            ++count;
+        }
+        _stats.delivered += count;
+        return count;
+    }
+
+    /**
+     * @brief Get the time of the next delivery, to wake up for it
+     */
+    [[nodiscard]] std::optional<Clock::time_point> nextDelivery() const
+    {
+        if (_inFlight.empty())
+            return std::nullopt;
+        return _inFlight.top().at;
+    }
+
+    [[nodiscard]] const Stats &getStats() const { return _stats; }
+
+private:
+    struct Entry {
+        Clock::time_point at; // Time of the delivery
+        uint64_t order;       // Push order, to deliver the copies due at once in order
+        T datagram;
+
+        bool operator>(const Entry &other) const { return at != other.at ? at > other.at : order > other.order; }
+    };
+
+    Clock::duration delay()
+    {
+        auto delay = std::chrono::duration_cast<Clock::duration>(_settings.latency);
+        auto jitter = std::chrono::duration_cast<Clock::duration>(_settings.jitter);
+
+        if (jitter.count() > 0)
+            delay += Clock::duration(std::uniform_int_distribution<Clock::rep>(0, jitter.count())(_random));
+        return delay;
+    }
+
+private:
+    Settings _settings;
+    std::mt19937_64 _random;
+    std::uniform_real_distribution<double> _chance{0.0, 1.0};
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> _inFlight; // Datagrams by delivery time
+    uint64_t _order = 0;
+    Clock::time_point _busyUntil; // Time the bandwidth is free again
+    Stats _stats;
+};
+
+} // namespace Flakkari::Network
+
+#endif /* !FLAKKARI_LINKSIMULATOR_HPP_ */
@@ -0,0 +1,150 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file PriorityPacketQueue.hpp
+ * @brief This file contains the PriorityPacketQueue class. It is a set of
+ *        FIFO queues, one per priority level, sharing a single lock. It is
+ *        used by the server to schedule the packets sent to a client.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef PRIORITYPACKETQUEUE_HPP_
+#define PRIORITYPACKETQUEUE_HPP_
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <mutex>
+
+namespace Flakkari::Network {
+
+/**
+ * @brief Thread-safe multi-level packet queue class
+ * @tparam T Type of packets to be stored in the queue
+ * @tparam Levels Number of priority levels (0 is the lowest priority)
+ *
+ * @details Packets of the same level keep their arrival order. The consumer
+ * is expected to drain the highest levels first. Packets left in a level can
+ * be marked as stale at the end of a drain and dropped at the next one, which
+ * is used for state updates superseded by newer ones.
+ *
+ * @example "Flakkari/Network/PriorityPacketQueue.hpp"
+ * @code
+ * #include "PriorityPacketQueue.hpp"
+ * PriorityPacketQueue<Protocol::SerializedPacket, 4> packetQueue;
+ * packetQueue.push_back(3, packet);
+ * auto packet = packetQueue.pop_front(3);
+ * @endcode
+ */
+template <typename T, std::size_t Levels> class PriorityPacketQueue {
+public:
+    PriorityPacketQueue() = default;
+    PriorityPacketQueue(const PriorityPacketQueue<T, Levels> &) = delete;
+    virtual ~PriorityPacketQueue() { clear(); }
+
+public:
+    static constexpr std::size_t levels() { return Levels; }
+
+    const T &front(std::size_t level)
+    {
+        std::scoped_lock lock(_mutex);
+        return _queues[level].front();
+    }
+
+    void push_back(std::size_t level, const T &value)
+    {
+        std::scoped_lock lock(_mutex);
+        _queues[level].push_back(value);
+    }
+
+    T pop_front(std::size_t level)
+    {
+        std::scoped_lock lock(_mutex);
+        auto value = std::move(_queues[level].front());
+        _queues[level].pop_front();
+        if (_stale[level] > 0)
+            --_stale[level];
+        return value;
+    }
+
+    bool empty(std::size_t level)
+    {
+        std::scoped_lock lock(_mutex);
+        return _queues[level].empty();
+    }
+
+    bool empty()
+    {
+        std::scoped_lock lock(_mutex);
+        for (auto &queue : _queues)
+            if (!queue.empty())
+                return false;
+        return true;
+    }
+
+    size_t size(std::size_t level)
+    {
+        std::scoped_lock lock(_mutex);
+        return _queues[level].size();
+    }
+
+    size_t size()
+    {
+        std::scoped_lock lock(_mutex);
+        size_t size = 0;
+        for (auto &queue : _queues)
+            size += queue.size();
+        return size;
+    }
+
+    /**
+     * @brief Mark every packet currently waiting in a level as stale.
+     *
+     * @param level  The priority level.
+     */
+    void markStale(std::size_t level)
+    {
+        std::scoped_lock lock(_mutex);
+        _stale[level] = _queues[level].size();
+    }
+
+    /**
+     * @brief Drop the packets of a level marked as stale by markStale and
+     * not consumed since.
+     *
+     * @param level  The priority level.
+     * @return size_t  The number of packets dropped.
+     */
+    size_t dropStale(std::size_t level)
+    {
+        std::scoped_lock lock(_mutex);
+        size_t dropped = std::min(_stale[level], _queues[level].size());
+        _queues[level].erase(_queues[level].begin(), _queues[level].begin() + dropped);
+        _stale[level] = 0;
+        return dropped;
+    }
+
+    void clear()
+    {
+        std::scoped_lock lock(_mutex);
+        for (auto &queue : _queues)
+            queue.clear();
+        _stale.fill(0);
+    }
+
+protected:
+private:
+    std::mutex _mutex;
+    std::array<std::deque<T>, Levels> _queues;
+    std::array<size_t, Levels> _stale{};
+};
+
+} // namespace Flakkari::Network
+
+#endif /* !PRIORITYPACKETQUEUE_HPP_ */
@@ -0,0 +1,136 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file PriorityRingQueue.hpp
+ * @brief This file contains the PriorityRingQueue class. It is the lock-free
+ *        counterpart of PriorityPacketQueue: one bounded MPSC ring per
+ *        priority level.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef FLAKKARI_PRIORITYRINGQUEUE_HPP_
+#define FLAKKARI_PRIORITYRINGQUEUE_HPP_
+
+#include "RingQueue.hpp"
+
+#include <array>
+
+namespace Flakkari::Network {
+
+/**
+ * @brief Multi-level packet queue, with several producers and one consumer
+ * @tparam T Type of packets to be stored in the queue
+ * @tparam Levels Number of priority levels (0 is the lowest priority)
+ *
+ * @details Same interface and stale marking as PriorityPacketQueue, on one
+ * MpscRing per level instead of deques under a mutex: any thread may push,
+ * only the consumer thread may call the other methods. A level is bounded,
+ * a push to a full level fails and is counted in the stats of the level.
+ *
+ * @example "Flakkari/Network/PriorityRingQueue.hpp"
+ * @code
+ * #include "PriorityRingQueue.hpp"
+ * PriorityRingQueue<Protocol::SerializedPacket, 4> packetQueue(1024);
+ * packetQueue.push_back(3, packet);
+ * auto packet = packetQueue.pop_front(3);
+ * @endcode
+ */
+template <typename T, std::size_t Levels> class PriorityRingQueue {
+public:
+    explicit PriorityRingQueue(std::size_t capacity = 1024)
+    {
+        for (auto &queue : _queues)
+            queue = std::make_unique<MpscRing<T>>(capacity);
+    }
+    PriorityRingQueue(const PriorityRingQueue<T, Levels> &) = delete;
+    virtual ~PriorityRingQueue() = default;
+
+public:
+    static constexpr std::size_t levels() { return Levels; }
+
+    /**
+     * @brief Get the packet at the front of a level, which must not be empty.
+     */
+    const T &front(std::size_t level) { return *_queues[level]->front(); }
+
+    /**
+     * @brief Push a packet at the back of a level.
+     *
+     * @return true  If the packet was pushed, false if the level was full.
+     */
+    bool push_back(std::size_t level, const T &value) { return _queues[level]->push(value); }
+
+    T pop_front(std::size_t level)
+    {
+        T value;
+        _queues[level]->pop(value);
+        if (_stale[level] > 0)
+            --_stale[level];
+        return value;
+    }
+
+    bool empty(std::size_t level) { return _queues[level]->front() == nullptr; }
+
+    bool empty()
+    {
+        for (std::size_t level = 0; level < Levels; ++level)
+            if (!empty(level))
+                return false;
+        return true;
+    }
+
+    size_t size(std::size_t level) { return _queues[level]->size(); }
+
+    size_t size()
+    {
+        size_t size = 0;
+        for (auto &queue : _queues)
+            size += queue->size();
+        return size;
+    }
+
+    /**
+     * @brief Mark every packet currently waiting in a level as stale.
+     *
+     * @param level  The priority level.
+     */
+    void markStale(std::size_t level) { _stale[level] = _queues[level]->size(); }
+
+    /**
+     * @brief Drop the packets of a level marked as stale by markStale and
+     * not consumed since.
+     *
+     * @param level  The priority level.
+     * @return size_t  The number of packets dropped.
+     */
+    size_t dropStale(std::size_t level)
+    {
+        size_t dropped = _queues[level]->drain([](T &) {}, _stale[level]);
+        _stale[level] = 0;
+        return dropped;
+    }
+
+    void clear()
+    {
+        for (auto &queue : _queues)
+            queue->clear();
+        _stale.fill(0);
+    }
+
+    [[nodiscard]] RingStats getStats(std::size_t level) const { return _queues[level]->getStats(); }
+
+protected:
+private:
+    std::array<std::unique_ptr<MpscRing<T>>, Levels> _queues;
+    std::array<size_t, Levels> _stale{};
+};
+
+} // namespace Flakkari::Network
+
+#endif /* !FLAKKARI_PRIORITYRINGQUEUE_HPP_ */
@@ -0,0 +1,278 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file RingQueue.hpp
+ * @brief This file contains the RingQueue class. It is a bounded lock-free
+ *        queue with one consumer and one (SPSC) or several (MPSC) producers,
+ *        used for the packets handed from a thread to another.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef FLAKKARI_RINGQUEUE_HPP_
+#define FLAKKARI_RINGQUEUE_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace Flakkari::Network {
+
+/**
+ * @brief Occupancy of a RingQueue, read without locking (the counters of a
+ * queue in use may be a few operations apart)
+ */
+struct RingStats {
+    std::size_t capacity = 0;  // Number of slots
+    std::size_t size = 0;      // Values waiting
+    std::size_t highWater = 0; // Largest size seen by a push
+    uint64_t pushed = 0;       // Values pushed since the creation
+    uint64_t popped = 0;       // Values popped since the creation
+    uint64_t rejected = 0;     // Values not pushed because the queue was full
+};
+
+/**
+ * @brief Bounded lock-free queue with one consumer
+ *
+ * @details The values live in a ring of a power of two slots. The producers
+ * and the consumer only share two monotonic positions, each on its own cache
+ * line: the consumer never waits for a lock held by a producer and a
+ * producer never waits for the consumer, a full queue rejects the push
+ * instead. Batch operations publish or release a whole batch with one atomic
+ * store, so the hand-off of a tick of packets costs a few atomics, not one
+ * lock per packet.
+ *
+ * With several producers (MultiProducer), a push claims its slots with a
+ * compare-and-swap of the tail, then publishes each slot with its sequence
+ * once written, so that the consumer never reads a slot still being written
+ * by a slower producer.
+ *
+ * Only the consumer thread may call front(), pop(), drain() and clear().
+ *
+ * @tparam T  Type of the values (movable).
+ * @tparam MultiProducer  Whether several threads push at once.
+ *
+ * @example "Flakkari/Network/RingQueue.hpp"
+ * @code
+ * SpscRing<Protocol::PacketView<Protocol::CommandId>> queue(256);
+ * queue.push(packet);                                    // network thread
+ * queue.drain([](auto &packet) { handle(packet); }, 32); // game thread
+ * @endcode
+ */
+template <typename T, bool MultiProducer = false> class RingQueue {
+public:
+    explicit RingQueue(std::size_t capacity = 256)
+        : _capacity(roundCapacity(capacity)), _mask(_capacity - 1), _slots(std::make_unique<Slot[]>(_capacity))
+    {
+    }
+    RingQueue(const RingQueue &) = delete;
+    RingQueue &operator=(const RingQueue &) = delete;
+    ~RingQueue() { clear(); }
+
+public:
+    /**
+     * @brief Push a value, if there is a free slot
+     *
+     * @param value  The value
+     * @return true  If the value was pushed, false if the queue was full
+     */
+    bool push(const T &value) { return pushWith(1, [&](T *slot, std::size_t) { new (slot) T(value); }) == 1; }
+    bool push(T &&value) { return pushWith(1, [&](T *slot, std::size_t) { new (slot) T(std::move(value)); }) == 1; }
+
+    /**
+     * @brief Push the first values of a range, as many as there are free
+     * slots, in one claim
+     *
+     * @param values  The first value of the range
+     * @param count  The number of values of the range
+     * @return std::size_t  The number of values pushed (the first ones)
+     */
+    std::size_t push(const T *values, std::size_t count)
+    {
+        return pushWith(count, [&](T *slot, std::size_t i) { new (slot) T(values[i]); });
+    }
+
+    /**
+     * @brief Get the value at the front of the queue
+     *
+     * @return T*  The value, nullptr if the queue is empty
+     */
+    [[nodiscard]] T *front()
+    {
+        uint64_t head = _head.value.load(std::memory_order_relaxed);
+        if (!isPublished(head))
+            return nullptr;
+        return _slots[head & _mask].get();
+    }
+
+    /**
+     * @brief Pop the value at the front of the queue
+     *
+     * @param value  Where to move the value
+     * @return true  If a value was popped, false if the queue was empty
+     */
+    bool pop(T &value) { return drain([&](T &front) { value = std::move(front); }, 1) == 1; }
+
+    /**
+     * @brief Remove the value at the front of the queue, if any
+     */
+    void pop() { drain([](T &) {}, 1); }
+
+    /**
+     * @brief Pop up to `max` values and call a function on each of them, in
+     * order. The slots are given back to the producers once at the end.
+     *
+     * @param function  Called with each value (T&), which it may move from
+     * @param max  The largest number of values to pop
+     * @return std::size_t  The number of values popped
+     */
+    template <typename Function> std::size_t drain(Function &&function, std::size_t max = SIZE_MAX)
+    {
+        uint64_t head = _head.value.load(std::memory_order_relaxed);
+        std::size_t count = 0;
+        uint64_t tail = MultiProducer ? 0 : _tail.value.load(std::memory_order_acquire);
+
+        for (; count < max && (MultiProducer ? isPublished(head + count) : head + count < tail); ++count)
+        {
+            T *value = _slots[(head + count) & _mask].get();
+            function(*value);
+            value->~T();
+        }
+        if (count > 0)
+            _head.value.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    /**
+     * @brief Destroy the values waiting in the queue (consumer thread)
+     *
+     * @return std::size_t  The number of values removed
+     */
+    std::size_t clear() { return drain([](T &) {}); }
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    [[nodiscard]] std::size_t capacity() const { return _capacity; }
+
+    /**
+     * @brief Get the number of values waiting, claimed slots included
+     */
+    [[nodiscard]] std::size_t size() const
+    {
+        uint64_t head = _head.value.load(std::memory_order_acquire);
+        uint64_t tail = _tail.value.load(std::memory_order_acquire);
+        return tail > head ? static_cast<std::size_t>(tail - head) : 0;
+    }
+
+    [[nodiscard]] RingStats getStats() const
+    {
+        RingStats stats;
+        stats.capacity = _capacity;
+        stats.popped = _head.value.load(std::memory_order_relaxed);
+        stats.pushed = _tail.value.load(std::memory_order_relaxed);
+        stats.size = stats.pushed > stats.popped ? static_cast<std::size_t>(stats.pushed - stats.popped) : 0;
+        stats.highWater = _highWater.load(std::memory_order_relaxed);
+        stats.rejected = _rejected.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence = 0; // Position of the value + 1 once written (MultiProducer only)
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T *get() { return std::launder(reinterpret_cast<T *>(storage)); }
+    };
+
+    /**
+     * @brief A position alone on its cache line, so that the producers and the
+     * consumer do not invalidate each other's line on every operation
+     */
+    struct alignas(64) Position {
+        std::atomic<uint64_t> value = 0;
+    };
+
+    static std::size_t roundCapacity(std::size_t capacity)
+    {
+        std::size_t rounded = 2;
+        while (rounded < capacity)
+            rounded *= 2;
+        return rounded;
+    }
+
+    /**
+     * @brief Claim up to `count` slots, construct the values in them with
+     * `construct(slot, index)` and publish them
+     */
+    template <typename Construct> std::size_t pushWith(std::size_t count, Construct &&construct)
+    {
+        uint64_t tail = _tail.value.load(std::memory_order_relaxed);
+        std::size_t claimed;
+
+        for (;;)
+        {
+            uint64_t head = _head.value.load(std::memory_order_acquire);
+            // with several producers, `tail` may be older than `head`: the compare-and-swap then fails
+            auto used = tail > head ? static_cast<std::size_t>(tail - head) : 0;
+            claimed = std::min(count, _capacity - used);
+            if (claimed == 0)
+                return _rejected.fetch_add(count, std::memory_order_relaxed), 0;
+            if constexpr (!MultiProducer)
+                break;
+            else if (_tail.value.compare_exchange_weak(tail, tail + claimed, std::memory_order_relaxed))
+                break;
+        }
+
+        for (std::size_t i = 0; i < claimed; ++i)
+        {
+            Slot &slot = _slots[(tail + i) & _mask];
+            construct(slot.get(), i);
+            if constexpr (MultiProducer)
+                slot.sequence.store(tail + i + 1, std::memory_order_release);
+        }
+        if constexpr (!MultiProducer)
+            _tail.value.store(tail + claimed, std::memory_order_release);
+
+        if (claimed < count)
+            _rejected.fetch_add(count - claimed, std::memory_order_relaxed);
+        uint64_t head = _head.value.load(std::memory_order_relaxed);
+        auto occupancy = tail + claimed > head ? static_cast<std::size_t>(tail + claimed - head) : 0;
+        if (occupancy > _highWater.load(std::memory_order_relaxed))
+            _highWater.store(occupancy, std::memory_order_relaxed);
+        return claimed;
+    }
+
+    /**
+     * @brief Whether the value at a position is written (consumer thread)
+     */
+    bool isPublished(uint64_t position) const
+    {
+        if constexpr (MultiProducer)
+            return _slots[position & _mask].sequence.load(std::memory_order_acquire) == position + 1;
+        else
+            return position < _tail.value.load(std::memory_order_acquire);
+    }
+
+private:
+    const std::size_t _capacity;           // Number of slots, a power of two
+    const std::size_t _mask;               // _capacity - 1
+    std::unique_ptr<Slot[]> _slots;        // The ring
+    Position _head;                        // Position of the next value to pop, written by the consumer
+    Position _tail;                        // Position of the next slot to claim, written by the producers
+    std::atomic<std::size_t> _highWater{}; // Largest occupancy seen by a push
+    std::atomic<uint64_t> _rejected{};     // Values rejected by a full queue
+};
+
+template <typename T> using SpscRing = RingQueue<T, false>;
+template <typename T> using MpscRing = RingQueue<T, true>;
+
+} // namespace Flakkari::Network
+
+#endif /* !FLAKKARI_RINGQUEUE_HPP_ */
@@ -13,6 +13,7 @@ namespace Flakkari::Network {
 
 #if defined(__linux__)
 #    include <cstring>
+#    include <netinet/udp.h>
 #    include <sys/socket.h>
 #    include <sys/uio.h>
 #endif
@@ -341,53 +342,112 @@ std::optional<std::pair<std::shared_ptr<Address>, Buffer>> Socket::receiveFrom(i
     return std::make_pair(std::make_shared<Address>(addr, _address->getSocketType(), ip_type), data);
 }
 
-std::vector<std::pair<std::shared_ptr<Address>, Buffer>> Socket::receiveBatch(uint32_t maxMessages, int flags) const
+#if defined(__linux__)
+/**
+ * @brief Receive up to `count` messages with one recvmmsg, the i-th in
+ * buffers[i], then call emit(i, sender, data, length, segment) for each of
+ * them, where segment is the size of the datagrams of a message coalesced
+ * by GRO (its length otherwise).
+ *
+ * @return int  The number of messages received, -1 on error (0 on EAGAIN)
+ */
+template <typename Emit>
+static int receiveMessages(int socket, byte *const *buffers, size_t bufferSize, uint32_t count, bool gro, int flags,
+                           Emit &&emit)
 {
-    std::vector<std::pair<std::shared_ptr<Address>, Buffer>> results;
-    if (maxMessages == 0u)
-        return results;
+    constexpr size_t controlWords = (CMSG_SPACE(sizeof(int)) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
 
-#if defined(__linux__)
-    std::vector<Buffer> buffers(maxMessages, Buffer(4096, 0));
-    std::vector<mmsghdr> msgs(maxMessages);
-    std::vector<iovec> iov(maxMessages);
-    std::vector<sockaddr_storage> addrs(maxMessages);
+    thread_local std::vector<mmsghdr> msgs;
+    thread_local std::vector<iovec> iov;
+    thread_local std::vector<sockaddr_storage> addrs;
+    thread_local std::vector<uint64_t> control;
 
-    std::memset(msgs.data(), 0u, sizeof(mmsghdr) * msgs.size());
+    msgs.resize(count);
+    iov.resize(count);
+    addrs.resize(count);
+    control.resize(count * controlWords);
 
-    for (uint32_t i = 0u; i < maxMessages; ++i)
+    std::memset(msgs.data(), 0u, sizeof(mmsghdr) * count);
+
+    for (uint32_t i = 0u; i < count; ++i)
     {
-        iov[i].iov_base = buffers[i].data();
-        iov[i].iov_len = buffers[i].size();
+        iov[i].iov_base = buffers[i];
+        iov[i].iov_len = bufferSize;
 
         msgs[i].msg_hdr.msg_iov = &iov[i];
         msgs[i].msg_hdr.msg_iovlen = 1u;
         msgs[i].msg_hdr.msg_name = &addrs[i];
         msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        if (gro)
+        {
+            msgs[i].msg_hdr.msg_control = &control[i * controlWords];
+            msgs[i].msg_hdr.msg_controllen = controlWords * sizeof(uint64_t);
+        }
     }
 
-    int received = ::recvmmsg(_socket, msgs.data(), (uint32_t) msgs.size(), flags, nullptr);
+    int received = ::recvmmsg(socket, msgs.data(), count, flags, nullptr);
     if (received == -1)
     {
         if (errno == EAGAIN || errno == EWOULDBLOCK)
-            return results;
-        FLAKKARI_LOG_ERROR("recvmmsg failed, error: " + STD_ERROR);
-        return results;
+            return 0;
+        return FLAKKARI_LOG_ERROR("recvmmsg failed, error: " + STD_ERROR), -1;
     }
 
-    Address::SocketType socket_type = _address ? _address->getSocketType() : Address::SocketType::UDP;
-
     for (int i = 0; i < received; ++i)
     {
         auto &m = msgs[i];
-        ssize_t len = m.msg_len;
-        sockaddr_storage &addr = addrs[i];
-        Address::IpType ip_type = getIpTypeFromFamily(addr);
-
-        results.emplace_back(std::make_shared<Address>(addr, socket_type, ip_type),
-                             Buffer(buffers[i].begin(), buffers[i].begin() + (size_t) len));
+        size_t segment = m.msg_len;
+
+#    if defined(UDP_GRO)
+        // a message coalesced by the kernel carries the size of its datagrams
+        for (cmsghdr *cmsg = gro ? CMSG_FIRSTHDR(&m.msg_hdr) : nullptr; cmsg; cmsg = CMSG_NXTHDR(&m.msg_hdr, cmsg))
+        {
+            int size = 0;
+            if (cmsg->cmsg_level != SOL_UDP || cmsg->cmsg_type != UDP_GRO)
+                continue;
+            std::memcpy(&size, CMSG_DATA(cmsg), sizeof(size));
+            segment = size > 0 ? (size_t) size : m.msg_len;
+        }
+#    endif
+
+        emit(i, addrs[i], buffers[i], (size_t) m.msg_len, segment);
     }
+    return received;
+}
+#endif
 
+std::vector<std::pair<std::shared_ptr<Address>, Buffer>> Socket::receiveBatch(uint32_t maxMessages, int flags) const
+{
+    std::vector<std::pair<std::shared_ptr<Address>, Buffer>> results;
+    if (maxMessages == 0u)
+        return results;
+
+#if defined(__linux__)
+    const size_t bufferSize = _gro ? GRO_BUFFER_SIZE : 4096u;
+
+    // reused between calls: a slab of maxMessages * 4 KiB is too large for the heap cache of malloc
+    thread_local std::vector<byte> slab;
+    thread_local std::vector<byte *> buffers;
+
+    if (slab.size() < maxMessages * bufferSize)
+        slab.resize(maxMessages * bufferSize);
+    buffers.resize(maxMessages);
+    for (uint32_t i = 0u; i < maxMessages; ++i)
+        buffers[i] = &slab[i * bufferSize];
+
+    Address::SocketType socket_type = _address ? _address->getSocketType() : Address::SocketType::UDP;
+
+    receiveMessages(_socket, buffers.data(), bufferSize, maxMessages, _gro, flags,
+                    [&](int, sockaddr_storage &addr, const byte *data, size_t len, size_t segment) {
+                        auto address = std::make_shared<Address>(addr, socket_type, getIpTypeFromFamily(addr));
+                        size_t offset = 0u;
+                        do
+                        {
+                            size_t end = std::min(len, offset + segment);
+                            results.emplace_back(address, Buffer(data + offset, data + end));
+                            offset = end;
+                        } while (offset < len);
+                    });
     return results;
 #else
     for (uint32_t i = 0u; i < maxMessages; ++i)
@@ -401,6 +461,213 @@ std::vector<std::pair<std::shared_ptr<Address>, Buffer>> Socket::receiveBatch(ui
 #endif
 }
 
+size_t Socket::receiveBatch(BufferPool &pool, std::vector<std::pair<Endpoint, BufferView>> &datagrams,
+                            uint32_t maxMessages, int flags) const
+{
+    size_t first = datagrams.size();
+    if (maxMessages == 0u)
+        return 0u;
+
+#if defined(__linux__)
+    thread_local std::vector<BufferSlab *> slabs;
+    thread_local std::vector<byte *> buffers;
+
+    slabs.resize(maxMessages);
+    buffers.resize(maxMessages);
+
+    uint32_t count = (uint32_t) pool.acquire(slabs.data(), maxMessages);
+    for (uint32_t i = 0u; i < count; ++i)
+        buffers[i] = slabs[i]->data;
+
+    receiveMessages(_socket, buffers.data(), pool.getSlabSize(), count, _gro, flags,
+                    [&](int i, sockaddr_storage &addr, const byte *data, size_t len, size_t segment) {
+                        auto endpoint = Endpoint::from(addr);
+                        size_t offset = 0u;
+                        do
+                        {
+                            size_t end = std::min(len, offset + segment);
+                            datagrams.emplace_back(endpoint, BufferView(slabs[i], data + offset, end - offset));
+                            offset = end;
+                        } while (offset < len);
+                    });
+
+    // the slabs that received nothing go back to the pool
+    for (uint32_t i = 0u; i < count; ++i)
+        BufferPool::release(slabs[i]);
+#else
+    (void) pool;
+    for (uint32_t i = 0u; i < maxMessages; ++i)
+    {
+        auto pkt = receiveFrom(flags);
+        if (!pkt.has_value())
+            break;
+        datagrams.emplace_back(pkt->first->getEndpoint(), BufferView::copyOf(pkt->second));
+    }
+#endif
+    return datagrams.size() - first;
+}
+
+static const Buffer &payloadOf(const Buffer &buffer) { return buffer; }
+static const Buffer &payloadOf(const Buffer *buffer) { return *buffer; }
+
+size_t Socket::sendBatch(const std::vector<std::pair<std::shared_ptr<Address>, Buffer>> &datagrams, int flags) const
+{
+    return sendBatchOf(datagrams, flags);
+}
+
+size_t Socket::sendBatch(const std::vector<std::pair<std::shared_ptr<Address>, const Buffer *>> &datagrams,
+                         int flags) const
+{
+    return sendBatchOf(datagrams, flags);
+}
+
+template <typename Datagram>
+size_t Socket::sendBatchOf(const std::vector<Datagram> &datagrams, int flags) const
+{
+#if defined(__linux__)
+    constexpr size_t maxMessages = 1024u; // UIO_MAXIOV, the limit of one sendmmsg
+    constexpr size_t controlWords = (CMSG_SPACE(sizeof(uint16_t)) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    // the arrays of the calls are kept by the sending thread: a batch of the usual size allocates nothing
+    thread_local std::vector<mmsghdr> msgs;
+    thread_local std::vector<iovec> iov;
+    thread_local std::vector<size_t> starts; // First datagram of each message
+    thread_local std::vector<uint64_t> control;
+    size_t sent = 0u;
+
+    msgs.resize(std::min(datagrams.size(), maxMessages));
+    iov.resize(datagrams.size());
+    starts.resize(msgs.size() + 1u);
+    control.resize(msgs.size() * controlWords);
+
+    for (size_t first = 0u; first < datagrams.size();)
+    {
+        size_t count = 0u;
+        size_t next = first;
+
+        std::memset(msgs.data(), 0u, sizeof(mmsghdr) * msgs.size());
+        while (next < datagrams.size() && count < msgs.size())
+        {
+            const auto &address = datagrams[next].first;
+            const auto &addr = address ? address->getAddrInfo() : nullptr;
+            if (addr == nullptr)
+            {
+                FLAKKARI_LOG_ERROR("Address is nullptr");
+                ++next;
+                continue;
+            }
+
+            // with GSO, the datagrams of the same size to the same address are one message split by the kernel
+            size_t segment = payloadOf(datagrams[next].second).size();
+            size_t run = 1u;
+            size_t total = segment;
+            while (_gso && segment > 0u && next + run < datagrams.size() && run < MAX_GSO_SEGMENTS)
+            {
+                const auto &otherAddress = datagrams[next + run].first;
+                const auto &data = payloadOf(datagrams[next + run].second);
+                const auto &otherAddr = otherAddress ? otherAddress->getAddrInfo() : nullptr;
+                size_t previous = payloadOf(datagrams[next + run - 1u].second).size();
+
+                if (previous != segment || data.empty() || data.size() > segment ||
+                    total + data.size() > MAX_GSO_SIZE || otherAddr == nullptr ||
+                    (otherAddress != address && (otherAddr->ai_addrlen != addr->ai_addrlen ||
+                                                 std::memcmp(otherAddr->ai_addr, addr->ai_addr, addr->ai_addrlen))))
+                    break;
+                total += data.size();
+                ++run;
+            }
+
+            for (size_t i = next; i < next + run; ++i)
+            {
+                iov[i].iov_base = const_cast<byte *>(payloadOf(datagrams[i].second).getData());
+                iov[i].iov_len = payloadOf(datagrams[i].second).getSize();
+            }
+
+            auto &msg = msgs[count].msg_hdr;
+            msg.msg_iov = &iov[next];
+            msg.msg_iovlen = run;
+            msg.msg_name = addr->ai_addr;
+            msg.msg_namelen = addr->ai_addrlen;
+#    if defined(UDP_SEGMENT)
+            if (run > 1u)
+            {
+                auto gso = (uint16_t) segment;
+
+                msg.msg_control = &control[count * controlWords];
+                msg.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+                cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+                cmsg->cmsg_level = SOL_UDP;
+                cmsg->cmsg_type = UDP_SEGMENT;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                std::memcpy(CMSG_DATA(cmsg), &gso, sizeof(gso));
+            }
+#    endif
+            starts[count++] = next;
+            next += run;
+        }
+        starts[count] = next;
+        if (count == 0u)
+        {
+            first = next;
+            continue;
+        }
+
+        int result = ::sendmmsg(_socket, msgs.data(), (uint32_t) count, flags);
+        if (result == -1 && msgs[0].msg_hdr.msg_iovlen > 1u && (errno == EIO || errno == EINVAL))
+        {
+            // the route cannot segment (no checksum offload, or datagrams above its MTU): send them one by one
+            FLAKKARI_LOG_WARNING("UDP segmentation offload refused, error: " + STD_ERROR + ", turning it off");
+            _gso = false;
+            continue;
+        }
+        if (result == -1)
+        {
+            // the first message failed: skip it, the next call sends the others
+            FLAKKARI_LOG_ERROR("Failed to send to \"" + datagrams[starts[0]].first->toString().value_or("No address") +
+                               "\", error: " + STD_ERROR);
+            first = starts[1];
+            continue;
+        }
+        for (int i = 0; i < result; ++i)
+            sent += msgs[i].msg_hdr.msg_iovlen;
+        first = starts[result];
+    }
+    return sent;
+#else
+    size_t sent = 0u;
+
+    for (const auto &datagram : datagrams)
+    {
+        if (datagram.first == nullptr || datagram.first->getAddrInfo() == nullptr)
+            continue;
+        sendTo(datagram.first, payloadOf(datagram.second), flags);
+        ++sent;
+    }
+    return sent;
+#endif
+}
+
+bool Socket::enableGso()
+{
+#if defined(__linux__) && defined(UDP_SEGMENT)
+    int size = 0;
+
+    // 0 keeps the datagrams whole unless a send asks for segmentation: this only probes the kernel
+    _gso = ::setsockopt(_socket, SOL_UDP, UDP_SEGMENT, &size, sizeof(size)) == 0;
+#endif
+    return _gso;
+}
+
+bool Socket::enableGro()
+{
+#if defined(__linux__) && defined(UDP_GRO)
+    int on = 1;
+
+    _gro = ::setsockopt(_socket, SOL_UDP, UDP_GRO, &on, sizeof(on)) == 0;
+#endif
+    return _gro;
+}
+
 void Socket::close() const
 {
 #ifdef _WIN32
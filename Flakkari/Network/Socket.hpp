@@ -18,6 +18,7 @@
 
 #include "Address.hpp"
 #include "Buffer.hpp"
+#include "BufferPool.hpp"
 
 #include <iostream>
 #include <memory>
@@ -128,6 +129,10 @@ public:
     using ip_t = const std::string &;
     using socket_t = SOCKET;
 
+    static constexpr size_t MAX_GSO_SEGMENTS = 64;   // Datagrams of one segmented send (UDP_MAX_SEGMENTS)
+    static constexpr size_t MAX_GSO_SIZE = 65000;    // Bytes of one segmented send (below the 64 KiB of an IP packet)
+    static constexpr size_t GRO_BUFFER_SIZE = 65536; // Receive buffer of a message when GRO is on
+
 public:
     Socket() = default;
     Socket(const Socket &) = delete;
@@ -200,6 +205,30 @@ public:
      */
     void setBlocking(bool blocking = true) const;
 
+    /**
+     * @brief Let the kernel split the runs of datagrams of the same size to
+     * one address that sendBatch sends (UDP_SEGMENT, generic segmentation
+     * offload, Linux 4.18).
+     * This function is only used by UDP sockets.
+     *
+     * @return true  If the kernel supports it.
+     * @return false  If it does not: each datagram is sent on its own.
+     */
+    bool enableGso();
+
+    /**
+     * @brief Accept datagrams coalesced by the kernel on receive (UDP_GRO,
+     * generic receive offload, Linux 5.0). receiveBatch splits them back.
+     * This function is only used by UDP sockets.
+     *
+     * @return true  If the kernel supports it.
+     * @return false  If it does not.
+     */
+    bool enableGro();
+
+    [[nodiscard]] bool hasGso() const { return _gso; }
+    [[nodiscard]] bool hasGro() const { return _gro; }
+
     /**
      * @brief Send data to the socket.
      * This function is only used by TCP sockets.
@@ -287,11 +316,57 @@ public:
      * @param maxMessages  Maximum number of messages to receive in one call.
      * @param flags  Flags to pass to recvfrom / recvmmsg.
      * @return vector of (Address, Buffer) pairs received. Empty if none or on EAGAIN/EWOULDBLOCK.
-     * @note On Linux this uses recvmmsg for efficiency. On other platforms it falls back to repeated recvfrom.
+     * @note On Linux this uses recvmmsg for efficiency. With GRO (enableGro), a message coalesced by the kernel is
+     * split back into its datagrams, so more than maxMessages may be returned. On other platforms it falls back to
+     * repeated recvfrom.
      */
     std::vector<std::pair<std::shared_ptr<Address>, Buffer>> receiveBatch(uint32_t maxMessages = 16u,
                                                                           int flags = 0) const;
 
+    /**
+     * @brief Receive multiple UDP messages in one syscall, in slabs of a pool.
+     * This function is only used by UDP sockets.
+     *
+     * @param pool  The pool of the slabs, of at least 4096 bytes (GRO_BUFFER_SIZE to take the GRO messages whole).
+     * @param datagrams  Where to append the (Endpoint, BufferView) pairs received. Reuse it between calls: its
+     * capacity is kept, so that a batch allocates nothing for the datagrams.
+     * @param maxMessages  Maximum number of messages to receive in one call.
+     * @param flags  Flags to pass to recvfrom / recvmmsg.
+     * @return size_t  Number of datagrams appended. 0 if none or on EAGAIN/EWOULDBLOCK.
+     * @note The datagrams are not copied: each view references the slab it was received in, which goes back to
+     * the pool when the last view is destroyed. At most one slab per message is taken from the pool, and they are
+     * taken in one lock. The senders are Endpoints, read from the addresses without any resolution (make an
+     * Address of the ones to answer). On other platforms it falls back to repeated recvfrom and copies.
+     */
+    size_t receiveBatch(BufferPool &pool, std::vector<std::pair<Endpoint, BufferView>> &datagrams,
+                        uint32_t maxMessages = 16u, int flags = 0) const;
+
+    /**
+     * @brief Send multiple UDP messages in one syscall (batch).
+     * This function is only used by UDP sockets.
+     *
+     * @param datagrams  (Address, Buffer) pairs to send, in order.
+     * @param flags  Flags to pass to sendto / sendmmsg.
+     * @return size_t  Number of messages sent. A message that fails is logged and skipped.
+     * @note On Linux this uses sendmmsg (up to 1024 messages per call). With GSO (enableGso), consecutive datagrams
+     * of the same size to the same address go in one message that the kernel splits. On other platforms it falls
+     * back to repeated sendto.
+     */
+    size_t sendBatch(const std::vector<std::pair<std::shared_ptr<Address>, Buffer>> &datagrams, int flags = 0) const;
+
+    /**
+     * @brief Send multiple UDP messages in one syscall (batch), without
+     * copying nor owning them (the frames of FrameWriters, for instance).
+     * This function is only used by UDP sockets.
+     *
+     * @param datagrams  (Address, Buffer pointer) pairs to send, in order. The buffers must outlive the call.
+     * @param flags  Flags to pass to sendto / sendmmsg.
+     * @return size_t  Number of messages sent. A message that fails is logged and skipped.
+     * @note Same batching and GSO as the other sendBatch.
+     */
+    size_t sendBatch(const std::vector<std::pair<std::shared_ptr<Address>, const Buffer *>> &datagrams,
+                     int flags = 0) const;
+
     /**
      * @brief Close the socket.
      *
@@ -314,10 +389,17 @@ private:
      */
     [[nodiscard]] inline Address::IpType getIpTypeFromFamily(const sockaddr_storage &addrStorage) const;
 
+    /**
+     * @brief Send a batch of (Address, Buffer) or (Address, Buffer pointer) pairs, see sendBatch.
+     */
+    template <typename Datagram> size_t sendBatchOf(const std::vector<Datagram> &datagrams, int flags) const;
+
 protected:
 private:
     socket_t _socket;
     std::shared_ptr<Address> _address = nullptr;
+    mutable bool _gso = false; // Segmentation offload on send (turned off if the route refuses it)
+    bool _gro = false;         // Coalesced datagrams on receive
 };
 
 /**
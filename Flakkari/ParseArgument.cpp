@@ -41,6 +41,18 @@ ParseArgument::ParseArgument(int ac, const char *av[])
                 throw std::runtime_error("Invalid port number, must be between 1024 and 65535");
             ++i;
         }
+        else if (std::string(av[i]) == "-s" || std::string(av[i]) == "--shards")
+        {
+            auto shards = std::stoi(av[i + 1]);
+            if (shards < 1 || shards > 64)
+                throw std::runtime_error("Invalid number of shards, must be between 1 and 64");
+            _shards = static_cast<std::size_t>(shards);
+            ++i;
+        }
+        else if (std::string(av[i]) == "-u" || std::string(av[i]) == "--io-uring")
+        {
+            _ioUring = true;
+        }
         else if (std::string(av[i]) == "-dr" || std::string(av[i]) == "--dry-run")
         {
             _dryRun = true;
@@ -70,6 +70,18 @@ public:
      */
     unsigned short getPort() const;
 
+    /**
+     * @brief Gets the number of shards (sockets sharing the port).
+     * @return The number of shards, default is 1.
+     */
+    std::size_t getShards() const { return _shards; }
+
+    /**
+     * @brief Gets the io_uring flag.
+     * @return True if the shards receive with io_uring, false otherwise.
+     */
+    bool isIoUring() const { return _ioUring; }
+
     /**
      * @brief Gets the dry run flag.
      * @return True if the dry run flag is set, false otherwise.
@@ -98,6 +110,8 @@ private:
     std::string _gameDir;     ///< The game directory.
     std::string _ip;          ///< The IP address, default is "localhost".
     unsigned short _port = 0; ///< The port number, default is 8081.
+    std::size_t _shards = 1;  ///< The number of shards, default is 1.
+    bool _ioUring = false;    ///< Flag to receive with io_uring.
     bool _dryRun = false;     ///< Flag to indicate a dry run.
 
     static constexpr const char *HELP_MESSAGE =
@@ -105,6 +119,9 @@ private:
         "  -g|--games <gameDir>  The directory of the games folder\n"
         "  -i|--ip <ip>          The ip to bind the server to (default: localhost)\n"
         "  -p|--port <port>      The port to bind the server to (default: 8081)\n"
+        "  -s|--shards <n>       The number of sockets and receive threads on the port (default: 1)\n"
+        "  -u|--io-uring         Receive with io_uring when the kernel supports it (Linux 6.0), datagrams of\n"
+        "                        4096 bytes at most (larger ones are dropped and logged)\n"
         "  -dr|--dry-run         Run the server in dry-run mode\n"
         "  -d|--default          Use default values (Games, localhost, 8081)\n"
         "  -v|--version          Display the version of the Flakkari Library\n"
@@ -0,0 +1,129 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file Checksum.hpp
+ * @brief This file contains the DatagramChecksum class. It appends the
+ *        CRC32C of a datagram to it, and checks and strips it on the other
+ *        side.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef FLAKKARI_CHECKSUM_HPP_
+#define FLAKKARI_CHECKSUM_HPP_
+
+#include "../Network/Buffer.hpp"
+#include "../Network/Kernels.hpp"
+
+#include <cstring>
+
+namespace Flakkari::Protocol {
+
+/**
+ * @brief Counters of a DatagramChecksum
+ */
+struct ChecksumStats {
+    uint64_t checked = 0; // Datagrams received with a trailer
+    uint64_t invalid = 0; // Datagrams received whose trailer did not match (dropped)
+};
+
+/**
+ * @brief Integrity check of the whole datagrams of a connection
+ *
+ * @details The UDP checksum is 16 bits, optional over IPv4, and lets through
+ * the corruption of the middleboxes that rewrite it. A connection can ask
+ * for a CRC32C (Castagnoli polynomial) of every datagram on top of it, as a
+ * trailer after the last packet:
+ *
+ *      packets of the datagram (compressed or not) | CRC32C of them (32 bits)
+ *
+ * The trailer covers the datagram as it goes on the wire: it is appended
+ * after the compression and checked, then stripped, before the
+ * decompression. A datagram whose trailer does not match is dropped as the
+ * network would have, and the reliability layer sends its reliable packets
+ * again. The CRC32C runs on the crc32 instruction of the CPU when it has
+ * one (see Network::Kernels): about 90 ns for a datagram of 1200 bytes.
+ *
+ * The client asks for it with the OPTION bit of the options of REQ_CONNECT
+ * (after the id of its dictionary). Every datagram of the client has the
+ * trailer from then on, REQ_CONNECT included, and every datagram the server
+ * sends it too.
+ *
+ * @example "Flakkari/Protocol/Checksum.hpp"
+ * @code
+ * DatagramChecksum checksum(true);
+ * checksum.seal(datagram);
+ * std::size_t size = received.size();
+ * if (!checksum.open(received.data(), size))
+ *     return; // corrupted
+ * handle(received.data(), size);
+ * @endcode
+ */
+class DatagramChecksum {
+public:
+    static constexpr std::size_t SIZE = sizeof(uint32_t); // Bytes of the trailer
+    static constexpr uint8_t OPTION = 0x01;               // Bit of the options of REQ_CONNECT asking for it
+
+public:
+    explicit DatagramChecksum(bool enabled = false) : _enabled(enabled) {}
+
+    /**
+     * @brief Append the CRC32C of a datagram to it (nothing when disabled)
+     *
+     * @param datagram  The datagram, as it is sent on the wire
+     */
+    void seal(Network::Buffer &datagram) const
+    {
+        if (!_enabled)
+            return;
+        auto crc = Network::Kernels::get().crc32c(0, datagram.data(), datagram.size());
+        auto size = datagram.size();
+        datagram.resize(size + SIZE);
+        std::memcpy(datagram.data() + size, &crc, SIZE);
+    }
+
+    /**
+     * @brief Check the trailer of a received datagram and take it off its
+     * size (nothing when disabled)
+     *
+     * @param data  The datagram
+     * @param size  The size of the datagram, then of its packets without the trailer
+     * @return false  If the trailer is missing or does not match: the datagram must be dropped
+     */
+    [[nodiscard]] bool open(const byte *data, std::size_t &size)
+    {
+        if (!_enabled)
+            return true;
+        ++_stats.checked;
+
+        uint32_t crc;
+        if (size < SIZE)
+            return ++_stats.invalid, false;
+        std::memcpy(&crc, data + size - SIZE, SIZE);
+        if (Network::Kernels::get().crc32c(0, data, size - SIZE) != crc)
+            return ++_stats.invalid, false;
+        size -= SIZE;
+        return true;
+    }
+
+    /**
+     * @brief Get the bytes the trailer adds to a datagram, to take off the MTU
+     */
+    [[nodiscard]] std::size_t getOverhead() const { return _enabled ? SIZE : 0; }
+
+    [[nodiscard]] bool isEnabled() const { return _enabled; }
+    [[nodiscard]] const ChecksumStats &getStats() const { return _stats; }
+
+private:
+    bool _enabled;        // The datagrams of the connection have the trailer
+    ChecksumStats _stats; // Counters
+};
+
+} // namespace Flakkari::Protocol
+
+#endif /* !FLAKKARI_CHECKSUM_HPP_ */
@@ -43,6 +43,8 @@ enum class CommandId : uint8_t {
     REP_LOGOUT = 13,   // Server -> Client [Logout accepted]: ()
     REQ_REGISTER = 14, // Client -> Server [Register]: (user_id, username, password)
     REP_REGISTER = 15, // Server -> Client [Register accepted]: ()
+    REQ_COMPRESSED = 16, // Client -> Server [Datagram compressed with the dictionary]: (size, block)
+    REP_COMPRESSED = 17, // Server -> Client [Datagram compressed with the dictionary]: (size, block)
     // 20 - 29: Game
     REQ_ENTITY_SPAWN = 20,   // Server -> Client [Spawn entity]: (id)(component (position, rotation, velocity, etc))
     REP_ENTITY_SPAWN = 21,   // Client -> Server [Entity spawned]: ()
@@ -137,6 +139,8 @@ public:
         case CommandId::REP_LOGOUT: return "REP_LOGOUT";
         case CommandId::REQ_REGISTER: return "REQ_REGISTER";
         case CommandId::REP_REGISTER: return "REP_REGISTER";
+        case CommandId::REQ_COMPRESSED: return "REQ_COMPRESSED";
+        case CommandId::REP_COMPRESSED: return "REP_COMPRESSED";
         case CommandId::REQ_ENTITY_SPAWN: return "REQ_ENTITY_SPAWN";
         case CommandId::REP_ENTITY_SPAWN: return "REP_ENTITY_SPAWN";
         case CommandId::REQ_ENTITY_UPDATE: return "REQ_ENTITY_UPDATE";
@@ -176,13 +180,19 @@ enum class CommandId : uint8_t {
     REP_DISCONNECT = 3, // Server -> Client [Disconnect accepted]: ()
     REQ_HEARTBEAT = 4,  // Client -> Server [Heartbeat server) (Keep alive)]: (user_id)
     REP_HEARTBEAT = 5,  // Server -> Client [Heartbeat accepted) (Keep alive)]: ()
+    REQ_ACK = 6,        // Client -> Server [Acknowledge reliable packets, nothing else to send]: ()
+    REP_ACK = 7,        // Server -> Client [Acknowledge reliable packets, nothing else to send]: ()
+    REQ_FRAGMENT = 8,   // Client -> Server [Fragment of a packet larger than the MTU]: (message, index, count, slice)
+    REP_FRAGMENT = 9,   // Server -> Client [Fragment of a packet larger than the MTU]: (message, index, count, slice)
     // 10 - 19: Network
-    REQ_LOGIN = 10,    // Client -> Server [Login]: (username, password game)
-    REP_LOGIN = 11,    // Server -> Client [Login accepted]: ()
-    REQ_LOGOUT = 12,   // Client -> Server [Logout]: (user_id)
-    REP_LOGOUT = 13,   // Server -> Client [Logout accepted]: ()
-    REQ_REGISTER = 14, // Client -> Server [Register]: (user_id, username, password)
-    REP_REGISTER = 15, // Server -> Client [Register accepted]: ()
+    REQ_LOGIN = 10,      // Client -> Server [Login]: (username, password game)
+    REP_LOGIN = 11,      // Server -> Client [Login accepted]: ()
+    REQ_LOGOUT = 12,     // Client -> Server [Logout]: (user_id)
+    REP_LOGOUT = 13,     // Server -> Client [Logout accepted]: ()
+    REQ_REGISTER = 14,   // Client -> Server [Register]: (user_id, username, password)
+    REP_REGISTER = 15,   // Server -> Client [Register accepted]: ()
+    REQ_COMPRESSED = 16, // Client -> Server [Datagram compressed with the dictionary]: (size, block)
+    REP_COMPRESSED = 17, // Server -> Client [Datagram compressed with the dictionary]: (size, block)
     // 20 - 29: Game
     REQ_ENTITY_SPAWN = 20,   // Server -> Client [Spawn entity]: (id)(component (position, rotation, velocity, etc))
     REP_ENTITY_SPAWN = 21,   // Client -> Server [Entity spawned]: ()
@@ -209,6 +219,9 @@ enum class CommandId : uint8_t {
     REP_START_GAME = 57,  // Server -> Client [Game started]: ()
     REQ_END_GAME = 58,    // Client -> Server [End game]: (user_id)
     REP_END_GAME = 59,    // Server -> Client [Game ended]: ()
+    // 60 - 69: Snapshot
+    REQ_ENTITIES_MOVED = 60, // Server -> Client [Move entities]: (count)((id)(position, rotation, scale, movable))*
+    REP_ENTITIES_MOVED = 61, // Client -> Server [Entities moved]: ()
     MAX_COMMAND_ID
 };
 
@@ -226,12 +239,18 @@ public:
         case CommandId::REP_DISCONNECT: return "REP_DISCONNECT";
         case CommandId::REQ_HEARTBEAT: return "REQ_HEARTBEAT";
         case CommandId::REP_HEARTBEAT: return "REP_HEARTBEAT";
+        case CommandId::REQ_ACK: return "REQ_ACK";
+        case CommandId::REP_ACK: return "REP_ACK";
+        case CommandId::REQ_FRAGMENT: return "REQ_FRAGMENT";
+        case CommandId::REP_FRAGMENT: return "REP_FRAGMENT";
         case CommandId::REQ_LOGIN: return "REQ_LOGIN";
         case CommandId::REP_LOGIN: return "REP_LOGIN";
         case CommandId::REQ_LOGOUT: return "REQ_LOGOUT";
         case CommandId::REP_LOGOUT: return "REP_LOGOUT";
         case CommandId::REQ_REGISTER: return "REQ_REGISTER";
         case CommandId::REP_REGISTER: return "REP_REGISTER";
+        case CommandId::REQ_COMPRESSED: return "REQ_COMPRESSED";
+        case CommandId::REP_COMPRESSED: return "REP_COMPRESSED";
         case CommandId::REQ_ENTITY_SPAWN: return "REQ_ENTITY_SPAWN";
         case CommandId::REP_ENTITY_SPAWN: return "REP_ENTITY_SPAWN";
         case CommandId::REQ_ENTITY_UPDATE: return "REQ_ENTITY_UPDATE";
@@ -254,6 +273,8 @@ public:
         case CommandId::REP_START_GAME: return "REP_START_GAME";
         case CommandId::REQ_END_GAME: return "REQ_END_GAME";
         case CommandId::REP_END_GAME: return "REP_END_GAME";
+        case CommandId::REQ_ENTITIES_MOVED: return "REQ_ENTITIES_MOVED";
+        case CommandId::REP_ENTITIES_MOVED: return "REP_ENTITIES_MOVED";
         default: return "Unknown";
         }
     }
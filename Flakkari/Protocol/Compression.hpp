@@ -0,0 +1,174 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file Compression.hpp
+ * @brief This file contains the DatagramCompressor class. It replaces a
+ *        datagram by a compressed packet holding it when that makes it
+ *        smaller, and gives the datagram back on the other side.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef FLAKKARI_COMPRESSION_HPP_
+#define FLAKKARI_COMPRESSION_HPP_
+
+#include "../Network/Compressor.hpp"
+#include "Dictionary.hpp"
+#include "Header.hpp"
+
+#include <cstring>
+
+namespace Flakkari::Protocol {
+
+/**
+ * @brief Counters of a DatagramCompressor
+ */
+struct CompressionStats {
+    uint64_t datagrams = 0;  // Datagrams given to compress()
+    uint64_t compressed = 0; // Datagrams sent compressed (the others did not get smaller)
+    uint64_t bytesIn = 0;    // Bytes of the datagrams given to compress()
+    uint64_t bytesOut = 0;   // Bytes of the datagrams after compress(), compressed or not
+    uint64_t invalid = 0;    // Compressed datagrams received that did not decompress
+};
+
+/**
+ * @brief Compression of the whole datagrams of a connection
+ *
+ * @details The packets of a datagram are compressed together, headers
+ * included, and sent as the content of a single compressed packet
+ * (REP_COMPRESSED from the server) whose content is the size of the
+ * datagram (16 bits) followed by the compressed block:
+ *
+ *      Header<Id> | original size | LZ4 block of the packets of the datagram
+ *
+ * The compressed packet is the whole datagram, and is unpacked before the
+ * reliability layer sees the packets: each one keeps its own sequence and
+ * acks. A datagram is only replaced if the compressed packet is smaller,
+ * so compressing never costs a byte on the wire, only the CPU of trying.
+ *
+ * The peers agree on the dictionary in the connect handshake: the client
+ * sends the id of its dictionary in REQ_CONNECT, the server only compresses
+ * what it sends the client if its own has the same id. A peer that does not
+ * know compression sends and receives no compressed packet.
+ *
+ * @tparam Id  Type of the command ids of the headers.
+ *
+ * @example "Flakkari/Protocol/Compression.hpp"
+ * @code
+ * DatagramCompressor<CommandId> compressor(CommandId::REP_COMPRESSED);
+ * compressor.compress(frame);
+ * if (compressor.isCompressed(datagram.data(), datagram.size()))
+ *     packets = compressor.decompress(datagram.data(), datagram.size());
+ * @endcode
+ */
+template <typename Id> class DatagramCompressor {
+public:
+    static constexpr std::size_t OVERHEAD = sizeof(Header<Id>) + sizeof(uint16_t); // Header and original size
+    static constexpr std::size_t MIN_SIZE = 64; // Smaller datagrams are sent as they are: they would not shrink
+
+public:
+    /**
+     * @brief Construct a new DatagramCompressor object
+     *
+     * @param command  The command of the compressed packets (REQ_COMPRESSED or REP_COMPRESSED)
+     * @param dictionary  The dictionary (not copied), the one trained on the game traffic by default
+     * @param size  The size of the dictionary
+     */
+    explicit DatagramCompressor(Id command, const byte *dictionary = DICTIONARY, std::size_t size = sizeof(DICTIONARY))
+        : _command(command), _compressor(dictionary, size)
+    {
+    }
+
+    /**
+     * @brief Replace a datagram by its compressed packet, if it is smaller
+     *
+     * @details The datagram keeps a buffer of at least its capacity, so that
+     * the frames of a FrameWriter stay reserved to the MTU.
+     *
+     * @param datagram  The datagram (packets put end to end)
+     * @return true  If the datagram was replaced
+     */
+    bool compress(Network::Buffer &datagram)
+    {
+        ++_stats.datagrams;
+        _stats.bytesIn += datagram.size();
+
+        // the compressed packet must win a byte at least: a larger block is given up as soon as it is written
+        if (datagram.size() < MIN_SIZE || datagram.size() > UINT16_MAX)
+            return _stats.bytesOut += datagram.size(), false;
+        _scratch.reserve(datagram.capacity());
+        _scratch.resize(datagram.size() - 1);
+        auto size = _compressor.compress(datagram.data(), datagram.size(), _scratch.data() + OVERHEAD,
+                                         _scratch.size() - OVERHEAD);
+        if (size == 0)
+            return _stats.bytesOut += datagram.size(), false;
+
+        Header<Id> header;
+        header._commandId = _command;
+        header._contentLength = static_cast<uint16_t>(sizeof(uint16_t) + size);
+        auto original = static_cast<uint16_t>(datagram.size());
+        std::memcpy(_scratch.data(), &header, sizeof(header));
+        std::memcpy(_scratch.data() + sizeof(header), &original, sizeof(original));
+        _scratch.resize(OVERHEAD + size);
+        datagram.swap(_scratch);
+
+        ++_stats.compressed;
+        _stats.bytesOut += datagram.size();
+        return true;
+    }
+
+    /**
+     * @brief Whether a datagram is a compressed packet (with the command of
+     * this compressor, and nothing after it)
+     */
+    [[nodiscard]] bool isCompressed(const byte *data, std::size_t size) const
+    {
+        Header<Id> header;
+        if (size < OVERHEAD)
+            return false;
+        std::memcpy(&header, data, sizeof(header));
+        return header._commandId == _command && header._apiVersion == ApiVersion::V_1 &&
+               sizeof(header) + header._contentLength == size;
+    }
+
+    /**
+     * @brief Decompress a compressed packet
+     *
+     * @param data  The datagram, a compressed packet (see isCompressed())
+     * @param size  The size of the datagram
+     * @return const Network::Buffer*  The packets of the datagram, valid until the next call, nullptr if invalid
+     */
+    const Network::Buffer *decompress(const byte *data, std::size_t size)
+    {
+        uint16_t original;
+        std::memcpy(&original, data + sizeof(Header<Id>), sizeof(original));
+
+        _scratch.resize(original);
+        if (original == 0 ||
+            _compressor.decompress(data + OVERHEAD, size - OVERHEAD, _scratch.data(), _scratch.size()) != original)
+            return ++_stats.invalid, nullptr;
+        return &_scratch;
+    }
+
+    /**
+     * @brief Get the id of the dictionary, sent in the connect handshake
+     */
+    [[nodiscard]] uint32_t getDictionaryId() const { return _compressor.getDictionaryId(); }
+
+    [[nodiscard]] const CompressionStats &getStats() const { return _stats; }
+
+private:
+    Id _command;                     // Command of the compressed packets
+    Network::Compressor _compressor; // Codec, with the dictionary
+    Network::Buffer _scratch;        // Compressed packet being written, or packets being decompressed
+    CompressionStats _stats;         // Counters
+};
+
+} // namespace Flakkari::Protocol
+
+#endif /* !FLAKKARI_COMPRESSION_HPP_ */
@@ -0,0 +1,312 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file Congestion.hpp
+ * @brief This file contains the CongestionController class. It estimates the
+ *        bandwidth of a connection from the acks and the losses, and sets the
+ *        send rate, the pacing of the sends and the snapshot frequency of the
+ *        connection from it.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef FLAKKARI_CONGESTION_HPP_
+#define FLAKKARI_CONGESTION_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace Flakkari::Protocol {
+
+/**
+ * @brief Bounds of a CongestionController
+ */
+struct CongestionSettings {
+    std::size_t minRate = 16 * 1024;                    // Bytes per second always allowed
+    std::size_t maxRate = 8 * 1024 * 1024;              // Bytes per second never exceeded
+    std::size_t initialRate = 256 * 1024;               // Bytes per second before any feedback
+    std::chrono::milliseconds maxSnapshotInterval{250}; // Longest time between two snapshots of a congested link
+};
+
+/**
+ * @brief State and counters of a CongestionController
+ */
+struct CongestionStats {
+    std::size_t rate = 0;                         // Send rate, in bytes per second
+    std::size_t bandwidth = 0;                    // Estimated delivery rate, in bytes per second
+    double loss = 0;                              // Fraction of the bytes lost in the last interval
+    std::chrono::nanoseconds snapshotInterval{0}; // Time between two snapshots (0: every tick)
+    uint64_t increases = 0;                       // Intervals the rate was raised after
+    uint64_t decreases = 0;                       // Intervals the rate was cut after
+    uint64_t limitedTicks = 0;                    // Ticks that left packets in the queues for lack of budget
+};
+
+/**
+ * @brief Congestion control of one connection: send rate, pacing and snapshot
+ * frequency
+ *
+ * @details The controller is fed, every tick, the bytes of the datagrams the
+ * reliability layer saw delivered (acked) and lost (not acked while newer
+ * datagrams, sent later than the jitter could explain, were). At the end of
+ * each feedback interval, a round trip long at least and, unless a queue
+ * fills, until MIN_SAMPLE bytes were acked or lost (or MAX_INTERVAL passed):
+ *  - more than LOSS_TOLERANCE of the bytes lost, or a round trip time grown
+ *    past twice its minimum and QUEUE_TOLERANCE over it (a queue fills on
+ *    the path), cuts the rate to DECREASE times the delivery rate of the
+ *    interval, and doubles the snapshot interval;
+ *  - a clean interval in which the rate limited the sends raises the rate:
+ *    doubled until the first loss (slow start), then by an eighth; the
+ *    snapshot interval shrinks back by a quarter.
+ * An interval without feedback (the peer sent nothing) changes nothing, and
+ * the rate is not raised while the sends stay under it. Random loss under
+ * the tolerance is not taken for congestion.
+ *
+ * The sends are paced by a token bucket: a tick may send what the rate
+ * earned since the last one, and at most MAX_BURST worth after an idle time.
+ * A packet larger than the tokens left is still sent, and the debt is paid by
+ * the next ticks. The bucket only sets how much a tick sends: pace() then
+ * spreads the datagrams of the tick, each one leaving when the previous one
+ * has left at the rate, so that a long tick does not send its worth in one
+ * burst.
+ *
+ * @example "Flakkari/Protocol/Congestion.hpp"
+ * @code
+ * CongestionController congestion;
+ * auto stats = channel.getStats();
+ * congestion.update(stats.deliveredBytes, stats.lostBytes, stats.roundTripTime, now);
+ * auto budget = congestion.refill(now);
+ * // ... write at most `budget` bytes (one packet at least when budget > 0)
+ * congestion.consume(written, packetsLeft);
+ * @endcode
+ */
+class CongestionController {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::nanoseconds MIN_INTERVAL = std::chrono::milliseconds(50);
+    static constexpr std::chrono::nanoseconds MAX_INTERVAL = std::chrono::seconds(1);
+    static constexpr uint64_t MIN_SAMPLE = 64 * 1024; // Bytes an interval waits for before the end of MAX_INTERVAL
+    static constexpr std::chrono::nanoseconds MAX_BURST = std::chrono::milliseconds(20);
+    static constexpr std::chrono::nanoseconds SNAPSHOT_STEP = std::chrono::milliseconds(20);
+    static constexpr std::chrono::nanoseconds QUEUE_TOLERANCE = std::chrono::milliseconds(25);
+    static constexpr std::chrono::nanoseconds MIN_RTT_WINDOW = std::chrono::seconds(10);
+    static constexpr double LOSS_TOLERANCE = 0.1; // Fraction of the bytes lost taken for random loss
+    static constexpr double DECREASE = 0.7;       // Cut of the rate on congestion
+
+public:
+    explicit CongestionController(const CongestionSettings &settings = {}, Clock::time_point now = Clock::now())
+    {
+        setSettings(settings, now);
+    }
+
+    /**
+     * @brief Set the bounds of the controller and restart it from the initial
+     * rate (clamped to the bounds)
+     *
+     * @param settings  The bounds
+     * @param now  The current time
+     */
+    void setSettings(const CongestionSettings &settings, Clock::time_point now = Clock::now())
+    {
+        _settings = settings;
+        _settings.maxRate = std::max(_settings.minRate, _settings.maxRate);
+        _rate = static_cast<double>(std::clamp(_settings.initialRate, _settings.minRate, _settings.maxRate));
+        _tokens = _rate * seconds(MAX_BURST);
+        _slowStart = true;
+        _lastRefill = _intervalStart = _nextRelease = now;
+        _snapshotInterval = _minRoundTripTime = std::chrono::nanoseconds(0);
+    }
+
+public: // Feedback
+    /**
+     * @brief Take the delivery counters of the reliability layer
+     *
+     * @param delivered  The bytes of the datagrams delivered so far (ReliabilityStats::deliveredBytes)
+     * @param lost  The bytes of the datagrams lost so far (ReliabilityStats::lostBytes)
+     * @param roundTripTime  The smoothed round trip time (0 until a sample is known)
+     * @param now  The current time
+     */
+    void update(uint64_t delivered, uint64_t lost, std::chrono::nanoseconds roundTripTime, Clock::time_point now)
+    {
+        _intervalDelivered += delivered - _lastDelivered;
+        _intervalLost += lost - _lastLost;
+        _lastDelivered = delivered;
+        _lastLost = lost;
+
+        // the minimum is taken again from time to time, in case the path changed
+        if (roundTripTime.count() > 0 && (_minRoundTripTime.count() == 0 || roundTripTime < _minRoundTripTime ||
+                                          now - _minRoundTripTimeAt > MIN_RTT_WINDOW))
+        {
+            _minRoundTripTime = roundTripTime;
+            _minRoundTripTimeAt = now;
+        }
+
+        auto elapsed = now - _intervalStart;
+        bool queuing = _minRoundTripTime.count() > 0 &&
+                       roundTripTime > _minRoundTripTime + std::max(_minRoundTripTime, QUEUE_TOLERANCE);
+
+        if (elapsed < std::max(roundTripTime, MIN_INTERVAL))
+            return;
+        // the loss of a few datagrams is noise: without a queue on the path, an interval lasts until
+        // enough bytes were acked or lost
+        if (!queuing && elapsed < MAX_INTERVAL && _intervalDelivered + _intervalLost < MIN_SAMPLE)
+            return;
+
+        if (auto total = _intervalDelivered + _intervalLost; total > 0)
+        {
+            double sample = static_cast<double>(_intervalDelivered) / seconds(elapsed);
+
+            _bandwidth = _bandwidth <= 0 ? sample : _bandwidth + (sample - _bandwidth) / 4;
+            _loss = static_cast<double>(_intervalLost) / static_cast<double>(total);
+            if (_loss > LOSS_TOLERANCE || queuing)
+                decrease(sample);
+            else if (_intervalLimited)
+                increase();
+            else
+                _snapshotInterval = shrink(_snapshotInterval);
+        }
+        _intervalStart = now;
+        _intervalDelivered = _intervalLost = 0;
+        _intervalLimited = false;
+    }
+
+public: // Pacing
+    /**
+     * @brief Add the tokens earned since the last call
+     *
+     * @param now  The current time
+     * @return std::size_t  The bytes the tick may send (0 while in debt)
+     */
+    std::size_t refill(Clock::time_point now)
+    {
+        auto elapsed = std::max(now - _lastRefill, Clock::duration::zero());
+        auto burst = _rate * seconds(std::max<Clock::duration>(elapsed, MAX_BURST));
+
+        _lastRefill = now;
+        _tokens = std::min(_tokens + _rate * seconds(elapsed), burst);
+        return _tokens > 0 ? static_cast<std::size_t>(_tokens) : 0;
+    }
+
+    /**
+     * @brief Take the bytes sent by a tick from the tokens
+     *
+     * @param bytes  The bytes sent
+     * @param limited  Whether packets were left in the queues for lack of tokens
+     */
+    void consume(std::size_t bytes, bool limited)
+    {
+        _tokens -= static_cast<double>(bytes);
+        if (limited)
+            ++_stats.limitedTicks;
+        _intervalLimited = _intervalLimited || limited;
+    }
+
+    /**
+     * @brief Give the time a datagram may leave at: once the datagrams before
+     * it have left at the rate
+     *
+     * @param bytes  The size of the datagram
+     * @param now  The current time
+     * @return Clock::time_point  The release time of the datagram (now at the earliest)
+     */
+    Clock::time_point pace(std::size_t bytes, Clock::time_point now)
+    {
+        auto release = std::max(_nextRelease, now);
+
+        _nextRelease = release + std::chrono::duration_cast<Clock::duration>(
+                                     std::chrono::duration<double>(static_cast<double>(bytes) / _rate));
+        return release;
+    }
+
+public: // Snapshots
+    /**
+     * @brief Whether the peer is due a snapshot: always on a clean link, at
+     * most once per snapshot interval on a congested one
+     *
+     * @param now  The current time
+     */
+    [[nodiscard]] bool isSnapshotDue(Clock::time_point now) const { return now - _lastSnapshot >= _snapshotInterval; }
+
+    /**
+     * @brief Record that the peer was sent a snapshot
+     *
+     * @param now  The current time
+     */
+    void snapshotSent(Clock::time_point now) { _lastSnapshot = now; }
+
+public: // Getters
+    [[nodiscard]] std::size_t getRate() const { return static_cast<std::size_t>(_rate); }
+    [[nodiscard]] std::chrono::nanoseconds getSnapshotInterval() const { return _snapshotInterval; }
+    [[nodiscard]] const CongestionSettings &getSettings() const { return _settings; }
+
+    [[nodiscard]] CongestionStats getStats() const
+    {
+        auto stats = _stats;
+        stats.rate = getRate();
+        stats.bandwidth = static_cast<std::size_t>(_bandwidth);
+        stats.loss = _loss;
+        stats.snapshotInterval = _snapshotInterval;
+        return stats;
+    }
+
+private:
+    static double seconds(Clock::duration duration) { return std::chrono::duration<double>(duration).count(); }
+
+    void decrease(double deliveryRate)
+    {
+        auto floor = static_cast<double>(_settings.minRate);
+
+        _rate = std::max(floor, std::min(_rate, deliveryRate) * DECREASE);
+        _slowStart = false;
+        _snapshotInterval = std::min<std::chrono::nanoseconds>(std::max(_snapshotInterval * 2, SNAPSHOT_STEP),
+                                                               _settings.maxSnapshotInterval);
+        ++_stats.decreases;
+    }
+
+    void increase()
+    {
+        auto ceiling = static_cast<double>(_settings.maxRate);
+
+        _rate = std::min(ceiling, _slowStart ? _rate * 2 : _rate + _rate / 8);
+        _snapshotInterval = shrink(_snapshotInterval);
+        ++_stats.increases;
+    }
+
+    static std::chrono::nanoseconds shrink(std::chrono::nanoseconds interval)
+    {
+        interval -= interval / 4;
+        return interval < SNAPSHOT_STEP / 2 ? std::chrono::nanoseconds(0) : interval;
+    }
+
+private:
+    CongestionSettings _settings;
+    double _rate = 0;                              // Send rate, in bytes per second
+    double _tokens = 0;                            // Bytes the sends may still take (negative: debt)
+    bool _slowStart = true;                        // No congestion was seen yet: the rate doubles
+    double _bandwidth = 0;                         // Smoothed delivery rate, in bytes per second
+    double _loss = 0;                              // Fraction of the bytes lost in the last interval
+    std::chrono::nanoseconds _snapshotInterval{0}; // Time between two snapshots
+    std::chrono::nanoseconds _minRoundTripTime{0}; // Smallest round trip time seen in the window
+    Clock::time_point _minRoundTripTimeAt;         // Time the minimum was taken
+    Clock::time_point _lastSnapshot;               // Time of the last snapshot
+    Clock::time_point _lastRefill;                 // Time of the last refill
+    Clock::time_point _nextRelease;                // Time the next datagram may leave at
+    Clock::time_point _intervalStart;              // Start of the feedback interval
+    uint64_t _lastDelivered = 0;                   // Delivered bytes at the last update
+    uint64_t _lastLost = 0;                        // Lost bytes at the last update
+    uint64_t _intervalDelivered = 0;               // Bytes delivered in the interval
+    uint64_t _intervalLost = 0;                    // Bytes lost in the interval
+    bool _intervalLimited = false;                 // The rate limited the sends in the interval
+    CongestionStats _stats;                        // Counters
+};
+
+} // namespace Flakkari::Protocol
+
+#endif /* !FLAKKARI_CONGESTION_HPP_ */
@@ -333,6 +333,49 @@ public:
         packet << vel._acceleration.vec.x;
         packet << vel._acceleration.vec.y;
     }
+
+    /**
+     * @brief Add the movement state of a 3D entity to a packet.
+     * This is the layout of one entry of a REQ_ENTITIES_MOVED packet:
+     * (id)(last input)(position xyz)(rotation xyzw)(scale xyz)(velocity xyz)(acceleration xyz)
+     *
+     * @tparam Id  Type of the entity id.
+     * @param packet  Packet to add the movement to.
+     * @param entity  Entity that moved.
+     * @param lastInput  Sequence number of the last input applied to the entity (0 if none).
+     * @param pos  Transform of the entity.
+     * @param vel  Movable of the entity.
+     */
+    template <typename Id>
+    static void add3dUpdateMovementToPacket(Packet<Id> &packet, Engine::ECS::Entity entity, uint32_t lastInput,
+                                            const Engine::ECS::Components::_3D::Transform &pos,
+                                            const Engine::ECS::Components::_3D::Movable &vel)
+    {
+        packet << entity;
+        packet << lastInput;
+        packet << pos._position.vec.x;
+        packet << pos._position.vec.y;
+        packet << pos._position.vec.z;
+        packet << (float) pos._rotation.vec.x;
+        packet << (float) pos._rotation.vec.y;
+        packet << (float) pos._rotation.vec.z;
+        packet << (float) pos._rotation.vec.w;
+        packet << pos._scale.vec.x;
+        packet << pos._scale.vec.y;
+        packet << pos._scale.vec.z;
+        packet << vel._velocity.vec.x;
+        packet << vel._velocity.vec.y;
+        packet << vel._velocity.vec.z;
+        packet << vel._acceleration.vec.x;
+        packet << vel._acceleration.vec.y;
+        packet << vel._acceleration.vec.z;
+    }
+
+    /**
+     * @brief Size in bytes of one entry added by add3dUpdateMovementToPacket.
+     */
+    static constexpr std::size_t UPDATE_MOVEMENT_3D_SIZE =
+        sizeof(Engine::ECS::Entity) + sizeof(uint32_t) + sizeof(float) * 16;
 };
 
 } // namespace Flakkari::Protocol
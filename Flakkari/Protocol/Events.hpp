@@ -18,6 +18,7 @@
 #define EVENTS_HPP_
 
 #include "flakkari_config.h"
+#include <iostream>
 
 namespace Flakkari::Protocol {
 
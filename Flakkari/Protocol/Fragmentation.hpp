@@ -0,0 +1,306 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file Fragmentation.hpp
+ * @brief This file contains the Fragmenter and Reassembler classes. They
+ *        split a packet larger than the MTU in fragment packets, and put the
+ *        fragments back together on the other side of the connection.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef FLAKKARI_FRAGMENTATION_HPP_
+#define FLAKKARI_FRAGMENTATION_HPP_
+
+#include "Header.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+namespace Flakkari::Protocol {
+
+/**
+ * @brief Default size of the largest datagram sent: under the path MTU of
+ * the Internet once the IP and UDP headers are added, so that a datagram is
+ * never fragmented by IP
+ */
+constexpr std::size_t DEFAULT_MTU = 1200;
+
+LPL_PACKED_START
+
+/**
+ * @brief Header of the payload of a fragment packet (REQ_FRAGMENT or
+ * REP_FRAGMENT), followed by a slice of the serialized packet
+ */
+struct FragmentHeader {
+    uint16_t _message = 0; // Id of the fragmented packet on its connection
+    uint8_t _index = 0;    // Rank of the fragment in the packet
+    uint8_t _count = 0;    // Number of fragments of the packet
+};
+
+LPL_PACKED_END
+
+/**
+ * @brief Counters of a Reassembler
+ */
+struct ReassemblyStats {
+    uint64_t fragments = 0; // Fragments received
+    uint64_t messages = 0;  // Packets put back together
+    uint64_t expired = 0;   // Packets dropped because a fragment did not come in time
+    uint64_t evicted = 0;   // Packets dropped to make room for newer ones
+    uint64_t rejected = 0;  // Fragments dropped (invalid, or of a packet larger than the memory cap)
+    std::size_t bytes = 0;  // Bytes of the fragments currently held
+};
+
+/**
+ * @brief Splitter of the packets larger than the MTU of a connection
+ *
+ * @details A packet is cut, whole and already serialized (header included),
+ * in slices that each fit in one fragment packet of at most `mtu` bytes. The
+ * fragments inherit the priority and the reliable flag of the packet: the
+ * fragments of a reliable packet are sent again one by one until acked, the
+ * ones of an unreliable packet are not, and the packet is lost with any of
+ * them.
+ *
+ * @tparam Id  Type of the command ids of the headers.
+ *
+ * @example "Flakkari/Protocol/Fragmentation.hpp"
+ * @code
+ * Fragmenter<CommandId> fragmenter;
+ * fragmenter.split(serializedPacket, CommandId::REP_FRAGMENT, DEFAULT_MTU, [&](const Network::Buffer &fragment) {
+ *     channel.write(datagram, fragment, now);
+ * });
+ * @endcode
+ */
+template <typename Id> class Fragmenter {
+public:
+    static constexpr std::size_t MAX_FRAGMENTS = UINT8_MAX; // Fragments of a packet at most
+    static constexpr std::size_t OVERHEAD = sizeof(Header<Id>) + sizeof(FragmentHeader);
+
+public:
+    /**
+     * @brief Get the largest packet that can be split for a MTU
+     */
+    static constexpr std::size_t maxPacketSize(std::size_t mtu) { return MAX_FRAGMENTS * (mtu - OVERHEAD); }
+
+    /**
+     * @brief Split a serialized packet in fragment packets
+     *
+     * @param packet  The serialized packet
+     * @param command  The command of the fragments (REQ_FRAGMENT or REP_FRAGMENT)
+     * @param mtu  The size of a fragment packet at most
+     * @param emit  Called with each serialized fragment (const Network::Buffer &), in order
+     * @return std::size_t  The number of fragments, 0 if the packet is larger than maxPacketSize(mtu)
+     */
+    template <typename Emit> std::size_t split(const Network::Buffer &packet, Id command, std::size_t mtu, Emit &&emit)
+    {
+        if (mtu <= OVERHEAD || packet.size() < sizeof(Header<Id>) || packet.size() > maxPacketSize(mtu))
+            return 0;
+
+        Header<Id> original;
+        std::memcpy(&original, packet.data(), sizeof(original));
+
+        std::size_t slice = mtu - OVERHEAD;
+        auto count = static_cast<uint8_t>((packet.size() + slice - 1) / slice);
+        Network::Buffer fragment;
+        fragment.reserve(mtu);
+
+        for (uint8_t index = 0; index < count; ++index)
+        {
+            std::size_t offset = index * slice;
+            std::size_t length = std::min(slice, packet.size() - offset);
+
+            Header<Id> header;
+            header._priority = original._priority;
+            header._reliable = original._reliable;
+            header._apiVersion = original._apiVersion;
+            header._commandId = command;
+            header._contentLength = static_cast<uint16_t>(sizeof(FragmentHeader) + length);
+            FragmentHeader fragmentHeader{_nextMessage, index, count};
+
+            fragment.resize(sizeof(header) + sizeof(fragmentHeader) + length);
+            std::memcpy(fragment.data(), &header, sizeof(header));
+            std::memcpy(fragment.data() + sizeof(header), &fragmentHeader, sizeof(fragmentHeader));
+            std::memcpy(fragment.data() + OVERHEAD, packet.data() + offset, length);
+            emit(fragment);
+        }
+        ++_nextMessage;
+        return count;
+    }
+
+private:
+    uint16_t _nextMessage = 0; // Id of the next packet split
+};
+
+/**
+ * @brief Reassembly buffer of the fragmented packets of a connection
+ *
+ * @details The fragments of a packet are held until the last of them comes,
+ * in any order and with the duplicates ignored. The memory is bounded twice:
+ * an unreliable packet whose fragments do not all come within the timeout is
+ * dropped, and the packets held at once are capped in number and in bytes,
+ * the oldest unreliable one being dropped to make room for a newer one. A
+ * sender cannot make the receiver hold more than `maxBytes` of fragments per
+ * connection.
+ *
+ * The fragments of a reliable packet are delivered by the reliability layer,
+ * in order and each once, however late a retransmission: its packet never
+ * expires nor makes room for another, and there is at most one at a time.
+ *
+ * @example "Flakkari/Protocol/Fragmentation.hpp"
+ * @code
+ * Reassembler reassembler;
+ * if (auto packet = reassembler.add(payload.data(), payload.size(), header._reliable, now))
+ *     handle(*packet);
+ * @endcode
+ */
+class Reassembler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::nanoseconds DEFAULT_TIMEOUT = std::chrono::seconds(1);
+    static constexpr std::size_t DEFAULT_MAX_MESSAGES = 8;       // Packets held at once
+    static constexpr std::size_t DEFAULT_MAX_BYTES = 384 * 1024; // Bytes held at once (over maxPacketSize(DEFAULT_MTU))
+
+public:
+    explicit Reassembler(std::chrono::nanoseconds timeout = DEFAULT_TIMEOUT,
+                         std::size_t maxMessages = DEFAULT_MAX_MESSAGES, std::size_t maxBytes = DEFAULT_MAX_BYTES)
+        : _timeout(timeout), _maxMessages(std::max<std::size_t>(1, maxMessages)), _maxBytes(maxBytes)
+    {
+    }
+
+    /**
+     * @brief Add a fragment
+     *
+     * @param data  The payload of the fragment packet (FragmentHeader, then the slice)
+     * @param size  The size of the payload
+     * @param reliable  Whether the fragment packet has the reliable flag
+     * @param now  The current time
+     * @return std::optional<Network::Buffer>  The serialized packet, if it was the last fragment missing
+     */
+    std::optional<Network::Buffer> add(const byte *data, std::size_t size, bool reliable, Clock::time_point now)
+    {
+        ++_stats.fragments;
+        expire(now);
+
+        FragmentHeader header;
+        if (size < sizeof(header))
+            return ++_stats.rejected, std::nullopt;
+        std::memcpy(&header, data, sizeof(header));
+        std::size_t length = size - sizeof(header);
+        if (header._count == 0 || header._index >= header._count || length == 0 || length > _maxBytes)
+            return ++_stats.rejected, std::nullopt;
+        if (header._count == 1)
+            return ++_stats.messages, Network::Buffer(data + sizeof(header), data + size);
+
+        auto partial = find(header._message);
+        if (partial != _partials.end() && (partial->slices.size() != header._count || partial->reliable != reliable))
+        {
+            // the id was reused by a newer packet: the old one will never be complete
+            drop(partial);
+            ++_stats.evicted;
+            partial = _partials.end();
+        }
+        if (partial == _partials.end())
+        {
+            partial = _partials.insert(_partials.end(), {header._message, reliable, now, 0, 0, {}});
+            partial->slices.resize(header._count);
+        }
+        if (!partial->slices[header._index].empty())
+            return std::nullopt;
+
+        // the oldest unreliable packets are dropped to make room, never the current one
+        while (_stats.bytes + length > _maxBytes || _partials.size() > _maxMessages)
+        {
+            auto oldest = std::find_if(_partials.begin(), _partials.end(), [&](const Partial &other) {
+                return !other.reliable && other.message != header._message;
+            });
+            if (oldest == _partials.end())
+            {
+                drop(find(header._message));
+                return ++_stats.rejected, std::nullopt;
+            }
+            drop(oldest);
+            ++_stats.evicted;
+        }
+        partial = find(header._message);
+
+        partial->slices[header._index].assign(data + sizeof(header), data + size);
+        partial->bytes += length;
+        _stats.bytes += length;
+        if (++partial->received < partial->slices.size())
+            return std::nullopt;
+
+        Network::Buffer packet;
+        packet.reserve(partial->bytes);
+        for (const auto &slice : partial->slices)
+            packet.insert(packet.end(), slice.begin(), slice.end());
+        drop(partial);
+        ++_stats.messages;
+        return packet;
+    }
+
+    /**
+     * @brief Drop the unreliable packets whose first fragment came more than
+     * the timeout ago
+     *
+     * @param now  The current time
+     * @return std::size_t  The number of packets dropped
+     */
+    std::size_t expire(Clock::time_point now)
+    {
+        auto expired = std::remove_if(_partials.begin(), _partials.end(), [&](const Partial &partial) {
+            return !partial.reliable && now - partial.startedAt > _timeout;
+        });
+        auto count = static_cast<std::size_t>(_partials.end() - expired);
+
+        for (auto partial = expired; partial != _partials.end(); ++partial)
+            _stats.bytes -= partial->bytes;
+        _partials.erase(expired, _partials.end());
+        _stats.expired += count;
+        return count;
+    }
+
+    [[nodiscard]] std::size_t getPendingCount() const { return _partials.size(); }
+    [[nodiscard]] const ReassemblyStats &getStats() const { return _stats; }
+
+private:
+    struct Partial {
+        uint16_t message;                    // Id of the packet
+        bool reliable;                       // Its fragments are reliable: it does not expire
+        Clock::time_point startedAt;         // Time its first fragment came
+        std::size_t received;                // Fragments received
+        std::size_t bytes;                   // Bytes of the fragments received
+        std::vector<Network::Buffer> slices; // Slices by index (empty until received)
+    };
+
+    std::vector<Partial>::iterator find(uint16_t message)
+    {
+        return std::find_if(_partials.begin(), _partials.end(),
+                            [&](const Partial &partial) { return partial.message == message; });
+    }
+
+    void drop(std::vector<Partial>::iterator partial)
+    {
+        _stats.bytes -= partial->bytes;
+        _partials.erase(partial);
+    }
+
+private:
+    std::chrono::nanoseconds _timeout; // Time the fragments of an unreliable packet have to come
+    std::size_t _maxMessages;          // Packets held at once
+    std::size_t _maxBytes;             // Bytes of fragments held at once
+    std::vector<Partial> _partials;    // Packets being put back together, oldest first
+    ReassemblyStats _stats;            // Counters
+};
+
+} // namespace Flakkari::Protocol
+
+#endif /* !FLAKKARI_FRAGMENTATION_HPP_ */
@@ -85,20 +85,30 @@ LPL_PACKED_START
  *  0                   1                   2                   3
  *  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
  * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- * |Priority| Api V.|   CommandId   |       ContentLength          |
+ * |Prio.|R| Api V.|   CommandId   |       ContentLength          |
  * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- * |                        SequenceNumber                         |
- * |                                                               |
+ * |           Sequence            |              Ack              |
  * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |            AckBits            |             Order             |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *
+ * The last 8 bytes belong to the reliability layer (see ReliableChannel):
+ * the sequence of the datagram of the packet on its connection (shared by
+ * the packets of a datagram), the newest sequence received from the peer
+ * and the 16 before it (bit n of AckBits for Ack - 1 - n), and, for a
+ * packet with the reliable flag R, its rank among the reliable packets of
+ * the connection, in which order they are delivered.
  */
 template <typename Id> struct Header {
-    Priority _priority     : 4 = Priority::LOW;
+    Priority _priority     : 3 = Priority::LOW;
+    bool _reliable         : 1 = false;
     ApiVersion _apiVersion : 4 = ApiVersion::V_1;
     Id _commandId;
     uint16_t _contentLength = 0;
-    uint64_t _sequenceNumber = static_cast<uint64_t>(
-        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
-            .count());
+    uint16_t _sequence = 0; // Sequence of the datagram of the packet on its connection
+    uint16_t _ack = 0;      // Newest sequence received from the peer
+    uint16_t _ackBits = 0;  // Bit n set: sequence _ack - 1 - n received too
+    uint16_t _order = 0;    // Rank of a reliable packet among the reliable packets of the connection
 
     std::size_t size() const { return sizeof(*this); }
 };
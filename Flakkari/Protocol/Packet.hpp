@@ -7,9 +7,12 @@
  * represent a packet. A packet is a header and a payload.
  *  - The header is a Flakkari::Protocol::Header object.
  *  - The payload is a Flakkari::Network::Buffer object.
+ * A PacketView is a received packet whose payload is a view of the receive
+ * buffer instead of a copy (Flakkari::Network::BufferView).
  *
  * @see Flakkari::Protocol::Header
  * @see Flakkari::Network::Buffer
+ * @see Flakkari::Network::BufferView
  *
  * Flakkari Library is under MIT License.
  * https://opensource.org/licenses/MIT
@@ -24,11 +27,38 @@
 #include "Events.hpp"
 #include "Header.hpp"
 #include "Logger/Logger.hpp"
+#include "Network/BufferPool.hpp"
 
 #include <cstring>
 
 namespace Flakkari::Protocol {
 
+/**
+ * @brief Read and check the header of a serialized packet.
+ *
+ * @param header  The header to fill.
+ * @param data  The serialized packet.
+ * @param size  The size of the serialized packet.
+ * @return true  The header is valid and the payload fits in the data.
+ * @return false  The header is not valid.
+ */
+template <typename Id> [[nodiscard]] bool readHeader(Header<Id> &header, const byte *data, std::size_t size)
+{
+    if (size < header.size())
+        return FLAKKARI_LOG_WARNING("Buffer is too small to deserialize a packet."), false;
+    std::memcpy(&header, data, header.size());
+    if (header._priority >= Priority::MAX_PRIORITY)
+        return FLAKKARI_LOG_WARNING("Priority is too big (" + std::to_string((int) header._priority) + ")"), false;
+    if (header._apiVersion >= ApiVersion::MAX_VERSION)
+        return FLAKKARI_LOG_WARNING("ApiVersion is too big (" + std::to_string((int) header._apiVersion) + ")"),
+               false;
+    if (header._commandId >= CommandId::MAX_COMMAND_ID)
+        return FLAKKARI_LOG_WARNING("CommandId is too big (" + std::to_string((int) header._commandId) + ")"), false;
+    if (header._contentLength > size - header.size())
+        return false;
+    return true;
+}
+
 /**
  * @brief Flakkari Packet v1 (new packet)
  *
@@ -55,7 +85,9 @@ template <typename Id> struct Packet {
     {
         std::string str = "Packet<Id: " + Commands::command_to_string(header._commandId) +
                           ", ContentLength: " + std::to_string(int(header._contentLength)) +
-                          ", SequenceNumber: " + std::to_string(long(header._sequenceNumber)) +
+                          ", Sequence: " + std::to_string(int(header._sequence)) +
+                          ", Ack: " + std::to_string(int(header._ack)) +
+                          (header._reliable ? ", Order: " + std::to_string(int(header._order)) : "") +
                           ", Payload: " + std::string((const char *) payload.data(), payload.size()) + ">";
         return str;
     }
@@ -71,7 +103,8 @@ template <typename Id> struct Packet {
     {
         os << "Packet<Id: " << htons(packet.header._commandId)
            << ", ContentLength: " << htons(packet.header._contentLength)
-           << ", SequenceNumber: " << htonl(packet.header._sequenceNumber) << ", Payload: " << packet.payload << ">";
+           << ", Sequence: " << packet.header._sequence << ", Ack: " << packet.header._ack
+           << ", Payload: " << packet.payload << ">";
         return os;
     }
 
@@ -180,22 +213,81 @@ template <typename Id> struct Packet {
      */
     [[nodiscard]] bool deserialize(const Network::Buffer &buffer)
     {
-        if (buffer.size() < header.size())
-            return FLAKKARI_LOG_WARNING("Buffer is too small to deserialize a packet."), false;
-        std::memcpy(&header, buffer.data(), header.size());
-        if (header._priority >= Priority::MAX_PRIORITY)
-            return FLAKKARI_LOG_WARNING("Priority is too big (" + std::to_string((int) header._priority) + ")"), false;
-        if (header._apiVersion >= ApiVersion::MAX_VERSION)
-            return FLAKKARI_LOG_WARNING("ApiVersion is too big (" + std::to_string((int) header._apiVersion) + ")"),
-                   false;
-        if (header._commandId >= CommandId::MAX_COMMAND_ID)
-            return FLAKKARI_LOG_WARNING("CommandId is too big (" + std::to_string((int) header._commandId) + ")"),
-                   false;
-        if (header._contentLength > buffer.size() - header.size())
+        if (!readHeader(header, buffer.data(), buffer.size()))
             return false;
         payload = buffer.extractData(header.size(), header._contentLength);
         return true;
     }
+
+    /**
+     * @brief Deserialize a received buffer into a packet (the payload is copied).
+     *
+     * @param buffer  The view of the serialized packet.
+     * @return true  The packet has been deserialized successfully.
+     * @return false  The packet has not been deserialized successfully.
+     */
+    [[nodiscard]] bool deserialize(const Network::BufferView &buffer)
+    {
+        if (!readHeader(header, buffer.data(), buffer.size()))
+            return false;
+        payload.assign(buffer.data() + header.size(), buffer.data() + header.size() + header._contentLength);
+        return true;
+    }
+};
+
+/**
+ * @brief Received packet whose payload references the receive buffer
+ *
+ * @details The payload is a slice of the slab the datagram was received in
+ * (see Network::BufferPool): deserializing does not copy nor allocate, and
+ * the slab is given back to its pool when the view is destroyed, after the
+ * game thread handled the packet. Use Packet to build or edit a packet.
+ *
+ * @tparam Id: The type of the command id.
+ * @param header: The header of the packet.
+ * @param payload: The view of the payload of the packet.
+ */
+template <typename Id> struct PacketView {
+    Header<Id> header;
+    Network::BufferView payload;
+
+    /**
+     * @brief Get the size of the packet.
+     *
+     */
+    std::size_t size() const { return sizeof(header) + payload.size(); }
+
+    /**
+     * @brief Convert the packet to a string.
+     *
+     * @return std::string  The packet as a string.
+     */
+    std::string to_string() const
+    {
+        std::string str = "Packet<Id: " + Commands::command_to_string(header._commandId) +
+                          ", ContentLength: " + std::to_string(int(header._contentLength)) +
+                          ", Sequence: " + std::to_string(int(header._sequence)) +
+                          ", Ack: " + std::to_string(int(header._ack)) +
+                          (header._reliable ? ", Order: " + std::to_string(int(header._order)) : "") +
+                          ", Payload: " + std::string((const char *) payload.data(), payload.size()) + ">";
+        return str;
+    }
+
+    /**
+     * @brief Deserialize a received buffer into a packet, without copying
+     * the payload.
+     *
+     * @param buffer  The view of the serialized packet.
+     * @return true  The packet has been deserialized successfully.
+     * @return false  The packet has not been deserialized successfully.
+     */
+    [[nodiscard]] bool deserialize(const Network::BufferView &buffer)
+    {
+        if (!readHeader(header, buffer.data(), buffer.size()))
+            return false;
+        payload = buffer.subview(header.size(), header._contentLength);
+        return true;
+    }
 };
 
 } // namespace Flakkari::Protocol
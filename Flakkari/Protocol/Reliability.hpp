@@ -0,0 +1,506 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file Reliability.hpp
+ * @brief This file contains the ReliableChannel class. It is the reliability
+ *        layer of a connection: sequence numbers, piggybacked acks,
+ *        retransmission of the reliable packets and their ordering.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef FLAKKARI_RELIABILITY_HPP_
+#define FLAKKARI_RELIABILITY_HPP_
+
+#include "Header.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace Flakkari::Protocol {
+
+/**
+ * @brief Counters of a ReliableChannel
+ */
+struct ReliabilityStats {
+    uint64_t sent = 0;                             // Packets sent, retransmissions and acks included
+    uint64_t reliableSent = 0;                     // Reliable packets sent (first transmissions)
+    uint64_t retransmitted = 0;                    // Reliable packets sent again
+    uint64_t acked = 0;                            // Reliable packets acknowledged by the peer
+    uint64_t received = 0;                         // Packets received
+    uint64_t duplicates = 0;                       // Packets received twice, dropped
+    uint64_t reordered = 0;                        // Reliable packets held until the ones before them arrived
+    uint64_t deliveredBytes = 0;                   // Bytes of the datagrams acked by the peer
+    uint64_t lostBytes = 0;                        // Bytes of the datagrams not acked while newer ones were
+    std::size_t pending = 0;                       // Reliable packets waiting for their ack
+    std::size_t waiting = 0;                       // Reliable packets waiting for room in the window
+    std::chrono::nanoseconds roundTripTime{0};     // Smoothed round trip time (0 until a sample is known)
+    std::chrono::nanoseconds retransmitTimeout{0}; // Timeout of a first retransmission
+};
+
+/**
+ * @brief Reliability layer of one connection, on top of the packet headers
+ *
+ * @details Every datagram written by the channel gets the next sequence of
+ * the connection, stamped in the header of each of its packets, and its
+ * packets carry, for free, the acks of the datagrams received from the peer:
+ * the last sequence received and a bitfield of the 16 before it. A sequence
+ * per datagram, not per packet, keeps a tick of many packets within the
+ * window of one ack: a datagram is lost or received as a whole.
+ * Nothing else is added to an unreliable packet (a state update): it is
+ * never acked on its own, never sent again and delivered as soon as it
+ * arrives.
+ *
+ * A packet with the reliable flag is also given the next order of the
+ * connection and kept until a packet of the peer acks it. It is written
+ * again, with a new sequence, each time its timeout expires; the timeout
+ * starts at srtt + 4 * rttvar (RFC 6298, sampled from the acks) and doubles
+ * at each retransmission. On the receiving side, the reliable packets are
+ * delivered once each, in order: a packet ahead of the next expected one is
+ * held until the gap is filled. The receiver holds REORDER_WINDOW packets at
+ * most, so that the sender never has more reliable packets unacked: the next
+ * ones wait in the channel, unsent, and writeRetransmissions writes them once
+ * the oldest ones are acked. When a reliable packet was received and no
+ * packet carried its ack back yet, needsAck() asks the owner to write an
+ * ack alone (writeAck) if it has nothing else to send.
+ *
+ * The channel is not thread safe: its owner writes and receives from one
+ * thread, or locks it.
+ *
+ * @tparam Id  Type of the command ids of the headers.
+ * @tparam Held  Type of the received packets (a Packet or a PacketView), held
+ * while reordered.
+ *
+ * @example "Flakkari/Protocol/Reliability.hpp"
+ * @code
+ * ReliableChannel<CommandId, PacketView<CommandId>> channel;
+ * channel.writeRetransmissions(datagram, now);
+ * channel.write(datagram, serializedPacket.data, now);
+ * channel.receive(std::move(packet), now, [&](auto &packet) { handle(packet); });
+ * @endcode
+ */
+template <typename Id, typename Held> class ReliableChannel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr uint16_t ACK_BITS = 16;         // Sequences acked before the last one
+    static constexpr std::size_t SENT_HISTORY = 256; // Send times kept for the round trip samples
+    static constexpr uint16_t REORDER_WINDOW = 256;  // Reliable packets held ahead of the next one
+    static constexpr uint16_t LOSS_REORDER = 3;      // Newer datagrams acked before an unacked one may be lost
+    static constexpr std::chrono::nanoseconds INITIAL_TIMEOUT = std::chrono::milliseconds(200);
+    static constexpr std::chrono::nanoseconds MIN_TIMEOUT = std::chrono::milliseconds(20);
+    static constexpr std::chrono::nanoseconds MAX_TIMEOUT = std::chrono::seconds(2);
+
+    /**
+     * @brief Whether sequence `a` is more recent than `b`, across the wrap
+     * around of the 16 bit sequences
+     */
+    static bool isNewer(uint16_t a, uint16_t b) { return a != b && static_cast<uint16_t>(a - b) < 0x8000; }
+
+public: // Sending
+    /**
+     * @brief Append a serialized packet to a datagram and stamp its header:
+     * sequence, acks and, for a reliable packet, order. A reliable packet is
+     * kept (shared, not copied) until it is acked.
+     *
+     * A reliable packet is not appended while REORDER_WINDOW reliable packets
+     * are unacked: it waits, in order, for writeRetransmissions to send it.
+     *
+     * @param datagram  The datagram to append to (an empty one opens a new sequence)
+     * @param packet  The serialized packet
+     * @param now  The current time
+     */
+    void write(Network::Buffer &datagram, const std::shared_ptr<const Network::Buffer> &packet, Clock::time_point now)
+    {
+        append(datagram, *packet, now, [&]() { return packet; });
+    }
+
+    void write(Network::Buffer &datagram, const Network::Buffer &packet, Clock::time_point now)
+    {
+        append(datagram, packet, now, [&]() { return std::make_shared<const Network::Buffer>(packet); });
+    }
+
+    /**
+     * @brief Append the reliable packets whose timeout expired to a datagram,
+     * with a new sequence each, then the waiting ones the window has room for
+     *
+     * @param datagram  The datagram to append to
+     * @param now  The current time
+     * @param budget  The size the datagram should not exceed (one packet is always written)
+     * @return std::size_t  The number of packets written
+     */
+    std::size_t writeRetransmissions(Network::Buffer &datagram, Clock::time_point now, std::size_t budget = SIZE_MAX)
+    {
+        std::size_t count = 0;
+
+        for (auto &pending : _pending)
+        {
+            if (now < pending.sentAt + pending.timeout)
+                continue;
+            if (!datagram.empty() && datagram.size() + pending.packet->size() > budget)
+                break;
+            auto offset = datagram.size();
+            datagram.insert(datagram.end(), pending.packet->begin(), pending.packet->end());
+
+            Header<Id> header;
+            std::memcpy(&header, datagram.data() + offset, sizeof(header));
+            header._order = pending.order;
+            pending.sequence = stamp(header, now, offset == 0);
+            std::memcpy(datagram.data() + offset, &header, sizeof(header));
+
+            pending.sentAt = now;
+            pending.timeout = std::min(pending.timeout * 2, MAX_TIMEOUT);
+            ++_stats.retransmitted;
+            ++count;
+        }
+        while (!_waiting.empty() && !isWindowFull())
+        {
+            if (!datagram.empty() && datagram.size() + _waiting.front()->size() > budget)
+                break;
+            send(datagram, std::move(_waiting.front()), now);
+            _waiting.pop_front();
+            ++count;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Whether a reliable packet was received and no packet written
+     * since carried its ack
+     */
+    [[nodiscard]] bool needsAck() const { return _ackPending; }
+
+    /**
+     * @brief Append a packet without payload that only carries the acks
+     *
+     * @param datagram  The datagram to append to
+     * @param command  The command of the packet (REQ_ACK or REP_ACK)
+     * @param now  The current time
+     */
+    void writeAck(Network::Buffer &datagram, Id command, Clock::time_point now)
+    {
+        Header<Id> header;
+        header._commandId = command;
+        stamp(header, now, datagram.empty());
+
+        auto bytes = reinterpret_cast<const byte *>(&header);
+        datagram.insert(datagram.end(), bytes, bytes + sizeof(header));
+    }
+
+public: // Receiving
+    /**
+     * @brief Take the acks of a received packet, then deliver it unless it is
+     * a duplicate: at once if it is unreliable, in order if it is reliable
+     * (with the reliable packets it was holding back, if any).
+     *
+     * The packets of a datagram must be received one after the other: they
+     * share a sequence, which only makes a duplicate once another datagram
+     * was received. An unreliable packet of a datagram duplicated right away
+     * is delivered twice (the reliable ones never are).
+     *
+     * @param packet  The received packet
+     * @param now  The current time
+     * @param deliver  Called with each packet (Held &) to hand to the application
+     */
+    template <typename Deliver> void receive(Held &&packet, Clock::time_point now, Deliver &&deliver)
+    {
+        const auto &header = packet.header;
+
+        ++_stats.received;
+        acknowledge(header._ack, header._ackBits, now);
+        // beyond the window the sender keeps to: garbage, not recorded so that its datagram is not acked
+        auto distance = static_cast<uint16_t>(header._order - _nextDelivery);
+        if (header._reliable && distance >= REORDER_WINDOW && distance < 0x8000)
+            return;
+        bool sameDatagram = _hasRemote && header._sequence == _lastSequence;
+        if (!record(header._sequence) && !sameDatagram)
+        {
+            ++_stats.duplicates;
+            return;
+        }
+        _lastSequence = header._sequence;
+        if (!header._reliable)
+        {
+            deliver(packet);
+            return;
+        }
+
+        // even a duplicate is acked again: the ack of its first copy was lost
+        _ackPending = true;
+        if (distance >= 0x8000)
+        {
+            ++_stats.duplicates;
+            return;
+        }
+        if (distance > 0)
+        {
+            if (_held.empty())
+                _held.resize(REORDER_WINDOW);
+            auto &slot = _held[header._order % REORDER_WINDOW];
+            if (slot.has_value())
+                ++_stats.duplicates;
+            else
+                slot = std::move(packet), ++_stats.reordered;
+            return;
+        }
+
+        deliver(packet);
+        ++_nextDelivery;
+        while (!_held.empty() && _held[_nextDelivery % REORDER_WINDOW].has_value())
+        {
+            auto &slot = _held[_nextDelivery % REORDER_WINDOW];
+            Held next = std::move(*slot);
+            slot.reset();
+            ++_nextDelivery;
+            deliver(next);
+        }
+    }
+
+public: // Getters
+    [[nodiscard]] std::chrono::nanoseconds getRoundTripTime() const { return _roundTripTime; }
+
+    /**
+     * @brief Get the timeout of a first retransmission: srtt + 4 * rttvar,
+     * clamped to [MIN_TIMEOUT, MAX_TIMEOUT]
+     */
+    [[nodiscard]] std::chrono::nanoseconds getRetransmitTimeout() const { return _timeout; }
+
+    [[nodiscard]] std::size_t getPendingCount() const { return _pending.size(); }
+
+    /**
+     * @brief Get the number of reliable packets waiting for room in the window
+     */
+    [[nodiscard]] std::size_t getWaitingCount() const { return _waiting.size(); }
+
+    [[nodiscard]] ReliabilityStats getStats() const
+    {
+        auto stats = _stats;
+        stats.pending = _pending.size();
+        stats.waiting = _waiting.size();
+        stats.roundTripTime = _roundTripTime;
+        stats.retransmitTimeout = _timeout;
+        return stats;
+    }
+
+private:
+    struct Pending {
+        std::shared_ptr<const Network::Buffer> packet; // The packet as serialized, before stamping
+        uint16_t order;                                // Order of the packet
+        uint16_t sequence;                             // Sequence of its last transmission
+        Clock::time_point sentAt;                      // Time of its last transmission
+        std::chrono::nanoseconds timeout;              // Time to wait for the ack of the last transmission
+    };
+
+    struct Sent {
+        Clock::time_point at;  // Time the sequence was sent
+        uint16_t sequence = 0; // Sequence, to tell it from a sequence SENT_HISTORY before
+        bool sampled = true;   // The round trip time was sampled from its ack
+        bool resolved = true;  // The datagram was counted as delivered or lost
+        uint32_t bytes = 0;    // Size of the packets of the datagram
+    };
+
+    /**
+     * @brief Whether REORDER_WINDOW reliable packets are unacked, the most the
+     * peer holds (the pending ones are by order, the oldest first)
+     */
+    [[nodiscard]] bool isWindowFull() const
+    {
+        return !_pending.empty() && static_cast<uint16_t>(_nextOrder - _pending.front().order) >= REORDER_WINDOW;
+    }
+
+    template <typename Keep>
+    void append(Network::Buffer &datagram, const Network::Buffer &packet, Clock::time_point now, Keep &&keep)
+    {
+        Header<Id> header;
+        std::memcpy(&header, packet.data(), sizeof(header));
+        if (!header._reliable)
+        {
+            auto offset = datagram.size();
+            datagram.insert(datagram.end(), packet.begin(), packet.end());
+            stamp(header, now, offset == 0);
+            std::memcpy(datagram.data() + offset, &header, sizeof(header));
+        }
+        else if (!_waiting.empty() || isWindowFull())
+            _waiting.push_back(keep());
+        else
+            send(datagram, keep(), now);
+    }
+
+    /**
+     * @brief Append the first transmission of a reliable packet, with the next order
+     */
+    void send(Network::Buffer &datagram, std::shared_ptr<const Network::Buffer> packet, Clock::time_point now)
+    {
+        auto offset = datagram.size();
+        datagram.insert(datagram.end(), packet->begin(), packet->end());
+
+        Header<Id> header;
+        std::memcpy(&header, datagram.data() + offset, sizeof(header));
+        header._order = _nextOrder++;
+        auto sequence = stamp(header, now, offset == 0);
+        std::memcpy(datagram.data() + offset, &header, sizeof(header));
+
+        _pending.push_back({std::move(packet), header._order, sequence, now, _timeout});
+        ++_stats.reliableSent;
+    }
+
+    /**
+     * @brief Give a header the sequence of its datagram and the acks to send
+     *
+     * @param open  Whether the header is the first of its datagram, which gets the next sequence
+     */
+    uint16_t stamp(Header<Id> &header, Clock::time_point now, bool open)
+    {
+        if (open)
+        {
+            header._sequence = _nextSequence++;
+            _sent[header._sequence % SENT_HISTORY] = {now, header._sequence, false, false, 0};
+        }
+        else
+            header._sequence = static_cast<uint16_t>(_nextSequence - 1);
+        _sent[header._sequence % SENT_HISTORY].bytes += sizeof(header) + header._contentLength;
+        header._ack = _remoteSequence;
+        header._ackBits = _receivedBits;
+        _ackPending = false;
+        ++_stats.sent;
+        return header._sequence;
+    }
+
+    /**
+     * @brief Record a received sequence in the window of the acks to send
+     *
+     * @return false  If the sequence was already received
+     */
+    bool record(uint16_t sequence)
+    {
+        if (!_hasRemote)
+        {
+            _hasRemote = true;
+            _remoteSequence = sequence;
+            return true;
+        }
+        if (isNewer(sequence, _remoteSequence))
+        {
+            auto shift = static_cast<uint16_t>(sequence - _remoteSequence);
+            // the previous last sequence becomes bit shift - 1
+            if (shift > ACK_BITS)
+                _receivedBits = 0;
+            else
+                _receivedBits = static_cast<uint16_t>((_receivedBits << shift) | (1u << (shift - 1)));
+            _remoteSequence = sequence;
+            return true;
+        }
+        if (sequence == _remoteSequence)
+            return false;
+
+        auto back = static_cast<uint16_t>(_remoteSequence - sequence);
+        if (back > ACK_BITS) // older than the window: delivered, but not acked anymore
+            return true;
+        auto bit = static_cast<uint16_t>(1u << (back - 1));
+        if (_receivedBits & bit)
+            return false;
+        _receivedBits |= bit;
+        return true;
+    }
+
+    static bool isAcked(uint16_t sequence, uint16_t ack, uint16_t ackBits)
+    {
+        if (sequence == ack)
+            return true;
+        auto back = static_cast<uint16_t>(ack - sequence);
+        return isNewer(ack, sequence) && back <= ACK_BITS && (ackBits & (1u << (back - 1)));
+    }
+
+    /**
+     * @brief Drop the reliable packets acked by the peer, count the bytes of
+     * the datagrams delivered and lost for the congestion control, and sample
+     * the round trip time from the last sequence it received (each sequence is
+     * sent once, so the sample is never ambiguous, even for a retransmission)
+     */
+    void acknowledge(uint16_t ack, uint16_t ackBits, Clock::time_point now)
+    {
+        // an ack of a sequence not sent yet is garbage (the sequences start at 1, so the
+        // ack 0 of a peer that received nothing acks nothing)
+        if (isNewer(ack, static_cast<uint16_t>(_nextSequence - 1)))
+            return;
+
+        auto &sent = _sent[ack % SENT_HISTORY];
+        if (sent.sequence == ack && !sent.sampled)
+        {
+            sent.sampled = true;
+            sample(now - sent.at);
+        }
+
+        // the datagrams of the window are delivered once acked, lost once LOSS_REORDER newer ones were
+        // and the newest acked one was sent longer after it than the jitter may reorder them
+        auto reorder = _roundTripTime / 8 + _roundTripVariation;
+        for (uint16_t back = 0; back <= ACK_BITS && sent.sequence == ack; ++back)
+        {
+            auto sequence = static_cast<uint16_t>(ack - back);
+            auto &datagram = _sent[sequence % SENT_HISTORY];
+            bool delivered = isAcked(sequence, ack, ackBits);
+
+            if (datagram.sequence != sequence || datagram.resolved)
+                continue;
+            if (!delivered && (back < LOSS_REORDER || sent.at - datagram.at <= reorder))
+                continue;
+            datagram.resolved = true;
+            (delivered ? _stats.deliveredBytes : _stats.lostBytes) += datagram.bytes;
+        }
+
+        auto acked = std::remove_if(_pending.begin(), _pending.end(),
+                                    [&](const Pending &pending) { return isAcked(pending.sequence, ack, ackBits); });
+        _stats.acked += static_cast<uint64_t>(_pending.end() - acked);
+        _pending.erase(acked, _pending.end());
+    }
+
+    void sample(std::chrono::nanoseconds roundTripTime)
+    {
+        if (_roundTripTime.count() == 0)
+        {
+            _roundTripTime = roundTripTime;
+            _roundTripVariation = roundTripTime / 2;
+        }
+        else
+        {
+            auto error = std::chrono::abs(_roundTripTime - roundTripTime);
+            _roundTripVariation += (error - _roundTripVariation) / 4;
+            _roundTripTime += (roundTripTime - _roundTripTime) / 8;
+        }
+        _timeout = std::clamp(_roundTripTime + 4 * _roundTripVariation, MIN_TIMEOUT, MAX_TIMEOUT);
+    }
+
+private:
+    uint16_t _nextSequence = 1;                                  // Sequence of the next packet written
+    uint16_t _nextOrder = 0;                                     // Order of the next reliable packet written
+    std::vector<Pending> _pending;                               // Reliable packets not acked yet, by order
+    std::deque<std::shared_ptr<const Network::Buffer>> _waiting; // Reliable packets not sent yet, window full
+    std::array<Sent, SENT_HISTORY> _sent{};                      // Send times of the last sequences
+    std::chrono::nanoseconds _roundTripTime{0};                  // Smoothed round trip time
+    std::chrono::nanoseconds _roundTripVariation{0};             // Round trip time variation
+    std::chrono::nanoseconds _timeout = INITIAL_TIMEOUT;         // Timeout of a first retransmission
+
+    bool _hasRemote = false;                // A packet was received
+    uint16_t _remoteSequence = 0;           // Newest sequence received
+    uint16_t _lastSequence = 0;             // Sequence of the last packet received
+    uint16_t _receivedBits = 0;             // Sequences received before it
+    bool _ackPending = false;               // A reliable packet waits for its ack to be written
+    uint16_t _nextDelivery = 0;             // Order of the next reliable packet to deliver
+    std::vector<std::optional<Held>> _held; // Reliable packets received ahead, by order (allocated on use)
+    ReliabilityStats _stats;                // Counters
+};
+
+} // namespace Flakkari::Protocol
+
+#endif /* !FLAKKARI_RELIABILITY_HPP_ */
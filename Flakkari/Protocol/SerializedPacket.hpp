@@ -0,0 +1,106 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file SerializedPacket.hpp
+ * @brief Flakkari::Protocol::SerializedPacket and BroadcastPacket. A
+ * serialized packet is an immutable, reference counted wire image of a
+ * packet. It is encoded once and shared by every recipient queue.
+ *
+ * @see Flakkari::Protocol::Packet
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef SERIALIZEDPACKET_HPP_
+#define SERIALIZEDPACKET_HPP_
+
+#include "Packet.hpp"
+
+#include <array>
+#include <memory>
+
+namespace Flakkari::Protocol {
+
+/**
+ * @brief Handle on an already serialized packet.
+ *
+ * @details The wire bytes are held by a shared, read-only buffer: copying a
+ * SerializedPacket only bumps a reference count, so the same encoding can sit
+ * in the send queue of every client without being copied or re-serialized.
+ */
+struct SerializedPacket {
+    Priority priority = Priority::LOW;
+    std::shared_ptr<const Network::Buffer> data;
+
+    SerializedPacket() = default;
+
+    /**
+     * @brief Serialize a packet into a new shared buffer.
+     *
+     * @tparam Id  The type of the command id.
+     * @param packet  The packet to serialize.
+     */
+    template <typename Id>
+    explicit SerializedPacket(const Packet<Id> &packet)
+        : priority(packet.header._priority), data(std::make_shared<const Network::Buffer>(packet.serialize()))
+    {
+    }
+
+    /**
+     * @brief Get the size of the wire image.
+     *
+     * @return std::size_t  The size of the serialized packet in bytes.
+     */
+    [[nodiscard]] std::size_t size() const { return data ? data->size() : 0; }
+};
+
+/**
+ * @brief Packet sent to several clients, serialized at most once per API version.
+ *
+ * @tparam Id  The type of the command id.
+ *
+ * @example "Flakkari/Protocol/SerializedPacket.hpp"
+ * @code
+ * Protocol::BroadcastPacket<Protocol::CommandId> broadcast(packet);
+ * for (auto &player : players)
+ *     player->addPacketToSendQueue(broadcast.get(player->getApiVersion()));
+ * @endcode
+ */
+template <typename Id> class BroadcastPacket {
+public:
+    explicit BroadcastPacket(const Packet<Id> &packet) : _packet(packet) {}
+
+    /**
+     * @brief Get the wire image of the packet for a given API version.
+     * The packet is serialized on the first request for that version only.
+     *
+     * @param apiVersion  The API version of the recipient.
+     * @return const SerializedPacket&  The shared serialized packet.
+     */
+    [[nodiscard]] const SerializedPacket &get(ApiVersion apiVersion)
+    {
+        auto &encoded = _encoded[static_cast<std::size_t>(apiVersion)];
+
+        if (!encoded.data)
+        {
+            Network::Buffer buffer = _packet.serialize();
+            reinterpret_cast<Header<Id> *>(buffer.data())->_apiVersion = apiVersion;
+            encoded.priority = _packet.header._priority;
+            encoded.data = std::make_shared<const Network::Buffer>(std::move(buffer));
+        }
+        return encoded;
+    }
+
+private:
+    const Packet<Id> &_packet;
+    std::array<SerializedPacket, static_cast<std::size_t>(ApiVersion::MAX_VERSION)> _encoded;
+};
+
+} // namespace Flakkari::Protocol
+
+#endif /* !SERIALIZEDPACKET_HPP_ */
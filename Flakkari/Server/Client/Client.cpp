@@ -13,7 +13,7 @@ namespace Flakkari {
 
 Client::Client(const std::shared_ptr<Network::Address> &address, const std::string &name,
                Protocol::ApiVersion apiVersion)
-    : _address(address), _gameName(name), _name(address->toString().value_or(""))
+    : _address(address), _endpoint(address->getEndpoint()), _gameName(name), _name(_endpoint.toString())
 {
     _apiVersion = apiVersion;
     _lastActivity = std::chrono::steady_clock::now();
@@ -44,16 +44,46 @@ bool Client::incrementWarningCount()
     return _warningCount >= _maxWarningCount;
 }
 
-void Client::addPacketToReceiveQueue(const Protocol::Packet<Protocol::CommandId> &packet)
+bool Client::addPacketToReceiveQueue(const Protocol::PacketView<Protocol::CommandId> &packet)
 {
     _apiVersion = packet.header._apiVersion;
-    _receiveQueue.push_back(packet);
+    return _receiveQueue.push(packet);
 }
 
-void Client::addPacketToSendQueue(const Protocol::Packet<Protocol::CommandId> &packet)
+bool Client::addPacketToSendQueue(const Protocol::Packet<Protocol::CommandId> &packet)
 {
-    _apiVersion = packet.header._apiVersion;
-    _sendQueue.push_back(packet);
+    return addPacketToSendQueue(Protocol::SerializedPacket(packet));
+}
+
+bool Client::addPacketToSendQueue(const Protocol::SerializedPacket &packet)
+{
+    bool reliable =
+        packet.data && reinterpret_cast<const Protocol::Header<Protocol::CommandId> *>(packet.data->data())->_reliable;
+
+    if (!reliable)
+    {
+        if (_sendQueue.push_back(static_cast<std::size_t>(packet.priority), packet))
+            return true;
+        // a state update is superseded by the next one
+        FLAKKARI_LOG_DEBUG("send queue of client " + _name + " is full, packet dropped");
+        return false;
+    }
+
+    // a reliable packet is lost for good if dropped: it waits behind the ones already in the backlog
+    std::lock_guard<std::mutex> lock(_backlogMutex);
+    if (_reliableBacklog.empty() && _sendQueue.push_back(static_cast<std::size_t>(packet.priority), packet))
+        return true;
+    _reliableBacklog.push_back(packet);
+    return true;
+}
+
+std::size_t Client::flushReliableBacklog()
+{
+    std::lock_guard<std::mutex> lock(_backlogMutex);
+    while (!_reliableBacklog.empty() &&
+           _sendQueue.push_back(static_cast<std::size_t>(_reliableBacklog.front().priority), _reliableBacklog.front()))
+        _reliableBacklog.pop_front();
+    return _reliableBacklog.size();
 }
 
 } /* namespace Flakkari */
@@ -17,13 +17,22 @@
 #define CLIENT_HPP_
 
 #include <chrono>
+#include <deque>
 #include <mutex>
+#include <unordered_map>
 
 #include "../Game/GameManager.hpp"
 #include "Engine/EntityComponentSystem/Entity.hpp"
-#include "Network/PacketQueue.hpp"
+#include "Network/FrameWriter.hpp"
+#include "Network/PriorityRingQueue.hpp"
+#include "Network/RingQueue.hpp"
 #include "Network/Socket.hpp"
+#include "Protocol/Checksum.hpp"
+#include "Protocol/Congestion.hpp"
+#include "Protocol/Fragmentation.hpp"
 #include "Protocol/Packet.hpp"
+#include "Protocol/Reliability.hpp"
+#include "Protocol/SerializedPacket.hpp"
 
 namespace Flakkari {
 
@@ -40,6 +49,15 @@ namespace Flakkari {
  * @see Network::Address
  */
 class Client {
+public:
+    using SendQueue = Network::PriorityRingQueue<Protocol::SerializedPacket,
+                                                 static_cast<std::size_t>(Protocol::Priority::MAX_PRIORITY)>;
+    using ReceiveQueue = Network::SpscRing<Protocol::PacketView<Protocol::CommandId>>;
+    using Channel = Protocol::ReliableChannel<Protocol::CommandId, Protocol::PacketView<Protocol::CommandId>>;
+
+    static constexpr std::size_t RECEIVE_QUEUE_CAPACITY = 256; // Packets waiting for the game thread
+    static constexpr std::size_t SEND_QUEUE_CAPACITY = 256;    // Packets waiting to be sent, per priority level
+
 public:
     /**
      * @brief Construct a new Client object
@@ -83,19 +101,43 @@ public:
 
     /**
      * @brief Add a packet to the client's receive queue and set the api version
-     * used by the client
+     * used by the client. The payload still references the receive buffer,
+     * which is given back when the game thread pops the packet. Only the
+     * network thread of the client's shard may call it (single producer).
      *
      * @param packet  The packet to add
+     * @return true  If the packet was queued, false if the queue was full
      */
-    void addPacketToReceiveQueue(const Protocol::Packet<Protocol::CommandId> &packet);
+    bool addPacketToReceiveQueue(const Protocol::PacketView<Protocol::CommandId> &packet);
 
     /**
-     * @brief Add a packet to the client's send queue and set the api version
-     * used by the client
+     * @brief Serialize a packet and add it to the client's send queue of the
+     * packet's priority
      *
      * @param packet  The packet to add
+     * @return true  If the packet was queued, false if its level was full
+     */
+    bool addPacketToSendQueue(const Protocol::Packet<Protocol::CommandId> &packet);
+
+    /**
+     * @brief Add an already serialized packet to the client's send queue.
+     * The wire image is shared, not copied. A reliable packet is never
+     * dropped: when its level is full, it waits in the reliable backlog, in
+     * order with the reliable packets added after it.
+     *
+     * @param packet  The serialized packet to add
+     * @return true  If the packet was queued, false if its level was full and it was dropped
+     */
+    bool addPacketToSendQueue(const Protocol::SerializedPacket &packet);
+
+    /**
+     * @brief Move the reliable packets of the backlog back to the send queue,
+     * oldest first, while their levels have room (game thread, before the
+     * send queue is written)
+     *
+     * @return std::size_t  The number of reliable packets still in the backlog
      */
-    void addPacketToSendQueue(const Protocol::Packet<Protocol::CommandId> &packet);
+    std::size_t flushReliableBacklog();
 
     /**
      * @brief Get the client's address
@@ -104,6 +146,13 @@ public:
      */
     [[nodiscard]] std::shared_ptr<Network::Address> getAddress() const { return _address; }
 
+    /**
+     * @brief Get the Endpoint of the client, its key in the ClientManager
+     *
+     * @return const Network::Endpoint&  The family, ip and port of the client
+     */
+    [[nodiscard]] const Network::Endpoint &getEndpoint() const { return _endpoint; }
+
     /**
      * @brief Get the Entity object
      *
@@ -112,8 +161,12 @@ public:
     [[nodiscard]] Engine::ECS::Entity getEntity() const { return _entity; }
     void setEntity(Engine::ECS::Entity entity) { _entity = entity; }
 
-    [[nodiscard]] std::string getSceneName() const { return _sceneName; }
-    void setSceneName(std::string sceneName) { _sceneName = sceneName; }
+    [[nodiscard]] SceneId getSceneId() const { return _sceneId; }
+    void setSceneId(SceneId sceneId)
+    {
+        _sceneId = sceneId;
+        _pendingMoves.clear();
+    }
 
     [[nodiscard]] std::string getGameName() const { return _gameName; }
     void setGameName(std::string gameName) { _gameName = gameName; }
@@ -129,18 +182,83 @@ public:
 
     [[nodiscard]] Protocol::ApiVersion getApiVersion() const { return _apiVersion; }
 
-    [[nodiscard]] Network::PacketQueue<Protocol::Packet<Protocol::CommandId>> &getReceiveQueue()
-    {
-        return _receiveQueue;
-    }
+    [[nodiscard]] ReceiveQueue &getReceiveQueue() { return _receiveQueue; }
+
+    [[nodiscard]] SendQueue &getSendQueue() { return _sendQueue; }
+
+    /**
+     * @brief Get the reliability layer of the client's connection. Only the
+     * thread of the client's game uses it: it stamps the packets of the tick
+     * and takes the acks and the order of the received ones.
+     */
+    [[nodiscard]] Channel &getChannel() { return _channel; }
+
+    /**
+     * @brief Get the splitter of the packets larger than the MTU sent to the
+     * client, and the reassembly buffer of the ones it sends (game thread).
+     */
+    [[nodiscard]] Protocol::Fragmenter<Protocol::CommandId> &getFragmenter() { return _fragmenter; }
+    [[nodiscard]] Protocol::Reassembler &getReassembler() { return _reassembler; }
+
+    /**
+     * @brief Get the outbound writer of the client: the frames, of at most
+     * one MTU each, the game thread packs the packets of a tick in.
+     */
+    [[nodiscard]] Network::FrameWriter &getWriter() { return _writer; }
+
+    /**
+     * @brief Get the size of the largest datagram the client may be sent
+     *
+     * @return std::size_t  The MTU in bytes
+     */
+    [[nodiscard]] std::size_t getMtu() const { return _writer.getMtu(); }
+    void setMtu(std::size_t mtu) { _writer.setMtu(mtu); }
+
+    /**
+     * @brief Get the dictionary of the compression of the datagrams sent to
+     * the client: the one it offered in REQ_CONNECT until it joins a game,
+     * then the one the game accepted (Network::Compressor::NO_DICTIONARY:
+     * the datagrams are sent as they are)
+     */
+    [[nodiscard]] uint32_t getDictionaryId() const { return _dictionaryId; }
+    void setDictionaryId(uint32_t dictionaryId) { _dictionaryId = dictionaryId; }
 
-    [[nodiscard]] Network::PacketQueue<Protocol::Packet<Protocol::CommandId>> &getSendQueue() { return _sendQueue; }
+    /**
+     * @brief Get the CRC32C trailer of the client's datagrams: enabled if the
+     * client asked for it in REQ_CONNECT, on the datagrams it sends and the
+     * ones it is sent
+     */
+    [[nodiscard]] Protocol::DatagramChecksum &getChecksum() { return _checksum; }
+    void setChecksum(const Protocol::DatagramChecksum &checksum) { _checksum = checksum; }
+
+    /**
+     * @brief Get the congestion control of the client's connection: the send
+     * rate, the bytes each tick may send and the snapshot frequency of the
+     * client (game thread).
+     */
+    [[nodiscard]] Protocol::CongestionController &getCongestion() { return _congestion; }
+
+    /**
+     * @brief Get the entities of the client's scene moved since the last
+     * snapshot the client was sent, with their last input id. Only a client
+     * whose snapshots are spaced out by the congestion control holds any.
+     */
+    [[nodiscard]] std::unordered_map<Engine::ECS::Entity, uint32_t> &getPendingMoves() { return _pendingMoves; }
+
+    /**
+     * @brief Get the smoothed round trip time of the client, sampled by its
+     * channel from the acks of the datagrams it was sent
+     *
+     * @return std::chrono::nanoseconds  The round trip time (0 until a sample is known)
+     */
+    [[nodiscard]] std::chrono::nanoseconds getRoundTripTime() const { return _channel.getRoundTripTime(); }
 
 private:
     std::chrono::steady_clock::time_point _lastActivity;
     std::shared_ptr<Network::Address> _address;
+    Network::Endpoint _endpoint;
     Engine::ECS::Entity _entity;
-    std::string _sceneName;
+    SceneId _sceneId = 0;
     std::string _gameName;
     bool _isConnected = true;
     std::string _name;
@@ -148,10 +266,20 @@ private:
     unsigned short _warningCount = 0;
     unsigned short _maxWarningCount = 5;
     unsigned short _maxPacketHistory = 10;
+    uint32_t _dictionaryId = 0;
+    Protocol::DatagramChecksum _checksum;
 
     std::vector<Network::Buffer> _packetHistory;
-    Network::PacketQueue<Protocol::Packet<Protocol::CommandId>> _sendQueue;
-    Network::PacketQueue<Protocol::Packet<Protocol::CommandId>> _receiveQueue;
+    SendQueue _sendQueue{SEND_QUEUE_CAPACITY};
+    std::deque<Protocol::SerializedPacket> _reliableBacklog; // Reliable packets whose level was full, in order
+    std::mutex _backlogMutex;                                // Guards the backlog (any thread may add a packet)
+    ReceiveQueue _receiveQueue{RECEIVE_QUEUE_CAPACITY};
+    Channel _channel;
+    Protocol::Fragmenter<Protocol::CommandId> _fragmenter;
+    Protocol::Reassembler _reassembler;
+    Network::FrameWriter _writer{Protocol::DEFAULT_MTU};
+    Protocol::CongestionController _congestion;
+    std::unordered_map<Engine::ECS::Entity, uint32_t> _pendingMoves;
 };
 
 } /* namespace Flakkari */
@@ -14,157 +14,336 @@
 
 namespace Flakkari {
 
+ClientManager::ClientManager(const std::vector<std::shared_ptr<Network::Socket>> &sockets)
+{
+    for (const auto &socket : sockets)
+    {
+        _shards.push_back(std::make_unique<Shard>());
+        _shards.back()->socket = socket;
+    }
+}
+
 std::optional<std::pair<std::string, std::shared_ptr<Client>>>
-ClientManager::addClient(const std::shared_ptr<Network::Address> &client, Network::Buffer &buffer)
+ClientManager::addClient(const std::shared_ptr<Network::Address> &client, Network::Buffer &buffer, std::size_t shard)
 {
-    if (this->isBanned(client))
+    auto endpoint = client->getEndpoint();
+
+    if (isBanned(endpoint))
     {
-        FLAKKARI_LOG_LOG("Client " + client->toString().value_or("Unknown") + " tried to connect but is banned");
+        FLAKKARI_LOG_LOG("Client " + endpoint.toString() + " tried to connect but is banned");
         return std::nullopt;
     }
 
-    auto clientString = client->toString().value_or("");
+    auto &clientShard = *_shards[shard];
+    std::lock_guard<std::mutex> lock(clientShard.mutex);
 
-    if (_clients.contains(clientString))
+    if (auto *known = clientShard.clients.find(endpoint))
     {
-        _clients[clientString]->keepAlive();
+        (*known)->keepAlive();
         return std::make_pair("", nullptr);
     }
 
+    return connectClient(clientShard, endpoint, Network::BufferView::copyOf(buffer));
+}
+
+std::optional<std::pair<std::string, std::shared_ptr<Client>>>
+ClientManager::connectClient(Shard &shard, const Network::Endpoint &client, const Network::BufferView &datagram)
+{
+    // a client that can decompress the datagrams sends the id of its dictionary after the name of the game, then its
+    // options: they are read first, as a client that asked for the CRC32C trailer has it on this datagram already
+    bool sealed = false;
+    Protocol::Header<Protocol::CommandId> header;
+    int nameSize;
+    if (datagram.size() >= header.size() + sizeof(nameSize))
+    {
+        std::memcpy(&header, datagram.data(), header.size());
+        std::memcpy(&nameSize, datagram.data() + header.size(), sizeof(nameSize));
+        auto end = header.size() + header._contentLength;
+        auto name = header.size() + sizeof(nameSize) + static_cast<std::size_t>(nameSize);
+
+        if (header._commandId == Protocol::CommandId::REQ_CONNECT)
+        {
+            // a length past the datagram is a corrupted one, or the datagram was cut on the way
+            if (end > datagram.size() || nameSize < 0 || name > end)
+                return std::nullopt;
+            // nothing but the trailer follows REQ_CONNECT: bytes after the packet are one, even if the options were hit
+            sealed = datagram.size() > end;
+            if (name + sizeof(uint32_t) < end)
+                sealed |= (datagram.data()[name + sizeof(uint32_t)] & Protocol::DatagramChecksum::OPTION) != 0;
+        }
+    }
+
+    // a corrupted REQ_CONNECT is dropped as the network would have: the client sends it again, it is not banned
+    Protocol::DatagramChecksum checksum(sealed);
+    std::size_t size = datagram.size();
+    if (!checksum.open(datagram.data(), size))
+        return std::nullopt;
+    auto buffer = datagram.subview(0, size);
+
     Protocol::Packet<Protocol::CommandId> packet;
     if (!packet.deserialize(buffer))
     {
-        FLAKKARI_LOG_WARNING("Client " + client->toString().value_or("Unknown") + " sent an invalid packet");
-        _bannedClients.push_back(client->getIp().value());
+        FLAKKARI_LOG_WARNING("Client " + client.toString() + " sent an invalid packet");
+        ban(client);
         return std::nullopt;
     }
 
     if (packet.header._commandId != Protocol::CommandId::REQ_CONNECT)
     {
-        FLAKKARI_LOG_WARNING("Client " + client->toString().value_or("Unknown") + " sent an invalid packet");
-        _bannedClients.push_back(client->getIp().value());
+        FLAKKARI_LOG_WARNING("Client " + client.toString() + " sent an invalid packet");
+        ban(client);
         return std::nullopt;
     }
 
     std::string gameName = packet.extractString();
+
+    uint32_t dictionaryId = 0;
+    if (packet.payload.size() >= sizeof(dictionaryId))
+        packet >> dictionaryId;
+
     auto apiVersion = packet.header._apiVersion;
-    _clients[clientString] = std::make_shared<Client>(client, gameName, apiVersion);
+    auto address = std::make_shared<Network::Address>(client, Network::Address::SocketType::UDP);
+    auto &newClient = shard.clients.insert(client, std::make_shared<Client>(address, gameName, apiVersion));
+    newClient->setDictionaryId(dictionaryId);
+    newClient->setChecksum(checksum);
+    newClient->setMtu(newClient->getMtu() - checksum.getOverhead());
+
+    // REQ_CONNECT is reliable: the channel of the client acks it, and drops the copies sent again before the ack
+    Protocol::PacketView<Protocol::CommandId> view;
+    if (view.deserialize(buffer))
+        newClient->addPacketToReceiveQueue(view);
+
+    return std::make_pair(gameName, newClient);
+}
 
-    return std::make_pair(gameName, _clients[clientString]);
+void ClientManager::removeClient(const Network::Endpoint &client)
+{
+    for (auto &shard : _shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        if (shard->clients.erase(client))
+            return;
+    }
 }
 
-void ClientManager::removeClient(const std::string &clientName)
+bool ClientManager::isBanned(const std::shared_ptr<Network::Address> &client)
 {
-    if (_clients.find(clientName) == _clients.end())
-        return;
+    return isBanned(client->getEndpoint());
+}
 
-    _clients.erase(clientName);
+bool ClientManager::isBanned(const Network::Endpoint &client)
+{
+    std::lock_guard<std::mutex> lock(_bannedMutex);
+    return !_bannedClients.empty() && _bannedClients.contains(client.host());
 }
 
-bool ClientManager::isBanned(const std::shared_ptr<Network::Address> &client)
+void ClientManager::ban(const Network::Endpoint &client)
 {
-    return std::find(_bannedClients.begin(), _bannedClients.end(), client->getIp().value_or("")) !=
-           _bannedClients.end();
+    std::lock_guard<std::mutex> lock(_bannedMutex);
+    _bannedClients.insert(client.host(), true);
 }
 
 void ClientManager::checkInactiveClients()
 {
-    for (auto it = _clients.begin(); it != _clients.end();)
-    {
-        if (!it->second->isConnected())
-        {
-            FLAKKARI_LOG_LOG("Client " + it->first + " disconnected");
-            it = _clients.erase(it);
-            continue;
-        }
+    for (std::size_t shard = 0; shard < _shards.size(); ++shard)
+        checkInactiveClients(shard);
+}
 
-        ++it;
-    }
+void ClientManager::checkInactiveClients(std::size_t shard)
+{
+    auto &clientShard = *_shards[shard];
+    std::lock_guard<std::mutex> lock(clientShard.mutex);
+
+    clientShard.clients.eraseIf([](const Network::Endpoint &, const std::shared_ptr<Client> &client) {
+        if (client->isConnected())
+            return false;
+        FLAKKARI_LOG_LOG("Client " + client->getName().value_or("") + " disconnected");
+        return true;
+    });
 }
 
 void ClientManager::sendPacketToClient(const std::shared_ptr<Network::Address> &client, const Network::Buffer &packet)
 {
-    _socket->sendTo(client, packet);
+    _shards.front()->socket->sendTo(client, packet);
+}
+
+void ClientManager::sendPacketsToClients(
+    const std::vector<std::pair<std::shared_ptr<Network::Address>, const Network::Buffer *>> &packets)
+{
+    _shards.front()->socket->sendBatch(packets);
 }
 
 void ClientManager::sendPacketToAllClients(const Network::Buffer &packet)
 {
-    for (auto &tmp_client : _clients)
+    for (auto &shard : _shards)
     {
-        if (tmp_client.second->isConnected())
-            _socket->sendTo(tmp_client.second->getAddress(), packet);
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->clients.forEach([&](const Network::Endpoint &, const std::shared_ptr<Client> &client) {
+            if (client->isConnected())
+                shard->socket->sendTo(client->getAddress(), packet);
+        });
     }
 }
 
 void ClientManager::sendPacketToAllClientsExcept(const std::shared_ptr<Network::Address> &client,
                                                  const Network::Buffer &packet)
 {
-    auto clientKey = client->toString().value_or("");
+    auto except = client->getEndpoint();
 
-    for (auto &tmp_client : _clients)
+    for (auto &shard : _shards)
     {
-        auto tmp_clientKey = tmp_client.second->getName().value_or("");
-
-        if (tmp_client.second->isConnected() && tmp_clientKey != clientKey)
-            _socket->sendTo(tmp_client.second->getAddress(), packet);
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->clients.forEach([&](const Network::Endpoint &endpoint, const std::shared_ptr<Client> &tmp_client) {
+            if (tmp_client->isConnected() && endpoint != except)
+                shard->socket->sendTo(tmp_client->getAddress(), packet);
+        });
     }
 }
 
 std::optional<std::pair<std::string, std::shared_ptr<Client>>>
-ClientManager::receivePacketFromClient(const std::shared_ptr<Network::Address> &client, const Network::Buffer &buffer)
+ClientManager::receivePacketFromClient(const std::shared_ptr<Network::Address> &client, const Network::Buffer &buffer,
+                                       std::size_t shard)
 {
-    auto clientName = client->toString().value_or("");
-    auto ip = client->getIp().value_or("");
+    auto endpoint = client->getEndpoint();
 
-    if (std::find(_bannedClients.begin(), _bannedClients.end(), ip) != _bannedClients.end())
+    if (isBanned(endpoint))
     {
-        FLAKKARI_LOG_LOG("Client " + clientName + " tried to connect but is banned");
+        FLAKKARI_LOG_LOG("Client " + endpoint.toString() + " tried to connect but is banned");
         return std::nullopt;
     }
 
-    if (!_clients.contains(clientName))
+    auto &clientShard = *_shards[shard];
+    std::lock_guard<std::mutex> lock(clientShard.mutex);
+
+    auto *known = clientShard.clients.find(endpoint);
+    if (known == nullptr)
         return std::nullopt;
-    auto &tmp_client = _clients[clientName];
+    return handlePacket(*known, Network::BufferView::copyOf(buffer));
+}
 
-    Protocol::Packet<Protocol::CommandId> packet;
-    if (packet.deserialize(buffer))
+std::optional<std::pair<std::string, std::shared_ptr<Client>>>
+ClientManager::handlePacket(const std::shared_ptr<Client> &client, const Network::BufferView &datagram)
+{
+    // a datagram corrupted on the way is dropped as the network would have, without a warning for the client
+    std::size_t size = datagram.size();
+    if (!client->getChecksum().open(datagram.data(), size))
     {
-        FLAKKARI_LOG_LOG("Client " + clientName + " sent a valid packet: " + packet.to_string());
+        FLAKKARI_LOG_WARNING("Client " + client->getName().value_or("") + " sent a datagram with an invalid checksum");
+        return std::nullopt;
+    }
+    auto buffer = datagram.subview(0, size);
+
+    // the client puts the packets it sends again end to end in one datagram, with their shared sequence
+    for (std::size_t offset = 0; offset < buffer.size();)
+    {
+        Protocol::PacketView<Protocol::CommandId> packet;
+        if (!packet.deserialize(buffer.subview(offset, buffer.size() - offset)))
+            break;
+        offset += packet.size();
+        FLAKKARI_LOG_DEBUG("Client " + client->getName().value_or("") + " sent a valid packet: " + packet.to_string());
 
         if (packet.header._commandId == Protocol::CommandId::REQ_DISCONNECT)
         {
-            FLAKKARI_LOG_LOG("Client " + clientName + " disconnected");
-            return std::make_pair(tmp_client->getGameName(), tmp_client);
+            FLAKKARI_LOG_LOG("Client " + client->getName().value_or("") + " disconnected");
+            return std::make_pair(client->getGameName(), client);
         }
 
-        tmp_client->addPacketToReceiveQueue(packet);
-        return std::nullopt;
+        // the game thread is late: drop the packet as the network would
+        if (!client->addPacketToReceiveQueue(packet))
+            FLAKKARI_LOG_DEBUG("receive queue of client " + client->getName().value_or("") + " is full");
+        if (offset == buffer.size())
+            return std::nullopt;
     }
 
-    FLAKKARI_LOG_WARNING("Client " + clientName + " sent an invalid packet");
+    FLAKKARI_LOG_WARNING("Client " + client->getName().value_or("") + " sent an invalid packet");
 
-    if (!tmp_client->incrementWarningCount())
+    if (!client->incrementWarningCount())
         return std::nullopt;
 
-    FLAKKARI_LOG_LOG("Client " + clientName + " has been banned");
+    FLAKKARI_LOG_LOG("Client " + client->getName().value_or("") + " has been banned");
+
+    ban(client->getEndpoint());
+    FLAKKARI_LOG_LOG("Client " + client->getName().value_or("") + " banned");
+    return std::make_pair(client->getGameName(), client);
+}
+
+ClientManager::ReceivedBatch
+ClientManager::receivePackets(const std::vector<std::pair<Network::Endpoint, Network::BufferView>> &datagrams,
+                              std::size_t shard)
+{
+    ReceivedBatch batch;
+    auto &clientShard = *_shards[shard];
+
+    {
+        std::lock_guard<std::mutex> lock(clientShard.mutex);
 
-    _bannedClients.push_back(ip);
-    FLAKKARI_LOG_LOG("Client " + clientName + " banned");
-    return std::make_pair(tmp_client->getGameName(), tmp_client);
+        for (const auto &[endpoint, buffer] : datagrams)
+        {
+            if (isBanned(endpoint))
+            {
+                FLAKKARI_LOG_LOG("Client " + endpoint.toString() + " tried to connect but is banned");
+                continue;
+            }
+
+            auto *known = clientShard.clients.find(endpoint);
+            if (known == nullptr)
+            {
+                if (auto connected = connectClient(clientShard, endpoint, buffer))
+                    batch.connected.push_back(std::move(*connected));
+                continue;
+            }
+
+            (*known)->keepAlive();
+            if (auto disconnected = handlePacket(*known, buffer))
+                batch.disconnected.push_back(std::move(*disconnected));
+        }
+    }
+
+    checkInactiveClients(shard);
+    return batch;
+}
+
+std::shared_ptr<Client> ClientManager::findClient(const Network::Endpoint &client)
+{
+    for (auto &shard : _shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        if (auto *found = shard->clients.find(client))
+            return *found;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<Client> ClientManager::findClient(const std::string &id)
+{
+    std::shared_ptr<Client> found;
+
+    for (auto &shard : _shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->clients.forEach([&](const Network::Endpoint &, const std::shared_ptr<Client> &client) {
+            if (!found && client->getName() == id)
+                found = client;
+        });
+        if (found)
+            return found;
+    }
+    return nullptr;
 }
 
 std::shared_ptr<Client> ClientManager::getClient(const std::shared_ptr<Network::Address> &client)
 {
-    return _clients[client->toString().value_or("")];
+    return findClient(client->getEndpoint());
 }
 
-std::shared_ptr<Client> ClientManager::getClient(const std::string &id) { return _clients[id]; }
+std::shared_ptr<Client> ClientManager::getClient(const std::string &id) { return findClient(id); }
 
 std::shared_ptr<Network::Address> ClientManager::getAddress(const std::string &id)
 {
-    return _clients[id]->getAddress();
+    auto client = findClient(id);
+    return client ? client->getAddress() : nullptr;
 }
 
-std::shared_ptr<Client> ClientManager::operator[](const std::string &id) { return _clients[id]; }
+std::shared_ptr<Client> ClientManager::operator[](const std::string &id) { return findClient(id); }
 
 } /* namespace Flakkari */
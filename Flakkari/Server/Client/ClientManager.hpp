@@ -17,6 +17,7 @@
 #define CLIENTMANAGER_HPP_
 
 #include "Client.hpp"
+#include "Network/EndpointMap.hpp"
 #include "Network/Network.hpp"
 #include "Network/Serializer.hpp"
 
@@ -24,7 +25,7 @@
 #include <Singleton.hpp>
 #include <memory>
 #include <mutex>
-#include <unordered_map>
+#include <vector>
 
 namespace Flakkari {
 
@@ -37,6 +38,17 @@ namespace Flakkari {
  * It is also used to check if the clients are still connected to the server
  * (using the checkInactiveClients() method) and to add a client to the client
  *
+ * The clients are split in shards, one per socket of the server (the sockets
+ * share the port with SO_REUSEPORT and the kernel hashes each client to one
+ * of them). A shard owns its client table and its lock: the methods taking a
+ * shard only lock that shard, so the receive threads of the shards do not
+ * contend with each other nor with the lock of the singleton. The other
+ * methods look up the clients in every shard.
+ *
+ * The client tables and the banned ips are keyed by Network::Endpoint in an
+ * open addressing table: finding the client of a datagram neither formats
+ * nor allocates anything.
+ *
  * @see UDPServer
  * @see Client
  *
@@ -50,9 +62,15 @@ namespace Flakkari {
  */
 class ClientManager : public Singleton<ClientManager> {
 private:
-    std::unordered_map<std::string /*ip*/, std::shared_ptr<Client>> _clients;
-    std::vector<std::string /*ip*/> _bannedClients;
-    std::shared_ptr<Network::Socket> _socket;
+    struct Shard {
+        std::shared_ptr<Network::Socket> socket;               // Socket receiving the shard's clients
+        Network::EndpointMap<std::shared_ptr<Client>> clients; // Clients hashed to the socket
+        std::mutex mutex;                                      // Lock of the client table
+    };
+
+    std::vector<std::unique_ptr<Shard>> _shards;
+    Network::EndpointMap<bool> _bannedClients; // Banned ips (endpoints of port 0)
+    std::mutex _bannedMutex;
 
     using id_t = short;
 
@@ -62,7 +80,17 @@ public:
      *
      * @param socket  The server's socket
      */
-    explicit ClientManager(const std::shared_ptr<Network::Socket> &socket) : _socket(socket) {}
+    explicit ClientManager(const std::shared_ptr<Network::Socket> &socket)
+        : ClientManager(std::vector<std::shared_ptr<Network::Socket>>{socket})
+    {
+    }
+
+    /**
+     * @brief Construct a new ClientManager object with one shard per socket
+     *
+     * @param sockets  The server's sockets, bound to the same port
+     */
+    explicit ClientManager(const std::vector<std::shared_ptr<Network::Socket>> &sockets);
 
     /**
      * @brief Destroy the ClientManager object
@@ -75,18 +103,19 @@ public:
      *
      * @param client  The client's address
      * @param buffer  The packet received from the client
+     * @param shard  The shard of the socket that received the packet
      * @return std::optional<std::pair<std::string, std::shared_ptr<Client>>
      *         The client's name and the client object
      */
     std::optional<std::pair<std::string, std::shared_ptr<Client>>>
-    addClient(const std::shared_ptr<Network::Address> &client, Network::Buffer &buffer);
+    addClient(const std::shared_ptr<Network::Address> &client, Network::Buffer &buffer, std::size_t shard = 0);
 
     /**
      * @brief Remove a client from the client manager
      *
-     * @param client  The client's name
+     * @param client  The client's endpoint
      */
-    void removeClient(const std::string &client);
+    void removeClient(const Network::Endpoint &client);
 
     /**
      * @brief Check if a client is banned
@@ -108,6 +137,13 @@ public:
      */
     void checkInactiveClients();
 
+    /**
+     * @brief Check the clients of one shard only (see checkInactiveClients())
+     *
+     * @param shard  The shard to check
+     */
+    void checkInactiveClients(std::size_t shard);
+
     /**
      * @brief Send a packet to a client
      *
@@ -116,6 +152,17 @@ public:
      */
     void sendPacketToClient(const std::shared_ptr<Network::Address> &client, const Network::Buffer &packet);
 
+    /**
+     * @brief Send a batch of packets, each to its client, in as few syscalls
+     * as possible (see Network::Socket::sendBatch). Any socket bound to the
+     * port can send to any client: the batch goes through the first one.
+     * The packets are not copied, they must outlive the call.
+     *
+     * @param packets  The clients' addresses and the packets to send (the frames of their writers)
+     */
+    void sendPacketsToClients(
+        const std::vector<std::pair<std::shared_ptr<Network::Address>, const Network::Buffer *>> &packets);
+
     /**
      * @brief Send a packet to all clients
      *
@@ -136,11 +183,41 @@ public:
      *
      * @param client  The client's address
      * @param packet  The packet received
+     * @param shard  The shard of the socket that received the packet
      * @return std::optional<std::pair<const std::string &, std::shared_ptr<Client>>
      *         A pair of the client's game name and the client object
      */
     std::optional<std::pair<std::string, std::shared_ptr<Client>>>
-    receivePacketFromClient(const std::shared_ptr<Network::Address> &client, const Network::Buffer &packet);
+    receivePacketFromClient(const std::shared_ptr<Network::Address> &client, const Network::Buffer &packet,
+                            std::size_t shard = 0);
+
+    /**
+     * @brief Clients to add to or remove from their game after a batch of packets
+     */
+    struct ReceivedBatch {
+        std::vector<std::pair<std::string, std::shared_ptr<Client>>> connected;    // New clients and their game
+        std::vector<std::pair<std::string, std::shared_ptr<Client>>> disconnected; // Leaving or banned clients
+    };
+
+    /**
+     * @brief Handle a batch of packets received by a shard under one lock of
+     * the shard: connect the new clients, keep the known ones alive and queue
+     * their packets, then check the inactive clients of the shard once for
+     * the whole batch
+     *
+     * @param datagrams  The clients' addresses and the packets received, in order
+     * @param shard  The shard of the socket that received the batch
+     * @return ReceivedBatch  The clients to add to their game and the clients to remove from it
+     */
+    ReceivedBatch receivePackets(const std::vector<std::pair<Network::Endpoint, Network::BufferView>> &datagrams,
+                                 std::size_t shard = 0);
+
+    /**
+     * @brief Get the number of shards (sockets) of the client manager
+     *
+     * @return std::size_t  The number of shards
+     */
+    [[nodiscard]] std::size_t getShardCount() const { return _shards.size(); }
 
     /**
      * @brief Get the Client object
@@ -173,6 +250,59 @@ public:
      * @return std::shared_ptr<Client>  The client object
      */
     std::shared_ptr<Client> operator[](const std::string &id);
+
+private:
+    /**
+     * @brief Find a client in the shards, locking one shard at a time
+     *
+     * @param client  The client's endpoint
+     * @return std::shared_ptr<Client>  The client object, nullptr if unknown
+     */
+    std::shared_ptr<Client> findClient(const Network::Endpoint &client);
+
+    /**
+     * @brief Find a client by name in the shards (a scan of the clients)
+     *
+     * @param id  The client's id
+     * @return std::shared_ptr<Client>  The client object, nullptr if unknown
+     */
+    std::shared_ptr<Client> findClient(const std::string &id);
+
+    /**
+     * @brief Check if the ip of an endpoint is banned, under the lock of the banned list
+     */
+    [[nodiscard]] bool isBanned(const Network::Endpoint &client);
+
+    /**
+     * @brief Ban the ip of an endpoint, under the lock of the banned list
+     */
+    void ban(const Network::Endpoint &client);
+
+    /**
+     * @brief Create a client from its first packet, which must be a
+     * REQ_CONNECT (the sender is banned otherwise). The Address of the
+     * client is made here, once. A REQ_CONNECT that asks for the CRC32C
+     * trailer and fails it is dropped, without a ban.
+     *
+     * @param shard  The shard of the client, locked by the caller
+     * @param client  The client's endpoint
+     * @param datagram  The datagram received from the client (and its CRC32C trailer, if it asks for it)
+     * @return std::optional<std::pair<std::string, std::shared_ptr<Client>>>
+     *         The game of the client and the client object
+     */
+    std::optional<std::pair<std::string, std::shared_ptr<Client>>>
+    connectClient(Shard &shard, const Network::Endpoint &client, const Network::BufferView &datagram);
+
+    /**
+     * @brief Queue the packets of a datagram of a known client
+     *
+     * @param client  The client object
+     * @param datagram  The datagram received from the client (its packets end to end, and its CRC32C trailer)
+     * @return std::optional<std::pair<std::string, std::shared_ptr<Client>>>
+     *         The game of the client and the client object if it left or got banned
+     */
+    std::optional<std::pair<std::string, std::shared_ptr<Client>>> handlePacket(const std::shared_ptr<Client> &client,
+                                                                                const Network::BufferView &datagram);
 };
 
 } /* namespace Flakkari */
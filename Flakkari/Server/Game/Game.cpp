@@ -14,75 +14,83 @@
 
 namespace Flakkari {
 
-Game::Game(const std::string &name, std::shared_ptr<nlohmann::json> config)
+Game::Game(const std::string &name, std::shared_ptr<const GameSettings> settings)
 {
     _name = name;
-    _config = config;
+    _settings = settings;
     _time = std::chrono::steady_clock::now();
+    _simulationTime = _time;
 
-    if ((*_config)["scenes"].empty())
-    {
-        FLAKKARI_LOG_ERROR("Game: no scenes found");
-        return;
-    }
+#ifdef FLAKKARI_PROFILE_SYSTEMS
+    _tickSlot = _profiler.slot("tick");
+    _profileDumpTime = _time;
+    if (const char *interval = std::getenv("FLAKKARI_PROFILE_INTERVAL"))
+        _profileDumpInterval = std::chrono::seconds(std::atoi(interval));
+#endif
 
-    loadScene((*_config)["startGame"]);
-    ResourceManager::GetInstance().addScene(config, (*_config)["startGame"]);
+    _startScene = loadScene(_settings->startGame);
+    ResourceManager::GetInstance().addScene(_settings->config, _settings->startGame);
     ResourceManager::UnlockInstance();
 }
 
 Game::~Game()
 {
     _running = false;
-    _thread.join();
+    if (_thread.joinable())
+        _thread.join();
     FLAKKARI_LOG_INFO("game \"" + _name + "\" is now stopped");
 }
 
-void Game::loadSystems(Engine::ECS::Registry &registry, const std::string &sceneName, const std::string &sysName)
+void Game::loadSystems(Engine::ECS::Registry &registry, SceneId sceneId, const std::string &sysName)
 {
     if (sysName == "position")
-        registry.add_system([this](Engine::ECS::Registry &r) { Engine::ECS::Systems::_2D::position(r, _deltaTime); });
+        registry.add_system(sysName,
+                            [this](Engine::ECS::Registry &r) { Engine::ECS::Systems::_2D::position(r, _deltaTime); });
 
     else if (sysName == "apply_movable")
         registry.add_system(
-            [this](Engine::ECS::Registry &r) { Engine::ECS::Systems::_3D::apply_movable(r, _deltaTime); });
+            sysName, [this](Engine::ECS::Registry &r) { Engine::ECS::Systems::_3D::apply_movable(r, _deltaTime); });
 
     else if (sysName == "spawn_enemy")
-        registry.add_system([this, sceneName](Engine::ECS::Registry &r) {
+        registry.add_system(sysName, [this, sceneId](Engine::ECS::Registry &r) {
             std::string templateName;
             Engine::ECS::Entity entity;
-            if (Engine::ECS::Systems::_3D::spawn_enemy(r, templateName, entity))
+            if (Engine::ECS::Systems::_3D::spawn_enemy(r, templateName, entity, _simulationTime,
+                                                       _scenes[sceneId].rng))
             {
                 Protocol::Packet<Protocol::CommandId> packet;
+                packet.header._priority = Protocol::Priority::HIGH;
+                packet.header._reliable = true;
                 packet.header._commandId = Protocol::CommandId::REQ_ENTITY_SPAWN;
                 packet << entity;
                 packet.injectString(templateName);
 
                 Protocol::PacketFactory::addComponentsToPacketByEntity(packet, r, entity);
 
-                this->sendOnSameScene(sceneName, packet);
+                this->sendOnSameScene(sceneId, packet);
             }
         });
 
     else if (sysName == "spawn_random_within_skybox")
-        registry.add_system([this, sceneName](Engine::ECS::Registry &r) {
+        registry.add_system(sysName, [this, sceneId](Engine::ECS::Registry &r) {
             std::vector<Engine::ECS::Entity> entities(10);
-            Engine::ECS::Systems::_3D::spawn_random_within_skybox(r, entities);
+            Engine::ECS::Systems::_3D::spawn_random_within_skybox(r, entities, _scenes[sceneId].rng);
 
             for (auto &entity : entities)
             {
                 Protocol::Packet<Protocol::CommandId> packet;
+                packet.header._priority = Protocol::Priority::MEDIUM;
                 packet.header._commandId = Protocol::CommandId::REQ_ENTITY_UPDATE;
                 packet << entity;
 
                 Protocol::PacketFactory::addComponentsToPacketByEntity(packet, r, entity);
 
-                this->sendOnSameScene(sceneName, packet);
+                this->sendOnSameScene(sceneId, packet);
             }
         });
 
     else if (sysName == "handle_collisions")
-        registry.add_system([this, sceneName](Engine::ECS::Registry &r) {
+        registry.add_system(sysName, [this, sceneId](Engine::ECS::Registry &r) {
             std::unordered_map<Engine::ECS::Entity, bool> entities;
             Engine::ECS::Systems::_3D::handle_collisions(r, entities);
 
@@ -91,19 +99,22 @@ void Game::loadSystems(Engine::ECS::Registry &registry, const std::string &scene
                 if (!entity.second)
                 {
                     Protocol::Packet<Protocol::CommandId> packet;
+                    packet.header._priority = Protocol::Priority::HIGH;
+                    packet.header._reliable = true;
                     packet.header._commandId = Protocol::CommandId::REQ_ENTITY_DESTROY;
                     packet << entity.first;
-                    this->sendOnSameScene(sceneName, packet);
+                    this->sendOnSameScene(sceneId, packet);
                     continue;
                 }
 
                 Protocol::Packet<Protocol::CommandId> packet;
+                packet.header._priority = Protocol::Priority::MEDIUM;
                 packet.header._commandId = Protocol::CommandId::REQ_ENTITY_UPDATE;
                 packet << entity.first;
 
                 Protocol::PacketFactory::addComponentsToPacketByEntity(packet, r, entity.first);
 
-                this->sendOnSameScene(sceneName, packet);
+                this->sendOnSameScene(sceneId, packet);
             }
         });
 }
@@ -122,68 +133,81 @@ void Game::loadEntityFromTemplate(Engine::ECS::Registry &registry, const nl_enti
     }
 }
 
-void Game::loadScene(const std::string &sceneName)
+SceneId Game::loadScene(const std::string &sceneName)
 {
-    for (auto &scene : (*_config)["scenes"].items())
+    auto it = _sceneIds.find(sceneName);
+    if (it != _sceneIds.end())
+        return it->second;
+
+    auto sceneId = static_cast<SceneId>(_scenes.size());
+    Scene newScene;
+    newScene.name = sceneName;
+#ifdef FLAKKARI_PROFILE_SYSTEMS
+    newScene.registry.setProfiler(&_profiler);
+#endif
+
+    for (auto &scene : (*_settings->config)["scenes"].items())
     {
         for (auto sceneInfo : scene.value().items())
         {
             if (sceneInfo.key() != sceneName)
                 continue;
-            Engine::ECS::Registry registry;
 
             for (auto &system : sceneInfo.value()["systems"].items())
-                loadSystems(registry, sceneName, system.value());
+                loadSystems(newScene.registry, sceneId, system.value());
 
             for (auto &entity : sceneInfo.value()["entities"].items())
-                loadEntityFromTemplate(registry, entity, sceneInfo.value()["templates"]);
-
-            _scenes[sceneName] = registry;
-            return;
+                loadEntityFromTemplate(newScene.registry, entity, sceneInfo.value()["templates"]);
+            break;
         }
     }
+
+    // timers count in game time so that a replay spawns at the same ticks
+    for (auto &timer : newScene.registry.getComponents<Engine::ECS::Components::Common::Timer>())
+        if (timer.has_value())
+            timer->lastTime = _simulationTime;
+
+    newScene.history = TransformHistory(_settings->historyTicks, _settings->broadphaseCellSize);
+    newScene.seed = std::random_device{}();
+    newScene.rng.seed(newScene.seed);
+
+    _sceneIds.emplace(sceneName, sceneId);
+    _scenes.push_back(std::move(newScene));
+    return sceneId;
 }
 
-void Game::sendOnSameScene(const std::string &sceneName, Protocol::Packet<Protocol::CommandId> &packet)
+void Game::sendOnSameScene(SceneId sceneId, const Protocol::Packet<Protocol::CommandId> &packet)
 {
-    for (auto &player : _players)
+    Protocol::BroadcastPacket<Protocol::CommandId> broadcast(packet);
+
+    for (auto &player : _scenes[sceneId].players)
     {
-        if (!player)
-            continue;
         if (!player->isConnected())
             continue;
-        if (player->getSceneName() != sceneName)
-            continue;
-
-        packet.header._apiVersion = player->getApiVersion();
 
-        player->addPacketToSendQueue(packet);
+        player->addPacketToSendQueue(broadcast.get(player->getApiVersion()));
     }
 }
 
-void Game::sendOnSameSceneExcept(const std::string &sceneName, Protocol::Packet<Protocol::CommandId> &packet,
+void Game::sendOnSameSceneExcept(SceneId sceneId, const Protocol::Packet<Protocol::CommandId> &packet,
                                  std::shared_ptr<Client> except)
 {
-    for (auto &player : _players)
+    Protocol::BroadcastPacket<Protocol::CommandId> broadcast(packet);
+
+    for (auto &player : _scenes[sceneId].players)
     {
-        if (!player)
-            continue;
         if (!player->isConnected())
             continue;
-        if (player->getSceneName() != sceneName)
-            continue;
         if (player == except)
             continue;
 
-        packet.header._apiVersion = player->getApiVersion();
-
-        player->addPacketToSendQueue(packet);
+        player->addPacketToSendQueue(broadcast.get(player->getApiVersion()));
     }
 }
 
-void Game::sendAllEntitiesToPlayer(std::shared_ptr<Client> player, const std::string &sceneGame)
+void Game::sendAllEntitiesToPlayer(std::shared_ptr<Client> player, SceneId sceneId)
 {
-    auto &registry = _scenes[sceneGame];
+    auto &registry = _scenes[sceneId].registry;
     auto &transforms = registry.getComponents<Engine::ECS::Components::_3D::Transform>();
     auto &tags = registry.getComponents<Engine::ECS::Components::Common::Tag>();
 
@@ -194,6 +218,8 @@ void Game::sendAllEntitiesToPlayer(std::shared_ptr<Client> player, const std::st
         if (tags[i]->tag == "Skybox")
             continue;
         Protocol::Packet<Protocol::CommandId> packet;
+        packet.header._priority = Protocol::Priority::HIGH;
+        packet.header._reliable = true;
         packet.header._apiVersion = player->getApiVersion();
         packet.header._commandId = Protocol::CommandId::REQ_ENTITY_SPAWN;
         packet << i;
@@ -207,52 +233,112 @@ void Game::sendAllEntitiesToPlayer(std::shared_ptr<Client> player, const std::st
 
 void Game::checkDisconnect()
 {
-    for (auto &player : _players)
+    // removePlayer swaps the last player into the removed slot, so iterate backward
+    for (auto i = _players.size(); i-- > 0;)
     {
+        auto player = _players[i];
+
         if (!player || player->isConnected())
             continue;
         Protocol::Packet<Protocol::CommandId> packet;
+        packet.header._priority = Protocol::Priority::HIGH;
+        packet.header._reliable = true;
         packet.header._commandId = Protocol::CommandId::REQ_DISCONNECT;
         packet << player->getEntity();
-        sendOnSameScene(player->getSceneName(), packet);
-        _scenes[player->getSceneName()].kill_entity(player->getEntity());
+        sendOnSameScene(player->getSceneId(), packet);
         removePlayer(player);
     }
 }
 
-void Game::sendUpdatePosition(std::shared_ptr<Client> player, Engine::ECS::Components::_3D::Transform pos,
-                              Engine::ECS::Components::_3D::Movable vel)
+void Game::replicateMovedEntities()
 {
+    for (SceneId sceneId = 0; sceneId < _scenes.size(); ++sceneId)
+    {
+        auto &entities = _scenes[sceneId].movedEntities;
+
+        // the players due a snapshot and holding no older moves share the packets of the tick, the
+        // others keep the moves until their snapshot is due and are then sent the latest states
+        _snapshotPlayers.clear();
+        for (auto &player : _scenes[sceneId].players)
+        {
+            if (!player->isConnected())
+                continue;
+            auto &congestion = player->getCongestion();
+            auto &pending = player->getPendingMoves();
+
+            if (pending.empty() && congestion.isSnapshotDue(_time))
+            {
+                if (!entities.empty())
+                {
+                    _snapshotPlayers.push_back(player.get());
+                    congestion.snapshotSent(_time);
+                }
+                continue;
+            }
+            for (auto &[entity, lastInput] : entities)
+                pending[entity] = lastInput;
+            if (pending.empty() || !congestion.isSnapshotDue(_time))
+                continue;
+            packMovedEntities(sceneId, pending, [&](const Protocol::Packet<Protocol::CommandId> &packet) {
+                player->addPacketToSendQueue(packet);
+            });
+            pending.clear();
+            congestion.snapshotSent(_time);
+        }
+
+        if (!_snapshotPlayers.empty())
+            packMovedEntities(sceneId, entities, [&](const Protocol::Packet<Protocol::CommandId> &packet) {
+                Protocol::BroadcastPacket<Protocol::CommandId> broadcast(packet);
+
+                for (auto *player : _snapshotPlayers)
+                    player->addPacketToSendQueue(broadcast.get(player->getApiVersion()));
+            });
+        entities.clear();
+    }
+}
+
+void Game::packMovedEntities(SceneId sceneId, const std::unordered_map<Engine::ECS::Entity, uint32_t> &entities,
+                             const std::function<void(const Protocol::Packet<Protocol::CommandId> &)> &send)
+{
+    constexpr std::size_t maxEntitiesPerPacket =
+        (std::numeric_limits<uint16_t>::max() - sizeof(uint16_t)) / Protocol::PacketFactory::UPDATE_MOVEMENT_3D_SIZE;
+
+    auto &registry = _scenes[sceneId].registry;
+    auto &transforms = registry.getComponents<Engine::ECS::Components::_3D::Transform>();
+    auto &movables = registry.getComponents<Engine::ECS::Components::_3D::Movable>();
+
     Protocol::Packet<Protocol::CommandId> packet;
-    packet.header._commandId = Protocol::CommandId::REQ_ENTITY_MOVED;
-    packet << player->getEntity();
-    packet << pos._position.vec.x;
-    packet << pos._position.vec.y;
-    packet << pos._position.vec.z;
-    packet << (float) pos._rotation.vec.x;
-    packet << (float) pos._rotation.vec.y;
-    packet << (float) pos._rotation.vec.z;
-    packet << (float) pos._rotation.vec.w;
-    packet << pos._scale.vec.x;
-    packet << pos._scale.vec.y;
-    packet << pos._scale.vec.z;
-    packet << vel._velocity.vec.x;
-    packet << vel._velocity.vec.y;
-    packet << vel._velocity.vec.z;
-    packet << vel._acceleration.vec.x;
-    packet << vel._acceleration.vec.y;
-    packet << vel._acceleration.vec.z;
-
-    FLAKKARI_LOG_LOG("packet size: " + std::to_string(packet.size()) +
-                     " bytes\n"
-                     "packet sent: <Id: " +
-                     std::to_string(player->getEntity()) + ", Pos: (" + std::to_string(pos._position.vec.x) + ", " +
-                     std::to_string(pos._position.vec.y) + ", " + std::to_string(pos._position.vec.z) + ")" +
-                     ", Vel: (" + std::to_string(vel._velocity.vec.x) + ", " + std::to_string(vel._velocity.vec.y) +
-                     ", " + std::to_string(vel._velocity.vec.z) + ")" + ", Acc: (" +
-                     std::to_string(vel._acceleration.vec.x) + ", " + std::to_string(vel._acceleration.vec.y) + ", " +
-                     std::to_string(vel._acceleration.vec.z) + ")" + ">");
-    sendOnSameScene(player->getSceneName(), packet);
+    uint16_t count = 0;
+
+    auto flush = [&]() {
+        std::memcpy(packet.payload.data(), &count, sizeof(count));
+        send(packet);
+    };
+
+    for (auto &[entity, lastInput] : entities)
+    {
+        auto &pos = transforms[entity];
+        auto &vel = movables[entity];
+
+        if (!pos.has_value() || !vel.has_value())
+            continue;
+        if (count == 0)
+        {
+            packet = Protocol::Packet<Protocol::CommandId>();
+            packet.header._priority = Protocol::Priority::LOW;
+            packet.header._commandId = Protocol::CommandId::REQ_ENTITIES_MOVED;
+            packet << count;
+        }
+        Protocol::PacketFactory::add3dUpdateMovementToPacket(packet, entity, lastInput, pos.value(), vel.value());
+
+        if (++count == maxEntitiesPerPacket)
+        {
+            flush();
+            count = 0;
+        }
+    }
+    if (count > 0)
+        flush();
 }
 
 static bool handleMoveEvent(Protocol::Event &event, Engine::ECS::Components::_3D::Control &ctrl,
@@ -314,10 +400,71 @@ static bool handleMoveEvent(Protocol::Event &event, Engine::ECS::Components::_3D
     }
 }
 
-void Game::handleEvents(std::shared_ptr<Client> player, Protocol::Packet<Protocol::CommandId> packet)
+std::chrono::nanoseconds Game::getViewDelay(const Client &player) const
+{
+    auto delay = player.getRoundTripTime() / 2 + _settings->interpolationDelay;
+
+    return std::min<std::chrono::nanoseconds>(delay, _settings->maxRewind);
+}
+
+void Game::shoot(std::shared_ptr<Client> player, const Engine::ECS::Components::_3D::Transform &pos,
+                 std::chrono::nanoseconds viewDelay)
+{
+    auto sceneId = player->getSceneId();
+    auto &scene = _scenes[sceneId];
+    auto &registry = scene.registry;
+    auto shooter = player->getEntity();
+    auto &healths = registry.getComponents<Engine::ECS::Components::Common::Health>();
+    auto &weapons = registry.getComponents<Engine::ECS::Components::Common::Weapon>();
+    auto direction = pos._rotation.multiplyWithFloatVector(Engine::Math::Vector3f(0, 0, 1)).normalized();
+
+    // check the hit against the colliders as the player saw them
+    auto hit = scene.history.raycast(_simulationTime - viewDelay, pos._position, direction, SHOOT_RANGE,
+                                     [&](Engine::ECS::Entity entity) {
+                                         return entity != shooter && entity < healths.size() &&
+                                                healths[entity].has_value();
+                                     });
+    if (!hit)
+        return;
+
+    auto &health = healths[hit->entity];
+    std::size_t damage = 1;
+    if (shooter < weapons.size() && weapons[shooter].has_value())
+        damage = weapons[shooter]->minDamage;
+    health->currentHealth = damage >= health->currentHealth ? 0 : health->currentHealth - damage;
+
+    Protocol::Packet<Protocol::CommandId> packet;
+    packet << hit->entity;
+
+    if (health->currentHealth == 0)
+    {
+        registry.kill_entity(hit->entity);
+        packet.header._priority = Protocol::Priority::HIGH;
+        packet.header._reliable = true;
+        packet.header._commandId = Protocol::CommandId::REQ_ENTITY_DESTROY;
+    }
+    else
+    {
+        packet.header._priority = Protocol::Priority::MEDIUM;
+        packet.header._commandId = Protocol::CommandId::REQ_ENTITY_UPDATE;
+        Protocol::PacketFactory::addComponentsToPacketByEntity(packet, registry, hit->entity);
+    }
+    sendOnSameScene(sceneId, packet);
+}
+
+void Game::handleEvents(std::shared_ptr<Client> player, const Protocol::PacketView<Protocol::CommandId> &packet)
+{
+    handleEvents(player, packet, getViewDelay(*player));
+}
+
+void Game::handleEvents(std::shared_ptr<Client> player, const Protocol::PacketView<Protocol::CommandId> &packet,
+                        std::chrono::nanoseconds viewDelay)
 {
+    if (_recorder)
+        _recorder->input(player.get(), packet.payload, viewDelay);
+
     auto entity = player->getEntity();
-    auto &registry = _scenes[player->getSceneName()];
+    auto &registry = _scenes[player->getSceneId()].registry;
     auto &ctrl = registry.getComponents<Engine::ECS::Components::_3D::Control>()[entity];
     auto &vel = registry.getComponents<Engine::ECS::Components::_3D::Movable>()[entity];
     auto &pos = registry.getComponents<Engine::ECS::Components::_3D::Transform>()[entity];
@@ -325,14 +472,28 @@ void Game::handleEvents(std::shared_ptr<Client> player, Protocol::Packet<Protoco
     if (!ctrl.has_value() || !vel.has_value() || !pos.has_value())
         return;
 
+    auto size = packet.payload.size();
+    if (size < sizeof(uint16_t) * 2)
+        return FLAKKARI_LOG_WARNING("truncated REQ_USER_UPDATES packet"), void();
+
     // there is the number of the events in the two first (size of ushort) byte of the payload
     uint16_t count_events = *(uint16_t *) packet.payload.data();
+    std::size_t axisOffset = sizeof(uint16_t) + count_events * sizeof(Protocol::Event);
+    if (size < axisOffset + sizeof(uint16_t))
+        return FLAKKARI_LOG_WARNING("truncated REQ_USER_UPDATES packet"), void();
     // there is the number of the axis events in the two next (size of ushort) byte of the payload after the events
-    uint16_t count_axis =
-        *(uint16_t *) (packet.payload.data() + sizeof(uint16_t) + count_events * sizeof(Protocol::Event));
+    uint16_t count_axis = *(uint16_t *) (packet.payload.data() + axisOffset);
+    std::size_t sequenceOffset = axisOffset + sizeof(uint16_t) + count_axis * sizeof(Protocol::EventAxis);
+    if (size < sequenceOffset)
+        return FLAKKARI_LOG_WARNING("truncated REQ_USER_UPDATES packet"), void();
+    // the input sequence number of the client follows the axis events (optional)
+    uint32_t sequence = 0;
+    if (size >= sequenceOffset + sizeof(uint32_t))
+        sequence = *(uint32_t *) (packet.payload.data() + sequenceOffset);
 
     // jump to the first event
     auto data = packet.payload.data() + sizeof(uint16_t);
+    bool moved = false;
 
     for (uint16_t i = 0; i < count_events; ++i)
     {
@@ -340,17 +501,14 @@ void Game::handleEvents(std::shared_ptr<Client> player, Protocol::Packet<Protoco
 
         if (handleMoveEvent(event, ctrl.value(), vel.value(), pos.value()))
         {
-            FLAKKARI_LOG_DEBUG("event: " + std::to_string(int(event.id)) + " " + std::to_string(int(event.state)));
-            sendUpdatePosition(player, pos.value(), vel.value());
+            moved = true;
             continue;
         }
         else if (event.id == Protocol::EventId::SHOOT && ctrl->_shoot)
         {
             if (event.state == Protocol::EventState::PRESSED)
-            {
-            }
-            else if (event.state == Protocol::EventState::RELEASED)
-                continue;
+                shoot(player, pos.value(), viewDelay);
+            continue;
         }
     }
 
@@ -364,92 +522,299 @@ void Game::handleEvents(std::shared_ptr<Client> player, Protocol::Packet<Protoco
         if (event.id == Protocol::EventId::LOOK_RIGHT && ctrl->_look_right)
         {
             pos->_rotation.rotate(Engine::Math::Vector3d(0, 0, 1), -event.value);
-            sendUpdatePosition(player, pos.value(), vel.value());
+            moved = true;
             continue;
         }
         else if (event.id == Protocol::EventId::LOOK_UP && ctrl->_look_up)
         {
             pos->_rotation.rotate(Engine::Math::Vector3d(1, 0, 0), -event.value);
-            sendUpdatePosition(player, pos.value(), vel.value());
+            moved = true;
             continue;
         }
     }
+
+    // a numbered input is acknowledged with the state of the entity, even if it did not move it
+    if (!moved && sequence == 0)
+        return;
+    auto &lastInput = _scenes[player->getSceneId()].movedEntities[entity];
+    if (sequence != 0)
+        lastInput = sequence;
+}
+
+void Game::handleHeartbeat(const std::shared_ptr<Client> &player,
+                           const Protocol::PacketView<Protocol::CommandId> &packet)
+{
+    Protocol::Packet<Protocol::CommandId> repPacket;
+    repPacket.header._priority = Protocol::Priority::MEDIUM;
+    repPacket.header._apiVersion = packet.header._apiVersion;
+    repPacket.header._commandId = Protocol::CommandId::REP_HEARTBEAT;
+
+    player->addPacketToSendQueue(repPacket);
 }
 
 void Game::updateIncomingPackets(unsigned char maxMessagePerFrame)
 {
+    auto now = std::chrono::steady_clock::now();
+
     for (auto &player : _players)
     {
         if (!player->isConnected())
             continue;
-        auto &packets = player->getReceiveQueue();
-        auto messageCount = maxMessagePerFrame;
-
-        while (!packets.empty() && messageCount > 0)
-        {
-            auto packet = packets.pop_front();
+        auto &channel = player->getChannel();
+        auto &reassembler = player->getReassembler();
+        auto dispatch = [&](Protocol::PacketView<Protocol::CommandId> &packet) {
             FLAKKARI_LOG_INFO("packet received: " + packet.to_string());
-            messageCount--;
 
             if (packet.header._commandId == Protocol::CommandId::REQ_USER_UPDATES)
                 handleEvents(player, packet);
 
             else if (packet.header._commandId == Protocol::CommandId::REQ_HEARTBEAT)
-            {
-                Protocol::Packet<Protocol::CommandId> repPacket;
-                repPacket.header._apiVersion = packet.header._apiVersion;
-                repPacket.header._commandId = Protocol::CommandId::REP_HEARTBEAT;
-
-                player->addPacketToSendQueue(repPacket);
-            }
-        }
+                handleHeartbeat(player, packet);
+        };
+        auto handle = [&](Protocol::PacketView<Protocol::CommandId> &packet) {
+            if (packet.header._commandId != Protocol::CommandId::REQ_FRAGMENT)
+                return dispatch(packet);
+
+            // the packet of the last fragment missing is handled as if it came whole
+            auto whole = reassembler.add(packet.payload.data(), packet.payload.size(), packet.header._reliable, now);
+            Protocol::PacketView<Protocol::CommandId> reassembled;
+            if (whole && reassembled.deserialize(Network::BufferView::copyOf(*whole)))
+                dispatch(reassembled);
+        };
+        reassembler.expire(now);
+
+        // one acquire of the queue for the packets of the tick, one release of their slots; the
+        // channel takes the acks of every packet, drops the duplicates and orders the reliable ones
+        player->getReceiveQueue().drain(
+            [&](Protocol::PacketView<Protocol::CommandId> &packet) { channel.receive(std::move(packet), now, handle); },
+            maxMessagePerFrame);
     }
 }
 
-void Game::updateOutcomingPackets(unsigned char maxMessagePerFrame)
+void Game::updateOutcomingPackets()
 {
+    constexpr auto low = static_cast<std::size_t>(Protocol::Priority::LOW);
+    auto now = std::chrono::steady_clock::now();
+
+    // the datagrams of the previous ticks leave before the new ones of their player
+    sendPacedDatagrams(now);
+
     for (auto &player : _players)
     {
         if (!player->isConnected())
             continue;
         auto &packets = player->getSendQueue();
-        auto messageCount = maxMessagePerFrame;
-
-        Network::Buffer buffer;
-
-        while (!packets.empty() && messageCount > 0)
+        auto &channel = player->getChannel();
+        auto &writer = player->getWriter();
+        auto &congestion = player->getCongestion();
+        auto mtu = writer.getMtu();
+        std::size_t written = 0; // bytes written in the frames of the tick
+        bool exhausted = false;
+
+        // a packet larger than the MTU is split, and its fragments packed as packets
+        auto fragment = [&](const Network::Buffer &packet) {
+            auto write = [&](const Network::Buffer &slice) { channel.write(writer.reserve(slice.size()), slice, now); };
+            return player->getFragmenter().split(packet, Protocol::CommandId::REP_FRAGMENT, mtu, write);
+        };
+
+        // the frames of the last tick were sent: their memory is reused, a frame per datagram of at most one MTU
+        writer.clear();
+
+        // the acks and losses seen since the last tick adjust the rate, the tick sends what the rate earned
+        auto stats = channel.getStats();
+        congestion.update(stats.deliveredBytes, stats.lostBytes, stats.roundTripTime, now);
+        auto budget = congestion.refill(now);
+
+        // low priority packets left from the previous tick are superseded by newer states, and the reliable
+        // packets that found their level full take the room the last tick made
+        packets.dropStale(low);
+        player->flushReliableBacklog();
+
+        // the reliable packets not acked in time go first, then the queue from the highest level
+        while (written < budget && channel.writeRetransmissions(writer.open(), now, mtu) > 0)
+            written = writer.size();
+        for (auto level = packets.levels(); level-- > 0 && !exhausted;)
         {
-            auto packet = packets.pop_front();
-            messageCount--;
+            while (!packets.empty(level))
+            {
+                auto &packet = packets.front(level);
 
-            buffer += packet.serialize();
-        }
-        if (buffer.size() > 0)
-        {
-            ClientManager::GetInstance().sendPacketToClient(player->getAddress(), buffer);
-            ClientManager::UnlockInstance();
+                if (written + packet.size() > budget && (written > 0 || budget == 0))
+                {
+                    exhausted = true;
+                    break;
+                }
+                if (packet.size() <= mtu)
+                    channel.write(writer.reserve(packet.size()), packet.data, now);
+                else if (!fragment(*packet.data))
+                    FLAKKARI_LOG_WARNING("packet of " + std::to_string(packet.size()) + " bytes too large to send");
+                written += packet.size();
+                packets.pop_front(level);
+            }
         }
+        if (exhausted)
+            packets.markStale(low);
+
+        // a reliable packet of the client is acked even if the client is sent nothing this tick
+        if (writer.empty() && channel.needsAck())
+            channel.writeAck(writer.current(), Protocol::CommandId::REP_ACK, now);
+        congestion.consume(writer.size(), exhausted);
+
+        // the rate counts the bytes of the packets: the bytes compression saves on the wire are a margin
+        if (player->getDictionaryId() != Network::Compressor::NO_DICTIONARY)
+            writer.forEach([&](Network::Buffer &frame) { _compressor.compress(frame); });
+        // the CRC32C trailer covers the datagram as it goes on the wire, compressed or not
+        if (player->getChecksum().isEnabled())
+            writer.forEach([&](Network::Buffer &frame) { player->getChecksum().seal(frame); });
+
+        // the frames leave at the rate: the first ones with the batch of the tick, the others between the steps of
+        // the next tick
+        writer.forEach([&](const Network::Buffer &frame) {
+            auto release = congestion.pace(frame.size(), now);
+            if (release <= now + PACING_QUANTUM)
+            {
+                _outgoing.emplace_back(player->getAddress(), &frame);
+                return;
+            }
+            // the frame is copied in the buffer of a datagram already sent, whose memory it reuses
+            Network::Buffer datagram;
+            if (!_pacedSpares.empty())
+            {
+                datagram = std::move(_pacedSpares.back());
+                _pacedSpares.pop_back();
+            }
+            datagram.assign(frame.begin(), frame.end());
+            _paced.push_back({release, player->getAddress(), std::move(datagram)});
+        });
     }
+
+    // one lock and one sendmmsg for the datagrams of every player
+    if (_outgoing.empty())
+        return;
+    ClientManager::GetInstance().sendPacketsToClients(_outgoing);
+    ClientManager::UnlockInstance();
+    _outgoing.clear();
+}
+
+void Game::sendPacedDatagrams(std::chrono::steady_clock::time_point now)
+{
+    auto due = [&](const PacedDatagram &paced) { return paced.release <= now + PACING_QUANTUM; };
+
+    for (const auto &paced : _paced)
+        if (due(paced))
+            _outgoing.emplace_back(paced.address, &paced.datagram);
+    if (_outgoing.empty())
+        return;
+    ClientManager::GetInstance().sendPacketsToClients(_outgoing);
+    ClientManager::UnlockInstance();
+    _outgoing.clear();
+    for (auto &paced : _paced)
+        if (due(paced))
+            _pacedSpares.push_back(std::move(paced.datagram));
+    std::erase_if(_paced, due);
+}
+
+void Game::beginTick(std::chrono::nanoseconds elapsed)
+{
+    _simulationTime += elapsed;
+    _deltaTime = std::chrono::duration_cast<std::chrono::duration<float>>(elapsed).count();
+
+    if (_recorder)
+        _recorder->tick(static_cast<uint64_t>(elapsed.count()));
+}
+
+void Game::runSystems()
+{
+    for (auto &scene : _scenes)
+        scene.registry.run_systems();
+
+    replicateMovedEntities();
+
+    for (auto &scene : _scenes)
+        scene.history.record(scene.registry, _simulationTime);
+
+    if (!_recorder)
+        return;
+    _recorder->systems();
+    if (++_recordedTicks % REPLAY_HASH_INTERVAL == 0)
+        _recorder->hash(computeStateHash());
 }
 
 void Game::update()
 {
+    std::scoped_lock lock(_mutex);
+
     auto now = std::chrono::steady_clock::now();
-    _deltaTime = std::chrono::duration_cast<std::chrono::duration<float>>(now - _time).count();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - _time);
     _time = now;
 
+    beginTick(elapsed);
+
     checkDisconnect();
 
     updateIncomingPackets();
 
-    for (auto &scene : _scenes)
-    {
-        auto &registry = scene.second;
+    sendPacedDatagrams(std::chrono::steady_clock::now());
 
-        registry.run_systems();
-    }
+    runSystems();
 
     updateOutcomingPackets();
+
+#ifdef FLAKKARI_PROFILE_SYSTEMS
+    auto end = std::chrono::steady_clock::now();
+    _profiler.record(_tickSlot, end - now);
+
+    if (_profileDumpInterval.count() > 0 && end - _profileDumpTime >= _profileDumpInterval)
+        FLAKKARI_LOG_INFO("profile of game \"" + _name + "\":\n" + getProfileReport(true));
+#endif
+}
+
+std::string Game::getProfileReport([[maybe_unused]] bool reset)
+{
+#ifdef FLAKKARI_PROFILE_SYSTEMS
+    std::scoped_lock lock(_mutex);
+
+    auto report = _profiler.report();
+    if (reset)
+    {
+        _profiler.reset();
+        _profileDumpTime = std::chrono::steady_clock::now();
+    }
+    return report;
+#else
+    return "";
+#endif
+}
+
+std::string Game::getQueueReport()
+{
+    std::scoped_lock lock(_mutex);
+    std::string report;
+
+    for (auto &player : _players)
+    {
+        auto received = player->getReceiveQueue().getStats();
+        Network::RingStats sent;
+        for (std::size_t level = 0; level < Client::SendQueue::levels(); ++level)
+        {
+            auto stats = player->getSendQueue().getStats(level);
+            sent.size += stats.size;
+            sent.highWater = std::max(sent.highWater, stats.highWater);
+            sent.capacity += stats.capacity;
+            sent.rejected += stats.rejected;
+        }
+        auto congestion = player->getCongestion().getStats();
+        auto snapshotInterval = std::chrono::duration_cast<std::chrono::milliseconds>(congestion.snapshotInterval);
+        report += " - " + player->getName().value_or("") + ": receive " + std::to_string(received.size) + "/" +
+                  std::to_string(received.capacity) + " (high " + std::to_string(received.highWater) + ", rejected " +
+                  std::to_string(received.rejected) + "), send " + std::to_string(sent.size) + "/" +
+                  std::to_string(sent.capacity) + " (high " + std::to_string(sent.highWater) + ", rejected " +
+                  std::to_string(sent.rejected) + "), rate " + std::to_string(congestion.rate / 1024) +
+                  " KiB/s (bandwidth " + std::to_string(congestion.bandwidth / 1024) + " KiB/s, loss " +
+                  std::to_string(static_cast<int>(congestion.loss * 100)) + "%, snapshot every " +
+                  std::to_string(snapshotInterval.count()) + " ms)\n";
+    }
+    return report;
 }
 
 void Game::start()
@@ -468,68 +833,111 @@ void Game::run()
 
 bool Game::addPlayer(std::shared_ptr<Client> player)
 {
-    if (std::find(_players.begin(), _players.end(), player) != _players.end())
+    std::scoped_lock lock(_mutex);
+
+    if (_playerSlots.contains(player.get()))
         return false;
-    if (_players.size() >= (*_config)["maxPlayers"] || !player->isConnected())
+    if (_players.size() >= _settings->maxPlayers || !player->isConnected())
         return false;
 
-    auto sceneGame = (*_config)["startGame"].get<std::string>();
-    auto &registry = _scenes[sceneGame];
+    auto &scene = _scenes[_startScene];
+    auto &registry = scene.registry;
     auto address = player->getAddress();
 
-    player->setSceneName(sceneGame);
+    player->setSceneId(_startScene);
+    // the CRC32C trailer of a client that asked for it is added after the frames are filled
+    player->setMtu(_settings->mtu - player->getChecksum().getOverhead());
+
+    Protocol::CongestionSettings congestion;
+    congestion.minRate = _settings->minSendRate;
+    congestion.maxRate = _settings->maxSendRate;
+    congestion.maxSnapshotInterval = _settings->maxSnapshotInterval;
+    player->getCongestion().setSettings(congestion);
+
+    // the datagrams of the player are compressed if it has the dictionary of the server
+    auto dictionaryId = _compressor.getDictionaryId();
+    bool compression = _settings->compression && player->getDictionaryId() == dictionaryId;
+    player->setDictionaryId(compression ? dictionaryId : Network::Compressor::NO_DICTIONARY);
+
+    if (_recorder)
+        _recorder->join(player.get());
 
     Engine::ECS::Entity newEntity = registry.spawn_entity();
-    auto p_Template = (*_config)["playerTemplate"];
-    auto player_info = ResourceManager::GetInstance().getTemplateById(_name, sceneGame, p_Template);
+    auto &p_Template = _settings->playerTemplate;
+    auto player_info = ResourceManager::GetInstance().getTemplateById(_name, scene.name, p_Template);
 
     Engine::ECS::Factory::RegistryEntityByTemplate(registry, newEntity, player_info.value());
     ResourceManager::UnlockInstance();
 
     player->setEntity(newEntity);
+    _playerSlots[player.get()] = {_players.size(), scene.players.size()};
     _players.push_back(player);
+    scene.players.push_back(player);
     FLAKKARI_LOG_INFO("client \"" + std::string(*address) + "\" added to game \"" + _name + "\"");
 
     Protocol::Packet<Protocol::CommandId> packet;
+    packet.header._priority = Protocol::Priority::CRITICAL;
+    packet.header._reliable = true;
     packet.header._apiVersion = player->getApiVersion();
     packet.header._commandId = Protocol::CommandId::REP_CONNECT;
     packet << newEntity;
     packet.injectString(p_Template);
-    packet.injectString(sceneGame);
+    packet.injectString(scene.name);
+    packet << player->getDictionaryId();
 
     player->addPacketToSendQueue(packet);
 
     Protocol::Packet<Protocol::CommandId> packet2;
+    packet2.header._priority = Protocol::Priority::HIGH;
+    packet2.header._reliable = true;
     packet2.header._apiVersion = packet.header._apiVersion;
     packet2.header._commandId = Protocol::CommandId::REQ_ENTITY_SPAWN;
     packet2 << newEntity;
     packet2.injectString(p_Template);
 
-    sendOnSameSceneExcept(sceneGame, packet2, player);
+    sendOnSameSceneExcept(_startScene, packet2, player);
 
-    sendAllEntitiesToPlayer(player, sceneGame);
+    sendAllEntitiesToPlayer(player, _startScene);
     return true;
 }
 
 bool Game::removePlayer(std::shared_ptr<Client> player)
 {
-    auto it = std::find(_players.begin(), _players.end(), player);
-    if (it == _players.end())
+    std::scoped_lock lock(_mutex);
+
+    auto it = _playerSlots.find(player.get());
+    if (it == _playerSlots.end())
         return false;
 
-    auto sceneGame = player->getSceneName();
-    auto &registry = _scenes[sceneGame];
+    if (_recorder)
+        _recorder->leave(player.get());
+
+    auto sceneId = player->getSceneId();
+    auto &scene = _scenes[sceneId];
+    auto slot = it->second;
 
     Engine::ECS::Entity entity = player->getEntity();
 
     Protocol::Packet<Protocol::CommandId> packet;
+    packet.header._priority = Protocol::Priority::HIGH;
+    packet.header._reliable = true;
     packet.header._commandId = Protocol::CommandId::REQ_ENTITY_DESTROY;
     packet << entity;
 
-    _players.erase(it);
-    registry.kill_entity(entity);
+    // swap with the last player of each list to keep the removal O(1)
+    _players[slot.index] = _players.back();
+    _players.pop_back();
+    if (slot.index < _players.size())
+        _playerSlots[_players[slot.index].get()].index = slot.index;
+    scene.players[slot.sceneIndex] = scene.players.back();
+    scene.players.pop_back();
+    if (slot.sceneIndex < scene.players.size())
+        _playerSlots[scene.players[slot.sceneIndex].get()].sceneIndex = slot.sceneIndex;
+    _playerSlots.erase(it);
+
+    scene.registry.kill_entity(entity);
 
-    sendOnSameScene(sceneGame, packet);
+    sendOnSameScene(sceneId, packet);
     FLAKKARI_LOG_INFO("client \"" + std::string(*player->getAddress()) + "\" removed from game \"" + _name + "\"");
     return true;
 }
@@ -538,6 +946,81 @@ bool Game::isRunning() const { return _running; }
 
 std::string Game::getName() const { return _name; }
 
-std::vector<std::shared_ptr<Client>> Game::getPlayers() const { return _players; }
+std::vector<std::shared_ptr<Client>> Game::getPlayers() const
+{
+    std::scoped_lock lock(_mutex);
+    return _players;
+}
+
+bool Game::startRecording(const std::string &path)
+{
+    std::scoped_lock lock(_mutex);
+
+    auto recorder = std::make_unique<ReplayRecorder>(path, _name);
+    if (!recorder->isOpen())
+        return false;
+
+    for (SceneId sceneId = 0; sceneId < _scenes.size(); ++sceneId)
+        recorder->seed(sceneId, _scenes[sceneId].seed);
+    _recorder = std::move(recorder);
+    _recordedTicks = 0;
+    FLAKKARI_LOG_INFO("game \"" + _name + "\" is recorded in \"" + path + "\"");
+    return true;
+}
+
+void Game::seedScene(SceneId sceneId, uint32_t seed)
+{
+    auto &scene = _scenes[sceneId];
+
+    scene.seed = seed;
+    scene.rng.seed(seed);
+}
+
+template <typename T> static void hashBytes(uint64_t &hash, const T &value)
+{
+    const auto *bytes = reinterpret_cast<const unsigned char *>(&value);
+
+    for (std::size_t i = 0; i < sizeof(value); ++i)
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull; // FNV-1a
+}
+
+static void hashVector3(uint64_t &hash, const Engine::Math::Vector3f &vector)
+{
+    hashBytes(hash, vector.vec.x);
+    hashBytes(hash, vector.vec.y);
+    hashBytes(hash, vector.vec.z);
+}
+
+uint64_t Game::computeStateHash()
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    for (auto &scene : _scenes)
+    {
+        auto &transforms = scene.registry.getComponents<Engine::ECS::Components::_3D::Transform>();
+        auto &movables = scene.registry.getComponents<Engine::ECS::Components::_3D::Movable>();
+        auto &healths = scene.registry.getComponents<Engine::ECS::Components::Common::Health>();
+
+        for (Engine::ECS::Entity i(0); i < transforms.size(); ++i)
+        {
+            auto &transform = transforms[i];
+
+            if (!transform.has_value())
+                continue;
+            hashBytes(hash, i);
+            hashVector3(hash, transform->_position);
+            hashVector3(hash, transform->_scale);
+            hashBytes(hash, transform->_rotation.vec);
+            if (i < movables.size() && movables[i].has_value())
+            {
+                hashVector3(hash, movables[i]->_velocity);
+                hashVector3(hash, movables[i]->_acceleration);
+            }
+            if (i < healths.size() && healths[i].has_value())
+                hashBytes(hash, healths[i]->currentHealth);
+        }
+    }
+    return hash;
+}
 
 } /* namespace Flakkari */
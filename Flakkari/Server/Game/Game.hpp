@@ -20,16 +20,26 @@
 #define GAME_HPP_
 
 #include <fstream>
+#include <functional>
+#include <mutex>
 #include <nlohmann/json.hpp>
+#include <random>
 #include <string>
 #include <thread>
+#include <unordered_map>
 
 #include "Engine/EntityComponentSystem/Factory.hpp"
 #include "Engine/EntityComponentSystem/Systems/Systems.hpp"
 
+#include "Network/Address.hpp"
+#include "Network/Buffer.hpp"
+#include "Protocol/Compression.hpp"
 #include "Protocol/Engine/PacketFactory.hpp"
 
+#include "GameSettings.hpp"
+#include "Replay.hpp"
 #include "ResourceManager.hpp"
+#include "TransformHistory.hpp"
 
 namespace Flakkari {
 
@@ -39,19 +49,49 @@ using nl_entity = nlohmann::detail::iteration_proxy_value<nlohmann::detail::iter
 using nl_template = nlohmann::json;
 using nl_component = nlohmann::json;
 
+using SceneId = uint16_t; // Index of a scene in its game instance
+
+// Datagrams to send, each to its player: the frames of the players' writers, not copied
+using OutgoingDatagrams = std::vector<std::pair<std::shared_ptr<Network::Address>, const Network::Buffer *>>;
+
+// Compression of the datagrams sent to the players that have the dictionary of the server
+using DatagramCompressor = Protocol::DatagramCompressor<Protocol::CommandId>;
+
 class Game {
 public:
     friend class Client;
 
+    /**
+     * @brief A scene of the game instance with the players that are in it.
+     */
+    struct Scene {
+        std::string name;                                                // Name of the scene
+        Engine::ECS::Registry registry;                                  // Content of the scene
+        std::vector<std::shared_ptr<Client>> players;                    // Players in the scene
+        std::unordered_map<Engine::ECS::Entity, uint32_t> movedEntities; // Entities moved by inputs, last input id
+        uint32_t seed = 0;                                               // Seed of the random generator
+        std::mt19937 rng;                                                // Random generator of the systems
+        TransformHistory history;                                        // Colliders of the last ticks
+    };
+
+    static constexpr uint64_t REPLAY_HASH_INTERVAL = 256; // Ticks between two state hashes in a replay log
+    static constexpr float SHOOT_RANGE = 1000.0f;         // Length of a shot
+
+    // Datagrams due within this time leave with the current batch: a sendmmsg per datagram costs more than the gap
+    static constexpr std::chrono::microseconds PACING_QUANTUM{1000};
+
+    // Default interval of the profile dumps (FLAKKARI_PROFILE_INTERVAL overrides it, in seconds)
+    static constexpr std::chrono::seconds PROFILE_DUMP_INTERVAL{60};
+
 public: // Constructors/Destructors
     /**
      * @brief Construct a new Game object and load the config file
      *        of the game.
      *
      * @param name  Name of the game (name of the file in Games/ folder)
-     * @param config  Config of the game (config of the file in Games/ folder)
+     * @param settings  Settings of the game, shared by all its instances
      */
-    Game(const std::string &name, std::shared_ptr<nlohmann::json> config);
+    Game(const std::string &name, std::shared_ptr<const GameSettings> settings);
     ~Game();
 
 public: // Loaders
@@ -59,10 +99,10 @@ public: // Loaders
      * @brief Add all the systems of the game to the registry.
      *
      * @param registry  Registry to add the systems to.
-     * @param sceneName  Name of the scene to load.
+     * @param sceneId  Id of the scene to load.
      * @param sysName  Name of the system to load.
      */
-    void loadSystems(Engine::ECS::Registry &registry, const std::string &sceneName, const std::string &sysName);
+    void loadSystems(Engine::ECS::Registry &registry, SceneId sceneId, const std::string &sysName);
 
     /**
      * @brief Add all the entities of the game to the registry.
@@ -74,19 +114,40 @@ public: // Loaders
     void loadEntityFromTemplate(Engine::ECS::Registry &registry, const nl_entity &entity, const nl_template &templates);
 
     /**
-     * @brief Load a scene from the game.
+     * @brief Load a scene from the game. A scene is loaded only once.
      *
      * @param name  Name of the scene to load.
+     * @return SceneId  Id of the scene.
      */
-    void loadScene(const std::string &name);
+    SceneId loadScene(const std::string &name);
 
 public: // Actions
-    void sendOnSameScene(const std::string &sceneName, Protocol::Packet<Protocol::CommandId> &packet);
+    /**
+     * @brief Send a packet to every player of a scene. The packet is serialized
+     * once per API version and the encoding is shared by all the recipients.
+     *
+     * @param sceneId  Id of the scene.
+     * @param packet  Packet to send.
+     */
+    void sendOnSameScene(SceneId sceneId, const Protocol::Packet<Protocol::CommandId> &packet);
 
-    void sendOnSameSceneExcept(const std::string &sceneName, Protocol::Packet<Protocol::CommandId> &packet,
+    /**
+     * @brief Send a packet to every player of a scene except one.
+     *
+     * @param sceneId  Id of the scene.
+     * @param packet  Packet to send.
+     * @param except  Player that must not receive the packet.
+     */
+    void sendOnSameSceneExcept(SceneId sceneId, const Protocol::Packet<Protocol::CommandId> &packet,
                                std::shared_ptr<Client> except);
 
-    void sendAllEntitiesToPlayer(std::shared_ptr<Client> player, const std::string &sceneGame);
+    /**
+     * @brief Send every entity of a scene to a player.
+     *
+     * @param player  Player to send the entities to.
+     * @param sceneId  Id of the scene.
+     */
+    void sendAllEntitiesToPlayer(std::shared_ptr<Client> player, SceneId sceneId);
 
     /**
      * @brief Check if a player is disconnected.
@@ -95,22 +156,74 @@ public: // Actions
     void checkDisconnect();
 
     /**
-     * @brief Send a packet to a player.
+     * @brief Send the state of every entity moved by player inputs during this
+     * tick. All the moved entities of a scene are packed in REQ_ENTITIES_MOVED
+     * packets shared by every player of the scene due a snapshot. A player
+     * whose snapshots are spaced out by its congestion control keeps the moved
+     * entities instead, and is sent the latest state of all of them in its own
+     * packets when its next snapshot is due.
+     */
+    void replicateMovedEntities();
+
+    /**
+     * @brief Pack the state of entities of a scene in REQ_ENTITIES_MOVED packets.
      *
-     * @param player  Player to send the packet to.
-     * @param pos  Position of the player.
-     * @param vel  Velocity of the player.
+     * @param sceneId  Id of the scene.
+     * @param entities  Entities to pack, with the last input id of each.
+     * @param send  Called with each packet.
      */
-    void sendUpdatePosition(std::shared_ptr<Client> player, Engine::ECS::Components::_3D::Transform pos,
-                            Engine::ECS::Components::_3D::Movable vel);
+    void packMovedEntities(SceneId sceneId, const std::unordered_map<Engine::ECS::Entity, uint32_t> &entities,
+                           const std::function<void(const Protocol::Packet<Protocol::CommandId> &)> &send);
 
     /**
-     * @brief Handle the events from a player.
+     * @brief Apply the events from a player. The moved entity is replicated
+     * once at the end of the tick by replicateMovedEntities, with the input
+     * sequence number that ends the payload (if any) as acknowledgement.
      *
      * @param player  Player that sent the event.
      * @param packet  Packet containing the events.
      */
-    void handleEvents(std::shared_ptr<Client> player, Protocol::Packet<Protocol::CommandId> packet);
+    void handleEvents(std::shared_ptr<Client> player, const Protocol::PacketView<Protocol::CommandId> &packet);
+
+    /**
+     * @brief Apply the events from a player seeing the world viewDelay in the past.
+     *
+     * @param player  Player that sent the event.
+     * @param packet  Packet containing the events.
+     * @param viewDelay  Rewind of the hit checks (see getViewDelay).
+     */
+    void handleEvents(std::shared_ptr<Client> player, const Protocol::PacketView<Protocol::CommandId> &packet,
+                      std::chrono::nanoseconds viewDelay);
+
+    /**
+     * @brief Answer a heartbeat of a player.
+     *
+     * @param player  Player that sent the heartbeat.
+     * @param packet  Packet of the heartbeat.
+     */
+    void handleHeartbeat(const std::shared_ptr<Client> &player,
+                         const Protocol::PacketView<Protocol::CommandId> &packet);
+
+    /**
+     * @brief Estimate how far in the past a player sees the world: half its
+     * round trip time (sampled from the acks of its channel, every datagram
+     * the player acks) plus the interpolation delay, capped by maxRewind.
+     *
+     * @param player  The player.
+     * @return std::chrono::nanoseconds  The view delay of the player.
+     */
+    [[nodiscard]] std::chrono::nanoseconds getViewDelay(const Client &player) const;
+
+    /**
+     * @brief Cast a shot of a player against the colliders of its scene as
+     * they were at its view time, and damage the first entity hit.
+     *
+     * @param player  Player that shot.
+     * @param pos  Transform of the player.
+     * @param viewDelay  Rewind of the hit check.
+     */
+    void shoot(std::shared_ptr<Client> player, const Engine::ECS::Components::_3D::Transform &pos,
+               std::chrono::nanoseconds viewDelay);
 
     /**
      * @brief Empty the incoming packets of the players and update the game with the new packets.
@@ -118,9 +231,37 @@ public: // Actions
     void updateIncomingPackets(unsigned char maxMessagePerFrame = 20);
 
     /**
-     * @brief Empty the outcoming packets of the players.
+     * @brief Empty the outcoming packets of the players, highest priority first,
+     * within the send budget of each player, in datagrams of at most the MTU
+     * of the player (a packet larger than the MTU is sent in fragments). Low
+     * priority packets that could not be sent during a tick are dropped at
+     * the next one. Each datagram is given a release time by the congestion
+     * control of its player: the datagrams due are sent at the end, in one
+     * batch for all the players, the others wait in the paced queue.
+     */
+    void updateOutcomingPackets();
+
+    /**
+     * @brief Send, in one batch, the datagrams of the paced queue whose
+     * release time came. It is called between the steps of a tick, so that
+     * the datagrams of a tick leave spread over the next one.
+     *
+     * @param now  The current time
+     */
+    void sendPacedDatagrams(std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief Start a new tick: advance the game clock and record the tick.
+     *
+     * @param elapsed  Time elapsed since the previous tick.
      */
-    void updateOutcomingPackets(unsigned char maxMessagePerFrame = 20);
+    void beginTick(std::chrono::nanoseconds elapsed);
+
+    /**
+     * @brief Run the systems of every scene and replicate the moved entities.
+     * This ends the current tick.
+     */
+    void runSystems();
 
     /**
      * @brief Update the game. This function is called every frame.
@@ -164,6 +305,55 @@ public: // Actions
      */
     [[nodiscard]] bool isRunning() const;
 
+public: // Replay
+    /**
+     * @brief Record the game instance in a replay log: the seeds of its scenes,
+     * the players joining and leaving, every applied input and every tick.
+     *
+     * @param path  Path of the replay log.
+     * @return true  The recording started
+     * @return false  The log could not be opened
+     */
+    bool startRecording(const std::string &path);
+
+    /**
+     * @brief Reseed the random generator of a scene (used to replay a log).
+     *
+     * @param sceneId  Id of the scene.
+     * @param seed  Seed of the random generator.
+     */
+    void seedScene(SceneId sceneId, uint32_t seed);
+
+    /**
+     * @brief Hash the state of the entities of every scene (transform, movable, health).
+     * Two runs of the same replay log must give the same hashes.
+     *
+     * @return uint64_t  Hash of the game state.
+     */
+    [[nodiscard]] uint64_t computeStateHash();
+
+public: // Profiling
+    /**
+     * @brief Get the run time of each system and of the whole tick since the
+     * last dump (see Engine::ECS::SystemProfiler::report). The systems are
+     * only timed when the server is built with FLAKKARI_PROFILE_SYSTEMS.
+     *
+     * @param reset  Start a new measure window.
+     * @return std::string  The profile table, empty if profiling is disabled.
+     */
+    [[nodiscard]] std::string getProfileReport(bool reset = false);
+
+    /**
+     * @brief Get the occupancy of the receive and send queues of each player:
+     * waiting packets, high water mark, capacity and packets rejected because
+     * the queue was full (summed over the priority levels for the sends),
+     * then the send rate, estimated bandwidth, loss and snapshot interval set
+     * by its congestion control.
+     *
+     * @return std::string  One line per player.
+     */
+    [[nodiscard]] std::string getQueueReport();
+
 public: // Getters
     /**
      * @brief Get the Name object (name of the game).
@@ -180,15 +370,45 @@ public: // Getters
     [[nodiscard]] std::vector<std::shared_ptr<Client>> getPlayers() const;
 
 protected:
+private:
+    struct PlayerSlot {
+        std::size_t index;      // Index in _players
+        std::size_t sceneIndex; // Index in the players of its scene
+    };
+
+    struct PacedDatagram {
+        std::chrono::steady_clock::time_point release; // Time the datagram may leave at
+        std::shared_ptr<Network::Address> address;     // Address of the player
+        Network::Buffer datagram;                      // Copy of the frame, in a buffer of _pacedSpares
+    };
+
 private:
     bool _running = false;                                                                    // Is the game running
     std::thread _thread;                                                                      // Thread of the game
     std::string _name;                                                                        // Name of the game
-    std::shared_ptr<nlohmann::json> _config;                                                  // Config of the game
+    std::shared_ptr<const GameSettings> _settings;                                            // Settings of the game
     std::vector<std::shared_ptr<Client>> _players;                                            // Players of the game
     float _deltaTime;                                                                         // Time between two frames
     std::chrono::steady_clock::time_point _time;                                              // Time of the last frame
-    std::unordered_map<std::string /*sceneName*/, Engine::ECS::Registry /*content*/> _scenes; // Scenes of the game
+    std::chrono::steady_clock::time_point _simulationTime;                                    // Time of the game clock
+    mutable std::recursive_mutex _mutex;                                                      // Lock of a tick
+    std::unique_ptr<ReplayRecorder> _recorder;                                                // Replay log
+    uint64_t _recordedTicks = 0;                                                              // Ticks in the log
+    std::unordered_map<const Client *, PlayerSlot> _playerSlots;                              // Slots of the players
+    std::vector<Scene> _scenes;                                                               // Scenes of the game
+    std::unordered_map<std::string /*sceneName*/, SceneId> _sceneIds;                         // Ids of the scenes
+    SceneId _startScene = 0;                                                                  // Scene of new players
+    OutgoingDatagrams _outgoing;                                                              // Datagrams of a tick
+    std::vector<PacedDatagram> _paced;                                                        // Datagrams not due yet
+    std::vector<Network::Buffer> _pacedSpares;                                                // Buffers of sent ones
+    std::vector<Client *> _snapshotPlayers;                                                   // Players of a snapshot
+    DatagramCompressor _compressor{Protocol::CommandId::REP_COMPRESSED};                      // Compression of a tick
+#ifdef FLAKKARI_PROFILE_SYSTEMS
+    Engine::ECS::SystemProfiler _profiler;                                                    // Run time of the systems
+    std::size_t _tickSlot = 0;                                                                // Slot of a whole tick
+    std::chrono::steady_clock::duration _profileDumpInterval = PROFILE_DUMP_INTERVAL;         // 0 disables the dumps
+    std::chrono::steady_clock::time_point _profileDumpTime;                                   // Time of the last dump
+#endif
 };
 
 } /* namespace Flakkari */
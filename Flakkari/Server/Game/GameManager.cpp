@@ -10,6 +10,7 @@
 #include "GameManager.hpp"
 #include "../Client/Client.hpp"
 
+#include <cstdlib>
 #include <future>
 
 namespace Flakkari {
@@ -45,13 +46,12 @@ GameManager::GameManager(const std::string &gameDir) : _game_dir(gameDir)
         }
         configFile >> config;
 
-        if (config["scenes"].empty())
-        {
-            FLAKKARI_LOG_ERROR("no scenes found");
+        auto settings = GameSettings::load(gameName, config);
+
+        if (!settings)
             continue;
-        }
 
-        _gamesStore[gameName] = std::make_shared<nlohmann::json>(config);
+        _gamesStore[gameName] = settings;
         FLAKKARI_LOG_INFO("\"" + gameName + "\" game loaded");
     }
 }
@@ -67,10 +67,12 @@ int GameManager::addGame(const std::string &gameName)
         return FLAKKARI_LOG_ERROR("could not open config file"), 3;
     configFile >> config;
 
-    if (config["scenes"].empty())
-        return FLAKKARI_LOG_ERROR("no scenes found"), 3;
+    auto settings = GameSettings::load(gameName, config);
 
-    _gamesStore[gameName] = std::make_shared<nlohmann::json>(config);
+    if (!settings)
+        return 3;
+
+    _gamesStore[gameName] = settings;
     FLAKKARI_LOG_INFO("\"" + gameName + "\" game loaded");
     return 0;
 }
@@ -86,7 +88,12 @@ int GameManager::updateGame(const std::string &gameName)
         return FLAKKARI_LOG_ERROR("could not open config file"), 3;
     configFile >> config;
 
-    _gamesStore[gameName] = std::make_shared<nlohmann::json>(config);
+    auto settings = GameSettings::load(gameName, config);
+
+    if (!settings)
+        return 3;
+
+    _gamesStore[gameName] = settings;
     FLAKKARI_LOG_INFO("\"" + gameName + "\" game updated");
     return 0;
 }
@@ -110,44 +117,64 @@ void GameManager::listGames()
     FLAKKARI_LOG_INFO(gamesList);
 }
 
+void GameManager::profileGames()
+{
+#ifdef FLAKKARI_PROFILE_SYSTEMS
+    for (const auto &[gameName, instances] : _gamesInstances)
+        for (std::size_t i = 0; i < instances.size(); ++i)
+            FLAKKARI_LOG_INFO("profile of game \"" + gameName + "\" instance " + std::to_string(i + 1) + ":\n" +
+                              instances[i]->getProfileReport());
+#else
+    FLAKKARI_LOG_WARNING("systems are not profiled: build the server with FLAKKARI_PROFILE_SYSTEMS");
+#endif
+}
+
+void GameManager::listQueues()
+{
+    for (const auto &[gameName, instances] : _gamesInstances)
+        for (std::size_t i = 0; i < instances.size(); ++i)
+            FLAKKARI_LOG_INFO("queues of game \"" + gameName + "\" instance " + std::to_string(i + 1) + ":\n" +
+                              instances[i]->getQueueReport());
+}
+
 bool GameManager::addClientToGame(const std::string &gameName, std::shared_ptr<Client> client)
 {
     if (_gamesStore.find(gameName) == _gamesStore.end())
         return FLAKKARI_LOG_ERROR("game not found"), false;
 
-    auto &gameStore = _gamesStore[gameName];
+    auto settings = _gamesStore[gameName];
     auto &gameInstance = _gamesInstances[gameName];
 
-    if (gameStore->at("online").get<bool>() == false)
+    if (!settings->online)
         return FLAKKARI_LOG_ERROR("game \"" + gameName + "\" is'nt an online game"), false;
 
-    auto minPlayers = gameStore->at("minPlayers").get<size_t>();
-    auto maxPlayers = gameStore->at("maxPlayers").get<size_t>();
-    auto maxInstances = gameStore->at("maxInstances").get<size_t>();
-    auto lobby = gameStore->at("lobby").get<std::string>();
-
-    FLAKKARI_LOG_INFO("<Game>: " + gameName + ", minPlayers: " + std::to_string(minPlayers) +
-                      ",  maxPlayers: " + std::to_string(maxPlayers) +
-                      ", maxInstances: " + std::to_string(maxInstances) + ", lobby: " + lobby);
-
-    if (gameInstance.empty() || gameInstance.back()->getPlayers().size() >= maxPlayers)
+    if (gameInstance.empty() || gameInstance.back()->getPlayers().size() >= settings->maxPlayers)
     {
-        if (gameInstance.size() >= maxInstances)
+        if (gameInstance.size() >= settings->maxInstances)
         {
             FLAKKARI_LOG_ERROR("game \"" + gameName + "\"is full");
             _waitingClients[gameName].push(client);
             return true;
         }
-        gameInstance.push_back(std::make_shared<Game>(gameName, gameStore));
+        gameInstance.push_back(std::make_shared<Game>(gameName, settings));
         FLAKKARI_LOG_INFO("game \"" + gameName + "\" created");
+
+        if (const char *recordDir = std::getenv("FLAKKARI_RECORD_DIR"))
+        {
+            auto stamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch());
+            gameInstance.back()->startRecording(std::string(recordDir) + "/" + gameName + "-" +
+                                                std::to_string(stamp.count()) + "-" +
+                                                std::to_string(gameInstance.size()) + ".flkr");
+        }
     }
 
     if (gameInstance.back()->addPlayer(client))
     {
-        if (lobby == "Matchmaking" && gameInstance.back()->getPlayers().size() >= minPlayers &&
-            !gameInstance.back()->isRunning())
+        if (settings->lobby == LobbyType::MATCHMAKING &&
+            gameInstance.back()->getPlayers().size() >= settings->minPlayers && !gameInstance.back()->isRunning())
             gameInstance.back()->start();
-        if (lobby == "OpenWorld" && !gameInstance.back()->isRunning())
+        if (settings->lobby == LobbyType::OPEN_WORLD && !gameInstance.back()->isRunning())
             gameInstance.back()->start();
         return true;
     }
@@ -162,7 +189,7 @@ bool GameManager::removeClientFromGame(const std::string &gameName, const std::s
 
     auto &waitingQueue = _waitingClients[gameName];
 
-    auto minPlayers = _gamesStore[gameName]->at("minPlayers").get<size_t>();
+    auto minPlayers = _gamesStore[gameName]->minPlayers;
 
     for (auto &instance : _gamesInstances[gameName])
     {
@@ -36,7 +36,7 @@ private:
     std::unordered_map<std::string /*gameName*/, std::queue<std::shared_ptr<Client>> /*waitingClients*/>
         _waitingClients;
     std::unordered_map<std::string /*gameName*/, std::vector<std::shared_ptr<Game>> /*gamesInstances*/> _gamesInstances;
-    std::unordered_map<std::string /*gameName*/, std::shared_ptr<nlohmann::json> /*data*/> _gamesStore;
+    std::unordered_map<std::string /*gameName*/, std::shared_ptr<const GameSettings> /*settings*/> _gamesStore;
     std::unordered_map<std::string /*gameName*/, bool /*remove_request*/> _gamesRemoveRequest;
     std::string _game_dir;
 
@@ -90,6 +90,20 @@ public:
      */
     void listGames();
 
+    /**
+     * @brief Log the run time of the systems of every game instance
+     * (server built with FLAKKARI_PROFILE_SYSTEMS only).
+     *
+     */
+    void profileGames();
+
+    /**
+     * @brief Log the occupancy of the packet queues of the players of every
+     * game instance.
+     *
+     */
+    void listQueues();
+
     /**
      * @brief Add a client to a game
      *
@@ -0,0 +1,123 @@
+/*
+** EPITECH PROJECT, 2024
+** Title: Flakkari
+** Author: MasterLaplace
+** Created: 2024-10-19
+** File description:
+** GameSettings
+*/
+
+#include "GameSettings.hpp"
+#include "Logger/Logger.hpp"
+
+namespace Flakkari {
+
+static bool hasScene(const nlohmann::json &config, const std::string &sceneName)
+{
+    for (auto &scene : config["scenes"].items())
+        if (scene.value().contains(sceneName))
+            return true;
+    return false;
+}
+
+std::shared_ptr<const GameSettings> GameSettings::load(const std::string &name, const nlohmann::json &config)
+{
+    auto error = [&name](const std::string &message) {
+        FLAKKARI_LOG_ERROR("invalid config for \"" + name + "\" game: " + message);
+        return nullptr;
+    };
+
+    if (!config.is_object())
+        return error("config is not an object");
+    if (!config.contains("scenes") || config["scenes"].empty())
+        return error("no scenes found");
+
+    if (!config.contains("online") || !config["online"].is_boolean())
+        return error("\"online\" must be a boolean");
+    for (auto field : {"minPlayers", "maxPlayers", "maxInstances"})
+        if (!config.contains(field) || !config[field].is_number_unsigned())
+            return error(std::string("\"") + field + "\" must be a positive integer");
+    for (auto field : {"lobby", "startGame", "playerTemplate"})
+        if (!config.contains(field) || !config[field].is_string())
+            return error(std::string("\"") + field + "\" must be a string");
+
+    auto settings = std::make_shared<GameSettings>();
+
+    settings->name = name;
+    settings->title = config.value("title", name);
+    settings->online = config["online"].get<bool>();
+    settings->minPlayers = config["minPlayers"].get<std::size_t>();
+    settings->maxPlayers = config["maxPlayers"].get<std::size_t>();
+    settings->maxInstances = config["maxInstances"].get<std::size_t>();
+    settings->startGame = config["startGame"].get<std::string>();
+    settings->playerTemplate = config["playerTemplate"].get<std::string>();
+
+    auto lobby = config["lobby"].get<std::string>();
+
+    if (lobby == "Matchmaking")
+        settings->lobby = LobbyType::MATCHMAKING;
+    else if (lobby == "OpenWorld")
+        settings->lobby = LobbyType::OPEN_WORLD;
+    else
+        return error("unknown lobby \"" + lobby + "\"");
+
+    if (settings->maxPlayers == 0 || settings->minPlayers > settings->maxPlayers)
+        return error("\"minPlayers\" must be lower than or equal to \"maxPlayers\" and \"maxPlayers\" not null");
+    if (settings->maxInstances == 0)
+        return error("\"maxInstances\" must not be null");
+    if (!hasScene(config, settings->startGame))
+        return error("start scene \"" + settings->startGame + "\" not found");
+
+    if (config.contains("lagCompensation"))
+    {
+        auto &lag = config["lagCompensation"];
+
+        if (!lag.is_object())
+            return error("\"lagCompensation\" must be an object");
+        for (auto field : {"historyTicks", "interpolationDelay", "maxRewind"})
+            if (lag.contains(field) && !lag[field].is_number_unsigned())
+                return error(std::string("\"lagCompensation.") + field + "\" must be a positive integer");
+        if (lag.contains("cellSize") && (!lag["cellSize"].is_number() || lag["cellSize"].get<float>() <= 0))
+            return error("\"lagCompensation.cellSize\" must be a positive number");
+
+        settings->historyTicks = lag.value("historyTicks", settings->historyTicks);
+        settings->broadphaseCellSize = lag.value("cellSize", settings->broadphaseCellSize);
+        settings->interpolationDelay =
+            std::chrono::milliseconds(lag.value("interpolationDelay", settings->interpolationDelay.count()));
+        settings->maxRewind = std::chrono::milliseconds(lag.value("maxRewind", settings->maxRewind.count()));
+
+        if (settings->historyTicks == 0)
+            return error("\"lagCompensation.historyTicks\" must not be null");
+    }
+
+    if (config.contains("network"))
+    {
+        auto &network = config["network"];
+
+        if (!network.is_object())
+            return error("\"network\" must be an object");
+        for (auto field : {"mtu", "minSendRate", "maxSendRate", "maxSnapshotInterval"})
+            if (network.contains(field) && !network[field].is_number_unsigned())
+                return error(std::string("\"network.") + field + "\" must be a positive integer");
+        if (network.contains("compression") && !network["compression"].is_boolean())
+            return error("\"network.compression\" must be a boolean");
+
+        settings->mtu = network.value("mtu", settings->mtu);
+        settings->minSendRate = network.value("minSendRate", settings->minSendRate / 1024) * 1024;
+        settings->maxSendRate = network.value("maxSendRate", settings->maxSendRate / 1024) * 1024;
+        settings->maxSnapshotInterval =
+            std::chrono::milliseconds(network.value("maxSnapshotInterval", settings->maxSnapshotInterval.count()));
+        settings->compression = network.value("compression", settings->compression);
+
+        if (settings->mtu < MIN_MTU || settings->mtu > MAX_MTU)
+            return error("\"network.mtu\" must be between " + std::to_string(MIN_MTU) + " and " +
+                         std::to_string(MAX_MTU));
+        if (settings->minSendRate == 0 || settings->minSendRate > settings->maxSendRate)
+            return error("\"network.minSendRate\" must be lower than or equal to \"network.maxSendRate\" and not null");
+    }
+
+    settings->config = std::make_shared<nlohmann::json>(config);
+    return settings;
+}
+
+} /* namespace Flakkari */
@@ -0,0 +1,87 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file GameSettings.hpp
+ * @brief This file contains the GameSettings struct. It holds the typed
+ *        settings of a game, validated once when its config is loaded and
+ *        shared by every instance of the game.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef GAMESETTINGS_HPP_
+#define GAMESETTINGS_HPP_
+
+#include <chrono>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+
+namespace Flakkari {
+
+/**
+ * @brief Kind of lobby used to start the instances of a game
+ */
+enum class LobbyType : uint8_t {
+    MATCHMAKING, // The instance starts once it has minPlayers players
+    OPEN_WORLD   // The instance starts with its first player
+};
+
+/**
+ * @brief Immutable settings of a game
+ *
+ * @details The settings are read from the config.cfg file of the game by
+ * GameManager when the game is loaded or updated. An invalid config is
+ * rejected at that time, so the game instances and the connect path only
+ * read plain fields and never touch the JSON document.
+ *
+ * @see GameManager
+ * @see Game
+ */
+struct GameSettings {
+    std::string name;                         // Name of the game (name of its folder)
+    std::string title;                        // Title of the game
+    bool online = false;                      // Can the game be played online
+    std::size_t minPlayers = 0;               // Players needed to start a matchmaking instance
+    std::size_t maxPlayers = 0;               // Players per instance
+    std::size_t maxInstances = 0;             // Instances running at the same time
+    LobbyType lobby = LobbyType::MATCHMAKING; // Lobby of the game
+    std::string startGame;                    // Scene of the new players
+    std::string playerTemplate;               // Template of the new players
+    std::shared_ptr<nlohmann::json> config;   // Full config of the game (scenes loading only)
+
+    // Lag compensation
+    std::size_t historyTicks = 32;                       // Ticks of collider history kept per scene
+    float broadphaseCellSize = 8.0f;                     // Size of the cells of the hit detection grid
+    std::chrono::milliseconds interpolationDelay{100};   // Time the clients render behind the server
+    std::chrono::milliseconds maxRewind{250};            // Maximum rewind of a hit check
+
+    // Network
+    std::size_t mtu = 1200;                             // Size of the largest datagram sent to a player
+    std::size_t minSendRate = 16 * 1024;                // Bytes per second a player is always allowed
+    std::size_t maxSendRate = 8 * 1024 * 1024;          // Bytes per second a player is never sent more than
+    std::chrono::milliseconds maxSnapshotInterval{250}; // Longest time between two snapshots of a player
+    bool compression = true;                            // Compress the datagrams of the players that can
+
+    static constexpr std::size_t MIN_MTU = 256;  // Room for a fragment of a packet of the largest size
+    static constexpr std::size_t MAX_MTU = 4096; // Size of the receive buffers of the clients
+
+    /**
+     * @brief Validate a game config and build its settings.
+     *
+     * @param name  Name of the game.
+     * @param config  Config of the game (content of its config.cfg file).
+     * @return std::shared_ptr<const GameSettings>  The settings, or nullptr if the config is invalid.
+     */
+    [[nodiscard]] static std::shared_ptr<const GameSettings> load(const std::string &name,
+                                                                  const nlohmann::json &config);
+};
+
+} /* namespace Flakkari */
+
+#endif /* !GAMESETTINGS_HPP_ */
@@ -0,0 +1,137 @@
+/*
+** EPITECH PROJECT, 2024
+** Title: Flakkari
+** Author: MasterLaplace
+** Created: 2024-10-19
+** File description:
+** Replay
+*/
+
+#include "Replay.hpp"
+#include "Logger/Logger.hpp"
+
+namespace Flakkari {
+
+ReplayRecorder::ReplayRecorder(const std::string &path, const std::string &gameName)
+    : _file(path, std::ios::binary | std::ios::trunc)
+{
+    if (!_file.is_open())
+    {
+        FLAKKARI_LOG_ERROR("could not open replay log \"" + path + "\"");
+        return;
+    }
+    write(MAGIC);
+    write(VERSION);
+    write(static_cast<uint16_t>(gameName.size()));
+    _file.write(gameName.data(), static_cast<std::streamsize>(gameName.size()));
+}
+
+void ReplayRecorder::tick(uint64_t elapsedNs)
+{
+    write(ReplayRecordType::TICK);
+    write(elapsedNs);
+}
+
+void ReplayRecorder::systems() { write(ReplayRecordType::SYSTEMS); }
+
+void ReplayRecorder::seed(uint16_t scene, uint32_t seed)
+{
+    write(ReplayRecordType::SEED);
+    write(scene);
+    write(seed);
+}
+
+void ReplayRecorder::join(const void *client)
+{
+    auto id = _nextClient++;
+
+    _clients[client] = id;
+    write(ReplayRecordType::JOIN);
+    write(id);
+}
+
+void ReplayRecorder::leave(const void *client)
+{
+    auto it = _clients.find(client);
+    if (it == _clients.end())
+        return;
+    write(ReplayRecordType::LEAVE);
+    write(it->second);
+    _clients.erase(it);
+}
+
+void ReplayRecorder::input(const void *client, const Network::BufferView &payload,
+                           std::chrono::nanoseconds viewDelay)
+{
+    auto it = _clients.find(client);
+    if (it == _clients.end())
+        return;
+    write(ReplayRecordType::INPUT);
+    write(it->second);
+    write(static_cast<uint64_t>(viewDelay.count()));
+    write(static_cast<uint16_t>(payload.size()));
+    _file.write(reinterpret_cast<const char *>(payload.data()), static_cast<std::streamsize>(payload.size()));
+}
+
+void ReplayRecorder::hash(uint64_t stateHash)
+{
+    write(ReplayRecordType::HASH);
+    write(stateHash);
+}
+
+ReplayReader::ReplayReader(const std::string &path) : _file(path, std::ios::binary)
+{
+    uint32_t magic = 0;
+    uint16_t version = 0;
+    uint16_t nameSize = 0;
+
+    if (!_file.is_open())
+    {
+        FLAKKARI_LOG_ERROR("could not open replay log \"" + path + "\"");
+        return;
+    }
+    if (!read(magic) || magic != ReplayRecorder::MAGIC || !read(version) || version != ReplayRecorder::VERSION)
+    {
+        FLAKKARI_LOG_ERROR("\"" + path + "\" is not a replay log of version " +
+                           std::to_string(ReplayRecorder::VERSION));
+        return;
+    }
+    if (!read(nameSize))
+        return;
+    _gameName.resize(nameSize);
+    _valid = static_cast<bool>(_file.read(_gameName.data(), nameSize));
+}
+
+bool ReplayReader::next(ReplayRecord &record)
+{
+    if (!_valid || !read(record.type))
+        return false;
+
+    switch (record.type)
+    {
+    case ReplayRecordType::TICK:
+    case ReplayRecordType::HASH: return read(record.value);
+    case ReplayRecordType::SYSTEMS: return true;
+    case ReplayRecordType::SEED:
+    {
+        uint32_t seed = 0;
+        if (!read(record.scene) || !read(seed))
+            return false;
+        record.value = seed;
+        return true;
+    }
+    case ReplayRecordType::JOIN:
+    case ReplayRecordType::LEAVE: return read(record.client);
+    case ReplayRecordType::INPUT:
+    {
+        uint16_t size = 0;
+        if (!read(record.client) || !read(record.value) || !read(size))
+            return false;
+        record.payload.resize(size);
+        return static_cast<bool>(_file.read(reinterpret_cast<char *>(record.payload.data()), size));
+    }
+    default: return FLAKKARI_LOG_ERROR("unknown replay record type " + std::to_string(int(record.type))), false;
+    }
+}
+
+} /* namespace Flakkari */
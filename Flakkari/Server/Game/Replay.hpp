@@ -0,0 +1,161 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file Replay.hpp
+ * @brief This file contains the ReplayRecorder and ReplayReader classes.
+ *        They write and read the binary log of a game instance: its RNG
+ *        seeds, the players joining and leaving, every applied input and
+ *        the duration of each tick. Replaying the log through the same
+ *        systems gives the same game state, with no network.
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef REPLAY_HPP_
+#define REPLAY_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+#include "Network/BufferPool.hpp"
+
+namespace Flakkari {
+
+/**
+ * @brief Type of a record of a replay log
+ *
+ * @details A log starts with the "FLKR" magic, the format version and the
+ * name of the game, then holds a sequence of records. Each record is its
+ * type (1 byte) followed by its fields, in native byte order:
+ *  - TICK: (elapsed nanoseconds: u64) a tick starts
+ *  - SYSTEMS: () the systems of every scene ran, the tick ends
+ *  - SEED: (scene: u16)(seed: u32) the random generator of a scene was seeded
+ *  - JOIN: (client: u32) a player joined the game
+ *  - LEAVE: (client: u32) a player left the game
+ *  - INPUT: (client: u32)(view delay ns: u64)(size: u16)(payload) a REQ_USER_UPDATES
+ *    payload was applied, its hits checked viewDelay in the past
+ *  - HASH: (state hash: u64) hash of the game state after the systems ran
+ */
+enum class ReplayRecordType : uint8_t {
+    TICK = 0,
+    SYSTEMS = 1,
+    SEED = 2,
+    JOIN = 3,
+    LEAVE = 4,
+    INPUT = 5,
+    HASH = 6
+};
+
+/**
+ * @brief One record read from a replay log
+ */
+struct ReplayRecord {
+    ReplayRecordType type = ReplayRecordType::TICK;
+    uint64_t value = 0;      // Elapsed ns (TICK), seed (SEED), state hash (HASH) or view delay ns (INPUT)
+    uint32_t client = 0;     // Client id (JOIN, LEAVE, INPUT)
+    uint16_t scene = 0;      // Scene id (SEED)
+    Network::Buffer payload; // Input payload (INPUT)
+};
+
+/**
+ * @brief Writer of a replay log
+ *
+ * @details The clients are identified in the log by a small id given when
+ * they join. The writes are buffered by the underlying stream. The recorder
+ * is not thread safe: the game calls it under its own lock.
+ */
+class ReplayRecorder {
+public:
+    static constexpr uint32_t MAGIC = 0x524B4C46; // "FLKR"
+    static constexpr uint16_t VERSION = 2;
+
+public:
+    /**
+     * @brief Open a new replay log.
+     *
+     * @param path  Path of the log file.
+     * @param gameName  Name of the recorded game.
+     */
+    ReplayRecorder(const std::string &path, const std::string &gameName);
+    ~ReplayRecorder() = default;
+
+    /**
+     * @brief Check if the log file could be opened.
+     */
+    [[nodiscard]] bool isOpen() const { return _file.is_open(); }
+
+    void tick(uint64_t elapsedNs);
+    void systems();
+    void seed(uint16_t scene, uint32_t seed);
+    void join(const void *client);
+    void leave(const void *client);
+    void input(const void *client, const Network::BufferView &payload, std::chrono::nanoseconds viewDelay);
+    void hash(uint64_t stateHash);
+
+private:
+    template <typename T> void write(const T &value)
+    {
+        _file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+private:
+    std::ofstream _file;
+    std::unordered_map<const void *, uint32_t> _clients;
+    uint32_t _nextClient = 0;
+};
+
+/**
+ * @brief Reader of a replay log
+ */
+class ReplayReader {
+public:
+    /**
+     * @brief Open a replay log and read its header.
+     *
+     * @param path  Path of the log file.
+     */
+    explicit ReplayReader(const std::string &path);
+    ~ReplayReader() = default;
+
+    /**
+     * @brief Check if the log file is open and its header is valid.
+     */
+    [[nodiscard]] bool isValid() const { return _valid; }
+
+    /**
+     * @brief Get the name of the recorded game.
+     */
+    [[nodiscard]] const std::string &getGameName() const { return _gameName; }
+
+    /**
+     * @brief Read the next record of the log.
+     *
+     * @param record  The record to fill.
+     * @return true  A record was read.
+     * @return false  The end of the log was reached or the log is truncated.
+     */
+    [[nodiscard]] bool next(ReplayRecord &record);
+
+private:
+    template <typename T> bool read(T &value)
+    {
+        return static_cast<bool>(_file.read(reinterpret_cast<char *>(&value), sizeof(value)));
+    }
+
+private:
+    std::ifstream _file;
+    std::string _gameName;
+    bool _valid = false;
+};
+
+} /* namespace Flakkari */
+
+#endif /* !REPLAY_HPP_ */
@@ -0,0 +1,325 @@
+/*
+** EPITECH PROJECT, 2024
+** Title: Flakkari
+** Author: MasterLaplace
+** Created: 2024-10-19
+** File description:
+** TransformHistory
+*/
+
+#include "TransformHistory.hpp"
+#include "Engine/EntityComponentSystem/Components/Components3D.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Flakkari {
+
+void TransformHistory::Frame::clear()
+{
+    entities.clear();
+    x.clear();
+    y.clear();
+    z.clear();
+    halfX.clear();
+    halfY.clear();
+    halfZ.clear();
+    radius.clear();
+    cells.clear();
+    oversized.clear();
+}
+
+TransformHistory::TransformHistory(std::size_t frames, float cellSize)
+    : _frames(std::max<std::size_t>(frames, 1)), _cellSize(cellSize > 0 ? cellSize : 8.0f)
+{
+}
+
+int32_t TransformHistory::cellOf(float coordinate) const
+{
+    return static_cast<int32_t>(std::floor(coordinate / _cellSize));
+}
+
+uint64_t TransformHistory::cellKey(int32_t x, int32_t y, int32_t z)
+{
+    constexpr uint64_t mask = (1ull << 21) - 1; // 21 bits per axis
+    return ((static_cast<uint64_t>(x) & mask) << 42) | ((static_cast<uint64_t>(y) & mask) << 21) |
+           (static_cast<uint64_t>(z) & mask);
+}
+
+void TransformHistory::record(Engine::ECS::Registry &registry, std::chrono::steady_clock::time_point time)
+{
+    auto &frame = _frames[_head];
+    auto &transforms = registry.getComponents<Engine::ECS::Components::_3D::Transform>();
+    auto &boxes = registry.getComponents<Engine::ECS::Components::_3D::BoxCollider>();
+    auto &spheres = registry.getComponents<Engine::ECS::Components::_3D::SphereCollider>();
+
+    frame.clear();
+    frame.time = time;
+
+    for (Engine::ECS::Entity i(0); i < transforms.size(); ++i)
+    {
+        auto &transform = transforms[i];
+
+        if (!transform.has_value())
+            continue;
+
+        auto &position = transform->_position.vec;
+
+        if (i < boxes.size() && boxes[i].has_value())
+        {
+            // the position of a box is its min corner (see handle_collisions)
+            auto &size = boxes[i]->_size.vec;
+            auto &scale = transform->_scale.vec;
+            float hx = std::abs(size.x * scale.x) / 2;
+            float hy = std::abs(size.y * scale.y) / 2;
+            float hz = std::abs(size.z * scale.z) / 2;
+
+            frame.entities.push_back(i);
+            frame.x.push_back(position.x + hx);
+            frame.y.push_back(position.y + hy);
+            frame.z.push_back(position.z + hz);
+            frame.halfX.push_back(hx);
+            frame.halfY.push_back(hy);
+            frame.halfZ.push_back(hz);
+            frame.radius.push_back(0);
+        }
+        else if (i < spheres.size() && spheres[i].has_value())
+        {
+            float r = spheres[i]->_radius;
+
+            frame.entities.push_back(i);
+            frame.x.push_back(position.x);
+            frame.y.push_back(position.y);
+            frame.z.push_back(position.z);
+            frame.halfX.push_back(r);
+            frame.halfY.push_back(r);
+            frame.halfZ.push_back(r);
+            frame.radius.push_back(r);
+        }
+    }
+
+    buildGrid(frame);
+    _head = (_head + 1) % _frames.size();
+    _count = std::min(_count + 1, _frames.size());
+}
+
+void TransformHistory::buildGrid(Frame &frame) const
+{
+    for (uint32_t i = 0; i < frame.size(); ++i)
+    {
+        int32_t minX = cellOf(frame.x[i] - frame.halfX[i]), maxX = cellOf(frame.x[i] + frame.halfX[i]);
+        int32_t minY = cellOf(frame.y[i] - frame.halfY[i]), maxY = cellOf(frame.y[i] + frame.halfY[i]);
+        int32_t minZ = cellOf(frame.z[i] - frame.halfZ[i]), maxZ = cellOf(frame.z[i] + frame.halfZ[i]);
+        auto cells = static_cast<std::size_t>(maxX - minX + 1) * static_cast<std::size_t>(maxY - minY + 1) *
+                     static_cast<std::size_t>(maxZ - minZ + 1);
+
+        if (cells > MAX_CELLS_PER_COLLIDER)
+        {
+            frame.oversized.push_back(i);
+            continue;
+        }
+        for (int32_t cx = minX; cx <= maxX; ++cx)
+            for (int32_t cy = minY; cy <= maxY; ++cy)
+                for (int32_t cz = minZ; cz <= maxZ; ++cz)
+                    frame.cells.emplace_back(cellKey(cx, cy, cz), i);
+    }
+    std::sort(frame.cells.begin(), frame.cells.end());
+}
+
+const TransformHistory::Frame *TransformHistory::rewind(std::chrono::steady_clock::time_point viewTime) const
+{
+    if (_count == 0)
+        return nullptr;
+
+    // walk from the newest frame to the oldest one
+    std::size_t index = (_head + _frames.size() - 1) % _frames.size();
+    for (std::size_t i = 0; i < _count; ++i)
+    {
+        if (_frames[index].time <= viewTime || i + 1 == _count)
+            return &_frames[index];
+        index = (index + _frames.size() - 1) % _frames.size();
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Distance along a ray to a box or a sphere, if the ray enters it
+ * within [0, maxDistance].
+ */
+static std::optional<float> intersect(const TransformHistory::Frame &frame, uint32_t i, const float origin[3],
+                                      const float direction[3], float maxDistance)
+{
+    const float center[3] = {frame.x[i], frame.y[i], frame.z[i]};
+
+    if (frame.radius[i] > 0)
+    {
+        float oc[3] = {origin[0] - center[0], origin[1] - center[1], origin[2] - center[2]};
+        float b = oc[0] * direction[0] + oc[1] * direction[1] + oc[2] * direction[2];
+        float c = oc[0] * oc[0] + oc[1] * oc[1] + oc[2] * oc[2] - frame.radius[i] * frame.radius[i];
+        float delta = b * b - c;
+
+        if (delta < 0)
+            return std::nullopt;
+        float t = -b - std::sqrt(delta);
+        if (t < 0)
+            t = 0; // the origin is inside the sphere
+        if (-b + std::sqrt(delta) < 0 || t > maxDistance)
+            return std::nullopt;
+        return t;
+    }
+
+    const float half[3] = {frame.halfX[i], frame.halfY[i], frame.halfZ[i]};
+    float tMin = 0;
+    float tMax = maxDistance;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float low = center[axis] - half[axis] - origin[axis];
+        float high = center[axis] + half[axis] - origin[axis];
+
+        if (direction[axis] == 0)
+        {
+            if (low > 0 || high < 0)
+                return std::nullopt;
+            continue;
+        }
+        float t1 = low / direction[axis];
+        float t2 = high / direction[axis];
+        if (t1 > t2)
+            std::swap(t1, t2);
+        tMin = std::max(tMin, t1);
+        tMax = std::min(tMax, t2);
+        if (tMin > tMax)
+            return std::nullopt;
+    }
+    return tMin;
+}
+
+std::optional<TransformHistory::Hit> TransformHistory::raycast(std::chrono::steady_clock::time_point viewTime,
+                                                               const Engine::Math::Vector3f &origin,
+                                                               const Engine::Math::Vector3f &direction,
+                                                               float maxDistance, const Filter &filter) const
+{
+    const Frame *frame = rewind(viewTime);
+    if (!frame || frame->size() == 0)
+        return std::nullopt;
+
+    const float o[3] = {origin.vec.x, origin.vec.y, origin.vec.z};
+    const float d[3] = {direction.vec.x, direction.vec.y, direction.vec.z};
+    std::optional<Hit> best;
+
+    auto test = [&](uint32_t i) {
+        if (filter && !filter(frame->entities[i]))
+            return;
+        auto t = intersect(*frame, i, o, d, best ? best->distance : maxDistance);
+        if (t && (!best || *t < best->distance))
+            best = Hit{frame->entities[i], *t};
+    };
+
+    for (auto i : frame->oversized)
+        test(i);
+
+    // walk the cells crossed by the ray (Amanatides & Woo)
+    int32_t cell[3] = {cellOf(o[0]), cellOf(o[1]), cellOf(o[2])};
+    int32_t step[3];
+    float tNext[3];
+    float tDelta[3];
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (d[axis] > 0)
+        {
+            step[axis] = 1;
+            tNext[axis] = (static_cast<float>(cell[axis] + 1) * _cellSize - o[axis]) / d[axis];
+            tDelta[axis] = _cellSize / d[axis];
+        }
+        else if (d[axis] < 0)
+        {
+            step[axis] = -1;
+            tNext[axis] = (static_cast<float>(cell[axis]) * _cellSize - o[axis]) / d[axis];
+            tDelta[axis] = -_cellSize / d[axis];
+        }
+        else
+        {
+            step[axis] = 0;
+            tNext[axis] = std::numeric_limits<float>::infinity();
+            tDelta[axis] = std::numeric_limits<float>::infinity();
+        }
+    }
+
+    float tCell = 0;
+    while (tCell <= maxDistance)
+    {
+        auto key = cellKey(cell[0], cell[1], cell[2]);
+        auto it = std::lower_bound(frame->cells.begin(), frame->cells.end(), std::make_pair(key, uint32_t(0)));
+
+        for (; it != frame->cells.end() && it->first == key; ++it)
+            test(it->second);
+
+        int axis = (tNext[0] < tNext[1]) ? (tNext[0] < tNext[2] ? 0 : 2) : (tNext[1] < tNext[2] ? 1 : 2);
+
+        // nothing in the next cells can be closer than a hit found so far
+        if (best && best->distance <= tNext[axis])
+            break;
+        tCell = tNext[axis];
+        tNext[axis] += tDelta[axis];
+        cell[axis] += step[axis];
+    }
+    return best;
+}
+
+void TransformHistory::overlapSphere(std::chrono::steady_clock::time_point viewTime,
+                                     const Engine::Math::Vector3f &center, float radius,
+                                     std::vector<Engine::ECS::Entity> &entities) const
+{
+    entities.clear();
+
+    const Frame *frame = rewind(viewTime);
+    if (!frame)
+        return;
+
+    const float c[3] = {center.vec.x, center.vec.y, center.vec.z};
+
+    auto overlaps = [&](uint32_t i) {
+        if (frame->radius[i] > 0)
+        {
+            float dx = c[0] - frame->x[i];
+            float dy = c[1] - frame->y[i];
+            float dz = c[2] - frame->z[i];
+            float reach = radius + frame->radius[i];
+            return dx * dx + dy * dy + dz * dz <= reach * reach;
+        }
+        // distance from the center to the closest point of the box
+        float dx = std::max(std::abs(c[0] - frame->x[i]) - frame->halfX[i], 0.0f);
+        float dy = std::max(std::abs(c[1] - frame->y[i]) - frame->halfY[i], 0.0f);
+        float dz = std::max(std::abs(c[2] - frame->z[i]) - frame->halfZ[i], 0.0f);
+        return dx * dx + dy * dy + dz * dz <= radius * radius;
+    };
+
+    _candidates.clear();
+    for (auto i : frame->oversized)
+        _candidates.push_back(i);
+
+    for (int32_t cx = cellOf(c[0] - radius); cx <= cellOf(c[0] + radius); ++cx)
+        for (int32_t cy = cellOf(c[1] - radius); cy <= cellOf(c[1] + radius); ++cy)
+            for (int32_t cz = cellOf(c[2] - radius); cz <= cellOf(c[2] + radius); ++cz)
+            {
+                auto key = cellKey(cx, cy, cz);
+                auto it =
+                    std::lower_bound(frame->cells.begin(), frame->cells.end(), std::make_pair(key, uint32_t(0)));
+
+                for (; it != frame->cells.end() && it->first == key; ++it)
+                    _candidates.push_back(it->second);
+            }
+
+    // a collider spanning several cells is found once per cell
+    std::sort(_candidates.begin(), _candidates.end());
+    _candidates.erase(std::unique(_candidates.begin(), _candidates.end()), _candidates.end());
+
+    for (auto i : _candidates)
+        if (overlaps(i))
+            entities.push_back(frame->entities[i]);
+}
+
+} /* namespace Flakkari */
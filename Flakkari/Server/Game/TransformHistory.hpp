@@ -0,0 +1,150 @@
+/**************************************************************************
+ * Flakkari Library v0.10.0
+ *
+ * Flakkari Library is a C++ Library for Network.
+ * @file TransformHistory.hpp
+ * @brief This file contains the TransformHistory class. It keeps the
+ *        colliders of a scene over the last ticks so that the hits of a
+ *        player are checked against the world as the player saw it
+ *        (server-side lag compensation).
+ *
+ * Flakkari Library is under MIT License.
+ * https://opensource.org/licenses/MIT
+ * © 2023 @MasterLaplace
+ * @version 0.10.0
+ * @date 2024-10-19
+ **************************************************************************/
+
+#ifndef TRANSFORMHISTORY_HPP_
+#define TRANSFORMHISTORY_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "Engine/EntityComponentSystem/Registry.hpp"
+#include "Engine/Math/Vector.hpp"
+
+namespace Flakkari {
+
+/**
+ * @brief History ring of the colliders of a scene
+ *
+ * @details Every tick, record() copies the position and extent of each
+ * entity with a 3D Transform and a BoxCollider or SphereCollider into the
+ * next frame of the ring. A frame stores its colliders as parallel arrays
+ * (center, half extents, radius) and indexes them in a uniform grid of
+ * cubic cells: a query only tests the colliders of the cells it crosses.
+ * Colliders spanning too many cells (e.g. a skybox) are kept in a separate
+ * list tested by every query.
+ *
+ * The frames keep their capacity once the ring is full, so recording does
+ * not allocate in steady state.
+ *
+ * @example "Flakkari/Server/Game/TransformHistory.hpp"
+ * @code
+ * TransformHistory history(32, 8.0f);
+ * history.record(registry, now);
+ * auto hit = history.raycast(now - viewDelay, origin, direction, 100.0f,
+ *                            [&](Engine::ECS::Entity e) { return e != shooter; });
+ * @endcode
+ */
+class TransformHistory {
+public:
+    static constexpr std::size_t MAX_CELLS_PER_COLLIDER = 64; // Larger colliders are tested by every query
+
+    struct Frame {
+        std::chrono::steady_clock::time_point time;       // Game time of the tick
+        std::vector<Engine::ECS::Entity> entities;        // Entity of each collider
+        std::vector<float> x, y, z;                       // Center of each collider
+        std::vector<float> halfX, halfY, halfZ;           // Half extents of each collider
+        std::vector<float> radius;                        // Radius of a sphere collider, 0 for a box
+        std::vector<std::pair<uint64_t, uint32_t>> cells; // (cell key, collider index) sorted by cell key
+        std::vector<uint32_t> oversized;                  // Colliders not put in the grid
+
+        void clear();
+        [[nodiscard]] std::size_t size() const { return entities.size(); }
+    };
+
+    struct Hit {
+        Engine::ECS::Entity entity; // Entity hit
+        float distance;             // Distance from the origin of the ray
+    };
+
+    using Filter = std::function<bool(Engine::ECS::Entity)>;
+
+public:
+    /**
+     * @brief Construct a new TransformHistory object.
+     *
+     * @param frames  Number of ticks kept (at least 1).
+     * @param cellSize  Size of the cells of the broadphase grid.
+     */
+    TransformHistory(std::size_t frames = 32, float cellSize = 8.0f);
+    ~TransformHistory() = default;
+
+    /**
+     * @brief Record the colliders of a registry as the newest frame.
+     *
+     * @param registry  Registry of the scene.
+     * @param time  Game time of the tick.
+     */
+    void record(Engine::ECS::Registry &registry, std::chrono::steady_clock::time_point time);
+
+    /**
+     * @brief Get the frame seen by a client at a given time: the newest
+     * frame not after that time, or the oldest frame kept.
+     *
+     * @param viewTime  Estimated view time of the client.
+     * @return const Frame*  The frame, or nullptr if nothing was recorded.
+     */
+    [[nodiscard]] const Frame *rewind(std::chrono::steady_clock::time_point viewTime) const;
+
+    /**
+     * @brief Cast a ray against the colliders of the frame seen at a given time.
+     *
+     * @param viewTime  Estimated view time of the client.
+     * @param origin  Origin of the ray.
+     * @param direction  Direction of the ray (normalized).
+     * @param maxDistance  Length of the ray.
+     * @param filter  Returns false for the entities to ignore.
+     * @return std::optional<Hit>  The closest accepted hit.
+     */
+    [[nodiscard]] std::optional<Hit> raycast(std::chrono::steady_clock::time_point viewTime,
+                                             const Engine::Math::Vector3f &origin,
+                                             const Engine::Math::Vector3f &direction, float maxDistance,
+                                             const Filter &filter) const;
+
+    /**
+     * @brief Get the entities overlapping a sphere in the frame seen at a given time.
+     *
+     * @param viewTime  Estimated view time of the client.
+     * @param center  Center of the sphere.
+     * @param radius  Radius of the sphere.
+     * @param entities  Filled with the overlapping entities.
+     */
+    void overlapSphere(std::chrono::steady_clock::time_point viewTime, const Engine::Math::Vector3f &center,
+                       float radius, std::vector<Engine::ECS::Entity> &entities) const;
+
+    [[nodiscard]] std::size_t capacity() const { return _frames.size(); }
+    [[nodiscard]] std::size_t size() const { return _count; }
+    void clear() { _count = 0; }
+
+private:
+    [[nodiscard]] int32_t cellOf(float coordinate) const;
+    [[nodiscard]] static uint64_t cellKey(int32_t x, int32_t y, int32_t z);
+    void buildGrid(Frame &frame) const;
+
+private:
+    std::vector<Frame> _frames;                // Ring of frames
+    std::size_t _head = 0;                     // Index of the next frame to write
+    std::size_t _count = 0;                    // Number of frames recorded
+    float _cellSize;                           // Size of the cells of the grid
+    mutable std::vector<uint32_t> _candidates; // Colliders of an overlap query (reused)
+};
+
+} /* namespace Flakkari */
+
+#endif /* !TRANSFORMHISTORY_HPP_ */
@@ -24,6 +24,8 @@ static const std::string HELP_MESSAGE = "Commands:\n"
                                         "updateGame <gameName> (admin only)\n"
                                         "removeGame <gameName> (admin only)\n"
                                         "listGames (admin only)\n"
+                                        "profile (admin only)\n"
+                                        "queues (admin only)\n"
                                         "version\n"
                                         "help\n"
                                         "exit (admin only)";
@@ -111,6 +113,20 @@ bool CommandManager::handleAdminCommand(const std::string &input)
         return true;
     }
 
+    if (input == "profile")
+    {
+        GameManager::GetInstance().profileGames();
+        GameManager::UnlockInstance();
+        return true;
+    }
+
+    if (input == "queues")
+    {
+        GameManager::GetInstance().listQueues();
+        GameManager::UnlockInstance();
+        return true;
+    }
+
     if (input == "exit")
     {
         FLAKKARI_LOG_INFO("Exiting...");
@@ -11,30 +11,68 @@
 
 using namespace Flakkari;
 
-UDPServer::UDPServer(const std::string &gameDir, const std::string &ip, unsigned short port)
+UDPServer::UDPServer(const std::string &gameDir, const std::string &ip, unsigned short port, std::size_t shards,
+                     bool ioUring)
 #ifdef FLAKKARI_AUTO_UPDATE
     : _gameDownloader(gameDir)
 #endif
 {
     Network::init();
 
-    _socket = std::make_shared<Network::Socket>();
-    _socket->create(ip, port, Network::Address::IpType::IPv4, Network::Address::SocketType::UDP);
+#if defined(_IO_URING_) && defined(__linux__)
+    _ioUring = ioUring && Network::IO_URING::isSupported();
+#endif
+    if (ioUring && !_ioUring)
+        FLAKKARI_LOG_WARNING("io_uring is not supported, the shards receive with " LPL_TOSTRING(IO_SELECTED));
+    else if (_ioUring)
+        FLAKKARI_LOG_INFO("The shards receive with io_uring");
 
-    FLAKKARI_LOG_INFO(std::string(*_socket));
-    _socket->setBlocking(false);
-    _socket->bind();
+    for (std::size_t shard = 0; shard < std::max<std::size_t>(shards, 1); ++shard)
+    {
+        auto socket = std::make_shared<Network::Socket>();
+        socket->create(ip, port, Network::Address::IpType::IPv4, Network::Address::SocketType::UDP);
 
-    _io = std::make_unique<IO_SELECTED>(_socket->getSocket());
-    _io->addSocket(STDIN_FILENO);
+        FLAKKARI_LOG_INFO(std::string(*socket));
+        socket->setBlocking(false);
+        socket->bind();
+        if (socket->enableGso() && shard == 0)
+            FLAKKARI_LOG_INFO("UDP segmentation offload (GSO) enabled");
+        // the ring receives one datagram per buffer, without the control data that splits a GRO message
+        if (!_ioUring && socket->enableGro() && shard == 0)
+            FLAKKARI_LOG_INFO("UDP receive offload (GRO) enabled");
+        _sockets.push_back(socket);
+        _pools.push_back(Network::BufferPool::create(
+            RECEIVE_POOL_SLABS, socket->hasGro() ? Network::Socket::GRO_BUFFER_SIZE : MAX_DATAGRAM_SIZE));
+        _datagrams.emplace_back().reserve(RECEIVE_BATCH_SIZE);
+        _truncated.push_back(0);
+    }
+    if (_sockets.size() > 1)
+        FLAKKARI_LOG_INFO(std::to_string(_sockets.size()) + " shards sharing the port with SO_REUSEPORT");
 
-    ClientManager::CreateInstance(_socket);
+    if (_ioUring)
+        _io = std::make_unique<IO_SELECTED>(STDIN_FILENO);
+    else
+    {
+        _io = std::make_unique<IO_SELECTED>(_sockets.front()->getSocket());
+        _io->addSocket(STDIN_FILENO);
+    }
+
+    ClientManager::CreateInstance(_sockets);
+    _clientManager = &ClientManager::GetInstance();
+    ClientManager::UnlockInstance();
     ResourceManager::CreateInstance();
     GameManager::CreateInstance(gameDir);
+
+    // on io_uring, the first shard has its own thread too: a ring receives the datagrams, not the readiness of stdin
+    for (std::size_t shard = _ioUring ? 0 : 1; shard < _sockets.size(); ++shard)
+        _shardThreads.emplace_back(&UDPServer::runShard, this, shard);
 }
 
 UDPServer::~UDPServer()
 {
+    _running = false;
+    for (auto &thread : _shardThreads)
+        thread.join();
     ClientManager::DestroyInstance();
     ResourceManager::DestroyInstance();
     GameManager::DestroyInstance();
@@ -50,8 +88,7 @@ bool UDPServer::handleTimeout(int event)
     if (event != 0)
         return false;
     FLAKKARI_LOG_DEBUG(LPL_TOSTRING(IO_SELECTED) " timed out");
-    ClientManager::GetInstance().checkInactiveClients();
-    ClientManager::UnlockInstance();
+    _clientManager->checkInactiveClients(0);
     return true;
 }
 
@@ -65,46 +102,155 @@ bool UDPServer::handleInput(int fd)
     return true;
 }
 
-void UDPServer::handlePacket()
+void UDPServer::handlePackets(std::size_t shard)
 {
-    auto packet = _socket->receiveFrom();
-    if (!packet.has_value())
-        return;
-    auto resultAddClient = ClientManager::GetInstance().addClient(packet->first, packet->second);
-    ClientManager::UnlockInstance();
-    if (!resultAddClient.has_value())
+    for (std::size_t batches = 0; batches < MAX_RECEIVE_BATCHES; ++batches)
+    {
+        auto &datagrams = _datagrams[shard];
+        auto received = _sockets[shard]->receiveBatch(*_pools[shard], datagrams, RECEIVE_BATCH_SIZE);
+        if (received == 0)
+            return;
+
+        dispatchClients(_clientManager->receivePackets(datagrams, shard));
+        datagrams.clear(); // the queued packets keep their slabs, the others go back to the pool
+
+        if (received < RECEIVE_BATCH_SIZE)
+            return;
+    }
+}
+
+void UDPServer::dispatchClients(const ClientManager::ReceivedBatch &batch)
+{
+    if (batch.connected.empty() && batch.disconnected.empty())
         return;
 
-    if (!resultAddClient->first.empty())
+    std::vector<Network::Endpoint> rejected;
+    std::vector<std::string> emptyGames;
+
+    auto &gameManager = GameManager::GetInstance();
+    for (const auto &[gameName, client] : batch.connected)
+        if (!gameManager.addClientToGame(gameName, client))
+            rejected.push_back(client->getEndpoint());
+    for (const auto &[gameName, client] : batch.disconnected)
+        if (!gameManager.removeClientFromGame(gameName, client))
+            emptyGames.push_back(gameName);
+    GameManager::UnlockInstance();
+
+    for (const auto &endpoint : rejected)
+        _clientManager->removeClient(endpoint);
+
+    for (const auto &gameName : emptyGames)
+    {
+        ResourceManager::GetInstance().deleteGame(gameName);
+        ResourceManager::UnlockInstance();
+    }
+}
+
+void UDPServer::runShard(std::size_t shard)
+{
+#if defined(_IO_URING_) && defined(__linux__)
+    if (_ioUring)
+        return runShardRing(shard);
+#endif
+    try
     {
-        bool result = GameManager::GetInstance().addClientToGame(resultAddClient->first, resultAddClient->second);
-        GameManager::UnlockInstance();
-        if (!result)
+        IO_SELECTED io(_sockets[shard]->getSocket());
+
+        while (_running.load(std::memory_order_relaxed))
         {
-            ClientManager::GetInstance().removeClient(packet->first->toString().value_or(""));
-            ClientManager::UnlockInstance();
+            int result = io.wait();
+
+            if (result == -1)
+            {
+                if (io.skipableError())
+                    continue;
+                throw std::runtime_error("Failed to poll sockets, error: " + SPECIAL_ERROR);
+            }
+            if (result == 0)
+                _clientManager->checkInactiveClients(shard);
+            else if (io.isReady(_sockets[shard]->getSocket()))
+                handlePackets(shard);
         }
     }
+    catch (const std::exception &e)
+    {
+        FLAKKARI_LOG_ERROR("Shard " + std::to_string(shard) + " stopped: " + e.what());
+    }
+}
 
-    ClientManager::GetInstance().checkInactiveClients();
-    ClientManager::UnlockInstance();
-    if (resultAddClient->first.empty())
+#if defined(_IO_URING_) && defined(__linux__)
+void UDPServer::runShardRing(std::size_t shard)
+{
+    try
     {
-        auto resultRecvClient = ClientManager::GetInstance().receivePacketFromClient(packet->first, packet->second);
-        ClientManager::UnlockInstance();
-        if (!resultRecvClient.has_value())
-            return;
-        bool ret = GameManager::GetInstance().removeClientFromGame(resultRecvClient->first, resultRecvClient->second);
-        GameManager::UnlockInstance();
+        // the ring is set up for a single issuer: it is created by the thread that uses it, with buffers that take
+        // the datagrams of the largest MTU whole, as the recvmmsg path does
+        Network::IO_URING io(1, 0, Network::IO_URING::DEFAULT_ENTRIES, Network::IO_URING::DEFAULT_BUFFER_COUNT,
+                             Network::IO_URING::bufferSizeFor(MAX_DATAGRAM_SIZE));
+        io.addSocket(_sockets[shard]->getSocket());
 
-        if (!ret)
+        while (_running.load(std::memory_order_relaxed))
         {
-            ResourceManager::GetInstance().deleteGame(resultRecvClient->first);
-            ResourceManager::UnlockInstance();
+            int result = io.wait();
+
+            if (result == -1)
+            {
+                if (io.skipableError())
+                    continue;
+                throw std::runtime_error("Failed to wait on the ring, error: " + SPECIAL_ERROR);
+            }
+            if (result == 0)
+                _clientManager->checkInactiveClients(shard);
+            else
+                handleRingPackets(shard, io);
         }
     }
+    catch (const std::exception &e)
+    {
+        FLAKKARI_LOG_ERROR("Shard " + std::to_string(shard) + " stopped: " + e.what());
+    }
 }
 
+void UDPServer::handleRingPackets(std::size_t shard, Network::IO_URING &io)
+{
+    auto &datagrams = _datagrams[shard];
+    Network::BufferSlab *slab = nullptr;
+    std::size_t used = 0;
+
+    for (const auto &datagram : io)
+    {
+        if (datagram.size == 0)
+            continue;
+        // logged at the 1st, 2nd, 4th... drop, so that a sender of large datagrams does not flood the log
+        if (datagram.truncated)
+        {
+            auto count = ++_truncated[shard];
+            if ((count & (count - 1)) == 0)
+                FLAKKARI_LOG_WARNING("Shard " + std::to_string(shard) + " dropped a datagram larger than " +
+                                     std::to_string(MAX_DATAGRAM_SIZE) + " bytes (" + std::to_string(count) +
+                                     " so far)");
+            continue;
+        }
+        if (!slab || used + datagram.size > slab->capacity)
+        {
+            if (slab)
+                Network::BufferPool::release(slab);
+            _pools[shard]->acquire(&slab, 1);
+            used = 0;
+        }
+        std::memcpy(slab->data + used, datagram.data, datagram.size);
+        datagrams.emplace_back(Network::Endpoint::from(datagram.address),
+                               Network::BufferView(slab, slab->data + used, datagram.size));
+        used += datagram.size;
+    }
+    if (slab)
+        Network::BufferPool::release(slab);
+
+    dispatchClients(_clientManager->receivePackets(datagrams, shard));
+    datagrams.clear(); // the queued packets keep their slabs, the others go back to the pool
+}
+#endif
+
 void UDPServer::run()
 {
     INIT_LOOP;
@@ -126,7 +272,7 @@ void UDPServer::run()
             continue;
         if (handleInput((int) fd))
             continue;
-        handlePacket();
+        handlePackets();
     }
     GOTO_LOOP;
 }
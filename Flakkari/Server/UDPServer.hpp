@@ -25,6 +25,9 @@
 #include "Network/IOMultiplexer.hpp"
 #include "Protocol/Packet.hpp"
 
+#include <atomic>
+#include <thread>
+
 namespace Flakkari {
 
 #define INIT_LOOP loop:
@@ -40,15 +43,34 @@ namespace Flakkari {
  * @details This class is the main class of the server, it handles incoming
  * packets and clients, it also handles the client's timeout and disconnection
  *
+ * The server can be split in shards: one socket per shard, all bound to the
+ * same port with SO_REUSEPORT, so that the kernel hashes each client (its
+ * address and port) to one socket and always the same. The first shard runs
+ * in the thread of run() with stdin, each other shard has its own thread and
+ * event loop, and owns its clients in the ClientManager.
+ *
+ * With io_uring (Linux 6.0, when asked and supported), every shard runs in a
+ * thread of its own with a ring that receives the datagrams without a
+ * syscall per batch (see Network::IO_URING), and the thread of run() only
+ * waits on stdin. The datagrams are copied from the buffers of the ring,
+ * which the next wait recycles, into the slabs of the pool of the shard. The
+ * sends stay on the sockets (sendmmsg from the game threads).
+ *
  * @example "Flakkari/Server/UDPServer.cpp"
  * @code
  * #include "UDPServer.hpp"
  *
- * Flakkari::UDPServer server("Games", "localhost", 8081);
+ * Flakkari::UDPServer server("Games", "localhost", 8081, 4);
  * return server.run();
  * @endcode
  */
 class UDPServer {
+public:
+    static constexpr uint32_t RECEIVE_BATCH_SIZE = 64;     // Datagrams received per recvmmsg
+    static constexpr std::size_t MAX_RECEIVE_BATCHES = 16; // Batches received per wake up
+    static constexpr std::size_t RECEIVE_POOL_SLABS = 256; // Receive slabs per shard (see Network::BufferPool)
+    static constexpr std::size_t MAX_DATAGRAM_SIZE = 4096; // Largest datagram received whole (GameSettings::MAX_MTU)
+
 public:
     /**
      * @brief Construct a new UDPServer object
@@ -56,8 +78,11 @@ public:
      * @param gameDir The directory of the games folder
      * @param ip The ip to bind the server to (default: localhost)
      * @param port The port to bind the server to (default: 8081)
+     * @param shards The number of sockets and receive threads (default: 1)
+     * @param ioUring Receive with io_uring if the kernel supports it (default: false)
      */
-    UDPServer(const std::string &gameDir, const std::string &ip = "localhost", unsigned short port = 8081);
+    UDPServer(const std::string &gameDir, const std::string &ip = "localhost", unsigned short port = 8081,
+              std::size_t shards = 1, bool ioUring = false);
     ~UDPServer();
 
     /**
@@ -90,12 +115,67 @@ private:
     /**
      * @brief Handle the incoming packets from the clients (UDP)
      *
+     * @details Drains the socket of a shard in batches of RECEIVE_BATCH_SIZE
+     * datagrams (recvmmsg), up to MAX_RECEIVE_BATCHES batches per wake up so
+     * that stdin and the timeouts are still handled under load. Each batch is
+     * handled under one lock of the shard in the ClientManager. The datagrams
+     * are received in the slabs of the pool of the shard and stay there until
+     * the game threads have handled their packets.
+     *
+     * @param shard  The shard whose socket is readable
+     */
+    void handlePackets(std::size_t shard = 0);
+
+    /**
+     * @brief Event loop of a shard other than the first one, in its own
+     * thread, until the server is destroyed
+     *
+     * @param shard  The shard to run
+     */
+    void runShard(std::size_t shard);
+
+#if defined(_IO_URING_) && defined(__linux__)
+    /**
+     * @brief Event loop of a shard on io_uring, in its own thread, until the
+     * server is destroyed
+     *
+     * @param shard  The shard to run
+     */
+    void runShardRing(std::size_t shard);
+
+    /**
+     * @brief Handle the datagrams received by the ring of a shard: copy them
+     * end to end in slabs of the pool of the shard, since the buffers of the
+     * ring are recycled by the next wait, and hand them to the ClientManager.
+     * A datagram larger than MAX_DATAGRAM_SIZE, truncated by the ring, is
+     * dropped and counted.
+     *
+     * @param shard  The shard of the ring
+     * @param io  The ring, after a wait that received datagrams
      */
-    void handlePacket();
+    void handleRingPackets(std::size_t shard, Network::IO_URING &io);
+#endif
+
+    /**
+     * @brief Add the new clients of a batch to their game and remove the
+     * leaving ones, under one lock of the GameManager
+     *
+     * @param batch  The clients connected and disconnected by a batch
+     */
+    void dispatchClients(const ClientManager::ReceivedBatch &batch);
 
 private:
-    std::shared_ptr<Network::Socket> _socket;
-    std::unique_ptr<IO_SELECTED> _io;
+    using Datagrams = std::vector<std::pair<Network::Endpoint, Network::BufferView>>;
+
+    std::vector<std::shared_ptr<Network::Socket>> _sockets;   // One socket per shard, same port
+    std::vector<std::shared_ptr<Network::BufferPool>> _pools; // Receive slabs of each shard
+    std::vector<Datagrams> _datagrams;                        // Last batch of each shard, reused between batches
+    std::unique_ptr<IO_SELECTED> _io;                         // Event loop of the first shard and stdin
+    ClientManager *_clientManager = nullptr;                  // Used without the lock of the singleton
+    std::vector<std::thread> _shardThreads;                   // Threads of the other shards
+    std::atomic<bool> _running = true;                        // Cleared to stop the threads of the shards
+    bool _ioUring = false;                                    // Every shard receives with io_uring in its thread
+    std::vector<uint64_t> _truncated;                         // Datagrams each ring dropped as too large
 #ifdef FLAKKARI_AUTO_UPDATE
     Internals::GameDownloader _gameDownloader;
 #endif
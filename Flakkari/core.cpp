@@ -13,7 +13,8 @@ int main(int ac, const char *av[])
     {
         Flakkari::ParseArgument parseArg(ac, av);
 
-        Flakkari::UDPServer server(parseArg.getGameDir(), parseArg.getIp(), parseArg.getPort());
+        Flakkari::UDPServer server(parseArg.getGameDir(), parseArg.getIp(), parseArg.getPort(),
+                                   parseArg.getShards(), parseArg.isIoUring());
 
         if (parseArg.isDryRun())
             return 0;
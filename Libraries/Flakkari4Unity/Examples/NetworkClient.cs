@@ -10,6 +10,7 @@ using CurrentProtocol = Flakkari4Unity.Protocol.V1;
 public class NetworkClient : MonoBehaviour
 {
     private UdpClient udpClient;
+    private readonly CurrentProtocol.ReliableChannel channel = new();
     private IPEndPoint serverEndpoint;
     private readonly float keepAliveInterval = 3;
     private string serverIP;
@@ -34,7 +35,7 @@ public class NetworkClient : MonoBehaviour
 
         udpClient.BeginReceive(OnReceive, null);
 
-        byte[] packet = Flk_API.APIClient.ReqConnect(gameName);
+        byte[] packet = channel.Write(Flk_API.APIClient.ReqConnect(gameName));
         udpClient.Send(packet, packet.Length, serverEndpoint);
         InvokeRepeating(nameof(ReqKeepAlive), keepAliveInterval, keepAliveInterval);
     }
@@ -43,6 +44,7 @@ public class NetworkClient : MonoBehaviour
     {
         if (udpClient != null)
         {
+            channel.Write(packet);
             udpClient.Send(packet, packet.Length, serverEndpoint);
         }
         else
@@ -53,7 +55,7 @@ public class NetworkClient : MonoBehaviour
 
     private void ReqKeepAlive()
     {
-        byte[] packet = Flk_API.APIClient.ReqKeepAlive();
+        byte[] packet = channel.Write(Flk_API.APIClient.ReqKeepAlive());
         udpClient.Send(packet, packet.Length, serverEndpoint);
     }
 
@@ -65,7 +67,7 @@ public class NetworkClient : MonoBehaviour
         try
         {
             byte[] receivedData = udpClient.EndReceive(result, ref serverEndpoint);
-            Flk_API.APIClient.Reply(receivedData, out List<CurrentProtocol.CommandId> commandId, out List<ulong> sequenceNumber, out List<byte[]> payload);
+            Flk_API.APIClient.Reply(receivedData, channel, out List<CurrentProtocol.CommandId> commandId, out List<byte[]> payload);
 
             Flakkari4Unity.Synchronizer synchronizer = gameObject.GetComponent<Flakkari4Unity.Synchronizer>();
 
@@ -97,11 +99,22 @@ public class NetworkClient : MonoBehaviour
                         Flk_API.APIClient.ReqEntityMoved(payload[i], ref synchronizer);
                         break;
 
+                    case CurrentProtocol.CommandId.REQ_ENTITIES_MOVED:
+                        Flk_API.APIClient.ReqEntitiesMoved(payload[i], ref synchronizer);
+                        break;
+
                     default:
                         Debug.LogWarning("Unknown command ID received from the server.");
                         break;
                 }
             }
+
+            // the server sends its reliable packets again until they are acked
+            if (channel.NeedsAck)
+            {
+                byte[] ack = channel.WriteAck();
+                udpClient.Send(ack, ack.Length, serverEndpoint);
+            }
         }
         catch (Exception e)
         {
@@ -17,10 +17,12 @@ namespace Flakkari4Unity.API
         /// <returns>A byte array representing the serialized REQ_CONNECT message.</returns>
         public static byte[] ReqConnect(string gameName)
         {
+            byte[] name = System.Text.Encoding.UTF8.GetBytes(gameName);
+
             return CurrentProtocol.Packet.Serialize(
                 CurrentProtocol.Priority.HIGH,
                 CurrentProtocol.CommandId.REQ_CONNECT,
-                System.Text.Encoding.UTF8.GetBytes(gameName)
+                ConcatByteArrays(BitConverter.GetBytes(name.Length), name)
             );
         }
 
@@ -121,7 +123,38 @@ namespace Flakkari4Unity.API
             movable.maxSpeed = BitConverter.ToSingle(payload, i);
         }
 
-        public static byte[] ReqUserUpdates(List<CurrentProtocol.Event> events, Dictionary<CurrentProtocol.EventId, float> axisEvents)
+        public static void ReqEntitiesMoved(byte[] payload, ref Synchronizer synchronizer)
+        {
+            ushort count = BitConverter.ToUInt16(payload, 0);
+            int i = sizeof(ushort);
+
+            for (ushort n = 0; n < count; n++)
+            {
+                ulong entityId = BitConverter.ToUInt64(payload, i);
+                i += sizeof(ulong);
+                // sequence number of the last input applied by the server (client-side prediction)
+                i += sizeof(uint);
+
+                ECS.Entity entity = synchronizer.GetEntity(entityId);
+                Transform transform = entity.transform;
+
+                transform.position = new Vector3(BitConverter.ToSingle(payload, i), BitConverter.ToSingle(payload, i + sizeof(float)), BitConverter.ToSingle(payload, i + sizeof(float) * 2));
+                i += sizeof(float) * 3;
+                transform.rotation = new Quaternion(BitConverter.ToSingle(payload, i), BitConverter.ToSingle(payload, i + sizeof(float)), BitConverter.ToSingle(payload, i + sizeof(float) * 2), BitConverter.ToSingle(payload, i + sizeof(float) * 3));
+                i += sizeof(float) * 4;
+                transform.localScale = new Vector3(BitConverter.ToSingle(payload, i), BitConverter.ToSingle(payload, i + sizeof(float)), BitConverter.ToSingle(payload, i + sizeof(float) * 2));
+                i += sizeof(float) * 3;
+
+                ECS.Components._3D.Movable movable = entity.GetComponent<ECS.Components._3D.Movable>();
+
+                movable.velocity = new Vector3(BitConverter.ToSingle(payload, i), BitConverter.ToSingle(payload, i + sizeof(float)), BitConverter.ToSingle(payload, i + sizeof(float) * 2));
+                i += sizeof(float) * 3;
+                movable.acceleration = new Vector3(BitConverter.ToSingle(payload, i), BitConverter.ToSingle(payload, i + sizeof(float)), BitConverter.ToSingle(payload, i + sizeof(float) * 2));
+                i += sizeof(float) * 3;
+            }
+        }
+
+        public static byte[] ReqUserUpdates(List<CurrentProtocol.Event> events, Dictionary<CurrentProtocol.EventId, float> axisEvents, uint sequence = 0)
         {
             byte[] eventCountBytes = BitConverter.GetBytes((ushort)events.Count);
             byte[] serializedEvents = CurrentProtocol.Event.Serialize(events);
@@ -131,6 +164,8 @@ namespace Flakkari4Unity.API
             byte[] payload = ConcatByteArrays(eventCountBytes, serializedEvents);
             payload = ConcatByteArrays(payload, axisEventCountBytes);
             payload = ConcatByteArrays(payload, serializedAxisEvents);
+            if (sequence != 0)
+                payload = ConcatByteArrays(payload, BitConverter.GetBytes(sequence));
 
             return CurrentProtocol.Packet.Serialize(
                 CurrentProtocol.Priority.HIGH,
@@ -140,25 +175,26 @@ namespace Flakkari4Unity.API
         }
 
         /// <summary>
-        /// Processes the received data and extracts the command ID, sequence number, and message.
+        /// Processes the received data and extracts the command IDs and payloads of the packets to handle.
         /// </summary>
         /// <param name="receivedData">The byte array containing the received data.</param>
+        /// <param name="channel">The reliability layer of the connection, which drops the duplicates, orders the reliable packets and reassembles the fragments.</param>
         /// <param name="commandIds">The extracted command IDs from the received data.</param>
-        /// <param name="sequenceNumbers">The extracted sequence numbers from the received data.</param>
         /// <param name="payloads">The extracted payloads from the received data.</param>
-        public static void Reply(byte[] receivedData, out List<CurrentProtocol.CommandId> commandIds, out List<ulong> sequenceNumbers, out List<byte[]> payloads)
+        /// <remarks>
+        /// Once the packets are handled, the client sends <see cref="CurrentProtocol.ReliableChannel.WriteAck"/>
+        /// if <see cref="CurrentProtocol.ReliableChannel.NeedsAck"/>: the server sends its reliable packets again until they are acked.
+        /// </remarks>
+        public static void Reply(byte[] receivedData, CurrentProtocol.ReliableChannel channel, out List<CurrentProtocol.CommandId> commandIds, out List<byte[]> payloads)
         {
             commandIds = new List<CurrentProtocol.CommandId>();
-            sequenceNumbers = new List<ulong>();
             payloads = new List<byte[]>();
 
             while (receivedData.Length > 0)
             {
-                CurrentProtocol.Packet.Deserialize(receivedData, out CurrentProtocol.CommandId commandId, out ulong sequenceNumber, out byte[] payload);
+                CurrentProtocol.Packet.Deserialize(receivedData, out CurrentProtocol.Header header, out byte[] payload);
 
-                commandIds.Add(commandId);
-                sequenceNumbers.Add(sequenceNumber);
-                payloads.Add(payload);
+                channel.Receive(header, payload, commandIds, payloads);
 
                 int headerSize = Marshal.SizeOf<CurrentProtocol.Header>();
                 receivedData = receivedData.Skip(headerSize + (payload?.Length ?? 0)).ToArray();
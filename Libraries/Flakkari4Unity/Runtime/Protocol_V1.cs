@@ -86,6 +86,22 @@ namespace Flakkari4Unity.Protocol
             /// System command: Response to heartbeat request.
             /// </summary>
             REP_HEARTBEAT = 5,
+            /// <summary>
+            /// System command: Acknowledge the reliable packets of the server, nothing else to send.
+            /// </summary>
+            REQ_ACK = 6,
+            /// <summary>
+            /// System command: Acknowledge the packets of the client, nothing else to send.
+            /// </summary>
+            REP_ACK = 7,
+            /// <summary>
+            /// System command: Fragment of a packet larger than the MTU, sent by the client.
+            /// </summary>
+            REQ_FRAGMENT = 8,
+            /// <summary>
+            /// System command: Fragment of a packet larger than the MTU, sent by the server.
+            /// </summary>
+            REP_FRAGMENT = 9,
 
             /// <summary>
             /// Network command: Request to login.
@@ -203,6 +219,15 @@ namespace Flakkari4Unity.Protocol
             /// </summary>
             REP_END_GAME = 59,
 
+            /// <summary>
+            /// Snapshot command: Request to move a batch of entities.
+            /// </summary>
+            REQ_ENTITIES_MOVED = 60,
+            /// <summary>
+            /// Snapshot command: Response to entities move request.
+            /// </summary>
+            REP_ENTITIES_MOVED = 61,
+
             MAX_COMMAND_ID
         }
 
@@ -360,19 +385,28 @@ namespace Flakkari4Unity.Protocol
         ///  0                   1                   2                   3
         ///  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
         /// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-        /// |Priority| Api V.|   CommandId   |       ContentLength          |
+        /// |Prio.|R| Api V.|   CommandId   |       ContentLength          |
         /// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-        /// |                        SequenceNumber                         |
-        /// |                                                               |
+        /// |           Sequence            |              Ack              |
         /// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        /// |            AckBits            |             Order             |
+        /// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        ///
+        /// The last 8 bytes belong to the reliability layer (see <see cref="ReliableChannel"/>):
+        /// the sequence of the datagram of the packet, the newest sequence received from the peer
+        /// and the 16 before it (bit n of AckBits for Ack - 1 - n), and, for a packet with the
+        /// reliable flag R, its rank among the reliable packets of the connection.
         /// </remarks>
         [StructLayout(LayoutKind.Sequential, Pack = 1)]
         public struct Header
         {
-            public byte priorityAndVersion;  // 4 bits for priority, 4 bits for API version
+            public byte flags;  // 3 bits for priority, 1 bit for the reliable flag, 4 bits for API version
             public CommandId commandId;
             public ushort contentLength;
-            public ulong sequenceNumber;
+            public ushort sequence;
+            public ushort ack;
+            public ushort ackBits;
+            public ushort order;
 
             /// <summary>
             /// Initializes a new instance of the <see cref="Header"/> struct.
@@ -381,24 +415,37 @@ namespace Flakkari4Unity.Protocol
             /// <param name="apiVersion">The API version.</param>
             /// <param name="commandId">The command ID.</param>
             /// <param name="contentLength">The length of the content.</param>
+            /// <remarks>
+            /// The sequence and the acks are stamped by the <see cref="ReliableChannel"/> when the packet is sent.
+            /// </remarks>
             public Header(Priority priority, ApiVersion apiVersion, CommandId commandId, ushort contentLength)
             {
-                priorityAndVersion = (byte)(((int)apiVersion << 4) | ((int)priority & 0x0F));
+                flags = (byte)(((int)apiVersion << 4) | ((int)priority & 0x07));
                 this.commandId = commandId;
                 this.contentLength = contentLength;
-                sequenceNumber = (ulong)DateTimeOffset.UtcNow.ToUnixTimeMilliseconds();
+                sequence = 0;
+                ack = 0;
+                ackBits = 0;
+                order = 0;
             }
 
+            public readonly Priority Priority => (Priority)(flags & 0x07);
+            public readonly bool Reliable => (flags & 0x08) != 0;
+            public readonly ApiVersion ApiVersion => (ApiVersion)(flags >> 4);
+
             /// <summary>
             /// Deserializes the header from a byte array.
             /// </summary>
             /// <param name="packet">The byte array containing the packet data.</param>
             public void Deserialize(byte[] packet)
             {
-                priorityAndVersion = packet[0];
+                flags = packet[0];
                 commandId = (CommandId)packet[1];
                 contentLength = BitConverter.ToUInt16(packet, 2);
-                sequenceNumber = BitConverter.ToUInt64(packet, 4);
+                sequence = BitConverter.ToUInt16(packet, 4);
+                ack = BitConverter.ToUInt16(packet, 6);
+                ackBits = BitConverter.ToUInt16(packet, 8);
+                order = BitConverter.ToUInt16(packet, 10);
             }
 
             /// <summary>
@@ -408,10 +455,13 @@ namespace Flakkari4Unity.Protocol
             public readonly byte[] Serialize()
             {
                 byte[] headerBytes = new byte[Marshal.SizeOf<Header>()];
-                headerBytes[0] = priorityAndVersion;
+                headerBytes[0] = flags;
                 headerBytes[1] = (byte)commandId;
                 BitConverter.GetBytes(contentLength).CopyTo(headerBytes, 2);
-                BitConverter.GetBytes(sequenceNumber).CopyTo(headerBytes, 4);
+                BitConverter.GetBytes(sequence).CopyTo(headerBytes, 4);
+                BitConverter.GetBytes(ack).CopyTo(headerBytes, 6);
+                BitConverter.GetBytes(ackBits).CopyTo(headerBytes, 8);
+                BitConverter.GetBytes(order).CopyTo(headerBytes, 10);
                 return headerBytes;
             }
         }
@@ -446,28 +496,25 @@ namespace Flakkari4Unity.Protocol
             /// Deserializes a packet from a byte array.
             /// </summary>
             /// <param name="packet">The byte array containing the packet data.</param>
-            /// <param name="commandId">The command ID.</param>
-            /// <param name="sequenceNumber">The sequence number.</param>
+            /// <param name="header">The header of the packet.</param>
             /// <param name="payload">The payload of the packet.</param>
-            public static void Deserialize(byte[] packet, out CommandId commandId, out ulong sequenceNumber, out byte[] payload)
+            public static void Deserialize(byte[] packet, out Header header, out byte[] payload)
             {
                 if (packet.Length < Marshal.SizeOf<Header>())
                     throw new ArgumentException("Packet is too short to contain a header.");
 
-                Header header = new();
+                header = new();
                 header.Deserialize(packet);
 
-                if ((ApiVersion)(header.priorityAndVersion >> 4) != ApiVersion.V_1)
-                    throw new ArgumentException("Unsupported API version: " + (ApiVersion)(header.priorityAndVersion >> 4));
+                if (header.ApiVersion != ApiVersion.V_1)
+                    throw new ArgumentException("Unsupported API version: " + header.ApiVersion);
 
-                if ((Priority)(header.priorityAndVersion & 0x0) >= Priority.MAX_PRIORITY)
+                if (header.Priority >= Priority.MAX_PRIORITY)
                     throw new ArgumentException("Priority is out of range.");
 
-                commandId = header.commandId;
-                if (commandId >= CommandId.MAX_COMMAND_ID)
+                if (header.commandId >= CommandId.MAX_COMMAND_ID)
                     throw new ArgumentException("Command ID is out of range.");
 
-                sequenceNumber = header.sequenceNumber;
                 if (header.contentLength > packet.Length - Marshal.SizeOf<Header>())
                     throw new ArgumentException("Content length is out of range : " + header.contentLength + " > " + packet.Length + " - " + Marshal.SizeOf<Header>());
 
@@ -0,0 +1,300 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Runtime.InteropServices;
+
+namespace Flakkari4Unity.Protocol.V1
+{
+    /// <summary>
+    /// Represents the reliability layer of the connection to the server, on top of the packet headers.
+    /// </summary>
+    /// <remarks>
+    /// Every datagram sent gets the next sequence of the connection and carries the acks of the
+    /// datagrams received from the server: the newest sequence received and a bitfield of the 16
+    /// before it. The server sends its reliable packets (REP_CONNECT, spawns, destroys) again until
+    /// they are acked: the channel drops the copies and delivers them once each, in the order of the
+    /// server, holding a packet that arrived ahead of the next one until the gap is filled. The
+    /// fragments (REP_FRAGMENT) of a packet larger than the MTU are put back together before it is
+    /// delivered. When a reliable packet was received and no datagram carried its ack back yet,
+    /// NeedsAck asks the client to send WriteAck (REQ_ACK) if it has nothing else to send.
+    ///
+    /// The packets of the client are sent unreliable. The channel is thread safe: the receive
+    /// callback of the socket and the main thread of Unity both use it.
+    /// </remarks>
+    public class ReliableChannel
+    {
+        /// <summary>
+        /// Sequences acked before the newest one.
+        /// </summary>
+        public const int ACK_BITS = 16;
+        /// <summary>
+        /// Reliable packets held ahead of the next one, the most the server sends unacked.
+        /// </summary>
+        public const int REORDER_WINDOW = 256;
+
+        private readonly object mutex = new();
+        private ushort nextSequence = 1;     // Sequence of the next datagram sent
+        private bool hasRemote = false;      // A packet was received
+        private ushort remoteSequence = 0;   // Newest sequence received
+        private ushort lastSequence = 0;     // Sequence of the last packet received
+        private ushort receivedBits = 0;     // Sequences received before it
+        private bool ackPending = false;     // A reliable packet waits for its ack to be sent
+        private ushort nextDelivery = 0;     // Order of the next reliable packet to deliver
+        private readonly byte[][] held = new byte[REORDER_WINDOW][];        // Payloads received ahead, by order
+        private readonly Header[] heldHeaders = new Header[REORDER_WINDOW]; // Their headers
+        private readonly Reassembler reassembler = new();                   // Fragments of the packets of the server
+
+        /// <summary>
+        /// Gets whether a reliable packet was received and no datagram sent since carried its ack.
+        /// </summary>
+        public bool NeedsAck
+        {
+            get { lock (mutex) return ackPending; }
+        }
+
+        /// <summary>
+        /// Stamps the packets of a datagram with its sequence and the acks to send.
+        /// </summary>
+        /// <param name="datagram">The serialized packets of the datagram, end to end.</param>
+        /// <returns>The datagram, stamped in place.</returns>
+        public byte[] Write(byte[] datagram)
+        {
+            int headerSize = Marshal.SizeOf<Header>();
+
+            lock (mutex)
+            {
+                ushort sequence = nextSequence++;
+
+                for (int offset = 0; offset + headerSize <= datagram.Length;)
+                {
+                    BitConverter.GetBytes(sequence).CopyTo(datagram, offset + 4);
+                    BitConverter.GetBytes(remoteSequence).CopyTo(datagram, offset + 6);
+                    BitConverter.GetBytes(receivedBits).CopyTo(datagram, offset + 8);
+                    offset += headerSize + BitConverter.ToUInt16(datagram, offset + 2);
+                }
+                ackPending = false;
+            }
+            return datagram;
+        }
+
+        /// <summary>
+        /// Creates a REQ_ACK datagram that only carries the acks.
+        /// </summary>
+        /// <returns>A byte array representing the stamped REQ_ACK datagram.</returns>
+        public byte[] WriteAck()
+        {
+            return Write(Packet.Serialize(Priority.LOW, CommandId.REQ_ACK));
+        }
+
+        /// <summary>
+        /// Receives a packet of the server and delivers it unless it is a duplicate: at once if it is
+        /// unreliable, in order if it is reliable (with the reliable packets it was holding back, if any).
+        /// </summary>
+        /// <param name="header">The header of the packet.</param>
+        /// <param name="payload">The payload of the packet.</param>
+        /// <param name="commandIds">The command IDs of the packets delivered.</param>
+        /// <param name="payloads">The payloads of the packets delivered.</param>
+        /// <remarks>
+        /// The packets of a datagram must be received one after the other: they share a sequence.
+        /// </remarks>
+        public void Receive(Header header, byte[] payload, List<CommandId> commandIds, List<byte[]> payloads)
+        {
+            lock (mutex)
+            {
+                // beyond the window the server keeps to: garbage, not recorded so that its datagram is not acked
+                ushort distance = (ushort)(header.order - nextDelivery);
+                if (header.Reliable && distance >= REORDER_WINDOW && distance < 0x8000)
+                    return;
+                bool sameDatagram = hasRemote && header.sequence == lastSequence;
+                if (!Record(header.sequence) && !sameDatagram)
+                    return;
+                lastSequence = header.sequence;
+                if (!header.Reliable)
+                {
+                    Deliver(header, payload, commandIds, payloads);
+                    return;
+                }
+
+                // even a duplicate is acked again: the ack of its first copy was lost
+                ackPending = true;
+                if (distance >= 0x8000)
+                    return;
+                if (distance > 0)
+                {
+                    int slot = header.order % REORDER_WINDOW;
+                    if (held[slot] == null)
+                    {
+                        held[slot] = payload;
+                        heldHeaders[slot] = header;
+                    }
+                    return;
+                }
+
+                Deliver(header, payload, commandIds, payloads);
+                ++nextDelivery;
+                while (held[nextDelivery % REORDER_WINDOW] != null)
+                {
+                    int next = nextDelivery % REORDER_WINDOW;
+                    byte[] nextPayload = held[next];
+                    held[next] = null;
+                    ++nextDelivery;
+                    Deliver(heldHeaders[next], nextPayload, commandIds, payloads);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Records a received sequence in the window of the acks to send.
+        /// </summary>
+        /// <returns>false if the sequence was already received.</returns>
+        private bool Record(ushort sequence)
+        {
+            if (!hasRemote)
+            {
+                hasRemote = true;
+                remoteSequence = sequence;
+                return true;
+            }
+            ushort shift = (ushort)(sequence - remoteSequence);
+            if (shift != 0 && shift < 0x8000)
+            {
+                // the previous newest sequence becomes bit shift - 1
+                receivedBits = shift > ACK_BITS ? (ushort)0 : (ushort)((receivedBits << shift) | (1 << (shift - 1)));
+                remoteSequence = sequence;
+                return true;
+            }
+            if (shift == 0)
+                return false;
+
+            ushort back = (ushort)(remoteSequence - sequence);
+            if (back > ACK_BITS) // older than the window: delivered, but not acked anymore
+                return true;
+            ushort bit = (ushort)(1 << (back - 1));
+            if ((receivedBits & bit) != 0)
+                return false;
+            receivedBits |= bit;
+            return true;
+        }
+
+        /// <summary>
+        /// Hands a packet to the client: the acks alone are dropped and the fragments are put back together.
+        /// </summary>
+        private void Deliver(Header header, byte[] payload, List<CommandId> commandIds, List<byte[]> payloads)
+        {
+            if (header.commandId == CommandId.REP_ACK)
+                return;
+            if (header.commandId == CommandId.REP_FRAGMENT)
+            {
+                byte[] whole = reassembler.Add(payload, header.Reliable);
+                if (whole == null)
+                    return;
+                Packet.Deserialize(whole, out Header wholeHeader, out byte[] wholePayload);
+                Deliver(wholeHeader, wholePayload, commandIds, payloads);
+                return;
+            }
+            commandIds.Add(header.commandId);
+            payloads.Add(payload);
+        }
+    }
+
+    /// <summary>
+    /// Represents the reassembly buffer of the fragments of the packets larger than the MTU.
+    /// </summary>
+    /// <remarks>
+    /// The payload of a fragment is its header (message: ushort, index: byte, count: byte), then a
+    /// slice of the serialized packet. The fragments of an unreliable packet that do not all come
+    /// within TIMEOUT_MS are dropped, and MAX_MESSAGES packets are held at once, the oldest
+    /// unreliable one being dropped to make room for a newer one.
+    /// </remarks>
+    public class Reassembler
+    {
+        /// <summary>
+        /// Time the fragments of an unreliable packet have to come.
+        /// </summary>
+        public const long TIMEOUT_MS = 1000;
+        /// <summary>
+        /// Packets held at once.
+        /// </summary>
+        public const int MAX_MESSAGES = 8;
+
+        private const int FRAGMENT_HEADER_SIZE = sizeof(ushort) + sizeof(byte) + sizeof(byte);
+
+        private class Partial
+        {
+            public bool reliable;   // Its fragments are reliable: it does not expire
+            public long startedAt;  // Time its first fragment came
+            public int received;    // Fragments received
+            public byte[][] slices; // Slices by index (null until received)
+        }
+
+        private readonly Dictionary<ushort, Partial> partials = new();
+        private readonly Stopwatch clock = Stopwatch.StartNew();
+
+        /// <summary>
+        /// Adds a fragment.
+        /// </summary>
+        /// <param name="payload">The payload of the fragment packet.</param>
+        /// <param name="reliable">Whether the fragment packet has the reliable flag.</param>
+        /// <returns>The serialized packet if it was the last fragment missing, null otherwise.</returns>
+        public byte[] Add(byte[] payload, bool reliable)
+        {
+            long now = clock.ElapsedMilliseconds;
+            List<ushort> expired = new();
+            foreach (KeyValuePair<ushort, Partial> partial in partials)
+                if (!partial.Value.reliable && now - partial.Value.startedAt > TIMEOUT_MS)
+                    expired.Add(partial.Key);
+            foreach (ushort key in expired)
+                partials.Remove(key);
+
+            if (payload.Length <= FRAGMENT_HEADER_SIZE)
+                return null;
+            ushort message = BitConverter.ToUInt16(payload, 0);
+            byte index = payload[2];
+            byte count = payload[3];
+            if (count == 0 || index >= count)
+                return null;
+            byte[] slice = new byte[payload.Length - FRAGMENT_HEADER_SIZE];
+            Buffer.BlockCopy(payload, FRAGMENT_HEADER_SIZE, slice, 0, slice.Length);
+            if (count == 1)
+                return slice;
+
+            // the id was reused by a newer packet: the old one will never be complete
+            if (partials.TryGetValue(message, out Partial current) && (current.slices.Length != count || current.reliable != reliable))
+                partials.Remove(message);
+            if (!partials.TryGetValue(message, out current))
+            {
+                // the oldest unreliable packet is dropped to make room, never a reliable one
+                while (partials.Count >= MAX_MESSAGES)
+                {
+                    ushort? oldest = null;
+                    foreach (KeyValuePair<ushort, Partial> partial in partials)
+                        if (!partial.Value.reliable && (oldest == null || partial.Value.startedAt < partials[oldest.Value].startedAt))
+                            oldest = partial.Key;
+                    if (oldest == null)
+                        return null;
+                    partials.Remove(oldest.Value);
+                }
+                current = new Partial { reliable = reliable, startedAt = now, received = 0, slices = new byte[count][] };
+                partials.Add(message, current);
+            }
+            if (current.slices[index] != null)
+                return null;
+            current.slices[index] = slice;
+            if (++current.received < count)
+                return null;
+
+            int size = 0;
+            foreach (byte[] part in current.slices)
+                size += part.Length;
+            byte[] packet = new byte[size];
+            int offset = 0;
+            foreach (byte[] part in current.slices)
+            {
+                Buffer.BlockCopy(part, 0, packet, offset, part.Length);
+                offset += part.Length;
+            }
+            partials.Remove(message);
+            return packet;
+        }
+    }
+}
@@ -0,0 +1,170 @@
+/*
+** EPITECH PROJECT, 2024
+** Title: Flakkari
+** Author: MasterLaplace
+** Created: 2024-10-19
+** File description:
+** reliability: delivery of the reliable packets of a ReliableChannel over a lossy link that reorders
+*/
+
+#include "Protocol/Packet.hpp"
+#include "Protocol/Reliability.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+
+namespace {
+
+using Flakkari::Network::Buffer;
+using Flakkari::Protocol::CommandId;
+using Packet = Flakkari::Protocol::Packet<CommandId>;
+using Channel = Flakkari::Protocol::ReliableChannel<CommandId, Packet>;
+using Clock = Channel::Clock;
+
+constexpr uint32_t PACKETS = 100000;              // Reliable packets sent, the 16 bits orders wrap once
+constexpr uint32_t BURST = 700;                   // Packets written at once, more than the window of the peer
+constexpr uint32_t BURST_EVERY = 5000;            // Steps between two bursts
+constexpr int LOSS = 20;                          // Percent of the datagrams lost, each way
+constexpr int DUPLICATION = 2;                    // Percent of the datagrams received twice
+constexpr int MIN_DELAY = 5;                      // Milliseconds of the shortest trip
+constexpr int MAX_DELAY = 40;                     // Milliseconds of the longest trip: the datagrams are reordered
+constexpr uint32_t MAX_STEPS = 10 * 60 * 1000;    // Milliseconds simulated at most
+constexpr std::size_t MTU = 1200;                 // Bytes of a datagram at most
+constexpr auto STEP = std::chrono::milliseconds(1);
+
+/**
+ * @brief One way of the link: drops, duplicates and delays the datagrams
+ */
+class Link {
+public:
+    explicit Link(uint32_t seed) : _random(seed) {}
+
+    void push(Buffer &&datagram, Clock::time_point now)
+    {
+        if (datagram.empty() || chance(LOSS))
+            return;
+        if (chance(DUPLICATION))
+            _flying.emplace(now + delay(), datagram);
+        _flying.emplace(now + delay(), std::move(datagram));
+    }
+
+    template <typename Receive> void deliver(Clock::time_point now, Receive &&receive)
+    {
+        while (!_flying.empty() && _flying.begin()->first <= now)
+        {
+            auto datagram = std::move(_flying.begin()->second);
+            _flying.erase(_flying.begin());
+            receive(datagram);
+        }
+    }
+
+private:
+    bool chance(int percent) { return static_cast<int>(_random() % 100) < percent; }
+    std::chrono::milliseconds delay()
+    {
+        return std::chrono::milliseconds(MIN_DELAY + _random() % (MAX_DELAY - MIN_DELAY));
+    }
+
+    std::mt19937 _random;
+    std::multimap<Clock::time_point, Buffer> _flying; // Datagrams on the way, by arrival time
+};
+
+/**
+ * @brief Hand the packets of a datagram, end to end, to a channel
+ */
+template <typename Deliver>
+bool receive(Channel &channel, const Buffer &datagram, Clock::time_point now, Deliver &&deliver)
+{
+    for (std::size_t offset = 0; offset < datagram.size();)
+    {
+        Packet packet;
+        if (!Flakkari::Protocol::readHeader(packet.header, datagram.data() + offset, datagram.size() - offset))
+            return false;
+        auto payload = datagram.data() + offset + packet.header.size();
+        packet.payload.assign(payload, payload + packet.header._contentLength);
+        offset += packet.size();
+        channel.receive(std::move(packet), now, deliver);
+    }
+    return true;
+}
+
+Packet numbered(uint32_t number)
+{
+    Packet packet;
+    packet.header._commandId = CommandId::REQ_USER_UPDATES;
+    packet.header._reliable = true;
+    packet << number;
+    return packet;
+}
+
+} // namespace
+
+int main()
+{
+    Channel sender;
+    Channel receiver;
+    Link uplink(1);
+    Link downlink(2);
+    auto now = Clock::time_point{} + std::chrono::hours(1);
+    uint32_t written = 0;
+    uint32_t delivered = 0;
+    std::size_t mostWaiting = 0;
+    std::string error;
+
+    auto check = [&](Packet &packet) {
+        uint32_t number = 0;
+        if (packet.payload.size() == sizeof(number))
+            std::memcpy(&number, packet.payload.data(), sizeof(number));
+        if (error.empty() && number != delivered)
+            error = "packet " + std::to_string(number) + " delivered instead of " + std::to_string(delivered);
+        ++delivered;
+    };
+    auto ignore = [](Packet &) {};
+
+    uint32_t step = 0;
+    for (; step < MAX_STEPS && delivered < PACKETS && error.empty(); ++step, now += STEP)
+    {
+        uplink.deliver(now, [&](const Buffer &datagram) { receive(receiver, datagram, now, check); });
+        downlink.deliver(now, [&](const Buffer &datagram) { receive(sender, datagram, now, ignore); });
+
+        // a packet a step, its retransmissions first, and a burst from time to time
+        Buffer datagram;
+        sender.writeRetransmissions(datagram, now, MTU);
+        uint32_t count = step % BURST_EVERY == BURST_EVERY - 1 ? BURST : 1;
+        for (uint32_t i = 0; i < count && written < PACKETS; ++i, ++written)
+        {
+            if (datagram.size() + numbered(written).size() > MTU)
+                uplink.push(std::move(datagram), now), datagram = Buffer();
+            sender.write(datagram, numbered(written).serialize(), now);
+        }
+        uplink.push(std::move(datagram), now);
+
+        if (sender.getPendingCount() > Channel::REORDER_WINDOW)
+            error = std::to_string(sender.getPendingCount()) + " reliable packets unacked, more than the window";
+        mostWaiting = std::max(mostWaiting, sender.getWaitingCount());
+
+        // the receiver acks every step, as a tick of the server
+        Buffer ack;
+        if (receiver.needsAck())
+            receiver.writeAck(ack, CommandId::REP_ACK, now);
+        downlink.push(std::move(ack), now);
+    }
+
+    if (error.empty() && delivered != PACKETS)
+        error = std::to_string(delivered) + " packets delivered out of " + std::to_string(PACKETS);
+    if (error.empty() && mostWaiting == 0)
+        error = "the window of the sender was never full";
+
+    auto stats = sender.getStats();
+    std::cout << delivered << " packets delivered in order in " << step << " ms, " << stats.retransmitted
+              << " retransmissions, " << mostWaiting << " packets waiting for the window at most" << std::endl;
+    if (!error.empty())
+    {
+        std::cerr << "FAILED: " << error << std::endl;
+        return 84;
+    }
+    return 0;
+}
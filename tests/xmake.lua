@@ -0,0 +1,25 @@
+-- Loss and reorder simulation of the reliability layer (xmake test)
+target("flakkari-test-reliability")
+    set_kind("binary")
+    set_default(false)
+    set_languages("cxx20")
+    set_policy("build.warning", true)
+
+    add_files("reliability/main.cpp")
+    add_files("$(projectdir)/Flakkari/Logger/Logger.cpp")
+    add_files("$(projectdir)/Flakkari/Network/Buffer.cpp")
+    add_files("$(projectdir)/Flakkari/Network/Kernels.cpp")
+
+    add_includedirs("$(projectdir)/Flakkari")
+
+    add_tests("default")
+
+    if is_mode("debug") then
+        add_defines("_DEBUG")
+        set_symbols("debug")
+        set_optimize("none")
+    elseif is_mode("release") then
+        add_defines("NDEBUG")
+        set_optimize("fastest")
+    end
+target_end()
@@ -0,0 +1,178 @@
+/*
+** EPITECH PROJECT, 2024
+** Title: Flakkari
+** Author: MasterLaplace
+** Created: 2024-10-19
+** File description:
+** bench_buffer: micro-benchmarks of the byte kernels of the buffers
+*/
+
+#include "Network/Kernels.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace Flakkari::Network;
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t SIZES[] = {16, 64, 256, 1200, 16384}; // Bytes per call: headers, datagrams, a large message
+constexpr uint32_t CHECK = 0xE3069283;                      // CRC32C of "123456789"
+
+volatile uint32_t sink; // Results of the kernels, so that their calls are not optimized out
+
+/**
+ * @brief Call `kernel` for `duration`, and give the nanoseconds per call
+ */
+template <typename Kernel> double measure(const Kernel &kernel, std::chrono::milliseconds duration)
+{
+    uint64_t calls = 0;
+    auto start = Clock::now();
+    auto end = start + duration;
+    auto now = start;
+
+    // check the clock every 64 calls only: reading it costs as much as a small kernel
+    for (; now < end; now = Clock::now())
+    {
+        for (int i = 0; i < 64; ++i)
+            kernel();
+        calls += 64;
+    }
+    return std::chrono::duration<double, std::nano>(now - start).count() / static_cast<double>(calls);
+}
+
+/**
+ * @brief The byte-wise 16 bits sum that the checksum of the buffers was
+ * before the CRC32C, as a reference
+ */
+uint16_t sum16(const byte *data, std::size_t size)
+{
+    uint16_t sum = 0;
+
+    for (std::size_t i = 0; i < size; ++i)
+        sum += data[i];
+    return sum;
+}
+
+/**
+ * @brief Check the kernels against the portable ones, on every size and
+ * alignment up to 100 bytes and on the sizes of the benchmark
+ */
+bool check(const Kernels &kernels, const std::vector<byte> &data, const std::vector<byte> &key)
+{
+    const Kernels &reference = *Kernels::getSupported().front();
+    auto digits = reinterpret_cast<const byte *>("123456789");
+
+    if (kernels.crc32c(0, digits, 9) != CHECK || kernels.crc32c(kernels.crc32c(0, digits, 4), digits + 4, 5) != CHECK)
+        return false;
+
+    std::vector<std::size_t> sizes(std::begin(SIZES), std::end(SIZES));
+    for (std::size_t size = 0; size <= 100; ++size)
+        sizes.push_back(size);
+    for (std::size_t size : sizes)
+    {
+        for (std::size_t offset = 0; offset < 8; ++offset)
+        {
+            const byte *src = data.data() + offset;
+            std::vector<byte> expected(src, src + size);
+            std::vector<byte> actual(src, src + size);
+            std::vector<byte> hex(2 * size);
+            std::vector<byte> back(size);
+
+            reference.bitwiseXOR(expected.data(), key.data(), size);
+            kernels.bitwiseXOR(actual.data(), key.data(), size);
+            kernels.toHex(src, size, hex.data());
+            if (kernels.crc32c(0, src, size) != reference.crc32c(0, src, size) || actual != expected)
+                return false;
+            for (std::size_t i = 0; i < 2 * size; ++i)
+                if (hex[i] != static_cast<byte>("0123456789abcdef"[i % 2 ? src[i / 2] & 15 : src[i / 2] >> 4]))
+                    return false;
+            if (!kernels.fromHex(hex.data(), size, back.data()) || !std::equal(back.begin(), back.end(), src))
+                return false;
+            for (std::size_t i = 0; i < 2 * size; ++i)
+                hex[i] = static_cast<byte>(std::toupper(hex[i]));
+            if (!kernels.fromHex(hex.data(), size, back.data()) || !std::equal(back.begin(), back.end(), src))
+                return false;
+            if (size > 0)
+            {
+                hex[(offset * 7) % (2 * size)] = 'g';
+                if (kernels.fromHex(hex.data(), size, back.data()))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+void print(const std::string &kernel, const std::string &name, std::size_t size, double nanoseconds)
+{
+    std::cout << std::left << std::setw(10) << kernel << std::setw(10) << name << std::right << std::setw(7) << size
+              << std::fixed << std::setprecision(1) << std::setw(12) << nanoseconds << " ns" << std::setw(10)
+              << static_cast<double>(size) / nanoseconds << " GB/s" << std::endl;
+}
+
+} // namespace
+
+int main(int ac, const char *av[])
+{
+    std::chrono::milliseconds duration(ac > 1 ? std::max(1, std::atoi(av[1])) : 200);
+    std::mt19937 random(42);
+    std::vector<byte> data(SIZES[std::size(SIZES) - 1] + 8);
+    std::vector<byte> key(data.size());
+    std::vector<byte> hex(2 * data.size());
+    std::vector<byte> binary(data.size());
+
+    for (auto &value : data)
+        value = static_cast<byte>(random());
+    for (auto &value : key)
+        value = static_cast<byte>(random());
+
+    std::cout << "Kernels of the CPU: " << Kernels::get().name << ", " << duration.count() << " ms per measure"
+              << std::endl;
+    for (const Kernels *kernels : Kernels::getSupported())
+    {
+        if (!check(*kernels, data, key))
+        {
+            std::cerr << "The " << kernels->name << " kernels give wrong results" << std::endl;
+            return 84;
+        }
+    }
+
+    std::cout << std::left << std::setw(10) << "kernel" << std::setw(10) << "set" << std::right << std::setw(7)
+              << "bytes" << std::setw(15) << "per call" << std::setw(15) << "throughput" << std::endl;
+    for (std::size_t size : SIZES)
+    {
+        print("sum16", "scalar", size, measure([&] { sink = sink + sum16(data.data(), size); }, duration));
+        for (const Kernels *kernels : Kernels::getSupported())
+            print("crc32c", kernels->name, size,
+                  measure([&] { sink = kernels->crc32c(sink, data.data(), size); }, duration));
+    }
+    for (std::size_t size : SIZES)
+    {
+        for (const Kernels *kernels : Kernels::getSupported())
+            print("xor", kernels->name, size,
+                  measure([&] { kernels->bitwiseXOR(data.data(), key.data(), size); }, duration));
+    }
+    for (std::size_t size : SIZES)
+    {
+        for (const Kernels *kernels : Kernels::getSupported())
+            print("toHex", kernels->name, size,
+                  measure([&] { kernels->toHex(data.data(), size, hex.data()); }, duration));
+    }
+    Kernels::get().toHex(data.data(), data.size(), hex.data());
+    for (std::size_t size : SIZES)
+    {
+        for (const Kernels *kernels : Kernels::getSupported())
+            print("fromHex", kernels->name, size,
+                  measure([&] { sink = sink + kernels->fromHex(hex.data(), size, binary.data()); }, duration));
+    }
+    return 0;
+}
@@ -0,0 +1,280 @@
+/*
+** EPITECH PROJECT, 2024
+** Title: Flakkari
+** Author: MasterLaplace
+** Created: 2024-10-19
+** File description:
+** bench_io: loopback benchmarks of the IO multiplexers and of the UDP offloads
+*/
+
+#include "Network/IOMultiplexer.hpp"
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#if defined(_IO_URING_) && defined(__linux__)
+#    include <atomic>
+#    include <chrono>
+#    include <cstring>
+#    include <ctime>
+#    include <thread>
+#    include <vector>
+
+namespace {
+
+using namespace Flakkari::Network;
+
+constexpr std::size_t SEND_BATCH = 64; // Datagrams sent per sendmmsg by the load thread
+
+struct Result {
+    uint64_t sent = 0;     // Datagrams sent by the load thread
+    uint64_t packets = 0;  // Datagrams received and echoed
+    uint64_t syscalls = 0; // System calls made by the receiver
+    double seconds = 0;    // Wall time of the run
+    double cpu = 0;        // CPU time of the receiver thread, in seconds
+};
+
+double threadCpu()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Blast datagrams of `size` bytes at `target` with sendmmsg until
+ * `stop` is set. The echoes are ignored (the kernel drops them).
+ */
+void load(const sockaddr_in &target, std::size_t size, const std::atomic<bool> &stop, uint64_t &sent)
+{
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    std::vector<byte> payload(size, 0x42);
+    std::vector<mmsghdr> messages(SEND_BATCH);
+    iovec vector{payload.data(), payload.size()};
+
+    for (auto &message : messages)
+    {
+        message = {};
+        message.msg_hdr.msg_name = const_cast<sockaddr_in *>(&target);
+        message.msg_hdr.msg_namelen = sizeof(target);
+        message.msg_hdr.msg_iov = &vector;
+        message.msg_hdr.msg_iovlen = 1;
+    }
+    while (!stop.load(std::memory_order_relaxed))
+        sent += static_cast<uint64_t>(std::max(::sendmmsg(fd, messages.data(), SEND_BATCH, 0), 0));
+    ::close(fd);
+}
+
+sockaddr_in localAddress(int fd)
+{
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+    ::getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length);
+    return address;
+}
+
+/**
+ * @brief The path of the server: PSELECT wakes up the loop, which reads one
+ * datagram with Socket::receiveFrom and answers with Socket::sendTo.
+ */
+Result runPselect(std::size_t size, double seconds)
+{
+    auto socket = std::make_shared<Socket>();
+    socket->create("127.0.0.1", 0, Address::IpType::IPv4, Address::SocketType::UDP);
+    socket->bind();
+
+    PSELECT io(socket->getSocket(), 0, 100000);
+    std::atomic<bool> stop = false;
+    Result result;
+    std::thread sender(load, localAddress(socket->getSocket()), size, std::cref(stop), std::ref(result.sent));
+    double cpu = threadCpu();
+    auto start = std::chrono::steady_clock::now();
+
+    while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < seconds)
+    {
+        ++result.syscalls;
+        if (io.wait() <= 0 || !io.isReady(socket->getSocket()))
+            continue;
+        auto packet = socket->receiveFrom();
+        ++result.syscalls;
+        if (!packet.has_value())
+            continue;
+        socket->sendTo(packet->first, packet->second.data(), size);
+        ++result.syscalls;
+        ++result.packets;
+    }
+    result.cpu = threadCpu() - cpu;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stop = true;
+    sender.join();
+    return result;
+}
+
+/**
+ * @brief IO_URING: multishot recvmsg into the provided buffers, the echoes
+ * are queued as sendmsg and submitted with the next wait.
+ */
+Result runUring(std::size_t size, double seconds)
+{
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+
+    IO_URING io(fd, 0, 100000);
+    std::atomic<bool> stop = false;
+    Result result;
+    std::thread sender(load, localAddress(fd), size, std::cref(stop), std::ref(result.sent));
+    double cpu = threadCpu();
+    auto start = std::chrono::steady_clock::now();
+
+    while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < seconds)
+    {
+        if (io.wait() <= 0)
+            continue;
+        for (const auto &datagram : io)
+        {
+            io.sendTo(datagram.socket, datagram.address, datagram.addressLength, datagram.data, datagram.size);
+            ++result.packets;
+        }
+    }
+    io.flush();
+    result.cpu = threadCpu() - cpu;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.syscalls = io.getSyscallCount() + io.getDirectSendCount();
+    stop = true;
+    sender.join();
+    ::close(fd);
+    return result;
+}
+
+struct OffloadResult {
+    double sentRate = 0;     // Datagrams sent per second
+    double sendCpu = 0;      // CPU time of the sender per datagram, in nanoseconds
+    double receivedRate = 0; // Datagrams received per second
+    double receiveCpu = 0;   // CPU time of the receiver per datagram, in nanoseconds
+};
+
+/**
+ * @brief Send batches of `segments` datagrams of `size` bytes to one address
+ * with Socket::sendBatch, GSO on or off, to a receiver draining its socket
+ * with Socket::receiveBatch, GRO on or off.
+ */
+OffloadResult runOffload(std::size_t size, std::size_t segments, double seconds, bool gso, bool gro)
+{
+    auto receiver = std::make_shared<Socket>();
+    receiver->create("127.0.0.1", 0, Address::IpType::IPv4, Address::SocketType::UDP);
+    receiver->bind();
+    receiver->setBlocking(false);
+    if (gro && !receiver->enableGro())
+        return {};
+
+    auto sender = std::make_shared<Socket>();
+    sender->create("127.0.0.1", 0, Address::IpType::IPv4, Address::SocketType::UDP);
+    if (gso && !sender->enableGso())
+        return {};
+
+    auto target = std::make_shared<Address>(localAddress(receiver->getSocket()), Address::SocketType::UDP,
+                                            Address::IpType::IPv4);
+    std::vector<std::pair<std::shared_ptr<Address>, Buffer>> batch(segments, {target, Buffer(size, 0x42)});
+    std::atomic<bool> stop = false;
+    uint64_t received = 0;
+    double receiveCpu = 0;
+
+    std::thread receiving([&] {
+        PSELECT io(receiver->getSocket(), 0, 10000);
+        double cpu = threadCpu();
+
+        while (!stop.load(std::memory_order_relaxed))
+            if (io.wait() > 0)
+                received += receiver->receiveBatch(64).size();
+        receiveCpu = threadCpu() - cpu;
+    });
+
+    uint64_t sent = 0;
+    double cpu = threadCpu();
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < seconds)
+        sent += sender->sendBatch(batch, MSG_DONTWAIT);
+    double sendCpu = threadCpu() - cpu;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stop = true;
+    receiving.join();
+
+    return {static_cast<double>(sent) / elapsed, sendCpu * 1e9 / static_cast<double>(std::max<uint64_t>(sent, 1)),
+            static_cast<double>(received) / elapsed,
+            receiveCpu * 1e9 / static_cast<double>(std::max<uint64_t>(received, 1))};
+}
+
+void print(const std::string &name, const OffloadResult &result)
+{
+    if (result.sentRate == 0)
+    {
+        std::cout << std::left << std::setw(12) << name << "not supported by this kernel" << std::endl;
+        return;
+    }
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(0)
+              << std::setw(12) << result.sentRate << std::setw(14) << std::setprecision(1) << result.sendCpu
+              << std::setw(12) << std::setprecision(0) << result.receivedRate << std::setw(14)
+              << std::setprecision(1) << result.receiveCpu << std::endl;
+}
+
+void print(const std::string &name, const Result &result)
+{
+    double packets = static_cast<double>(std::max<uint64_t>(result.packets, 1));
+
+    std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(0)
+              << std::setw(12) << static_cast<double>(result.sent) / result.seconds << std::setw(12)
+              << static_cast<double>(result.packets) / result.seconds << std::setw(14)
+              << std::setprecision(1) << result.cpu * 1e9 / packets << std::setw(16) << std::setprecision(3)
+              << static_cast<double>(result.syscalls) / packets << std::endl;
+}
+
+} // namespace
+
+int main(int ac, const char *av[])
+{
+    if (ac > 1 && std::string(av[1]) == "gso")
+    {
+        double seconds = ac > 2 ? std::stod(av[2]) : 3.0;
+        std::size_t size = ac > 3 ? std::stoul(av[3]) : 1200;
+        std::size_t segments = ac > 4 ? std::stoul(av[4]) : 16;
+
+        std::cout << "loopback, batches of " << segments << " datagrams of " << size << " bytes to one address, "
+                  << seconds << " s per mode" << std::endl;
+        std::cout << std::left << std::setw(12) << "mode" << std::right << std::setw(12) << "tx pps" << std::setw(14)
+                  << "tx ns/dgram" << std::setw(12) << "rx pps" << std::setw(14) << "rx ns/dgram" << std::endl;
+        print("plain", runOffload(size, segments, seconds, false, false));
+        print("gso", runOffload(size, segments, seconds, true, false));
+        print("gso+gro", runOffload(size, segments, seconds, true, true));
+        return 0;
+    }
+
+    double seconds = ac > 1 ? std::stod(av[1]) : 3.0;
+    std::size_t size = ac > 2 ? std::stoul(av[2]) : 64;
+
+    std::cout << "loopback echo, " << size << " byte datagrams, " << seconds << " s per multiplexer" << std::endl;
+    std::cout << std::left << std::setw(10) << "path" << std::right << std::setw(12) << "tx pps" << std::setw(12)
+              << "rx pps" << std::setw(14)
+              << "cpu ns/pkt" << std::setw(16) << "syscalls/pkt" << std::endl;
+    print("pselect", runPselect(size, seconds));
+    if (!IO_URING::isSupported())
+    {
+        std::cout << "io_uring: not supported by this kernel (multishot recvmsg and buffer rings)" << std::endl;
+        return 0;
+    }
+    print("io_uring", runUring(size, seconds));
+    return 0;
+}
+
+#else
+
+int main()
+{
+    std::cerr << "bench_io needs io_uring (Linux)" << std::endl;
+    return 1;
+}
+
+#endif
@@ -0,0 +1,574 @@
+/*
+** EPITECH PROJECT, 2024
+** Title: Flakkari
+** Author: MasterLaplace
+** Created: 2024-10-19
+** File description:
+** bots: drive many simulated players against a server from one process
+*/
+
+#include "Client/Connection.hpp"
+#include "Network/LinkSimulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#    include <cerrno>
+#    include <cstring>
+#    include <netdb.h>
+#    include <sys/epoll.h>
+#    include <sys/socket.h>
+#    include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using CommandId = Flakkari::Protocol::CommandId;
+using EventId = Flakkari::Protocol::EventId;
+using EventState = Flakkari::Protocol::EventState;
+using Packet = Flakkari::Protocol::Packet<CommandId>;
+using Buffer = Flakkari::Network::Buffer;
+using Link = Flakkari::Network::LinkSimulator<std::pair<std::size_t, Buffer>>;
+
+constexpr std::size_t RECV_BATCH = 32;                              // Datagrams read per recvmmsg
+constexpr std::size_t RECV_SIZE = 65536;                            // Size of a receive buffer
+constexpr auto KEEP_ALIVE_INTERVAL = std::chrono::seconds(3);       // Idle time before a heartbeat of the connection
+constexpr auto HEARTBEAT_INTERVAL = std::chrono::milliseconds(500); // Interval of the RTT probes
+constexpr auto REPORT_INTERVAL = std::chrono::seconds(1);           // Interval of the statistics lines
+constexpr int MOVE_TICKS = 30;                                      // Ticks spent moving in one direction
+constexpr int SHOOT_TICKS = 20;                                     // Ticks between two shots
+
+struct Settings {
+    std::string game;      // Name of the game to join
+    std::string ip;        // Address of the server
+    std::string port;      // Port of the server
+    std::size_t bots = 1;  // Number of simulated players
+    double seconds = 10;   // Duration of the run
+    double inputRate = 60; // Inputs sent per second by each bot
+    double loss = 0;       // Probability that a datagram is lost, each way (a tenth of it are duplicated)
+    double latency = 0;    // Latency (ms) added each way, with a jitter of half of it
+    double bandwidth = 0;  // Bandwidth (KiB/s) of the link from the server, shared by the bots (0: no limit)
+    std::string capture;   // File the datagrams of the server are written to (empty: none)
+    bool checksum = false; // CRC32C trailer on every datagram, both ways
+};
+
+/**
+ * @brief A simulated player: the protocol is the one of UDPClient (a
+ * Connection), the socket is driven by the swarm
+ */
+struct Bot {
+    Bot(const std::string &game, bool checksum)
+        : connection(
+              game, KEEP_ALIVE_INTERVAL, [this](const Buffer &datagram) { outbox.push_back(datagram); }, checksum)
+    {
+    }
+
+    int fd = -1;                     // Socket connected to the server
+    bool connecting = false;         // REQ_CONNECT was sent
+    uint32_t sequence = 0;           // Sequence number of the last input
+    Clock::time_point heartbeatSent; // Time of the pending heartbeat
+    bool heartbeatPending = false;   // A heartbeat waits for its REP_HEARTBEAT
+    Clock::time_point nextHeartbeat; // Time of the next heartbeat
+    int direction = -1;              // MOVE_* event currently pressed
+    std::vector<double> rtt;         // RTT samples (ms) of the current report
+    std::vector<Buffer> outbox;      // Datagrams written by the connection, sent with the next tick
+    Flakkari::Connection connection; // Reliability, fragments and compression of the connection
+};
+
+struct Counters {
+    uint64_t datagramsIn = 0;  // Datagrams received (the server sends at most one per client and tick)
+    uint64_t datagramsOut = 0; // Datagrams sent
+    uint64_t bytesIn = 0;      // Bytes received
+    uint64_t bytesOut = 0;     // Bytes sent
+    uint64_t updates = 0;      // REQ_ENTITIES_MOVED packets received
+    uint64_t inputs = 0;       // REQ_USER_UPDATES packets sent
+    uint64_t dropped = 0;      // Datagrams the kernel refused to send
+};
+
+struct Swarm {
+    Settings settings;
+    std::deque<Bot> bots;           // A bot does not move: its connection writes to its outbox
+    int epoll = -1;
+    Counters total;                 // Counters of the whole run
+    Counters report;                // Counters of the current report
+    std::vector<double> rttAll;     // RTT samples (ms) of the whole run
+    std::unique_ptr<Link> uplink;   // Simulated link from the bots to the server
+    std::unique_ptr<Link> downlink; // Simulated link from the server to the bots
+    uint64_t packedBytes = 0;       // Bytes of the compressed datagrams received
+    uint64_t unpackedBytes = 0;     // Bytes of the same datagrams once decompressed
+    std::ofstream capture;          // Datagrams of the server, decompressed (uint16 size, bytes)
+
+    // receive buffers shared by all the bots: one socket is drained at a time
+    std::vector<std::vector<uint8_t>> buffers = std::vector<std::vector<uint8_t>>(RECV_BATCH,
+                                                                                  std::vector<uint8_t>(RECV_SIZE));
+    std::vector<mmsghdr> recvHeaders = std::vector<mmsghdr>(RECV_BATCH);
+    std::vector<iovec> recvIovecs = std::vector<iovec>(RECV_BATCH);
+};
+
+double percentile(std::vector<double> &samples, double ratio)
+{
+    if (samples.empty())
+        return 0;
+    std::sort(samples.begin(), samples.end());
+    return samples[std::min(samples.size() - 1, static_cast<std::size_t>(ratio * static_cast<double>(samples.size())))];
+}
+
+bool openSockets(Swarm &swarm)
+{
+    addrinfo hints{};
+    addrinfo *server = nullptr;
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (int error = getaddrinfo(swarm.settings.ip.c_str(), swarm.settings.port.c_str(), &hints, &server); error != 0)
+        return FLAKKARI_LOG_ERROR("could not resolve the server: " + std::string(gai_strerror(error))), false;
+
+    swarm.epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (swarm.epoll == -1)
+        return freeaddrinfo(server), FLAKKARI_LOG_ERROR("epoll_create1: " + std::string(strerror(errno))), false;
+
+    for (std::size_t i = 0; i < swarm.settings.bots; ++i)
+    {
+        auto &bot = swarm.bots.emplace_back(swarm.settings.game, swarm.settings.checksum);
+
+        bot.fd = socket(server->ai_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (bot.fd == -1 || connect(bot.fd, server->ai_addr, server->ai_addrlen) == -1)
+        {
+            FLAKKARI_LOG_ERROR("could not open the socket of bot " + std::to_string(i) + ": " + strerror(errno) +
+                               " (raise the open files limit with ulimit -n)");
+            return freeaddrinfo(server), false;
+        }
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        if (epoll_ctl(swarm.epoll, EPOLL_CTL_ADD, bot.fd, &event) == -1)
+            return freeaddrinfo(server), FLAKKARI_LOG_ERROR("epoll_ctl: " + std::string(strerror(errno))), false;
+    }
+    freeaddrinfo(server);
+
+    for (std::size_t i = 0; i < RECV_BATCH; ++i)
+    {
+        swarm.recvIovecs[i] = {swarm.buffers[i].data(), RECV_SIZE};
+        swarm.recvHeaders[i].msg_hdr.msg_iov = &swarm.recvIovecs[i];
+        swarm.recvHeaders[i].msg_hdr.msg_iovlen = 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Handle one packet sent by the server to a bot, once delivered by its
+ * connection (REP_CONNECT and the fragments are handled there).
+ */
+void handlePacket(Swarm &swarm, Bot &bot, const Packet &packet, Clock::time_point now)
+{
+    switch (packet.header._commandId)
+    {
+    case CommandId::REP_HEARTBEAT:
+        if (bot.heartbeatPending)
+        {
+            bot.rtt.push_back(std::chrono::duration<double, std::milli>(now - bot.heartbeatSent).count());
+            bot.heartbeatPending = false;
+        }
+        break;
+    case CommandId::REQ_ENTITIES_MOVED: ++swarm.report.updates; break;
+    default: break;
+    }
+}
+
+/**
+ * @brief Handle a datagram of the server through the connection of the bot,
+ * and capture it once decompressed.
+ */
+void handleDatagram(Swarm &swarm, Bot &bot, const uint8_t *data, std::size_t size, Clock::time_point now)
+{
+    auto observe = [&](const uint8_t *packets, std::size_t length, bool compressed) {
+        if (compressed)
+            swarm.packedBytes += size, swarm.unpackedBytes += length;
+        if (!swarm.capture.is_open())
+            return;
+        auto record = static_cast<uint16_t>(length);
+        swarm.capture.write(reinterpret_cast<const char *>(&record), sizeof(record));
+        swarm.capture.write(reinterpret_cast<const char *>(packets), static_cast<std::streamsize>(length));
+    };
+
+    ++swarm.report.datagramsIn;
+    swarm.report.bytesIn += size;
+    bot.connection.receive(
+        data, size, now, [&](const Packet &packet) { handlePacket(swarm, bot, packet, now); }, observe);
+}
+
+/**
+ * @brief Read every datagram waiting on the socket of a bot, and handle it
+ * (or put it in the simulated downlink).
+ */
+void receive(Swarm &swarm, Bot &bot, std::size_t index)
+{
+    for (;;)
+    {
+        for (auto &header : swarm.recvHeaders)
+            header.msg_hdr.msg_flags = 0;
+
+        int count = recvmmsg(bot.fd, swarm.recvHeaders.data(), RECV_BATCH, MSG_DONTWAIT, nullptr);
+        if (count <= 0)
+            return;
+
+        auto now = Clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            const uint8_t *data = swarm.buffers[i].data();
+            std::size_t size = swarm.recvHeaders[i].msg_len;
+
+            if (swarm.downlink)
+                swarm.downlink->push({index, Buffer(data, data + size)}, now, size);
+            else
+                handleDatagram(swarm, bot, data, size, now);
+        }
+        if (static_cast<std::size_t>(count) < RECV_BATCH)
+            return;
+    }
+}
+
+/**
+ * @brief Scripted input of a bot: walk along a square, turn slowly and
+ * shoot at a fixed interval. The bots start at different points of the
+ * script so that they do not all send the same input.
+ */
+Packet scriptedInput(Bot &bot, std::size_t index, uint64_t tick)
+{
+    Packet packet;
+    std::vector<Flakkari::Protocol::Event> events;
+    auto step = tick + index * 7;
+    int direction = static_cast<int>((step / MOVE_TICKS) % 4); // MOVE_LEFT, MOVE_RIGHT, MOVE_UP, MOVE_DOWN
+
+    if (direction != bot.direction)
+    {
+        if (bot.direction != -1)
+            events.push_back({static_cast<EventId>(bot.direction), EventState::RELEASED});
+        events.push_back({static_cast<EventId>(direction), EventState::PRESSED});
+        bot.direction = direction;
+    }
+    if (step % SHOOT_TICKS == 0)
+        events.push_back({EventId::SHOOT, EventState::PRESSED});
+    else if (step % SHOOT_TICKS == 1)
+        events.push_back({EventId::SHOOT, EventState::RELEASED});
+
+    packet.header._priority = Flakkari::Protocol::Priority::HIGH;
+    packet.header._commandId = CommandId::REQ_USER_UPDATES;
+    packet << static_cast<uint16_t>(events.size());
+    for (const auto &event : events)
+        packet << event;
+    packet << static_cast<uint16_t>(1);
+    packet << EventId::LOOK_RIGHT;
+    packet << static_cast<float>(std::sin(static_cast<double>(step) / 50.0));
+    if (++bot.sequence == 0)
+        ++bot.sequence;
+    packet << bot.sequence;
+    return packet;
+}
+
+/**
+ * @brief Send the packets of a bot for one tick with a single sendmmsg (or
+ * put them in the simulated uplink): its input, its heartbeat, and what its
+ * connection flushes (the retransmissions of REQ_CONNECT, the acks).
+ */
+void sendTick(Swarm &swarm, Bot &bot, std::size_t index, uint64_t tick, Clock::time_point now)
+{
+    if (!bot.connecting)
+    {
+        bot.connection.connect(now);
+        bot.connecting = true;
+    }
+    else if (bot.connection.getEntity())
+    {
+        bot.connection.send(scriptedInput(bot, index, tick).serialize(), now);
+        ++swarm.report.inputs;
+
+        if (now >= bot.nextHeartbeat)
+        {
+            Packet packet;
+            packet.header._commandId = CommandId::REQ_HEARTBEAT;
+            bot.connection.send(packet.serialize(), now);
+            bot.heartbeatSent = now;
+            bot.heartbeatPending = true;
+            bot.nextHeartbeat = now + HEARTBEAT_INTERVAL;
+        }
+    }
+    bot.connection.flush(now);
+
+    auto datagrams = std::move(bot.outbox);
+    bot.outbox.clear();
+    if (swarm.uplink)
+    {
+        for (auto &datagram : datagrams)
+            swarm.uplink->push({index, std::move(datagram)}, now);
+        return;
+    }
+
+    std::vector<iovec> iovecs(datagrams.size());
+    std::vector<mmsghdr> headers(datagrams.size());
+    for (std::size_t i = 0; i < datagrams.size(); ++i)
+    {
+        iovecs[i] = {datagrams[i].data(), datagrams[i].size()};
+        headers[i].msg_hdr.msg_iov = &iovecs[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int sent = sendmmsg(bot.fd, headers.data(), static_cast<unsigned int>(headers.size()), MSG_DONTWAIT);
+    for (int i = 0; i < sent; ++i)
+    {
+        ++swarm.report.datagramsOut;
+        swarm.report.bytesOut += headers[i].msg_len;
+    }
+    swarm.report.dropped += datagrams.size() - static_cast<std::size_t>(std::max(sent, 0));
+}
+
+/**
+ * @brief Deliver the datagrams of the simulated links whose time has come.
+ */
+void deliverLinks(Swarm &swarm, Clock::time_point now)
+{
+    if (swarm.uplink)
+        swarm.uplink->deliver(now, [&](auto &datagram) {
+            auto &[index, buffer] = datagram;
+            if (send(swarm.bots[index].fd, buffer.data(), buffer.size(), MSG_DONTWAIT) == -1)
+                return (void) ++swarm.report.dropped;
+            ++swarm.report.datagramsOut;
+            swarm.report.bytesOut += buffer.size();
+        });
+    if (swarm.downlink)
+        swarm.downlink->deliver(now, [&](auto &datagram) {
+            auto &[index, buffer] = datagram;
+            handleDatagram(swarm, swarm.bots[index], buffer.data(), buffer.size(), now);
+        });
+}
+
+void accumulate(Counters &total, const Counters &report)
+{
+    total.datagramsIn += report.datagramsIn;
+    total.datagramsOut += report.datagramsOut;
+    total.bytesIn += report.bytesIn;
+    total.bytesOut += report.bytesOut;
+    total.updates += report.updates;
+    total.inputs += report.inputs;
+    total.dropped += report.dropped;
+}
+
+void printReport(const std::string &label, const Counters &counters, std::vector<double> &rtt, std::size_t connected,
+                 std::size_t bots, double seconds)
+{
+    double perBot = connected == 0 ? 0 : static_cast<double>(connected);
+    double p50 = percentile(rtt, 0.5);
+    double p99 = percentile(rtt, 0.99);
+    double max = rtt.empty() ? 0 : rtt.back();
+
+    std::cout << std::fixed << std::setprecision(1) << "[BOTS] " << label << ": " << connected << "/" << bots
+              << " connected, server ticks " << (perBot == 0 ? 0 : counters.datagramsIn / perBot / seconds)
+              << "/s, updates " << (perBot == 0 ? 0 : counters.updates / perBot / seconds) << "/s per bot, rtt p50 "
+              << std::setprecision(2) << p50 << "ms p99 " << p99 << "ms max " << max << "ms, in "
+              << std::setprecision(1) << counters.bytesIn / seconds / 1024 << " KiB/s ("
+              << counters.datagramsIn / seconds << " dgram/s), out " << counters.bytesOut / seconds / 1024
+              << " KiB/s (" << counters.datagramsOut / seconds << " dgram/s), " << counters.dropped << " dropped"
+              << std::endl;
+}
+
+int run(Swarm &swarm)
+{
+    auto start = Clock::now();
+    auto end =
+        start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(swarm.settings.seconds));
+    auto tickInterval =
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / swarm.settings.inputRate));
+    auto nextTick = start;
+    auto nextReport = start + REPORT_INTERVAL;
+    auto lastReport = start;
+    uint64_t tick = 0;
+    std::vector<epoll_event> events(std::min<std::size_t>(swarm.bots.size(), 1024));
+
+    for (auto now = start; now < end; now = Clock::now())
+    {
+        auto wake = std::min({nextTick, nextReport, end});
+        for (auto *link : {swarm.uplink.get(), swarm.downlink.get()})
+            if (auto next = link ? link->nextDelivery() : std::nullopt; next && *next < wake)
+                wake = *next;
+        int timeout = static_cast<int>(
+            std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(wake - now).count()));
+        int ready = epoll_wait(swarm.epoll, events.data(), static_cast<int>(events.size()), timeout);
+
+        if (ready == -1 && errno != EINTR)
+            return FLAKKARI_LOG_ERROR("epoll_wait: " + std::string(strerror(errno))), 84;
+        for (int i = 0; i < ready; ++i)
+            receive(swarm, swarm.bots[events[i].data.u64], events[i].data.u64);
+
+        now = Clock::now();
+        deliverLinks(swarm, now);
+        if (now >= nextTick)
+        {
+            for (std::size_t i = 0; i < swarm.bots.size(); ++i)
+                sendTick(swarm, swarm.bots[i], i, tick, now);
+            ++tick;
+            nextTick += tickInterval;
+            if (nextTick < now) // the bots cannot keep up: skip the late ticks
+                nextTick = now + tickInterval;
+        }
+        if (now >= nextReport)
+        {
+            std::vector<double> rtt;
+            std::size_t connected = 0;
+            for (auto &bot : swarm.bots)
+            {
+                connected += bot.connection.getEntity().has_value();
+                rtt.insert(rtt.end(), bot.rtt.begin(), bot.rtt.end());
+                bot.rtt.clear();
+            }
+            swarm.rttAll.insert(swarm.rttAll.end(), rtt.begin(), rtt.end());
+            accumulate(swarm.total, swarm.report);
+
+            auto elapsed = std::chrono::duration<double>(now - start).count();
+            printReport("t=" + std::to_string(static_cast<int>(elapsed)) + "s", swarm.report, rtt, connected,
+                        swarm.bots.size(), std::chrono::duration<double>(now - lastReport).count());
+            swarm.report = {};
+            lastReport = now;
+            nextReport += REPORT_INTERVAL;
+        }
+    }
+
+    std::size_t connected = 0;
+    for (auto &bot : swarm.bots)
+    {
+        connected += bot.connection.getEntity().has_value();
+        swarm.rttAll.insert(swarm.rttAll.end(), bot.rtt.begin(), bot.rtt.end());
+    }
+    accumulate(swarm.total, swarm.report);
+    printReport("total", swarm.total, swarm.rttAll, connected, swarm.bots.size(),
+                std::chrono::duration<double>(Clock::now() - start).count());
+    std::cout << "[BOTS] " << swarm.total.inputs << " inputs sent" << std::endl;
+
+    Flakkari::Protocol::ReliabilityStats reliability;
+    Flakkari::Protocol::ReassemblyStats reassembly;
+    uint64_t invalid = 0;
+    uint64_t checked = 0;
+    uint64_t corrupted = 0;
+    for (auto &bot : swarm.bots)
+    {
+        auto stats = bot.connection.getReliabilityStats();
+        reliability.received += stats.received;
+        reliability.duplicates += stats.duplicates;
+        reliability.reordered += stats.reordered;
+        reassembly.messages += bot.connection.getReassemblyStats().messages;
+        reassembly.expired += bot.connection.getReassemblyStats().expired;
+        invalid += bot.connection.getCompressionStats().invalid;
+        checked += bot.connection.getChecksumStats().checked;
+        corrupted += bot.connection.getChecksumStats().invalid;
+    }
+    std::cout << "[BOTS] " << reliability.received << " packets received, " << reliability.duplicates
+              << " duplicates dropped, " << reliability.reordered << " reliable packets reordered, "
+              << reassembly.messages << " reassembled from fragments (" << reassembly.expired << " expired)"
+              << std::endl;
+    std::cout << "[BOTS] compressed datagrams: " << swarm.packedBytes / 1024 << " KiB for "
+              << swarm.unpackedBytes / 1024 << " KiB of packets (ratio " << std::setprecision(2)
+              << (swarm.packedBytes == 0 ? 1.0 : static_cast<double>(swarm.unpackedBytes) / swarm.packedBytes)
+              << "), " << invalid << " invalid" << std::endl;
+    if (swarm.settings.checksum)
+        std::cout << "[BOTS] checksums: " << checked << " datagrams checked, " << corrupted << " corrupted"
+                  << std::endl;
+    for (auto *link : {swarm.uplink.get(), swarm.downlink.get()})
+    {
+        if (!link)
+            continue;
+        const auto &stats = link->getStats();
+        std::cout << "[BOTS] " << (link == swarm.uplink.get() ? "uplink" : "downlink") << ": " << stats.lost << "/"
+                  << stats.pushed << " datagrams lost, " << stats.overflowed << " dropped by the bandwidth, "
+                  << stats.duplicated << " duplicated" << std::endl;
+    }
+    return connected == swarm.bots.size() ? 0 : 1;
+}
+
+} // namespace
+
+int main(int ac, const char *av[])
+{
+    if (ac < 5)
+    {
+        std::cerr << "USAGE: " << av[0]
+                  << " <game> <ip> <port> <bots> [seconds] [input rate] [loss %] [latency ms] [bandwidth KiB/s]"
+                     " [capture file] [checksum 0|1]"
+                  << std::endl;
+        return 84;
+    }
+
+    Swarm swarm;
+    swarm.settings.game = av[1];
+    swarm.settings.ip = av[2];
+    swarm.settings.port = av[3];
+    swarm.settings.bots = static_cast<std::size_t>(std::max(1, std::atoi(av[4])));
+    if (ac > 5)
+        swarm.settings.seconds = std::max(0.1, std::atof(av[5]));
+    if (ac > 6)
+        swarm.settings.inputRate = std::max(1.0, std::atof(av[6]));
+    if (ac > 7)
+        swarm.settings.loss = std::clamp(std::atof(av[7]) / 100, 0.0, 1.0);
+    if (ac > 8)
+        swarm.settings.latency = std::max(0.0, std::atof(av[8]));
+    if (ac > 9)
+        swarm.settings.bandwidth = std::max(0.0, std::atof(av[9]));
+    if (ac > 10)
+        swarm.settings.capture = av[10];
+    if (ac > 11)
+        swarm.settings.checksum = std::atoi(av[11]) != 0;
+
+    Link::Settings link;
+    link.loss = swarm.settings.loss;
+    link.duplicate = swarm.settings.loss / 10;
+    link.latency = std::chrono::microseconds(static_cast<int64_t>(swarm.settings.latency * 1000));
+    link.jitter = link.latency / 2;
+    if (!Link(link).isPerfect() || swarm.settings.bandwidth > 0)
+    {
+        swarm.uplink = std::make_unique<Link>(link);
+        link.seed += 1;
+        link.bandwidth = static_cast<std::size_t>(swarm.settings.bandwidth * 1024);
+        swarm.downlink = std::make_unique<Link>(link);
+    }
+
+    if (!swarm.settings.capture.empty())
+    {
+        swarm.capture.open(swarm.settings.capture, std::ios::binary | std::ios::trunc);
+        if (!swarm.capture)
+            return FLAKKARI_LOG_ERROR("could not open the capture file " + swarm.settings.capture), 84;
+    }
+    if (!openSockets(swarm))
+        return 84;
+
+    int status = run(swarm);
+
+    // leave the game: the server frees the slots without waiting for the timeout
+    for (auto &bot : swarm.bots)
+    {
+        bot.outbox.clear();
+        if (bot.connection.getEntity())
+            bot.connection.disconnect(Clock::now());
+        for (auto &datagram : bot.outbox)
+            send(bot.fd, datagram.data(), datagram.size(), MSG_DONTWAIT);
+        close(bot.fd);
+    }
+    close(swarm.epoll);
+    return status;
+}
+
+#else
+
+int main()
+{
+    std::cerr << "flakkari-bots uses recvmmsg, sendmmsg and epoll: it only runs on Linux" << std::endl;
+    return 84;
+}
+
+#endif
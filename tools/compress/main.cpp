@@ -0,0 +1,301 @@
+/*
+** EPITECH PROJECT, 2024
+** Title: Flakkari
+** Author: MasterLaplace
+** Created: 2024-10-19
+** File description:
+** compress: train the dictionary of the datagrams on captures, and measure the compression of the captures
+*/
+
+#include "Logger/Logger.hpp"
+#include "Protocol/Compression.hpp"
+
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Flakkari::Network::Buffer;
+using Flakkari::Network::Compressor;
+using Compression = Flakkari::Protocol::DatagramCompressor<Flakkari::Protocol::CommandId>;
+
+constexpr std::size_t DMER = 8;           // Bytes of the sequences counted by the training
+constexpr std::size_t SEGMENT = 64;        // Bytes of the segments the dictionary is made of
+constexpr std::size_t FREQUENCY_LOG = 22;  // 4M counters of sequences
+constexpr std::size_t DEFAULT_SIZE = 4096; // Size of the dictionary trained by default
+constexpr double MIN_BENCH_SECONDS = 0.5;  // CPU time of a measure at least
+constexpr double MEBIBYTE = 1024.0 * 1024.0;
+
+/**
+ * @brief Read the datagrams of capture files: records of a size (16 bits)
+ * followed by the datagram, as written by flakkari-bots
+ */
+bool loadCaptures(const std::vector<std::string> &paths, std::vector<Buffer> &datagrams)
+{
+    for (const auto &path : paths)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return FLAKKARI_LOG_ERROR("could not open the capture " + path), false;
+
+        uint16_t size;
+        while (file.read(reinterpret_cast<char *>(&size), sizeof(size)))
+        {
+            Buffer datagram(size);
+            if (!file.read(reinterpret_cast<char *>(datagram.data()), size))
+                return FLAKKARI_LOG_ERROR("the capture " + path + " is truncated"), false;
+            if (size > 0)
+                datagrams.push_back(std::move(datagram));
+        }
+    }
+    if (datagrams.empty())
+        return FLAKKARI_LOG_ERROR("the captures hold no datagram"), false;
+    return true;
+}
+
+inline std::size_t dmerHash(const byte *data)
+{
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return static_cast<std::size_t>((value * 0x9E3779B97F4A7C15ull) >> (64 - FREQUENCY_LOG));
+}
+
+/**
+ * @brief Train a dictionary on datagrams (the COVER algorithm of zstd,
+ * simplified)
+ *
+ * @details A sequence of DMER bytes is worth the number of datagrams it is
+ * in. The dictionary is filled with the segments of SEGMENT bytes worth the
+ * most, the sum of their sequences, and the sequences of a segment chosen
+ * are worth nothing afterwards, so that the next segments bring other
+ * content. The best segments go at the end of the dictionary, whose start
+ * is dropped first by a compressor keeping the last 64 KiB.
+ */
+Buffer train(const std::vector<Buffer> &datagrams, std::size_t size)
+{
+    std::vector<uint32_t> frequencies(std::size_t(1) << FREQUENCY_LOG, 0);
+    std::vector<uint32_t> lastSeen(frequencies.size(), UINT32_MAX);
+    std::vector<std::vector<uint32_t>> hashes(datagrams.size());
+
+    for (std::size_t i = 0; i < datagrams.size(); ++i)
+    {
+        const auto &datagram = datagrams[i];
+        for (std::size_t position = 0; position + DMER <= datagram.size(); ++position)
+        {
+            auto hash = static_cast<uint32_t>(dmerHash(datagram.data() + position));
+            hashes[i].push_back(hash);
+            if (lastSeen[hash] != i)
+            {
+                lastSeen[hash] = static_cast<uint32_t>(i);
+                ++frequencies[hash];
+            }
+        }
+    }
+
+    std::vector<Buffer> segments;
+    for (std::size_t total = 0; total < size;)
+    {
+        uint64_t bestScore = 0;
+        std::size_t bestDatagram = 0;
+        std::size_t bestPosition = 0;
+
+        for (std::size_t i = 0; i < datagrams.size(); ++i)
+        {
+            const auto &hash = hashes[i];
+            if (datagrams[i].size() < DMER)
+                continue;
+            std::size_t window = std::min(SEGMENT, datagrams[i].size()) - DMER + 1;
+
+            uint64_t score = 0;
+            for (std::size_t position = 0; position < window; ++position)
+                score += frequencies[hash[position]];
+            for (std::size_t position = 0;; ++position)
+            {
+                if (score > bestScore)
+                    bestScore = score, bestDatagram = i, bestPosition = position;
+                if (position + window >= hash.size())
+                    break;
+                score += frequencies[hash[position + window]];
+                score -= frequencies[hash[position]];
+            }
+        }
+        if (bestScore == 0)
+            break;
+
+        const auto &datagram = datagrams[bestDatagram];
+        std::size_t length = std::min({SEGMENT, datagram.size() - bestPosition, size - total});
+        for (std::size_t position = bestPosition; position + DMER <= bestPosition + length; ++position)
+            frequencies[hashes[bestDatagram][position]] = 0;
+        segments.emplace_back(datagram.begin() + bestPosition, datagram.begin() + bestPosition + length);
+        total += length;
+    }
+
+    Buffer dictionary;
+    for (auto segment = segments.rbegin(); segment != segments.rend(); ++segment)
+        dictionary.insert(dictionary.end(), segment->begin(), segment->end());
+    return dictionary;
+}
+
+bool writeDictionary(const std::string &path, const Buffer &dictionary, std::size_t datagrams)
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+        return FLAKKARI_LOG_ERROR("could not write " + path), false;
+
+    file << "/**************************************************************************\n"
+            " * Flakkari Library v0.10.0\n"
+            " *\n"
+            " * Flakkari Library is a C++ Library for Network.\n"
+            " * @file Dictionary.hpp\n"
+            " * @brief This file contains the dictionary of the compression of the\n"
+            " *        datagrams, trained on captured game traffic. It is generated\n"
+            " *        by flakkari-compress train: do not edit it.\n"
+            " *\n"
+            " * Flakkari Library is under MIT License.\n"
+            " * https://opensource.org/licenses/MIT\n"
+            " * © 2023 @MasterLaplace\n"
+            " * @version 0.10.0\n"
+            " * @date 2024-10-19\n"
+            " **************************************************************************/\n"
+            "\n"
+            "#ifndef FLAKKARI_DICTIONARY_HPP_\n"
+            "#define FLAKKARI_DICTIONARY_HPP_\n"
+            "\n"
+            "#include \"../Network/Buffer.hpp\"\n"
+            "\n"
+            "namespace Flakkari::Protocol {\n"
+            "\n"
+            "/**\n"
+            " * @brief Dictionary of the compression of the datagrams: "
+         << dictionary.size() << " bytes trained on\n * " << datagrams
+         << " datagrams. The server and the clients must have the same.\n"
+            " */\n"
+            "inline constexpr byte DICTIONARY[] = {";
+    for (std::size_t i = 0; i < dictionary.size(); ++i)
+        file << (i % 16 == 0 ? "\n    " : " ") << "0x" << std::hex << std::setw(2) << std::setfill('0')
+             << static_cast<int>(dictionary[i]) << ",";
+    file << "\n};\n"
+            "\n"
+            "} // namespace Flakkari::Protocol\n"
+            "\n"
+            "#endif /* !FLAKKARI_DICTIONARY_HPP_ */\n";
+    return static_cast<bool>(file);
+}
+
+double cpuSeconds() { return static_cast<double>(std::clock()) / CLOCKS_PER_SEC; }
+
+/**
+ * @brief Compress and decompress every datagram as the server and the
+ * clients do, and print the ratio and the CPU time per MiB of datagrams
+ */
+bool bench(const std::string &label, const std::vector<Buffer> &datagrams, const byte *dictionary, std::size_t size)
+{
+    Compressor compressor(dictionary, size);
+    std::vector<Buffer> blocks(datagrams.size());
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    uint64_t compressed = 0;
+
+    // a datagram is only sent compressed if that makes it smaller, as by DatagramCompressor
+    for (std::size_t i = 0; i < datagrams.size(); ++i)
+    {
+        const auto &datagram = datagrams[i];
+        auto &block = blocks[i];
+        bytesIn += datagram.size();
+        block.resize(datagram.size() < Compression::MIN_SIZE ? 0 : datagram.size() - 1 - Compression::OVERHEAD);
+        block.resize(block.empty() ? 0 : compressor.compress(datagram.data(), datagram.size(), block.data(),
+                                                             block.size()));
+        compressed += !block.empty();
+        bytesOut += block.empty() ? datagram.size() : Compression::OVERHEAD + block.size();
+    }
+
+    Buffer scratch(Compressor::MAX_SIZE);
+    for (std::size_t i = 0; i < datagrams.size(); ++i)
+    {
+        const auto &block = blocks[i];
+        if (!block.empty() &&
+            (compressor.decompress(block.data(), block.size(), scratch.data(), scratch.size()) != datagrams[i].size() ||
+             !std::equal(datagrams[i].begin(), datagrams[i].end(), scratch.begin())))
+            return FLAKKARI_LOG_ERROR(label + ": datagram " + std::to_string(i) + " does not decompress"), false;
+    }
+
+    Buffer output(Compressor::bound(Compressor::MAX_SIZE));
+    double compressSeconds = 0;
+    uint64_t compressBytes = 0;
+    for (double start = cpuSeconds(); compressSeconds < MIN_BENCH_SECONDS; compressSeconds = cpuSeconds() - start)
+        for (const auto &datagram : datagrams)
+        {
+            std::size_t capacity =
+                datagram.size() < Compression::MIN_SIZE ? 0 : datagram.size() - 1 - Compression::OVERHEAD;
+            if (capacity > 0)
+                compressor.compress(datagram.data(), datagram.size(), output.data(), capacity);
+            compressBytes += datagram.size();
+        }
+
+    double decompressSeconds = 0;
+    uint64_t decompressBytes = 0;
+    for (double start = cpuSeconds(); decompressSeconds < MIN_BENCH_SECONDS; decompressSeconds = cpuSeconds() - start)
+        for (std::size_t i = 0; i < datagrams.size(); ++i)
+        {
+            if (!blocks[i].empty())
+                compressor.decompress(blocks[i].data(), blocks[i].size(), scratch.data(), scratch.size());
+            decompressBytes += datagrams[i].size();
+        }
+
+    std::cout << std::left << std::setw(12) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << 100.0 * static_cast<double>(compressed) / static_cast<double>(datagrams.size())
+              << "%" << std::setprecision(3) << std::setw(10)
+              << static_cast<double>(bytesIn) / static_cast<double>(bytesOut) << std::setprecision(2) << std::setw(14)
+              << 1000.0 * compressSeconds / (static_cast<double>(compressBytes) / MEBIBYTE) << std::setw(16)
+              << 1000.0 * decompressSeconds / (static_cast<double>(decompressBytes) / MEBIBYTE) << std::endl;
+    return true;
+}
+
+} // namespace
+
+int main(int ac, const char *av[])
+{
+    std::string mode = ac > 1 ? av[1] : "";
+
+    if (mode == "train" && ac > 4)
+    {
+        std::vector<Buffer> datagrams;
+        if (!loadCaptures({av + 4, av + ac}, datagrams))
+            return 84;
+        auto size = std::min<std::size_t>(std::stoul(av[3]), Compressor::MAX_DISTANCE);
+        auto dictionary = train(datagrams, size == 0 ? DEFAULT_SIZE : size);
+        if (!writeDictionary(av[2], dictionary, datagrams.size()))
+            return 84;
+        std::cout << "dictionary of " << dictionary.size() << " bytes trained on " << datagrams.size()
+                  << " datagrams written to " << av[2] << std::endl;
+        return 0;
+    }
+    if (mode == "bench" && ac > 2)
+    {
+        std::vector<Buffer> datagrams;
+        if (!loadCaptures({av + 2, av + ac}, datagrams))
+            return 84;
+        uint64_t bytes = 0;
+        for (const auto &datagram : datagrams)
+            bytes += datagram.size();
+
+        std::cout << datagrams.size() << " datagrams, " << bytes / 1024 << " KiB (" << bytes / datagrams.size()
+                  << " bytes per datagram)" << std::endl;
+        std::cout << std::left << std::setw(12) << "dictionary" << std::right << std::setw(11) << "compressed"
+                  << std::setw(10) << "ratio" << std::setw(14) << "comp ms/MiB" << std::setw(16) << "decomp ms/MiB"
+                  << std::endl;
+        bool valid = bench("none", datagrams, nullptr, 0) &&
+                     bench("built-in", datagrams, Flakkari::Protocol::DICTIONARY,
+                           sizeof(Flakkari::Protocol::DICTIONARY));
+        return valid ? 0 : 84;
+    }
+
+    std::cerr << "USAGE: " << av[0] << " train <Dictionary.hpp> <size> <capture>...\n"
+              << "       " << av[0] << " bench <capture>...\n"
+              << "The captures are written by flakkari-bots (its [capture file] argument)." << std::endl;
+    return 84;
+}
@@ -0,0 +1,175 @@
+/*
+** EPITECH PROJECT, 2024
+** Title: Flakkari
+** Author: MasterLaplace
+** Created: 2024-10-19
+** File description:
+** replay: run a recorded game offline, without network
+*/
+
+#include "Server/Client/Client.hpp"
+#include "Server/Game/Game.hpp"
+#include "Server/Game/Replay.hpp"
+#include "Server/Game/ResourceManager.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+namespace {
+
+struct ReplayResult {
+    uint64_t ticks = 0;                   // Ticks replayed
+    uint64_t inputs = 0;                  // Inputs applied
+    uint64_t hashChecks = 0;              // HASH records checked
+    uint64_t hashMismatches = 0;          // HASH records that did not match
+    uint64_t finalHash = 0;               // State hash at the end of the log
+    std::string profile;                  // Run time of the systems (FLAKKARI_PROFILE_SYSTEMS)
+    std::vector<double> tickMicroseconds; // Duration of each tick
+};
+
+std::shared_ptr<const Flakkari::GameSettings> loadSettings(const std::string &gameDir, const std::string &gameName)
+{
+    std::ifstream configFile(gameDir + "/" + gameName + "/config.cfg");
+    nlohmann::json config;
+
+    if (!configFile.is_open())
+        return FLAKKARI_LOG_ERROR("could not open config file for \"" + gameName + "\" game"), nullptr;
+    configFile >> config;
+    return Flakkari::GameSettings::load(gameName, config);
+}
+
+ReplayResult replay(const std::string &path, std::shared_ptr<const Flakkari::GameSettings> settings)
+{
+    using namespace Flakkari;
+
+    ReplayResult result;
+    ReplayReader reader(path);
+    ReplayRecord record;
+    Game game(settings->name, settings);
+    std::unordered_map<uint32_t, std::shared_ptr<Client>> clients;
+    std::chrono::steady_clock::time_point tickStart;
+
+    while (reader.next(record))
+    {
+        switch (record.type)
+        {
+        case ReplayRecordType::SEED: game.seedScene(record.scene, static_cast<uint32_t>(record.value)); break;
+        case ReplayRecordType::JOIN:
+        {
+            Network::Address::address_t ip = "127.0.0.1";
+            auto address = std::make_shared<Network::Address>(ip, static_cast<Network::Address::port_t>(record.client),
+                                                              Network::Address::SocketType::UDP,
+                                                              Network::Address::IpType::IPv4);
+            auto client = std::make_shared<Client>(address, settings->name, Protocol::ApiVersion::V_1);
+
+            if (!game.addPlayer(client))
+                FLAKKARI_LOG_WARNING("client " + std::to_string(record.client) + " could not join the game");
+            clients[record.client] = client;
+            break;
+        }
+        case ReplayRecordType::LEAVE:
+            if (auto it = clients.find(record.client); it != clients.end())
+            {
+                game.removePlayer(it->second);
+                clients.erase(it);
+            }
+            break;
+        case ReplayRecordType::TICK:
+            tickStart = std::chrono::steady_clock::now();
+            game.beginTick(std::chrono::nanoseconds(record.value));
+            break;
+        case ReplayRecordType::INPUT:
+            if (auto it = clients.find(record.client); it != clients.end())
+            {
+                Protocol::PacketView<Protocol::CommandId> packet;
+                packet.header._commandId = Protocol::CommandId::REQ_USER_UPDATES;
+                packet.payload = Network::BufferView::copyOf(record.payload);
+                game.handleEvents(it->second, packet, std::chrono::nanoseconds(record.value));
+                ++result.inputs;
+            }
+            break;
+        case ReplayRecordType::SYSTEMS:
+            game.runSystems();
+            result.tickMicroseconds.push_back(
+                std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - tickStart).count());
+            ++result.ticks;
+            // nothing is sent: drop the packets of the tick
+            for (auto &[id, client] : clients)
+            {
+                client->getSendQueue().clear();
+                client->keepAlive();
+            }
+            break;
+        case ReplayRecordType::HASH:
+            ++result.hashChecks;
+            if (game.computeStateHash() != record.value)
+            {
+                ++result.hashMismatches;
+                FLAKKARI_LOG_ERROR("state hash mismatch after tick " + std::to_string(result.ticks));
+            }
+            break;
+        }
+    }
+    result.finalHash = game.computeStateHash();
+    result.profile = game.getProfileReport();
+    return result;
+}
+
+double percentile(const std::vector<double> &sorted, double ratio)
+{
+    if (sorted.empty())
+        return 0;
+    return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(ratio * static_cast<double>(sorted.size())))];
+}
+
+} // namespace
+
+int main(int ac, const char *av[])
+{
+    if (ac < 3)
+    {
+        std::cerr << "USAGE: " << av[0] << " <games dir> <replay log> [runs]" << std::endl;
+        return 84;
+    }
+
+    std::string gameDir = av[1];
+    std::string path = av[2];
+    int runs = ac > 3 ? std::max(1, std::atoi(av[3])) : 1;
+
+    Flakkari::ReplayReader header(path);
+    if (!header.isValid())
+        return 84;
+
+    auto settings = loadSettings(gameDir, header.getGameName());
+    if (!settings)
+        return 84;
+
+    Flakkari::ResourceManager::CreateInstance();
+
+    uint64_t firstHash = 0;
+    bool deterministic = true;
+
+    for (int run = 0; run < runs; ++run)
+    {
+        auto result = replay(path, settings);
+        auto sorted = result.tickMicroseconds;
+        std::sort(sorted.begin(), sorted.end());
+        double mean =
+            sorted.empty() ? 0 : std::accumulate(sorted.begin(), sorted.end(), 0.0) / static_cast<double>(sorted.size());
+
+        if (run == 0)
+            firstHash = result.finalHash;
+        deterministic &= result.finalHash == firstHash && result.hashMismatches == 0;
+
+        std::cout << "[REPLAY] run " << run + 1 << "/" << runs << ": " << result.ticks << " ticks, " << result.inputs
+                  << " inputs, tick mean " << mean << "us p50 " << percentile(sorted, 0.5) << "us p99 "
+                  << percentile(sorted, 0.99) << "us max " << (sorted.empty() ? 0 : sorted.back()) << "us, "
+                  << result.hashMismatches << "/" << result.hashChecks << " hash mismatches, final state hash 0x"
+                  << std::hex << result.finalHash << std::dec << std::endl;
+        std::cout << result.profile;
+    }
+
+    std::cout << "[REPLAY] " << (deterministic ? "deterministic" : "NOT deterministic") << std::endl;
+    return deterministic ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+-- Tools built from the server sources, without its entry point
+target("flakkari-replay")
+    set_kind("binary")
+    set_default(false)
+    set_languages("cxx20")
+    set_policy("build.warning", true)
+
+    add_packages("nlohmann_json", "singleton")
+
+    if has_config("with-profiler") then
+        add_defines("FLAKKARI_PROFILE_SYSTEMS")
+    end
+
+    add_files("replay/main.cpp")
+    add_files("$(projectdir)/Flakkari/**.cpp")
+
+    remove_files("$(projectdir)/Flakkari/core.cpp")
+    remove_files("$(projectdir)/Flakkari/Client/**.cpp")
+    remove_files("$(projectdir)/Flakkari/Server/Internals/GameDownloader.cpp")
+
+    add_includedirs("$(projectdir)/Flakkari")
+    add_includedirs("$(projectdir)/Flakkari/Engine")
+    add_includedirs("$(projectdir)/Flakkari/Engine/EntityComponentSystem")
+    add_includedirs("$(projectdir)/Flakkari/Engine/EntityComponentSystem/Components")
+    add_includedirs("$(projectdir)/Flakkari/Engine/EntityComponentSystem/Systems")
+    add_includedirs("$(projectdir)/Flakkari/Engine/Math")
+    add_includedirs("$(projectdir)/Flakkari/Logger")
+    add_includedirs("$(projectdir)/Flakkari/Network")
+    add_includedirs("$(projectdir)/Flakkari/Protocol")
+    add_includedirs("$(projectdir)/Flakkari/Server")
+    add_includedirs("$(projectdir)/Flakkari/Server/Client")
+    add_includedirs("$(projectdir)/Flakkari/Server/Game")
+    add_includedirs("$(projectdir)/Flakkari/Server/Internals")
+
+    if is_mode("debug") then
+        add_defines("_DEBUG")
+        set_symbols("debug")
+        set_optimize("none")
+    elseif is_mode("release") then
+        add_defines("NDEBUG")
+        set_optimize("fastest")
+    end
+
+    if is_plat("windows") then
+        add_syslinks("ws2_32", "Iphlpapi")
+    elseif is_plat("linux") or is_plat("macosx") then
+        add_syslinks("pthread")
+    end
+target_end()
+
+-- Load generator: simulated players driven from one process (Linux only)
+target("flakkari-bots")
+    set_kind("binary")
+    set_default(false)
+    set_languages("cxx20")
+    set_policy("build.warning", true)
+
+    add_files("bots/main.cpp")
+    add_files("$(projectdir)/Flakkari/Client/Connection.cpp")
+    add_files("$(projectdir)/Flakkari/Logger/Logger.cpp")
+    add_files("$(projectdir)/Flakkari/Network/Buffer.cpp")
+    add_files("$(projectdir)/Flakkari/Network/Compressor.cpp")
+    add_files("$(projectdir)/Flakkari/Network/Kernels.cpp")
+
+    add_includedirs("$(projectdir)/Flakkari")
+
+    if is_mode("debug") then
+        add_defines("_DEBUG")
+        set_symbols("debug")
+        set_optimize("none")
+    elseif is_mode("release") then
+        add_defines("NDEBUG")
+        set_optimize("fastest")
+    end
+target_end()
+
+-- Loopback echo benchmark of the pselect path of the server and of io_uring (Linux only)
+target("flakkari-bench-io")
+    set_kind("binary")
+    set_default(false)
+    set_languages("cxx20")
+    set_policy("build.warning", true)
+
+    add_files("bench_io/main.cpp")
+    add_files("$(projectdir)/Flakkari/Logger/Logger.cpp")
+    add_files("$(projectdir)/Flakkari/Network/*.cpp")
+
+    add_includedirs("$(projectdir)/Flakkari")
+
+    if is_mode("debug") then
+        add_defines("_DEBUG")
+        set_symbols("debug")
+        set_optimize("none")
+    elseif is_mode("release") then
+        add_defines("NDEBUG")
+        set_optimize("fastest")
+    end
+
+    add_syslinks("pthread")
+target_end()
+
+-- Compression of the datagrams: trains the dictionary on captures and benchmarks it
+target("flakkari-compress")
+    set_kind("binary")
+    set_default(false)
+    set_languages("cxx20")
+    set_policy("build.warning", true)
+
+    add_files("compress/main.cpp")
+    add_files("$(projectdir)/Flakkari/Logger/Logger.cpp")
+    add_files("$(projectdir)/Flakkari/Network/Buffer.cpp")
+    add_files("$(projectdir)/Flakkari/Network/Compressor.cpp")
+    add_files("$(projectdir)/Flakkari/Network/Kernels.cpp")
+
+    add_includedirs("$(projectdir)/Flakkari")
+
+    if is_mode("debug") then
+        add_defines("_DEBUG")
+        set_symbols("debug")
+        set_optimize("none")
+    elseif is_mode("release") then
+        add_defines("NDEBUG")
+        set_optimize("fastest")
+    end
+target_end()
+
+-- Micro-benchmarks of the byte kernels of the buffers (CRC32C, XOR, hexadecimal)
+target("flakkari-bench-buffer")
+    set_kind("binary")
+    set_default(false)
+    set_languages("cxx20")
+    set_policy("build.warning", true)
+
+    add_files("bench_buffer/main.cpp")
+    add_files("$(projectdir)/Flakkari/Network/Kernels.cpp")
+
+    add_includedirs("$(projectdir)/Flakkari")
+
+    if is_mode("debug") then
+        add_defines("_DEBUG")
+        set_symbols("debug")
+        set_optimize("none")
+    elseif is_mode("release") then
+        add_defines("NDEBUG")
+        set_optimize("fastest")
+    end
+target_end()
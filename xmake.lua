@@ -8,6 +8,18 @@ option("with-autoupdate")
     set_description("Enable automatic game download/update feature")
 option_end()
 
+option("with-profiler")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Time each ECS system of the game instances (admin command \"profile\")")
+option_end()
+
+option("with-pselect")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Use pselect instead of epoll to wait for the sockets on Linux")
+option_end()
+
 option("pack-server")
     set_default(true)
     set_showmenu(true)
@@ -22,6 +34,10 @@ option_end()
 
 add_requires("nlohmann_json", "singleton")
 
+if has_config("with-pselect") then
+    add_defines("FLAKKARI_IO_PSELECT")
+end
+
 if has_config("with-autoupdate") then
     add_requires("libcurl", {configs = {openssl3 = is_plat("linux", "macosx")}})
     add_requires("libgit2", {configs = {https = is_plat("windows") and "winhttp" or "openssl3", tools = false}})
@@ -29,6 +45,8 @@ end
 
 includes("@builtin/xpack")
 includes("examples")
+includes("tools")
+includes("tests")
 
 set_project("Flakkari")
 set_license("MIT")
@@ -48,6 +66,10 @@ target("flakkari-server")
         set_policy("check.target_package_licenses", false)
     end
 
+    if has_config("with-profiler") then
+        add_defines("FLAKKARI_PROFILE_SYSTEMS")
+    end
+
     if is_mode("debug") then
         add_defines("_DEBUG")
         set_symbols("debug")